@@ -45,7 +45,7 @@
 #include <ironbee/escape.h>
 #include <ironbee/field.h>
 #include <ironbee/flags.h>
-#include <ironbee/json.h>
+#include <ironbee/json_writer.h>
 #include <ironbee/logevent.h>
 #include <ironbee/mm.h>
 #include <ironbee/rule_defs.h>
@@ -555,48 +555,102 @@ static size_t ib_auditlog_gen_raw_stream(ib_auditlog_part_t *part,
     return dlen;
 }
 
-static size_t ib_auditlog_gen_json_flist(ib_auditlog_part_t *part,
+/**
+ * End a JSON audit log part.
+ *
+ * The writer that produced the part's chunk is kept in the part's gen_data
+ * until the chunk has been written, that is, until the next call.
+ *
+ * @param[in] part Audit log part.
+ *
+ * @returns 0; the end of the part.
+ */
+static size_t ib_auditlog_gen_json_end(ib_auditlog_part_t *part)
+{
+    if (part->gen_data != AUDITLOG_GEN_FINISHED) {
+        ib_json_writer_release((ib_json_writer_t *)part->gen_data);
+    }
+    part->gen_data = AUDITLOG_GEN_NOTSTARTED;
+
+    return 0;
+}
+
+/**
+ * Fetch the chunk of a JSON audit log part from @a writer.
+ *
+ * @param[in]  part   Audit log part.
+ * @param[in]  writer Writer holding the part.
+ * @param[out] chunk  Chunk; `{}` if the writer failed.
+ *
+ * @returns Length of @a chunk.
+ */
+static size_t ib_auditlog_gen_json_chunk(ib_auditlog_part_t *part,
+                                         ib_json_writer_t *writer,
                                          const uint8_t **chunk)
 {
-    ib_engine_t *ib = part->log->ib;
+    const char *buf;
+    size_t len;
     ib_status_t rc;
 
-    /* When gen_data = -1, end the generation by returning 0. */
-    if (part->gen_data == AUDITLOG_GEN_FINISHED) {
-        part->gen_data = AUDITLOG_GEN_NOTSTARTED;
-        return 0;
+    rc = ib_json_writer_buf(writer, &buf, &len);
+    if (rc != IB_OK) {
+        ib_log_notice(part->log->ib,
+                      "Unable to generate JSON for audit log part \"%s\": %s",
+                      part->name, ib_status_to_string(rc));
+        ib_json_writer_release(writer);
+        part->gen_data = AUDITLOG_GEN_FINISHED;
+        *chunk = (const uint8_t *)"{}";
+        return 2;
     }
 
-    /* We only call this function twice. Once to do the work. Once to signal
-     * the work is done. */
-    part->gen_data = AUDITLOG_GEN_FINISHED;
+    part->gen_data = writer;
+    *chunk = (const uint8_t *)buf;
 
-    if (part->part_data != NULL) {
-        ib_mm_t mm = part->log->mm;
-        size_t chunk_len;
+    return len;
+}
 
-        rc = ib_json_encode(
-            mm,
-            (ib_list_t *)part->part_data,
-            true,
-            (char **)chunk,
-            &chunk_len
-        );
-        if (rc != IB_OK) {
-            ib_log_notice(ib, "Unable to generate JSON for audit log part \"%s\": %s",
-                          part->name, ib_status_to_string(rc));
-            *chunk = (uint8_t *)("{}");
-            return 2;
-        }
+static size_t ib_auditlog_gen_json_flist(ib_auditlog_part_t *part,
+                                         const uint8_t **chunk)
+{
+    ib_engine_t *ib = part->log->ib;
+    const ib_list_t *list = (const ib_list_t *)part->part_data;
+    const ib_list_node_t *node;
+    ib_json_writer_t *writer;
+    ib_status_t rc;
 
-        return chunk_len;
+    /* We only get here twice. Once to do the work. Once to signal
+     * the work is done. */
+    if (part->gen_data != AUDITLOG_GEN_NOTSTARTED) {
+        return ib_auditlog_gen_json_end(part);
     }
-    else {
+
+    part->gen_data = AUDITLOG_GEN_FINISHED;
+
+    if (list == NULL) {
         ib_log_notice(ib, "No data in audit log part: %s", part->name);
         *chunk = (const uint8_t *)"{}";
-        part->gen_data = AUDITLOG_GEN_FINISHED;
-        return strlen(*(const char **)chunk);
+        return 2;
+    }
+
+    rc = ib_json_writer_acquire(&writer, true);
+    if (rc != IB_OK) {
+        ib_log_notice(ib, "Unable to generate JSON for audit log part \"%s\": %s",
+                      part->name, ib_status_to_string(rc));
+        *chunk = (const uint8_t *)"{}";
+        return 2;
+    }
+
+    /* Errors are sticky and reported when the chunk is fetched. */
+    ib_json_writer_map_open(writer);
+    IB_LIST_LOOP_CONST(list, node) {
+        ib_json_writer_field(
+            writer,
+            (const ib_field_t *)ib_list_node_data_const(node)
+        );
     }
+    ib_json_writer_map_close(writer);
+
+    return ib_auditlog_gen_json_chunk(part, writer, chunk);
 }
 
 static size_t ib_auditlog_gen_header_flist(ib_auditlog_part_t *part,
@@ -754,23 +808,18 @@ static size_t ib_auditlog_gen_json_events(ib_auditlog_part_t *part,
     assert(part->log->ib != NULL);
     assert(part->log->tx != NULL);
 
-    ib_status_t       rc;
-    yajl_gen_status   yajl_status;
-
+    ib_status_t           rc;
     ib_tx_t              *tx   = part->log->tx;
     const ib_list_t      *list = (const ib_list_t *)part->part_data;
     const ib_list_node_t *node;
-    yajl_gen              yajl_handle;
-    size_t                chunk_len = 0; /* This value is returned. */
+    ib_json_writer_t     *writer;
 
-    /* When gen_data == -1, return 0. */
-    if (part->gen_data == AUDITLOG_GEN_FINISHED) {
-        part->gen_data = AUDITLOG_GEN_NOTSTARTED;
-        return 0;
+    /* When gen_data is set, the work is done. */
+    if (part->gen_data != AUDITLOG_GEN_NOTSTARTED) {
+        return ib_auditlog_gen_json_end(part);
     }
 
-    /* Gen_data may only be NULL or -1. */
-    assert(part->gen_data == AUDITLOG_GEN_NOTSTARTED);
+    part->gen_data = AUDITLOG_GEN_FINISHED;
 
     /* No events. */
     if (ib_list_elements(list) == 0) {
@@ -778,260 +827,72 @@ static size_t ib_auditlog_gen_json_events(ib_auditlog_part_t *part,
         return 2;
     }
 
-    rc = ib_json_yajl_gen_create(&yajl_handle, part->log->mm);
+    rc = ib_json_writer_acquire(&writer, true);
     if (rc != IB_OK) {
         ib_log_error_tx(tx, "Failed to create JSON generation resource.");
-        goto failure;
-    }
-
-    /* Set pretty option. */
-    int opt = yajl_gen_config(yajl_handle, yajl_gen_beautify, 1);
-    if (opt == 0) {
-        ib_log_error_tx(tx, "Failed to set yajl beautify option.");
-        goto failure;
-    }
-
-    yajl_status = yajl_gen_map_open(yajl_handle);
-    if (yajl_status != yajl_gen_status_ok) {
-        ib_log_error_tx(tx, "Failed to open events JSON map.");
-        goto failure;
-    }
-
-    yajl_status =
-        yajl_gen_string(yajl_handle, (unsigned char *)"events", 6);
-    if (yajl_status != yajl_gen_status_ok) {
-        ib_log_error_tx(tx, "Failed to add events JSON array.");
-        goto failure;
+        return 0;
     }
 
-    yajl_status = yajl_gen_array_open(yajl_handle);
-    if (yajl_status != yajl_gen_status_ok) {
-        ib_log_error_tx(tx, "Failed to open events JSON array.");
-        goto failure;
-    }
+    /* Errors are sticky and reported when the chunk is fetched. */
+    ib_json_writer_map_open(writer);
+    ib_json_writer_nulstr(writer, "events");
+    ib_json_writer_array_open(writer);
 
     IB_LIST_LOOP_CONST(list, node) {
         const ib_logevent_t *e =
             (const ib_logevent_t *)ib_list_node_data_const(node);
 
-        /* Open event hash. */
-        yajl_status = yajl_gen_map_open(yajl_handle);
-        if (yajl_status != yajl_gen_status_ok) {
-            ib_log_error_tx(tx, "Failed to open event JSON map.");
-            goto failure;
-        }
+        ib_json_writer_map_open(writer);
 
-        /* Event ID. */
-        yajl_status =
-            yajl_gen_string(yajl_handle, (unsigned char *)"event-id", 8);
-        if (yajl_status != yajl_gen_status_ok) {
-            ib_log_error_tx(tx, "Failed to add event id.");
-            goto failure;
-        }
+        ib_json_writer_nulstr(writer, "event-id");
+        ib_json_writer_num(writer, e->event_id);
 
-        yajl_status = yajl_gen_integer(yajl_handle, e->event_id);
-        if (yajl_status != yajl_gen_status_ok) {
-            ib_log_error_tx(tx, "Failed to add event id.");
-            goto failure;
-        }
+        ib_json_writer_nulstr(writer, "rule-id");
+        ib_json_writer_nulstr(writer, e->rule_id);
 
-        /* Rule ID. */
-        yajl_status =
-            yajl_gen_string(yajl_handle, (unsigned char *)"rule-id", 7);
-        if (yajl_status != yajl_gen_status_ok) {
-            ib_log_error_tx(tx, "Failed to add rule id for event.");
-            goto failure;
-        }
-
-        yajl_status = yajl_gen_string(
-            yajl_handle, (unsigned char *)IB_S2SL(e->rule_id)
-        );
-        if (yajl_status != yajl_gen_status_ok) {
-            ib_log_error_tx(tx, "Failed to add rule id for event.");
-            goto failure;
-        }
-
-        /* Type. */
-        yajl_status = yajl_gen_string(yajl_handle, (unsigned char *)"type", 4);
-        if (yajl_status != yajl_gen_status_ok) {
-            ib_log_error_tx(tx, "Failed to add event type.");
-            goto failure;
-        }
-
-        yajl_status = yajl_gen_string(
-            yajl_handle,
-            (unsigned char *)IB_S2SL(ib_logevent_type_name(e->type)));
-        if (yajl_status != yajl_gen_status_ok) {
-            ib_log_error_tx(tx, "Failed to add event type.");
-            goto failure;
-        }
-
-        /* Suppress. */
-        yajl_status =
-            yajl_gen_string(yajl_handle, (unsigned char *)"suppress", 8);
-        if (yajl_status != yajl_gen_status_ok) {
-            ib_log_error_tx(tx, "Failed to add suppression.");
-            goto failure;
-        }
-
-        yajl_status = yajl_gen_string(
-            yajl_handle,
-            (unsigned char *)IB_S2SL(ib_logevent_suppress_name(e->suppress)));
-        if (yajl_status != yajl_gen_status_ok) {
-            ib_log_error_tx(tx, "Failed to add suppression flags.");
-            goto failure;
-        }
-
-        /* Recommended Action. */
-        yajl_status = yajl_gen_string(
-            yajl_handle, (unsigned char *)"rec-action", 10);
-        if (yajl_status != yajl_gen_status_ok) {
-            ib_log_error_tx(tx, "Failed to add recommended action.");
-            goto failure;
-        }
-
-        yajl_status = yajl_gen_string(
-            yajl_handle,
-            (unsigned char *)IB_S2SL(ib_logevent_action_name(e->rec_action)));
-        if (yajl_status != yajl_gen_status_ok) {
-            ib_log_error_tx(tx, "Failed to add recommended action.");
-            goto failure;
-        }
-
-        /* Confidence. */
-        yajl_status =
-            yajl_gen_string(yajl_handle, (unsigned char *)"confidence", 10);
-        if (yajl_status != yajl_gen_status_ok) {
-            ib_log_error_tx(tx, "Failed to add confidence.");
-            goto failure;
-        }
+        ib_json_writer_nulstr(writer, "type");
+        ib_json_writer_nulstr(writer, ib_logevent_type_name(e->type));
 
-        yajl_status = yajl_gen_double(yajl_handle, e->confidence);
-        if (yajl_status != yajl_gen_status_ok) {
-            ib_log_error_tx(tx, "Failed to add confidence.");
-            goto failure;
-        }
+        ib_json_writer_nulstr(writer, "suppress");
+        ib_json_writer_nulstr(writer,
+                              ib_logevent_suppress_name(e->suppress));
 
-        /* Severity. */
-        yajl_status =
-            yajl_gen_string(yajl_handle, (unsigned char *)"severity", 8);
-        if (yajl_status != yajl_gen_status_ok) {
-            ib_log_error_tx(tx, "Failed to add severity.");
-            goto failure;
-        }
+        ib_json_writer_nulstr(writer, "rec-action");
+        ib_json_writer_nulstr(writer,
+                              ib_logevent_action_name(e->rec_action));
 
-        yajl_status = yajl_gen_double(yajl_handle, e->severity);
-        if (yajl_status != yajl_gen_status_ok) {
-            ib_log_error_tx(tx, "Failed to add severity.");
-            goto failure;
-        }
+        ib_json_writer_nulstr(writer, "confidence");
+        ib_json_writer_float(writer, e->confidence);
 
-        /* Tag List. */
-        yajl_status =
-            yajl_gen_string(yajl_handle, (unsigned char *)"tags", 4);
-        if (yajl_status != yajl_gen_status_ok) {
-            ib_log_error_tx(tx, "Failed to add tags.");
-            goto failure;
-        }
-
-        yajl_status = yajl_gen_array_open(yajl_handle);
-        if (yajl_status != yajl_gen_status_ok) {
-            ib_log_error_tx(tx, "Failed to open tag JSON array.");
-            goto failure;
-        }
+        ib_json_writer_nulstr(writer, "severity");
+        ib_json_writer_float(writer, e->severity);
 
+        ib_json_writer_nulstr(writer, "tags");
+        ib_json_writer_array_open(writer);
         if (e->tags != NULL) {
             const ib_list_node_t *tag_node;
             IB_LIST_LOOP_CONST(e->tags, tag_node) {
-                const char *tag_name =
-                    (const char *)ib_list_node_data_const(tag_node);
-
-                yajl_status = yajl_gen_string(
-                    yajl_handle,
-                    (unsigned char *)IB_S2SL(tag_name));
-                if (yajl_status != yajl_gen_status_ok) {
-                    ib_log_error_tx(
-                        tx, "Failed to add tag: %s", tag_name
-                    );
-                    return IB_EOTHER;
-                }
+                ib_json_writer_nulstr(
+                    writer,
+                    (const char *)ib_list_node_data_const(tag_node)
+                );
             }
         }
+        ib_json_writer_array_close(writer);
 
-        yajl_status = yajl_gen_array_close(yajl_handle);
-        if (yajl_status != yajl_gen_status_ok) {
-            ib_log_error_tx(tx, "Failed to close tag JSON array.");
-            goto failure;
-        }
-
-        /* Message. */
-        yajl_status = yajl_gen_string(yajl_handle, (unsigned char *)"msg", 3);
-        if (yajl_status != yajl_gen_status_ok) {
-            ib_log_error_tx(tx, "Failed to add event message.");
-            goto failure;
-        }
-
-        yajl_status = yajl_gen_string(
-            yajl_handle,
-            (unsigned char *)IB_S2SL(e->msg != NULL ? e->msg : "-"));
-        if (yajl_status != yajl_gen_status_ok) {
-            ib_log_error_tx(tx, "Failed to encode event message.");
-            goto failure;
-        }
-
-        /* Event Data. */
-        yajl_status = yajl_gen_string(yajl_handle, (unsigned char *)"data", 4);
-        if (yajl_status != yajl_gen_status_ok) {
-            ib_log_error_tx(tx, "Failed to add event data.");
-            goto failure;
-        }
-
-        yajl_status = yajl_gen_string(yajl_handle, e->data, e->data_len);
-        if (yajl_status != yajl_gen_status_ok) {
-            ib_log_error_tx(tx, "Failed to encode event data.");
-            goto failure;
-        }
-
-        /* Close event hash. */
-        yajl_status = yajl_gen_map_close(yajl_handle);
-        if (yajl_status != yajl_gen_status_ok) {
-            ib_log_error_tx(tx, "Failed to close event JSON map.");
-            goto failure;
-        }
-    }
+        ib_json_writer_nulstr(writer, "msg");
+        ib_json_writer_nulstr(writer, e->msg != NULL ? e->msg : "-");
 
-    yajl_status = yajl_gen_array_close(yajl_handle);
-    if (yajl_status != yajl_gen_status_ok) {
-        ib_log_error_tx(tx, "Failed to close events JSON array.");
-        goto failure;
-    }
+        ib_json_writer_nulstr(writer, "data");
+        ib_json_writer_string(writer, (const char *)e->data, e->data_len);
 
-    yajl_status = yajl_gen_map_close(yajl_handle);
-    if (yajl_status != yajl_gen_status_ok) {
-        ib_log_error_tx(tx, "Failed to close events JSON map.");
-        goto failure;
+        ib_json_writer_map_close(writer);
     }
 
-    yajl_status = yajl_gen_get_buf(
-        yajl_handle,
-        (const unsigned char **)chunk,
-        &chunk_len
-    );
-    if (yajl_status != yajl_gen_status_ok) {
-        ib_log_error_tx(tx, "Failed to generate event JSON.");
-        goto failure;
-    }
-
-    /* Signal that we should stop. */
-    part->gen_data = AUDITLOG_GEN_FINISHED;
-
-    return chunk_len;
+    ib_json_writer_array_close(writer);
+    ib_json_writer_map_close(writer);
 
-failure:
-    /* Signal that we should stop. */
-    part->gen_data = AUDITLOG_GEN_FINISHED;
-
-    return 0;
+    return ib_auditlog_gen_json_chunk(part, writer, chunk);
 }
 
 #define CORE_AUDITLOG_FORMAT "http-message/1"
@@ -3152,6 +3013,32 @@ static ib_status_t core_dir_param1(ib_cfgparser_t *cp,
             ib_mm_strdup(ib_engine_mm_config_get(ib), p1_unescaped);
         return IB_OK;
     }
+    else if (strcasecmp("ClockMode", name) == 0) {
+        if (strcasecmp("Precise", p1_unescaped) == 0) {
+            ib->clock_mode = IB_CLOCK_MODE_PRECISE;
+        }
+        else if (strcasecmp("Coarse", p1_unescaped) == 0) {
+            ib->clock_mode = IB_CLOCK_MODE_COARSE;
+        }
+        else if (strcasecmp("Cached", p1_unescaped) == 0) {
+            ib->clock_mode = IB_CLOCK_MODE_CACHED;
+        }
+        else {
+            ib_cfg_log_error(cp, "Unknown clock mode: %s", p1);
+            return IB_EINVAL;
+        }
+        return IB_OK;
+    }
+    else if (strcasecmp("ClockTickInterval", name) == 0) {
+        long long tick = atoll(p1_unescaped);
+
+        if (tick <= 0) {
+            ib_cfg_log_error(cp, "Invalid clock tick interval: %s", p1);
+            return IB_EINVAL;
+        }
+        ib->clock_tick = (ib_time_t)tick;
+        return IB_OK;
+    }
     else if (strcasecmp("ModuleBasePath", name) == 0) {
         rc = ib_core_context_config(ctx, &corecfg);
 
@@ -3970,6 +3857,18 @@ static IB_DIRMAP_INIT_STRUCTURE(core_directive_map) = {
         NULL
     ),
 
+    /* Clock */
+    IB_DIRMAP_INIT_PARAM1(
+        "ClockMode",
+        core_dir_param1,
+        NULL
+    ),
+    IB_DIRMAP_INIT_PARAM1(
+        "ClockTickInterval",
+        core_dir_param1,
+        NULL
+    ),
+
     /* Buffering */
     IB_DIRMAP_INIT_PARAM1(
         "RequestBuffering",
@@ -54,6 +54,7 @@ typedef struct {
     const ib_tx_t *tx;
     const ib_conn_t *conn;
     const ib_site_t *site;
+    char *tstamp;              /* IB_CLOCK_FMT_WIDTH bytes for timestamps. */
 } auditlog_callback_data_t;
 
 /* The default shell to use for piped commands. */
@@ -533,6 +534,10 @@ ib_status_t core_audit_write_part(ib_engine_t *ib,
         if (fwrite(chunk, chunk_size, 1, cfg->fp) != 1) {
             ib_log_error(ib,  "Failed to write audit log part.");
             fflush(cfg->fp);
+            /* Run the generator to its end so it can release resources. */
+            while (part->fn_gen(part, &chunk) != 0) {
+                /* Nothing to do. */
+            }
             return IB_EUNKNOWN;
         }
         cfg->parts_written++;
@@ -556,10 +561,20 @@ ib_status_t core_audit_write_footer(ib_engine_t *ib,
     return IB_OK;
 }
 
+/**
+ * Set @a str and @a len to a NUL terminated string or "-" if NULL.
+ */
+#define AUDIT_LINE_ITEM_STR(s) \
+    do { \
+        *str = ((s) != NULL) ? (s) : "-"; \
+        *len = strlen(*str); \
+    } while (0)
+
 static ib_status_t audit_add_line_item(const ib_logformat_t *lf,
                                        const ib_logformat_field_t *field,
                                        const void *cbdata,
-                                       const char **str)
+                                       const char **str,
+                                       size_t *len)
 {
     const auditlog_callback_data_t *logdata =
         (const auditlog_callback_data_t *)cbdata;
@@ -567,46 +582,42 @@ static ib_status_t audit_add_line_item(const ib_logformat_t *lf,
     switch (field->fchar) {
 
     case IB_LOG_FIELD_REMOTE_ADDR:
-        *str = logdata->tx->remote_ipstr;
+        AUDIT_LINE_ITEM_STR(logdata->tx->remote_ipstr);
         break;
     case IB_LOG_FIELD_LOCAL_ADDR:
-        *str = logdata->conn->local_ipstr;
+        AUDIT_LINE_ITEM_STR(logdata->conn->local_ipstr);
         break;
     case IB_LOG_FIELD_HOSTNAME:
-        *str = logdata->tx->hostname;
+        AUDIT_LINE_ITEM_STR(logdata->tx->hostname);
         break;
     case IB_LOG_FIELD_SITE_ID:
         if (logdata->site == NULL) {
-            *str = (char *)"-";
+            *str = "-";
+            *len = 1;
         }
         else {
-            *str = logdata->site->id;
+            AUDIT_LINE_ITEM_STR(logdata->site->id);
         }
         break;
     case IB_LOG_FIELD_SENSOR_ID:
         *str = logdata->log->ib->sensor_id;
+        *len = strnlen(*str, IB_UUID_LENGTH - 1);
         break;
     case IB_LOG_FIELD_TRANSACTION_ID:
         *str = logdata->tx->id;
+        *len = strnlen(*str, IB_UUID_LENGTH - 1);
         break;
     case IB_LOG_FIELD_TIMESTAMP:
-    {
-        char *tstamp = NULL;
         /* Prepare timestamp (only if needed) */
-        tstamp = (char *)ib_mm_alloc(logdata->log->mm, 30);
-        if (tstamp == NULL) {
-            return IB_EALLOC;
-        }
-
-        ib_clock_timestamp(tstamp, &logdata->tx->tv_created);
-        *str = tstamp;
+        ib_clock_timestamp(logdata->tstamp, &logdata->tx->tv_created);
+        AUDIT_LINE_ITEM_STR(logdata->tstamp);
         break;
-    }
     case IB_LOG_FIELD_LOG_FILE:
-        *str = logdata->cfg->fn;
+        AUDIT_LINE_ITEM_STR(logdata->cfg->fn);
         break;
     default:
         *str = "\n";
+        *len = 1;
         /* Not understood */
         return IB_EINVAL;
     }
@@ -634,6 +645,7 @@ static ib_status_t core_audit_get_index_line(ib_engine_t *ib,
     const ib_logformat_t *lf;
     ib_status_t rc;
     auditlog_callback_data_t cbdata;
+    char tstamp[IB_CLOCK_FMT_WIDTH];
 
     /* Get the site */
     rc = ib_context_site_get(log->ctx, &site);
@@ -654,8 +666,9 @@ static ib_status_t core_audit_get_index_line(ib_engine_t *ib,
     cbdata.tx = tx;
     cbdata.conn = conn;
     cbdata.site = site;
-    rc = ib_logformat_format(lf, line, line_size, line_len,
-                             audit_add_line_item, &cbdata);
+    cbdata.tstamp = tstamp;
+    rc = ib_logformat_write(lf, line, line_size, line_len,
+                            audit_add_line_item, &cbdata);
 
     return rc;
 }
@@ -667,14 +680,9 @@ ib_status_t core_audit_close(ib_engine_t *ib, ib_auditlog_t *log)
     ib_core_cfg_t *corecfg;
     ib_status_t ib_rc = IB_OK;
     int sys_rc;
-    char *line = NULL;
+    char line[LOGFORMAT_MAX_LINE_LENGTH + 2];
     size_t len = 0;
 
-    line = malloc(LOGFORMAT_MAX_LINE_LENGTH + 2);
-    if (line == NULL) {
-        return IB_EALLOC;
-    }
-
     /* Retrieve corecfg to get the AuditLogIndexFormat */
     ib_rc = ib_core_context_config(log->ctx, &corecfg);
     if (ib_rc != IB_OK) {
@@ -715,23 +723,22 @@ ib_status_t core_audit_close(ib_engine_t *ib, ib_auditlog_t *log)
     if ((cfg->index_fp != NULL) && (cfg->parts_written > 0)) {
         size_t written;
 
-        ib_rc = ib_lock_lock(log->ctx->auditlog->index_fp_lock);
-        if (ib_rc != IB_OK) {
-            goto cleanup;
-        }
-
+        /* Format the line before taking the lock; it needs only the tx. */
         ib_rc = core_audit_get_index_line(ib, log, line,
                                           LOGFORMAT_MAX_LINE_LENGTH,
                                           &len);
+        if ( (ib_rc != IB_ETRUNC) && (ib_rc != IB_OK) ) {
+            goto cleanup;
+        }
         line[len + 0] = '\n';
         line[len + 1] = '\0';
 
-        if ( (ib_rc != IB_ETRUNC) && (ib_rc != IB_OK) ) {
-            ib_lock_unlock(log->ctx->auditlog->index_fp_lock);
+        ib_rc = ib_lock_lock(log->ctx->auditlog->index_fp_lock);
+        if (ib_rc != IB_OK) {
             goto cleanup;
         }
 
-        written = fwrite(line, len, 1, cfg->index_fp);
+        written = fwrite(line, len + 1, 1, cfg->index_fp);
 
         if (written == 0) {
             sys_rc = errno;
@@ -754,8 +761,5 @@ ib_status_t core_audit_close(ib_engine_t *ib, ib_auditlog_t *log)
     }
 
 cleanup:
-    if (line != NULL) {
-        free(line);
-    }
     return ib_rc;
 }
@@ -43,6 +43,16 @@
 #include <ctype.h>
 #include <inttypes.h>
 
+/**
+ * Minimum number of networks for ipmatch to compile its set.
+ *
+ * A compiled IPv4 set costs at least 256 KiB (see
+ * ib_ipset4_init_compiled()), which only pays for long lists, e.g.,
+ * reputation lists.  IPv6 sets are always compiled as their size is
+ * proportional to the number of networks.
+ */
+#define IPMATCH4_COMPILE_THRESHOLD 1024
+
 /**
  * Perform a comparison of two inputs and store the boolean result in result.
  * @param[in] n1 Input number 1.
@@ -860,11 +870,21 @@ ib_status_t op_ipmatch_create(
     }
     assert(i == num_parameters);
 
-    rc = ib_ipset4_init(
-        ipset,
-        NULL, 0,
-        entries, num_parameters
-    );
+    if (num_parameters >= IPMATCH4_COMPILE_THRESHOLD) {
+        rc = ib_ipset4_init_compiled(
+            ipset,
+            NULL, 0,
+            entries, num_parameters,
+            mm
+        );
+    }
+    else {
+        rc = ib_ipset4_init(
+            ipset,
+            NULL, 0,
+            entries, num_parameters
+        );
+    }
     if (rc != IB_OK) {
         ib_log_error(ib,
             "Error initializing internal data: %s",
@@ -1073,10 +1093,11 @@ ib_status_t op_ipmatch6_create(
     }
     assert(i == num_parameters);
 
-    rc = ib_ipset6_init(
+    rc = ib_ipset6_init_compiled(
         ipset,
         NULL, 0,
-        entries, num_parameters
+        entries, num_parameters,
+        mm
     );
     if (rc != IB_OK) {
         ib_log_error(ib,
@@ -1229,6 +1250,8 @@ ib_status_t expand_field_num(
     const char *expanded;
     size_t expanded_len;
     ib_field_t *tmp_field;
+    ib_num_t num;
+    ib_float_t flt;
     ib_status_t rc;
 
     /* Expand */
@@ -1242,9 +1265,28 @@ ib_status_t expand_field_num(
         return rc;
     }
 
-    /* Wrap the string into a field and set it to the tmp_field.
-     * We will now try to expand tmp_field into a number. If we
-     * fail, we return tmp_field in *out_field. */
+    /* Parse the expansion in place as a number, then as a float. */
+    rc = ib_type_atoi_ex(expanded, expanded_len, 0, &num);
+    if (rc == IB_OK) {
+        return ib_field_create(
+            out_field,
+            tx->mm,
+            "expanded num", sizeof("expanded num"),
+            IB_FTYPE_NUM,
+            ib_ftype_num_in(&num));
+    }
+
+    rc = ib_type_atof_ex(expanded, expanded_len, &flt);
+    if (rc == IB_OK) {
+        return ib_field_create(
+            out_field,
+            tx->mm,
+            "expanded num", sizeof("expanded num"),
+            IB_FTYPE_FLOAT,
+            ib_ftype_float_in(&flt));
+    }
+
+    /* Wrap the string into a field. */
     rc = ib_field_create_bytestr_alias(
         &tmp_field,
         tx->mm,
@@ -1254,29 +1296,9 @@ ib_status_t expand_field_num(
         return rc;
     }
 
-    /* Attempt a num. */
-    rc = ib_field_convert(
-        tx->mm,
-        IB_FTYPE_NUM,
-        tmp_field,
-        out_field);
-    if (rc == IB_OK) {
-        return IB_OK;
-    }
-
-    /* Attempt a float. */
-    rc = ib_field_convert(
-        tx->mm,
-        IB_FTYPE_FLOAT,
-        tmp_field,
-        out_field);
-    if (rc == IB_OK) {
-        return IB_OK;
-    }
-
     /* We cannot convert the expanded string. Return the string. */
     *out_field = tmp_field;
-    return rc;
+    return IB_EINVAL;
 }
 
 /**
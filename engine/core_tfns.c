@@ -58,6 +58,9 @@ typedef ib_status_t (*ib_strmod_fn_t)(
 /**
  * String modification transformation core
  *
+ * If @a fn returns its input unchanged, @a fin itself is the output and
+ * nothing is allocated.
+ *
  * @param[in] mm Memory manager to use for allocations.
  * @param[in] fn Transformation function
  * @param[in] fin Input field.
@@ -116,6 +119,10 @@ static ib_status_t tfn_strmod(
         if (rc != IB_OK) {
             return rc;
         }
+        if (dout == din && dlen == ib_bytestr_length(bs)) {
+            *fout = fin;
+            return IB_OK;
+        }
         rc = ib_field_create_bytestr_alias(&fnew, mm,
                                            fin->name, fin->nlen,
                                            dout, dlen);
@@ -133,21 +140,18 @@ static ib_status_t tfn_strmod(
     return IB_OK;
 }
 
-/** Adapt ib_strlower() to ib_strmod_fn_t(). */
+/** Adapt ib_strlower_const() to ib_strmod_fn_t(). */
 static ib_status_t adapt_lower(
     ib_mm_t mm,
     const uint8_t  *data_in,  size_t  dlen_in,
     const uint8_t **data_out, size_t *dlen_out
 )
 {
-    uint8_t *out;
-    ib_status_t rc = ib_strlower(mm, data_in, dlen_in, &out);
+    ib_status_t rc = ib_strlower_const(mm, data_in, dlen_in, data_out);
     if (rc == IB_OK) {
         *dlen_out = dlen_in;
     }
 
-    *data_out = out;
-
     return rc;
 }
 
@@ -181,34 +185,48 @@ static ib_status_t adapt_trim_lr(
     return ib_strtrim_lr(data_in, dlen_in, data_out, dlen_out);
 }
 
-/** Adapt ib_str_whitespace_remove() to ib_strmod_fn_t(). */
+/** Adapt ib_str_whitespace_remove_const() to ib_strmod_fn_t(). */
 static ib_status_t adapt_whitespace_remove(
     ib_mm_t mm,
     const uint8_t  *data_in,  size_t  dlen_in,
     const uint8_t **data_out, size_t *dlen_out
 )
 {
-    uint8_t *out = NULL;
-    ib_status_t rc;
-    rc = ib_str_whitespace_remove(mm, data_in, dlen_in, &out, dlen_out);
-    *data_out = out;
-
-    return rc;
+    return ib_str_whitespace_remove_const(
+        mm, data_in, dlen_in, data_out, dlen_out);
 }
 
-/** Adapt ib_str_whitespace_compress() to ib_strmod_fn_t(). */
+/** Adapt ib_str_whitespace_compress_const() to ib_strmod_fn_t(). */
 static ib_status_t adapt_whitespace_compress(
     ib_mm_t mm,
     const uint8_t  *data_in,  size_t  dlen_in,
     const uint8_t **data_out, size_t *dlen_out
 )
 {
-    uint8_t *out = NULL;
-    ib_status_t rc;
-    rc = ib_str_whitespace_compress(mm, data_in, dlen_in, &out, dlen_out);
-    *data_out = out;
+    return ib_str_whitespace_compress_const(
+        mm, data_in, dlen_in, data_out, dlen_out);
+}
 
-    return rc;
+/** Adapt ib_util_decode_url_const() to ib_strmod_fn_t(). */
+static ib_status_t adapt_url_decode(
+    ib_mm_t mm,
+    const uint8_t  *data_in,  size_t  dlen_in,
+    const uint8_t **data_out, size_t *dlen_out
+)
+{
+    return ib_util_decode_url_const(
+        mm, data_in, dlen_in, data_out, dlen_out);
+}
+
+/** Adapt ib_util_decode_html_entity_const() to ib_strmod_fn_t(). */
+static ib_status_t adapt_html_entity_decode(
+    ib_mm_t mm,
+    const uint8_t  *data_in,  size_t  dlen_in,
+    const uint8_t **data_out, size_t *dlen_out
+)
+{
+    return ib_util_decode_html_entity_const(
+        mm, data_in, dlen_in, data_out, dlen_out);
 }
 
 /**
@@ -761,68 +779,11 @@ static ib_status_t tfn_url_decode(
     void              *instdata,
     void              *fndata
 ) {
-    assert(fin != NULL);
-    assert(fout != NULL);
-
-    ib_status_t rc;
-    ib_field_t *fnew;
-
-    /* Initialize the output field pointer */
-    *fout = NULL;
-
-    switch(fin->type) {
-    case IB_FTYPE_BYTESTR:
-    {
-        const ib_bytestr_t *bs;
-        const uint8_t      *din;
-        uint8_t            *dout;
-        size_t              dlen;
-
-        rc = ib_field_value(fin, ib_ftype_bytestr_out(&bs));
-        if (rc != IB_OK) {
-            return rc;
-        }
-        if (bs == NULL) {
-            return IB_EINVAL;
-        }
-
-        din  = ib_bytestr_const_ptr(bs);
-        dlen = ib_bytestr_length(bs);
-
-        if (dlen == 0) {
-            *fout = fin;
-            return IB_OK;
-        }
-
-        dout = ib_mm_alloc(mm, dlen + 1);
-        if (dout == NULL) {
-            return IB_EALLOC;
-        }
-        if (din == NULL && dlen > 0) {
-            return IB_EINVAL;
-        }
-        if (din != NULL) {
-            rc = ib_util_decode_url(din, dlen, dout, &dlen);
-            if (rc != IB_OK) {
-                return rc;
-            }
-        }
-        rc = ib_field_create_bytestr_alias(&fnew, mm,
-                                           fin->name, fin->nlen,
-                                           dout, dlen);
-        if (rc != IB_OK) {
-            return rc;
-        }
-        break;
-    }
-    default:
-        return IB_EINVAL;
-    } /* switch(fin->type) */
-
-    /* When we reach this point rc==IB_OK. Commit the output value. */
-    *fout = fnew;
+    ib_status_t rc = tfn_strmod(mm,
+                                adapt_url_decode,
+                                fin, fout);
 
-    return IB_OK;
+    return rc;
 }
 
 /**
@@ -843,67 +804,11 @@ static ib_status_t tfn_html_entity_decode(
     void              *instdata,
     void              *fndata
 ) {
-    assert(fin != NULL);
-    assert(fout != NULL);
-
-    ib_status_t rc;
-    ib_field_t *fnew;
-
-    /* Initialize the output field pointer */
-    *fout = NULL;
-
-    switch(fin->type) {
-    case IB_FTYPE_BYTESTR:
-    {
-        const ib_bytestr_t *bs;
-        const uint8_t      *din;
-        uint8_t            *dout;
-        size_t              dlen;
-
-        rc = ib_field_value(fin, ib_ftype_bytestr_out(&bs));
-        if (rc != IB_OK) {
-            return rc;
-        }
-        if (bs == NULL) {
-            return IB_EINVAL;
-        }
-
-        dlen = ib_bytestr_length(bs);
-        if (dlen == 0) {
-            *fout = fin;
-            return IB_OK;
-        }
-
-        din = ib_bytestr_const_ptr(bs);
-        if (din == NULL) {
-            return IB_EINVAL;
-        }
-
-        dout = ib_mm_alloc(mm, dlen);
-        if (dout == NULL) {
-            return IB_EALLOC;
-        }
-
-        rc = ib_util_decode_html_entity(din, dlen, dout, &dlen);
-        if (rc != IB_OK) {
-            return rc;
-        }
-        rc = ib_field_create_bytestr_alias(&fnew, mm,
-                                           fin->name, fin->nlen,
-                                           dout, dlen);
-        if (rc != IB_OK) {
-            return rc;
-        }
-        break;
-    }
-    default:
-        return IB_EINVAL;
-    } /* switch(fin->type) */
-
-    /* When we reach this point, rc==IB_OK. Commit the output values. */
-    *fout = fnew;
+    ib_status_t rc = tfn_strmod(mm,
+                                adapt_html_entity_decode,
+                                fin, fout);
 
-    return IB_OK;
+    return rc;
 }
 
 /**
@@ -498,6 +498,7 @@ static ib_status_t create_header_alias_list(
                             ib_status_to_string(rc));
             return rc;
         }
+        ib_var_field_atom_set(ib_var_store_config(tx->var_store), f);
 
         /* Add the field to the list */
         rc = ib_list_push(header_list, f);
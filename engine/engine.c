@@ -382,6 +382,12 @@ ib_status_t ib_engine_create(ib_engine_t **pib,
         return rc;
     }
 
+    /* Create the lock protecting reset connection pools. */
+    rc = ib_lock_create(&(ib->conn_pools_lock), mm);
+    if (rc != IB_OK) {
+        goto failed;
+    }
+
     /* Create temporary memory pool */
     rc = ib_mpool_create(&(ib->temp_mp),
                          "temp",
@@ -448,6 +454,10 @@ ib_status_t ib_engine_create(ib_engine_t **pib,
     ib->sensor_version = IB_PRODUCT_VERSION_NAME;
     ib->sensor_hostname = IB_DSTR_UNKNOWN;
 
+    /* Clock. */
+    ib->clock_mode = IB_CLOCK_MODE_PRECISE;
+    ib->clock_tick = IB_CLOCK_TICK_DEFAULT;
+
     /* Create the instance UUID */
     rc = ib_uuid_create_v4(ib->instance_id);
     if (rc != IB_OK) {
@@ -677,6 +687,24 @@ ib_status_t ib_engine_config_finished(ib_engine_t *ib)
         }
     }
 
+    /* Apply the clock mode; cached mode needs the ticker running. */
+    if (rc == IB_OK && ib->clock_mode == IB_CLOCK_MODE_CACHED) {
+        rc = ib_clock_ticker_start(ib->clock_tick);
+        if (rc != IB_OK) {
+            ib_log_error(ib, "Failed to start the clock ticker: %s",
+                         ib_status_to_string(rc));
+        }
+        else {
+            ib->clock_ticker = true;
+        }
+    }
+    if (rc == IB_OK) {
+        ib_clock_mode_set(ib->clock_mode);
+    }
+
+    /* No more names are interned; transactions only look them up. */
+    ib_atom_table_freeze(ib_var_config_atoms(ib->var_config));
+
     /* Clear config parser pointer */
     ib->cfgparser = NULL;
     ib->cfg_state = CFG_FINISHED;
@@ -945,6 +973,9 @@ void ib_engine_destroy(ib_engine_t *ib)
 
     /// @todo Destroy filters
 
+    /* While rules and logging still work. */
+    ib_rule_profile_shutdown(ib);
+
     IB_LIST_LOOP_REVERSE(ib->contexts, node) {
         ib_context_t *ctx = (ib_context_t *)ib_list_node_data(node);
         if ( (ctx != ib->ctx) && (ctx != ib->ectx) ) {
@@ -971,6 +1002,17 @@ void ib_engine_destroy(ib_engine_t *ib)
     /* Close the loggers. */
     ib_logger_close(ib->logger);
 
+    if (ib->clock_ticker) {
+        ib_clock_ticker_stop(ib->clock_tick);
+        ib->clock_ticker = false;
+    }
+
+    /* Destroy reset connection pools. */
+    for (size_t i = 0; i < ib->num_conn_pools; ++i) {
+        ib_mpool_destroy(ib->conn_pools[i]);
+    }
+    ib->num_conn_pools = 0;
+
 #ifdef IB_DEBUG_MEMORY
     /* We can't use ib_engine_pool_destroy here as too little of the
      * the engine is left.
@@ -1013,12 +1055,23 @@ ib_status_t ib_conn_create(ib_engine_t *ib,
     ib_conn_t *conn = NULL;
     ib_mm_t mm;
 
-    /* Create a sub-pool for each connection and allocate from it */
+    /* Create a sub-pool for each connection and allocate from it, reusing
+     * the pool of a destroyed connection if available. */
     /// @todo Need to tune the pool size
-    rc = ib_mpool_create(&pool, "conn", NULL);
-    if (rc != IB_OK) {
-        rc = IB_EALLOC;
-        goto failed;
+    pool = NULL;
+    if (ib_lock_lock(ib->conn_pools_lock) == IB_OK) {
+        if (ib->num_conn_pools > 0) {
+            pool = ib->conn_pools[--ib->num_conn_pools];
+        }
+        ib_lock_unlock(ib->conn_pools_lock);
+    }
+    if (pool == NULL) {
+        /* Named below. */
+        rc = ib_mpool_create(&pool, NULL, NULL);
+        if (rc != IB_OK) {
+            rc = IB_EALLOC;
+            goto failed;
+        }
     }
     mm = ib_mm_mpool(pool);
 
@@ -1104,8 +1157,33 @@ void ib_conn_destroy(ib_conn_t *conn)
 {
     /// @todo Probably need to update state???
     if ( conn != NULL && conn->mp != NULL ) {
-        ib_engine_pool_destroy(conn->ib, conn->mp);
+        ib_engine_t *ib = conn->ib;
+        ib_mpool_t  *mp = conn->mp;
+        bool         kept = false;
+
+#ifdef IB_DEBUG_MEMORY
+        ib_engine_pool_debug(ib, mp);
+#endif
+
+        /* Reset the pool, and with it the released pools of all
+         * transactions, for the next connection.  Cleanups run now. */
+        ib_mpool_reset(mp);
         /* Don't do this: conn->mp = NULL; conn is now freed memory! */
+
+        /* A pool that grew large keeps its pages; don't hold on to it. */
+        if (
+            ib_mpool_footprint(mp) <= IB_ENGINE_CONN_POOL_FOOTPRINT &&
+            ib_lock_lock(ib->conn_pools_lock) == IB_OK
+        ) {
+            if (ib->num_conn_pools < IB_ENGINE_CONN_POOLS) {
+                ib->conn_pools[ib->num_conn_pools++] = mp;
+                kept = true;
+            }
+            ib_lock_unlock(ib->conn_pools_lock);
+        }
+        if (! kept) {
+            ib_mpool_destroy(mp);
+        }
     }
 }
 
@@ -1137,9 +1215,9 @@ ib_status_t ib_tx_create(ib_tx_t **ptx,
     /* Create a sub-pool from the connection memory pool for each
      * transaction and allocate from it.
      *
-     * Preallocate some pages.
+     * Preallocate some pages.  The pool is named below.
      */
-    rc = ib_mpool_create(&pool, "tx", conn->mp);
+    rc = ib_mpool_create(&pool, NULL, conn->mp);
     if (rc != IB_OK) {
         rc = IB_EALLOC;
         goto failed;
@@ -96,7 +96,15 @@ struct ib_manager_t {
     ib_manager_engine_t **engine_list;
     size_t                engine_count;   /**< Current count of engines */
     size_t                max_engines;    /**< The maximum number of engines */
-    ib_lock_t            *manager_lck;    /**< Protect access to the mgr. */
+    /**
+     * Protect access to the manager.
+     *
+     * Acquiring and releasing engines only read the engine list and name
+     * map and take this for reading; they update
+     * ib_manager_engine_t::ref_count atomically. Everything else takes it
+     * for writing.
+     */
+    ib_rwlock_t          *manager_lck;
 
     /**
      * A mapping from a name (const char *) to an ib_manager_engine_t *.
@@ -140,6 +148,9 @@ struct ib_manager_engine_t {
      * represents the manager's use of that engine as the current engine.
      * Other engines may have a reference count as low as zero. If an
      * engine's reference count is zero, it may be cleaned up.
+     *
+     * Holders of a read lock on ib_manager_t::manager_lck must update
+     * this atomically.
      */
     size_t        ref_count;
 
@@ -340,12 +351,7 @@ ib_status_t ib_manager_create(
     }
 
     /* Create the locks */
-    manager->manager_lck = ib_mm_alloc(mm, sizeof(*(manager->manager_lck)));
-    if (manager->manager_lck == NULL) {
-        rc = IB_EALLOC;
-        goto cleanup;
-    }
-    rc = ib_lock_create(&(manager->manager_lck), mm);
+    rc = ib_rwlock_create(&(manager->manager_lck), mm);
     if (rc != IB_OK) {
         goto cleanup;
     }
@@ -682,7 +688,7 @@ ib_status_t ib_manager_engine_create(
     ib_manager_engine_t *wrapper = NULL;
 
     /* Grab the engine creation lock to serialize engine creation. */
-    rc = ib_lock_lock(manager->manager_lck);
+    rc = ib_rwlock_wrlock(manager->manager_lck);
     if (rc != IB_OK) {
         goto cleanup;
     }
@@ -714,7 +720,7 @@ ib_status_t ib_manager_engine_create(
 cleanup:
 
     /* Release any locks. */
-    ib_lock_unlock(manager->manager_lck);
+    ib_rwlock_unlock(manager->manager_lck);
 
     return rc;
 }
@@ -727,7 +733,7 @@ ib_status_t ib_manager_enable(
 
     ib_status_t rc;
 
-    rc = ib_lock_lock(manager->manager_lck);
+    rc = ib_rwlock_wrlock(manager->manager_lck);
     if (rc != IB_OK) {
         goto cleanup;
     }
@@ -736,7 +742,7 @@ ib_status_t ib_manager_enable(
 
 cleanup:
     /* Release any locks. */
-    ib_lock_unlock(manager->manager_lck);
+    ib_rwlock_unlock(manager->manager_lck);
 
     return rc;
 }
@@ -764,7 +770,7 @@ ib_status_t ib_manager_disable(
         goto cleanup;
     }
 
-    rc = ib_lock_lock(manager->manager_lck);
+    rc = ib_rwlock_wrlock(manager->manager_lck);
     if (rc != IB_OK) {
         goto cleanup;
     }
@@ -786,7 +792,7 @@ ib_status_t ib_manager_disable(
 cleanup:
 
     /* Release the lock. */
-    ib_lock_unlock(manager->manager_lck);
+    ib_rwlock_unlock(manager->manager_lck);
 
 
     const ib_list_node_t *node;
@@ -886,7 +892,7 @@ ib_status_t ib_manager_engine_acquire(
     ib_manager_engine_t *engine = NULL;
 
     /* Grab the engine list lock */
-    rc = ib_lock_lock(manager->manager_lck);
+    rc = ib_rwlock_rdlock(manager->manager_lck);
     if (rc != IB_OK) {
         return rc;
     }
@@ -901,7 +907,7 @@ ib_status_t ib_manager_engine_acquire(
     if (rc == IB_OK) {
 
         /* Increment and return the engine. */
-        ++(engine->ref_count);
+        __atomic_add_fetch(&(engine->ref_count), 1, __ATOMIC_RELAXED);
         *pengine = engine->engine;
 
         rc = IB_OK;
@@ -910,7 +916,7 @@ ib_status_t ib_manager_engine_acquire(
         rc = IB_DECLINED;
     }
 
-    ib_lock_unlock(manager->manager_lck);
+    ib_rwlock_unlock(manager->manager_lck);
     return rc;
 }
 
@@ -926,7 +932,7 @@ ib_status_t ib_manager_engine_release(
     ib_manager_engine_t *managed_engine = NULL;
 
     /* Grab the engine list lock */
-    rc = ib_lock_lock(manager->manager_lck);
+    rc = ib_rwlock_rdlock(manager->manager_lck);
     if (rc != IB_OK) {
         return rc;
     }
@@ -947,11 +953,13 @@ ib_status_t ib_manager_engine_release(
     /* Found the engine in this manager. Release it. */
     if (managed_engine != NULL) {
 
-        /* Quick sanity check. Never release an unowned engine. */
-        assert(managed_engine->ref_count > 0);
-
         /* Release the engine. */
-        --(managed_engine->ref_count);
+        size_t ref_count = __atomic_sub_fetch(
+            &(managed_engine->ref_count), 1, __ATOMIC_RELAXED);
+
+        /* Quick sanity check. Never release an unowned engine. */
+        assert(ref_count != (size_t)-1);
+        (void)ref_count;
 
         rc = IB_OK;
     }
@@ -962,7 +970,7 @@ ib_status_t ib_manager_engine_release(
     }
 
     /* Release the lock. */
-    ib_lock_unlock(manager->manager_lck);
+    ib_rwlock_unlock(manager->manager_lck);
 
     return rc;
 }
@@ -975,14 +983,14 @@ ib_status_t ib_manager_engine_cleanup(
     ib_status_t rc;
 
     /* Grab the engine list lock */
-    rc = ib_lock_lock(manager->manager_lck);
+    rc = ib_rwlock_wrlock(manager->manager_lck);
     if (rc != IB_OK) {
         return rc;
     }
 
     destroy_inactive_engines(manager);
 
-    ib_lock_unlock(manager->manager_lck);
+    ib_rwlock_unlock(manager->manager_lck);
 
     return IB_OK;
 }
@@ -1084,14 +1092,15 @@ ib_status_t DLL_PUBLIC ib_manager_engine_status(
     ib_manager_engine_status_t *engstat;
     ib_status_t                 rc;
 
-    /* Grab the engine creation lock to serialize engine creation. */
-    rc = ib_lock_lock(manager->manager_lck);
+    /* Reading the engine list only. */
+    rc = ib_rwlock_rdlock(manager->manager_lck);
     if (rc != IB_OK) {
         return rc;
     }
 
     engstat = ib_mm_alloc(mm, sizeof(*engstat) * manager->engine_count);
     if (engstat == NULL) {
+        ib_rwlock_unlock(manager->manager_lck);
         return IB_EALLOC;
     }
 
@@ -1103,7 +1112,7 @@ ib_status_t DLL_PUBLIC ib_manager_engine_status(
 
         es->id        = ib_engine_instance_id(e->engine);
         es->uptime    = IB_CLOCK_SECS(time_now - e->created);
-        es->ref_count = e->ref_count;
+        es->ref_count = __atomic_load_n(&(e->ref_count), __ATOMIC_RELAXED);
 
         // FIXME - this is useless information.
         es->current   = false;
@@ -1112,8 +1121,7 @@ ib_status_t DLL_PUBLIC ib_manager_engine_status(
     *status = engstat;
     *status_len = manager->engine_count;
 
-    /* Grab the engine creation lock to serialize engine creation. */
-    rc = ib_lock_unlock(manager->manager_lck);
+    rc = ib_rwlock_unlock(manager->manager_lck);
 
     return rc;
 }
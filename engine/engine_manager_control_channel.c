@@ -31,6 +31,7 @@
 #include <ironbee/mm.h>
 #include <ironbee/mm_mpool_lite.h>
 #include <ironbee/mpool_lite.h>
+#include <ironbee/rule_profile.h>
 
 #ifdef HAVE_VALGRIND
 #include <valgrind/memcheck.h>
@@ -230,6 +231,68 @@ static ib_status_t manager_diag_valgrind_added(
     return IB_OK;
 }
 
+/**
+ * Control and report rule profiling of the current engine.
+ *
+ * @param[in] mm Memory manager for allocations of @a result and other
+ *            allocations that should live until the response is sent.
+ * @param[in] name The name this command is called by.
+ * @param[in] args One of @c on, @c off, @c reset or @c dump.  An empty
+ *            argument is the same as @c dump.
+ * @param[out] result For @c dump, the profile as JSON.
+ * @param[in] cbdata The @ref ib_manager_t * to act on.
+ *
+ * @sa ib_rule_profile_json()
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EINVAL If @a args is not understood.
+ * - IB_EALLOC On failure to allocate from @a mm a @a result.
+ * - Other if no engine could be acquired.
+ */
+static ib_status_t manager_diag_rule_profile(
+    ib_mm_t      mm,
+    const char  *name,
+    const char  *args,
+    const char **result,
+    void        *cbdata
+)
+{
+    assert(args != NULL);
+    assert(cbdata != NULL);
+
+    ib_manager_t *manager = (ib_manager_t *)cbdata;
+    ib_engine_t  *ib;
+    ib_status_t   rc;
+
+    rc = ib_manager_engine_acquire(manager, IB_MANAGER_ENGINE_NAME_ANY, &ib);
+    if (rc != IB_OK) {
+        *result = "No engine to profile.";
+        return rc;
+    }
+
+    if (strcmp(args, "on") == 0) {
+        ib_rule_profile_enable(ib, true);
+    }
+    else if (strcmp(args, "off") == 0) {
+        ib_rule_profile_enable(ib, false);
+    }
+    else if (strcmp(args, "reset") == 0) {
+        ib_rule_profile_reset(ib);
+    }
+    else if (*args == '\0' || strcmp(args, "dump") == 0) {
+        rc = ib_rule_profile_json(ib, mm, result, NULL);
+    }
+    else {
+        *result = "Expected one of on, off, reset or dump.";
+        rc = IB_EINVAL;
+    }
+
+    ib_manager_engine_release(manager, ib);
+
+    return rc;
+}
+
 
 /**
  * Disable manager command.
@@ -1172,6 +1235,7 @@ ib_status_t DLL_PUBLIC ib_engine_manager_control_manager_diag_register(
         const char                                 *name;
         ib_engine_manager_control_channel_cmd_fn_t  fn;
     } cmds[] = {
+        { "rule_profile",   manager_diag_rule_profile },
         { "valgrind",       manager_diag_valgrind },
         { "valgrind_added", manager_diag_valgrind_added },
         { "version",        manager_diag_version },
@@ -28,6 +28,7 @@
 #include "state_notify_private.h"
 
 #include <ironbee/array.h>
+#include <ironbee/clock.h>
 #include <ironbee/context_selection.h>
 #include <ironbee/lock.h>
 #include <ironbee/logger.h>
@@ -35,6 +36,26 @@
 
 #include <stdio.h>
 
+/**
+ * Maximum number of connection pools an engine keeps for reuse.
+ *
+ * A destroyed connection's pool, including the released pools of its
+ * transactions, is reset in place and kept for the next connection instead
+ * of being returned to malloc.
+ */
+#define IB_ENGINE_CONN_POOLS 64
+
+/**
+ * Maximum footprint, in bytes, of a connection pool kept for reuse.
+ *
+ * A reset pool keeps every page it held, so a pool that served a large
+ * connection is destroyed instead of being kept.  This bounds the memory
+ * held by the kept pools to IB_ENGINE_CONN_POOLS times this value.
+ *
+ * @sa ib_mpool_footprint()
+ */
+#define IB_ENGINE_CONN_POOL_FOOTPRINT (1024 * 1024)
+
 /**
  * Per-context audit log configuration.
  *
@@ -157,6 +178,9 @@ struct ib_engine_t {
     const char            *sensor_version;  /**< Sensor version string */
     const char            *sensor_hostname; /**< Sensor hostname */
     char                   instance_id[IB_UUID_LENGTH]; /**< Engine instance UUID */
+    ib_clock_mode_t        clock_mode;      /**< Configured clock mode */
+    ib_time_t              clock_tick;      /**< Clock ticker interval (usec) */
+    bool                   clock_ticker;    /**< Holds a clock ticker ref. */
     ib_cfgparser_t        *cfgparser;       /**< Our configuration parser */
 
     /// @todo Only these should be private
@@ -192,6 +216,11 @@ struct ib_engine_t {
 
     /* Where stream processor definitions are stored. */
     ib_stream_processor_registry_t *stream_processor_registry;
+
+    /* Reset connection pools for reuse by ib_conn_create(). */
+    ib_lock_t  *conn_pools_lock;  /**< Protects conn_pools. */
+    ib_mpool_t *conn_pools[IB_ENGINE_CONN_POOLS]; /**< Reset conn pools. */
+    size_t      num_conn_pools;   /**< Number of entries in conn_pools. */
 };
 
 /**
@@ -30,8 +30,51 @@
 #include <ironbee/type_convert.h>
 
 #include <assert.h>
+#include <sched.h>
+#include <stdint.h>
 #include <stdlib.h>
 
+/**
+ * A slot of a @ref logger_ring_t.
+ */
+struct logger_slot_t {
+    /**
+     * Sequence number.
+     *
+     * A slot at position @c pos may be written by the producer claiming
+     * @c pos when this is @c pos and may be read by the consumer when this
+     * is @c pos + 1.  Reading it sets it to @c pos + capacity.
+     */
+    size_t  seq;
+    void   *rec; /**< The record. */
+};
+typedef struct logger_slot_t logger_slot_t;
+
+/**
+ * Bounded multi-producer single-consumer ring of records.
+ *
+ * Producers claim a position by compare-and-swap on @c head and publish the
+ * record through the slot sequence number; they never take a lock unless
+ * the ring is full.  Consumers are serialized by @c consumer_lck.
+ *
+ * @c pending counts records published and not yet consumed.  The producer
+ * that takes it from 0 to 1 signals the writer with
+ * ib_logger_writer_t::record_fn, as the queue has gone from empty to
+ * non-empty.  A consumer drains until it takes @c pending to 0.
+ */
+struct logger_ring_t {
+    logger_slot_t   *slots;        /**< Slots; capacity is mask + 1. */
+    size_t           mask;         /**< Capacity - 1; capacity is 2^n. */
+    size_t           head;         /**< Next position to claim. */
+    size_t           tail;         /**< Next position to consume. */
+    long             pending;      /**< Published, unconsumed records. */
+    long             waiters;      /**< Producers blocked on a full ring. */
+    ib_lock_t       *consumer_lck; /**< Serialize consumers. */
+    ib_lock_t       *wait_lck;     /**< Guard @c wait_cond. */
+    ib_cond_t       *wait_cond;    /**< Signalled when space is available. */
+};
+typedef struct logger_ring_t logger_ring_t;
+
 /**
  * A collection of callbacks and function pointer that implement a logger.
  */
@@ -45,8 +88,7 @@ struct ib_logger_writer_t {
     ib_logger_format_t    *format;      /**< Format a message.  */
     ib_logger_record_fn_t  record_fn;   /**< Signal a record is ready. */
     void                  *record_data; /**< Callback data. */
-    ib_queue_t            *records;     /**< Records for the log writer. */
-    ib_lock_t             *records_lck; /**< Guard the queue. */
+    logger_ring_t          records;     /**< Records for the log writer. */
 };
 
 //! Identify the type of a logger callback function.
@@ -111,6 +153,21 @@ struct ib_logger_t {
      * retrieved to assist clients to this API to better share functions.
      */
      ib_hash_t *functions;
+
+    /**
+     * Capacity of the record queue of writers added later.
+     */
+    size_t queue_depth;
+
+    /**
+     * What a writer does with a record when its queue is full.
+     */
+    ib_logger_overflow_t overflow;
+
+    /**
+     * Number of records dropped because of a full queue.
+     */
+    size_t dropped;
 };
 
 /**
@@ -203,18 +260,265 @@ typedef struct logger_write_cbdata_t {
 } logger_write_cbdata_t;
 
 /**
- * The maximum depth of a message queue in a @ref ib_logger_writer_t.
+ * The default depth of a message queue in a @ref ib_logger_writer_t.
  */
-static const size_t MAX_QUEUE_DEPTH = 1000;
+static const size_t DEFAULT_QUEUE_DEPTH = 1024;
+
+/**
+ * Free a record of @a writer.
+ *
+ * @param[in] logger The logger.
+ * @param[in] writer The writer @a rec was formatted for.
+ * @param[in] rec The record.
+ */
+static void logger_record_free(
+    ib_logger_t        *logger,
+    ib_logger_writer_t *writer,
+    void               *rec
+)
+{
+    if (writer->format->format_free_fn != NULL) {
+        writer->format->format_free_fn(
+            logger,
+            rec,
+            writer->format->format_free_cbdata);
+    }
+}
+
+/**
+ * Wake producers waiting for space in @a ring, if any.
+ *
+ * @param[in] ring The ring.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - Other if locking or signaling failed.
+ */
+static ib_status_t logger_ring_wake(logger_ring_t *ring)
+{
+    ib_status_t rc;
+
+    if (__atomic_load_n(&ring->waiters, __ATOMIC_SEQ_CST) == 0) {
+        return IB_OK;
+    }
+
+    rc = ib_lock_lock(ring->wait_lck);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    rc = ib_cond_broadcast(ring->wait_cond);
+    ib_lock_unlock(ring->wait_lck);
+
+    return rc;
+}
+
+/**
+ * Remove the oldest record of @a ring.
+ *
+ * The caller must hold ring::consumer_lck and then wake waiting producers
+ * with logger_ring_wake().
+ *
+ * @param[in] ring The ring.
+ * @param[out] rec The record.
+ *
+ * @returns
+ * - true if a record was removed.
+ * - false if the oldest record is not yet published.
+ */
+static bool logger_ring_pop(logger_ring_t *ring, void **rec)
+{
+    size_t         pos  = ring->tail;
+    logger_slot_t *slot = &ring->slots[pos & ring->mask];
+
+    if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != pos + 1) {
+        return false;
+    }
+
+    *rec = slot->rec;
+    __atomic_store_n(&slot->seq, pos + ring->mask + 1, __ATOMIC_RELEASE);
+    ring->tail = pos + 1;
+    __atomic_sub_fetch(&ring->pending, 1, __ATOMIC_SEQ_CST);
+
+    return true;
+}
+
+/**
+ * Try to claim a position in @a ring and store @a rec there.
+ *
+ * @param[in] ring The ring.
+ * @param[in] rec The record.
+ *
+ * @returns
+ * - true if @a rec was stored.
+ * - false if @a ring is full.
+ */
+static bool logger_ring_try_push(logger_ring_t *ring, void *rec)
+{
+    size_t pos = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+
+    for (;;) {
+        logger_slot_t *slot = &ring->slots[pos & ring->mask];
+        size_t         seq  = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        intptr_t       dif  = (intptr_t)seq - (intptr_t)pos;
+
+        if (dif == 0) {
+            if (__atomic_compare_exchange_n(
+                    &ring->head, &pos, pos + 1, true,
+                    __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            {
+                slot->rec = rec;
+                __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+                return true;
+            }
+            /* Lost the race; pos now holds the current head. */
+        }
+        else if (dif < 0) {
+            return false;
+        }
+        else {
+            pos = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+/**
+ * True if @a ring is full.
+ *
+ * @param[in] ring The ring.
+ *
+ * @returns True if the next position to claim has not been consumed.
+ */
+static bool logger_ring_full(logger_ring_t *ring)
+{
+    size_t         pos  = __atomic_load_n(&ring->head, __ATOMIC_SEQ_CST);
+    logger_slot_t *slot = &ring->slots[pos & ring->mask];
+
+    return (intptr_t)__atomic_load_n(&slot->seq, __ATOMIC_SEQ_CST) -
+           (intptr_t)pos < 0;
+}
+
+/**
+ * Enqueue @a rec in the queue of @a writer.
+ *
+ * If the queue is full, ib_logger_t::overflow decides what happens.
+ *
+ * @param[in] logger The logger.
+ * @param[in] writer The writer.
+ * @param[in] rec The record.
+ *
+ * @returns
+ * - true if @a rec was enqueued and made the queue non-empty.
+ * - false otherwise.
+ */
+static bool logger_ring_push(
+    ib_logger_t        *logger,
+    ib_logger_writer_t *writer,
+    void               *rec
+)
+{
+    logger_ring_t *ring = &writer->records;
+
+    while (! logger_ring_try_push(ring, rec)) {
+        switch (__atomic_load_n(&logger->overflow, __ATOMIC_RELAXED)) {
+        case IB_LOGGER_OVERFLOW_DROP_NEWEST:
+            logger_record_free(logger, writer, rec);
+            __atomic_add_fetch(&logger->dropped, 1, __ATOMIC_RELAXED);
+            return false;
+
+        case IB_LOGGER_OVERFLOW_DROP_OLDEST: {
+            /* Act as the consumer for one record unless one is running. */
+            void *old;
+            bool  popped = false;
+
+            if (ib_lock_trylock(ring->consumer_lck) == IB_OK) {
+                popped = logger_ring_pop(ring, &old);
+                ib_lock_unlock(ring->consumer_lck);
+            }
+            if (popped) {
+                logger_ring_wake(ring);
+                logger_record_free(logger, writer, old);
+                __atomic_add_fetch(&logger->dropped, 1, __ATOMIC_RELAXED);
+            }
+            else {
+                sched_yield();
+            }
+            break;
+        }
+
+        case IB_LOGGER_OVERFLOW_BLOCK:
+        default:
+            ib_lock_lock(ring->wait_lck);
+            __atomic_add_fetch(&ring->waiters, 1, __ATOMIC_SEQ_CST);
+            while (logger_ring_full(ring)) {
+                ib_cond_wait(ring->wait_cond, ring->wait_lck);
+            }
+            __atomic_sub_fetch(&ring->waiters, 1, __ATOMIC_SEQ_CST);
+            ib_lock_unlock(ring->wait_lck);
+            break;
+        }
+    }
+
+    return __atomic_fetch_add(&ring->pending, 1, __ATOMIC_SEQ_CST) == 0;
+}
+
+/**
+ * Initialize @a ring with room for at least @a depth records.
+ *
+ * @param[in] ring The ring.
+ * @param[in] depth Minimum capacity.
+ * @param[in] mm Memory manager defining the lifetime of @a ring.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EALLOC On allocation failure.
+ * - Other on lock creation failure.
+ */
+static ib_status_t logger_ring_init(
+    logger_ring_t *ring,
+    size_t         depth,
+    ib_mm_t        mm
+)
+{
+    ib_status_t rc;
+    size_t      capacity = 2;
+
+    while (capacity < depth) {
+        capacity *= 2;
+    }
+
+    ring->slots = ib_mm_alloc(mm, capacity * sizeof(*ring->slots));
+    if (ring->slots == NULL) {
+        return IB_EALLOC;
+    }
+    for (size_t i = 0; i < capacity; ++i) {
+        ring->slots[i].seq = i;
+        ring->slots[i].rec = NULL;
+    }
+    ring->mask    = capacity - 1;
+    ring->head    = 0;
+    ring->tail    = 0;
+    ring->pending = 0;
+    ring->waiters = 0;
+
+    rc = ib_lock_create(&(ring->consumer_lck), mm);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    rc = ib_lock_create(&(ring->wait_lck), mm);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    return ib_cond_create(&(ring->wait_cond), mm);
+}
 
 /**
  * The implementation for logger_log().
  *
  * This function will
  * - Format the message stored in @a cbdata as a @ref logger_write_cbdata_t.
- * - Lock the message queue.
- * - Enqueue the formatted message.
- * - If the message is the only message in the queue,
+ * - Enqueue the formatted message without locking.
+ * - If the message made the queue non-empty,
  *   ib_logger_writer_t::record_fn is called to signal the
  *   writer that at least one record is available.
  *
@@ -258,43 +562,12 @@ static ib_status_t logger_write(
         return rc;
     }
 
-    rc = ib_lock_lock(writer->records_lck);
-    if (rc != IB_OK) {
-        return rc;
-    }
-
-    /* Busy-wait until the queue has space available.
-     * This is emergency code to avoid a crash at the cost of a slowdown. */
-    while (ib_queue_size(writer->records) >= MAX_QUEUE_DEPTH) {
-        rc = ib_lock_unlock(writer->records_lck);
-        if (rc != IB_OK) {
-            return rc;
-        }
-
-        /* TODO - The number of times we need to sleep should be
-         *        audited. It is a good indicator of excessive logging or
-         *        proxy load. */
-        sleep(1);
-        rc = ib_lock_lock(writer->records_lck);
-        if (rc != IB_OK) {
-            return rc;
-        }
-    }
-
-    rc = ib_queue_push_front(writer->records, rec);
-    if (rc != IB_OK) {
-        return rc;
+    /* If the queue went from empty to non-empty, notify the writer. */
+    if (logger_ring_push(logger, writer, rec)) {
+        return writer->record_fn(logger, writer, writer->record_data);
     }
 
-    /* If the queue is size=1, unlock and notify writers. */
-    if (ib_queue_size(writer->records) == 1) {
-        ib_lock_unlock(writer->records_lck);
-        rc = writer->record_fn(logger, writer, writer->record_data);
-        return rc;
-    }
-
-    ib_lock_unlock(writer->records_lck);
-    return rc;
+    return IB_OK;
 }
 
 /**
@@ -631,8 +904,11 @@ ib_status_t ib_logger_create(
         return IB_EALLOC;
     }
 
-    l->level = level;
-    l->mm = mm;
+    l->level       = level;
+    l->mm          = mm;
+    l->queue_depth = DEFAULT_QUEUE_DEPTH;
+    l->overflow    = IB_LOGGER_OVERFLOW_BLOCK;
+    l->dropped     = 0;
     rc = ib_list_create(&(l->writers), mm);
     if (rc != IB_OK) {
         return rc;
@@ -688,18 +964,10 @@ ib_status_t ib_logger_writer_add(
     writer->format      = format;
     writer->record_fn   = record_fn;
     writer->record_data = record_data;
-    rc = ib_queue_create(&(writer->records), logger->mm, IB_QUEUE_NEVER_SHRINK);
-    if (rc != IB_OK) {
-        return rc;
-    }
-    writer->records_lck = ib_mm_alloc(
-        logger->mm,
-        sizeof(*(writer->records_lck)));
-    if (writer->records_lck == NULL) {
-        return IB_EALLOC;
-    }
-    rc = ib_lock_create(&(writer->records_lck), logger->mm)
-    ;
+    rc = logger_ring_init(
+        &(writer->records),
+        logger->queue_depth,
+        logger->mm);
     if (rc != IB_OK) {
         return rc;
     }
@@ -872,9 +1140,11 @@ ib_status_t ib_logger_dequeue(
 {
     assert(logger != NULL);
     assert(writer != NULL);
-    assert(writer->records != NULL);
+    assert(writer->records.slots != NULL);
 
     ib_status_t rc;
+    ib_status_t first_rc = IB_OK;
+    logger_ring_t *ring = &(writer->records);
     logger_handler_cbdata_t logger_handler_cbdata = {
         .logger    = logger,
         .user_fn   = handler,
@@ -883,19 +1153,59 @@ ib_status_t ib_logger_dequeue(
         .free_data = writer->format->format_free_cbdata
     };
 
-    rc = ib_lock_lock(writer->records_lck);
+    rc = ib_lock_lock(ring->consumer_lck);
     if (rc != IB_OK) {
         return rc;
     }
 
-    rc = ib_queue_dequeue_all_to_function(
-        writer->records,
-        logger_handler,
-        &logger_handler_cbdata);
+    /* Drain until every record counted in pending is consumed.  A record
+     * counted there may sit behind one claimed but not yet published; that
+     * producer is between two instructions, so yield to it.  An error does
+     * not stop the drain; the first one is returned. */
+    while (__atomic_load_n(&ring->pending, __ATOMIC_SEQ_CST) > 0) {
+        void *rec;
+
+        if (! logger_ring_pop(ring, &rec)) {
+            sched_yield();
+            continue;
+        }
+        rc = logger_ring_wake(ring);
+        if (rc != IB_OK && first_rc == IB_OK) {
+            first_rc = rc;
+        }
+        logger_handler(rec, &logger_handler_cbdata);
+    }
+
+    ib_lock_unlock(ring->consumer_lck);
 
-    ib_lock_unlock(writer->records_lck);
+    return first_rc;
+}
 
-    return rc;
+void ib_logger_queue_depth_set(
+    ib_logger_t *logger,
+    size_t       depth
+)
+{
+    assert(logger != NULL);
+
+    logger->queue_depth = depth;
+}
+
+void ib_logger_overflow_set(
+    ib_logger_t          *logger,
+    ib_logger_overflow_t  overflow
+)
+{
+    assert(logger != NULL);
+
+    __atomic_store_n(&logger->overflow, overflow, __ATOMIC_RELAXED);
+}
+
+size_t ib_logger_dropped(const ib_logger_t *logger)
+{
+    assert(logger != NULL);
+
+    return __atomic_load_n(&logger->dropped, __ATOMIC_RELAXED);
 }
 
 size_t ib_logger_writer_count(ib_logger_t *logger) {
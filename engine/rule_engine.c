@@ -566,13 +566,8 @@ ib_status_t ib_rule_exec_create(ib_tx_t *tx, ib_rule_exec_t **rule_exec)
         return rc;
     }
 
-    /* Create the phase rule list */
-    rc = ib_list_create(&(exec->phase_rules), tx->mm);
-    if (rc != IB_OK) {
-        ib_rule_log_tx_error(tx, "Failed to create phase rule list: %s",
-                             ib_status_to_string(rc));
-        return rc;
-    }
+    /* The phase rule list is only needed if rules are injected. */
+    exec->phase_rules = NULL;
 
     /* Create the value stack */
     rc = ib_list_create(&(exec->value_stack), tx->mm);
@@ -597,6 +592,9 @@ ib_status_t ib_rule_exec_create(ib_tx_t *tx, ib_rule_exec_t **rule_exec)
     exec->rule_status = IB_OK;
     exec->rule_result = 0;
     exec->exec_log = NULL;
+    exec->tfn_memo = NULL;
+    exec->tfn_memo_hits = 0;
+    exec->tfn_memo_misses = 0;
 
 #ifdef IB_RULE_TRACE
     exec->traces = ib_mm_calloc(
@@ -755,6 +753,246 @@ static void rule_exec_pop_value(ib_rule_exec_t *rule_exec,
     return;
 }
 
+/**
+ * Key of a result in @ref ib_rule_exec_t::tfn_memo.
+ *
+ * The key is followed by the parameters of the transformation instance, so
+ * that equal instances in different rules share results.
+ */
+typedef struct {
+    const ib_field_t          *in;  /**< Input field. */
+    const ib_transformation_t *tfn; /**< Transformation. */
+} tfn_memo_key_t;
+
+/** Longest key in @ref ib_rule_exec_t::tfn_memo. */
+#define TFN_MEMO_KEY_MAX 128
+
+/**
+ * A result in @ref ib_rule_exec_t::tfn_memo.
+ *
+ * Results are found by the identity of the input field, so the value of
+ * the input is recorded to notice a field that was changed since.
+ */
+typedef struct {
+    const ib_field_t *out;   /**< Result. */
+    const void       *value; /**< Value of the input. */
+    size_t            size;  /**< Size of the value of the input. */
+} tfn_memo_t;
+
+/**
+ * Record the current value of a field for @ref tfn_memo_t.
+ *
+ * Strings are recorded by pointer and length, numbers by value and lists
+ * by pointer and generation, see ib_list_generation().
+ *
+ * @param[in]  field Field.
+ * @param[out] value Value pointer or number.
+ * @param[out] size Length of @a value.
+ *
+ * @returns true if transformation results of @a field can be memoized.
+ */
+static bool tfn_memo_stamp(const ib_field_t  *field,
+                           const void       **value,
+                           size_t            *size)
+{
+    if (ib_field_is_dynamic(field)) {
+        return false;
+    }
+
+    switch (field->type) {
+        case IB_FTYPE_BYTESTR: {
+            const ib_bytestr_t *bs;
+
+            if (ib_field_value(field, ib_ftype_bytestr_out(&bs)) != IB_OK) {
+                return false;
+            }
+            *value = (bs == NULL) ? NULL : ib_bytestr_const_ptr(bs);
+            *size  = (bs == NULL) ? 0 : ib_bytestr_length(bs);
+            return true;
+        }
+        case IB_FTYPE_NULSTR: {
+            const char *str;
+
+            if (ib_field_value(field, ib_ftype_nulstr_out(&str)) != IB_OK) {
+                return false;
+            }
+            *value = str;
+            *size  = 0;
+            return true;
+        }
+        case IB_FTYPE_NUM: {
+            ib_num_t num;
+
+            if (ib_field_value(field, ib_ftype_num_out(&num)) != IB_OK) {
+                return false;
+            }
+            *value = NULL;
+            *size  = (size_t)num;
+            return true;
+        }
+        case IB_FTYPE_LIST: {
+            const ib_list_t *list;
+
+            if (ib_field_value(field, ib_ftype_list_out(&list)) != IB_OK) {
+                return false;
+            }
+            /* The element count misses a removal followed by an append. */
+            *value = list;
+            *size  = (list == NULL) ? 0 : ib_list_generation(list);
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+/**
+ * Execute a transformation, using and adding to the transaction's results.
+ *
+ * Lists that the transformation does not handle are unrolled here rather
+ * than by ib_transformation_inst_execute(), so that the results of their
+ * elements are memoized and shared by any list holding those elements,
+ * such as a filtered collection.
+ *
+ * @param[in] rule_exec The rule execution object.
+ * @param[in] tfn_inst The transformation instance to execute.
+ * @param[in] value Value to transform.
+ * @param[out] result Result.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ * - Any error of the transformation.
+ */
+static ib_status_t execute_tfn_memo(ib_rule_exec_t                  *rule_exec,
+                                    const ib_transformation_inst_t  *tfn_inst,
+                                    const ib_field_t                *value,
+                                    const ib_field_t               **result)
+{
+    assert(rule_exec != NULL);
+    assert(rule_exec->tx != NULL);
+    assert(value != NULL);
+
+    ib_mm_t                    mm  = rule_exec->tx->mm;
+    const ib_transformation_t *tfn =
+        ib_transformation_inst_transformation(tfn_inst);
+    const char                *params;
+    size_t                     params_len;
+    char                       key[TFN_MEMO_KEY_MAX];
+    size_t                     key_len;
+    tfn_memo_key_t             memo_key;
+    tfn_memo_t                *memo;
+    const void                *stamp_value;
+    size_t                     stamp_size;
+    const ib_field_t          *out;
+    ib_status_t                rc;
+
+    if (value->type == IB_FTYPE_LIST && ! ib_transformation_handle_list(tfn)) {
+        const ib_list_t      *value_list;
+        const ib_list_node_t *node;
+        ib_list_t            *out_list;
+        ib_field_t           *fnew;
+
+        rc = ib_field_value(value, ib_ftype_list_out(&value_list));
+        if (rc != IB_OK) {
+            return rc;
+        }
+        rc = ib_list_create(&out_list, mm);
+        if (rc != IB_OK) {
+            return rc;
+        }
+        IB_LIST_LOOP_CONST(value_list, node) {
+            rc = execute_tfn_memo(
+                rule_exec,
+                tfn_inst,
+                (const ib_field_t *)ib_list_node_data_const(node),
+                &out);
+            if (rc != IB_OK) {
+                return rc;
+            }
+            rc = ib_list_push(out_list, (void *)out);
+            if (rc != IB_OK) {
+                return rc;
+            }
+        }
+        rc = ib_field_create(&fnew, mm,
+                             value->name, value->nlen,
+                             IB_FTYPE_LIST, ib_ftype_list_in(out_list));
+        if (rc != IB_OK) {
+            return rc;
+        }
+        *result = fnew;
+        return IB_OK;
+    }
+
+    params = ib_transformation_inst_parameters(tfn_inst);
+    params_len = (params == NULL) ? 0 : strlen(params);
+    if (
+        sizeof(memo_key) + params_len > sizeof(key) ||
+        ! tfn_memo_stamp(value, &stamp_value, &stamp_size)
+    ) {
+        return ib_transformation_inst_execute(tfn_inst, mm, value, result);
+    }
+
+    memo_key.in = value;
+    memo_key.tfn = tfn;
+    memcpy(key, &memo_key, sizeof(memo_key));
+    if (params_len > 0) {
+        memcpy(key + sizeof(memo_key), params, params_len);
+    }
+    key_len = sizeof(memo_key) + params_len;
+
+    if (rule_exec->tfn_memo == NULL) {
+        rc = ib_hash_create(&rule_exec->tfn_memo, mm);
+        if (rc != IB_OK) {
+            return rc;
+        }
+        memo = NULL;
+    }
+    else if (
+        ib_hash_get_ex(rule_exec->tfn_memo, &memo, key, key_len) != IB_OK
+    ) {
+        memo = NULL;
+    }
+
+    if (
+        memo != NULL &&
+        memo->value == stamp_value &&
+        memo->size == stamp_size
+    ) {
+        ++rule_exec->tfn_memo_hits;
+        *result = memo->out;
+        return IB_OK;
+    }
+
+    rc = ib_transformation_inst_execute(tfn_inst, mm, value, &out);
+    if (rc != IB_OK || out == NULL) {
+        *result = out;
+        return rc;
+    }
+
+    /* The hash keeps the key, so a new entry gets a copy. */
+    if (memo == NULL) {
+        char *key_copy = ib_mm_memdup(mm, key, key_len);
+
+        memo = ib_mm_alloc(mm, sizeof(*memo));
+        if (key_copy == NULL || memo == NULL) {
+            return IB_EALLOC;
+        }
+        rc = ib_hash_set_ex(rule_exec->tfn_memo, key_copy, key_len, memo);
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+    memo->out = out;
+    memo->value = stamp_value;
+    memo->size = stamp_size;
+    ++rule_exec->tfn_memo_misses;
+
+    *result = out;
+    return IB_OK;
+}
+
 /**
  * Execute a single transformation on a target.
  *
@@ -765,7 +1003,7 @@ static void rule_exec_pop_value(ib_rule_exec_t *rule_exec,
  *
  * @returns Status code
  */
-static ib_status_t execute_tfn_single(const ib_rule_exec_t  *rule_exec,
+static ib_status_t execute_tfn_single(ib_rule_exec_t        *rule_exec,
                                       const ib_transformation_inst_t   *tfn_inst,
                                       const ib_field_t      *value,
                                       const ib_field_t     **result)
@@ -776,7 +1014,7 @@ static ib_status_t execute_tfn_single(const ib_rule_exec_t  *rule_exec,
     ib_status_t       rc;
     const ib_field_t *out = NULL;
 
-    rc = ib_transformation_inst_execute(tfn_inst, rule_exec->tx->mm, value, &out);
+    rc = execute_tfn_memo(rule_exec, tfn_inst, value, &out);
     ib_rule_log_exec_tfn_value(rule_exec->exec_log, value, out, rc);
 
     if (rc != IB_OK) {
@@ -817,7 +1055,7 @@ static ib_status_t execute_tfn_single(const ib_rule_exec_t  *rule_exec,
  *
  * @returns Status code
  */
-static ib_status_t execute_tfns(const ib_rule_exec_t *rule_exec,
+static ib_status_t execute_tfns(ib_rule_exec_t *rule_exec,
                                 const ib_field_t *value,
                                 const ib_field_t **result)
 {
@@ -1956,6 +2194,58 @@ static ib_status_t execute_phase_rule_targets(ib_rule_exec_t *rule_exec)
     return rc;
 }
 
+/**
+ * Is any target of a rule present in the transaction?
+ *
+ * A target is present if its source is set and is not an empty collection.
+ * Dynamic collections are always considered present.
+ *
+ * @param[in] rule_exec Rule execution object
+ * @param[in] rule Rule to check
+ *
+ * @returns true if any target of @a rule is present, otherwise false
+ */
+static bool rule_targets_present(const ib_rule_exec_t *rule_exec,
+                                 const ib_rule_t *rule)
+{
+    assert(rule_exec != NULL);
+    assert(rule_exec->tx != NULL);
+    assert(rule != NULL);
+
+    const ib_list_node_t *node;
+
+    IB_LIST_LOOP_CONST(rule->target_fields, node) {
+        const ib_rule_target_t *target =
+            (const ib_rule_target_t *)ib_list_node_data_const(node);
+        const ib_field_t       *field;
+        const ib_list_t        *list;
+        ib_status_t             rc;
+
+        rc = ib_var_source_get_const(
+            ib_var_target_source(target->target),
+            &field,
+            rule_exec->tx->var_store
+        );
+        if (rc == IB_ENOENT) {
+            continue;
+        }
+        if (
+            rc != IB_OK ||
+            field->type != IB_FTYPE_LIST ||
+            ib_field_is_dynamic(field)
+        ) {
+            return true;
+        }
+
+        rc = ib_field_value(field, ib_ftype_list_out(&list));
+        if (rc != IB_OK || ib_list_elements(list) > 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 /**
  * Execute a single phase rule, it's actions, and it's chained rules.
  *
@@ -1971,6 +2261,9 @@ static ib_status_t execute_phase_rule(ib_rule_exec_t *rule_exec,
 {
     ib_status_t         rc = IB_OK;
     ib_status_t         trc;          /* Temporary status code */
+    ib_rule_profile_t  *profile = rule_exec->ib->rule_engine->profile;
+    bool                profiling = ib_rule_profile_active(profile);
+    ib_time_t           profile_start = 0;
 #ifdef IB_RULE_TRACE
     ib_time_t pre_time;
     ib_time_t post_time;
@@ -2014,12 +2307,32 @@ static ib_status_t execute_phase_rule(ib_rule_exec_t *rule_exec,
      * returns an error.  This needs further discussion to determine what the
      * correct behavior should be.
      */
+    /* A rule with no target present would do nothing; skip it. */
+    if (ib_flags_all(rule->flags, IB_RULE_FLAG_SKIP_ABSENT) &&
+        ! rule_targets_present(rule_exec, rule))
+    {
+        ib_rule_log_debug(rule_exec,
+                          "Rule not running because none of its "
+                          "targets are present.");
+        goto cleanup;
+    }
+
 #ifdef IB_RULE_TRACE
     if (rule->flags & IB_RULE_FLAG_TRACE) {
         pre_time = ib_clock_get_time();
     }
 #endif
+    if (profiling) {
+        profile_start = ib_rule_profile_clock();
+    }
     trc = execute_phase_rule_targets(rule_exec);
+    if (profiling) {
+        ib_rule_profile_record(
+            profile, rule,
+            ib_rule_profile_clock() - profile_start,
+            rule_exec->rule_result != 0
+        );
+    }
     if (trc != IB_OK) {
         rc = trc;
         goto cleanup;
@@ -2177,11 +2490,27 @@ static ib_status_t inject_rules(const ib_engine_t *ib,
     size_t                rule_count = 0;   /* Used only for trace debugging */
     ib_rule_phase_num_t   phase = phase_meta->phase_num;
 
+    if (rule_exec->phase_rules != NULL) {
+        ib_list_clear(rule_exec->phase_rules);
+    }
+
     injection_cbs = ib->rule_engine->injection_cbs[phase];
-    if (injection_cbs == NULL) {
+    if (injection_cbs == NULL || ib_list_elements(injection_cbs) == 0) {
         return IB_OK;
     }
 
+    if (rule_exec->phase_rules == NULL) {
+        ib_status_t rc;
+
+        rc = ib_list_create(&(rule_exec->phase_rules), rule_exec->tx->mm);
+        if (rc != IB_OK) {
+            ib_rule_log_tx_error(rule_exec->tx,
+                                 "Failed to create phase rule list: %s",
+                                 ib_status_to_string(rc));
+            return rc;
+        }
+    }
+
     IB_LIST_LOOP_CONST(injection_cbs, node) {
         const ib_rule_injection_cb_t *cb =
             (const ib_rule_injection_cb_t *)ib_list_node_data_const(node);
@@ -2241,37 +2570,68 @@ static ib_status_t inject_rules(const ib_engine_t *ib,
 }
 
 /**
- * Append context rules onto the rule execution object's phase rule list
+ * Iterate over the rules of a phase: injected rules, then context rules.
  *
- * @param[in] ib IronBee engine
- * @param[in] phase_meta Phase meta data
- * @param[in] rule_list List of context rules to append
- * @param[in,out] rule_exec Rule execution object
+ * @param[in] rule_exec Rule execution object
+ * @param[in] ruleset_phase Context's ruleset for the phase
+ * @param[in,out] node Next injected rule node; initialize to NULL
+ * @param[in,out] n Index of the next context rule; initialize to 0
  *
- * @returns Status code
+ * @returns The next rule, or NULL when there are none left.
  */
-static ib_status_t append_context_rules(const ib_engine_t *ib,
-                                        const ib_rule_phase_meta_t *phase_meta,
-                                        const ib_list_t *rule_list,
-                                        ib_rule_exec_t *rule_exec)
+static const ib_rule_t *next_phase_rule(
+    const ib_rule_exec_t      *rule_exec,
+    const ib_ruleset_phase_t  *ruleset_phase,
+    const ib_list_node_t     **node,
+    size_t                    *n
+)
 {
-    assert(ib != NULL);
-    assert(phase_meta != NULL);
     assert(rule_exec != NULL);
-    assert(rule_list != NULL);
-
-    const ib_list_node_t *node;
+    assert(ruleset_phase != NULL);
+    assert(node != NULL);
+    assert(n != NULL);
 
-    IB_LIST_LOOP_CONST(rule_list, node) {
-        const ib_rule_ctx_data_t *ctx_rule =
-            (const ib_rule_ctx_data_t *)ib_list_node_data_const(node);
+    const ib_rule_t *rule;
 
-        if (rule_is_runnable(ctx_rule)) {
-            ib_list_push(rule_exec->phase_rules, ctx_rule->rule);
+    /* Injected rules first. */
+    if (*n == 0 && rule_exec->phase_rules != NULL) {
+        *node = (*node == NULL) ?
+            ib_list_first_const(rule_exec->phase_rules) :
+            ib_list_node_next_const(*node);
+        if (*node != NULL) {
+            return (const ib_rule_t *)ib_list_node_data_const(*node);
         }
     }
 
-    return IB_OK;
+    if (*n >= ruleset_phase->rule_count) {
+        return NULL;
+    }
+    rule = ruleset_phase->rules[*n];
+    ++(*n);
+
+    return rule;
+}
+
+/**
+ * Get the number of rules of a phase: injected rules and context rules.
+ *
+ * @param[in] rule_exec Rule execution object
+ * @param[in] ruleset_phase Context's ruleset for the phase
+ *
+ * @returns Number of rules.
+ */
+static size_t phase_rule_count(
+    const ib_rule_exec_t     *rule_exec,
+    const ib_ruleset_phase_t *ruleset_phase
+)
+{
+    size_t count = ruleset_phase->rule_count;
+
+    if (rule_exec->phase_rules != NULL) {
+        count += ib_list_elements(rule_exec->phase_rules);
+    }
+
+    return count;
 }
 
 /**
@@ -2317,20 +2677,20 @@ static ib_status_t run_phase_rules(ib_engine_t *ib,
     ib_context_t               *ctx = tx->ctx;
     const ib_ruleset_phase_t   *ruleset_phase;
     ib_rule_exec_t             *rule_exec = tx->rule_exec;
-    const ib_list_t            *rules;
+    const ib_rule_t            *rule;
     const ib_list_node_t       *node = NULL;
+    size_t                      n = 0;
+    size_t                      count;
     ib_status_t                 rc = IB_OK;
 
     ruleset_phase = &(ctx->rules->ruleset.phases[meta->phase_num]);
     assert(ruleset_phase != NULL);
-    rules = ruleset_phase->rule_list;
-    assert(rules != NULL);
 
     /* Log the transaction event start */
     ib_rule_log_tx_event_start(rule_exec, state);
     ib_rule_log_phase(rule_exec,
                       meta->phase_num, phase_name(meta),
-                      ib_list_elements(rules));
+                      ruleset_phase->rule_count);
 
     /* Check if this phase should be skipped. */
     if (rule_allow(tx, meta, true)) {
@@ -2378,7 +2738,6 @@ static ib_status_t run_phase_rules(ib_engine_t *ib,
     /* Setup for rule execution */
     rule_exec->phase = meta->phase_num;
     rule_exec->is_stream = false;
-    ib_list_clear(rule_exec->phase_rules);
 
     /* Invoke all of the rule injectors */
     rc = inject_rules(ib, meta, rule_exec);
@@ -2386,14 +2745,9 @@ static ib_status_t run_phase_rules(ib_engine_t *ib,
         return IB_EINVAL;
     }
 
-    /* Add all of the enabled "normal" rules to the list */
-    rc = append_context_rules(ib, meta, rules, rule_exec);
-    if (rc != IB_OK) {
-        return IB_EINVAL;
-    }
-
     /* Walk through the rules & execute them */
-    if (ib_list_elements(rule_exec->phase_rules) == 0) {
+    count = phase_rule_count(rule_exec, ruleset_phase);
+    if (count == 0) {
         ib_rule_log_tx_debug(tx,
                              "No rules for phase %d/\"%s\" in context \"%s\"",
                              meta->phase_num, phase_name(meta),
@@ -2404,7 +2758,7 @@ static ib_status_t run_phase_rules(ib_engine_t *ib,
     ib_rule_log_tx_debug(tx,
                          "Executing %zd rules for phase %d/\"%s\" "
                          "in context \"%s\"",
-                         ib_list_elements(rule_exec->phase_rules),
+                         count,
                          meta->phase_num, phase_name(meta),
                          ib_context_full_get(ctx));
 
@@ -2415,10 +2769,10 @@ static ib_status_t run_phase_rules(ib_engine_t *ib,
      * returns an error.  This needs further discussion to determine what the
      * correct behavior should be.
      */
-    IB_LIST_LOOP_CONST(rule_exec->phase_rules, node) {
-        const ib_rule_t *rule =
-            (const ib_rule_t *)ib_list_node_data_const(node);
-        ib_status_t      rule_rc;
+    while ((rule = next_phase_rule(rule_exec, ruleset_phase, &node, &n))
+           != NULL)
+    {
+        ib_status_t rule_rc;
 
         assert(
             rule->meta.phase == meta->phase_num ||
@@ -2754,8 +3108,10 @@ static ib_status_t run_stream_rules(ib_engine_t *ib,
     ib_context_t             *ctx = tx->ctx;
     const ib_ruleset_phase_t *ruleset_phase =
         &(ctx->rules->ruleset.phases[meta->phase_num]);
-    ib_list_t                *rules = ruleset_phase->rule_list;
+    const ib_rule_t          *rule;
     const ib_list_node_t     *node = NULL;
+    size_t                    n = 0;
+    size_t                    count;
     ib_rule_exec_t           *rule_exec = tx->rule_exec;
     ib_status_t               rc;
 
@@ -2763,7 +3119,7 @@ static ib_status_t run_stream_rules(ib_engine_t *ib,
     ib_rule_log_tx_event_start(rule_exec, state);
     ib_rule_log_phase(rule_exec,
                       meta->phase_num, phase_name(meta),
-                      ib_list_elements(rules));
+                      ruleset_phase->rule_count);
 
     /* Allow (skip) this phase? Perhaps the whole TX is allowed? */
     if (rule_allow(tx, meta, false)) {
@@ -2782,7 +3138,6 @@ static ib_status_t run_stream_rules(ib_engine_t *ib,
     /* Setup for rule execution */
     rule_exec->phase = meta->phase_num;
     rule_exec->is_stream = true;
-    ib_list_clear(rule_exec->phase_rules);
 
     /* Invoke all of the rule injectors */
     rc = inject_rules(ib, meta, rule_exec);
@@ -2790,14 +3145,9 @@ static ib_status_t run_stream_rules(ib_engine_t *ib,
         return IB_EINVAL;
     }
 
-    /* Add all of the enabled "normal" rules to the list */
-    rc = append_context_rules(ib, meta, rules, rule_exec);
-    if (rc != IB_OK) {
-        return IB_EINVAL;
-    }
-
     /* Are there any rules?  If not, do a quick exit */
-    if (ib_list_elements(rule_exec->phase_rules) == 0) {
+    count = phase_rule_count(rule_exec, ruleset_phase);
+    if (count == 0) {
         ib_rule_log_debug(rule_exec,
                           "No rules for stream %d/\"%s\" in context \"%s\"",
                           meta->phase_num, phase_name(meta),
@@ -2807,7 +3157,7 @@ static ib_status_t run_stream_rules(ib_engine_t *ib,
     ib_rule_log_debug(rule_exec,
                       "Executing %zd rules for stream %d/\"%s\" "
                       "in context \"%s\"",
-                      ib_list_elements(rule_exec->phase_rules),
+                      count,
                       meta->phase_num, phase_name(meta),
                       ib_context_full_get(ctx));
 
@@ -2818,10 +3168,13 @@ static ib_status_t run_stream_rules(ib_engine_t *ib,
      * returns an error.  This needs further discussion to determine what the
      * correct behavior should be.
      */
-    IB_LIST_LOOP_CONST(rule_exec->phase_rules, node) {
-        const ib_rule_t    *rule =
-            (const ib_rule_t *)ib_list_node_data_const(node);
+    while ((rule = next_phase_rule(rule_exec, ruleset_phase, &node, &n))
+           != NULL)
+    {
         ib_status_t         trc;
+        bool                profiling =
+            ib_rule_profile_active(ib->rule_engine->profile);
+        ib_time_t           profile_start = 0;
 
         /* Reset status */
         rc = IB_OK;
@@ -2844,12 +3197,22 @@ static ib_status_t run_stream_rules(ib_engine_t *ib,
          * operator returns an error.  This needs further discussion to
          * determine what the correct behavior should be.
          */
+        if (profiling) {
+            profile_start = ib_rule_profile_clock();
+        }
         if (data != NULL) {
             rc = execute_stream_txdata_rule(rule_exec, data, data_length);
         }
         else if (header != NULL) {
             rc = execute_stream_header_rule(rule_exec, header);
         }
+        if (profiling) {
+            ib_rule_profile_record(
+                ib->rule_engine->profile, rule,
+                ib_rule_profile_clock() - profile_start,
+                rule_exec->rule_result != 0
+            );
+        }
         if (rc != IB_OK) {
             ib_rule_log_error(rule_exec, "Error executing rule: %s",
                               ib_status_to_string(rc));
@@ -3102,6 +3465,8 @@ static ib_status_t init_ruleset(ib_engine_t *ib,
                          ib_status_to_string(rc));
             return rc;
         }
+        ruleset_phase->rules = NULL;
+        ruleset_phase->rule_count = 0;
     }
 
     /* Create a hash to hold rules indexed by ID */
@@ -3233,6 +3598,15 @@ static ib_status_t create_rule_engine(const ib_engine_t *ib,
     /* Indices start at 0 */
     rule_engine->index_limit = 0;
 
+    /* Create the rule profile */
+    rc = ib_rule_profile_create(&(rule_engine->profile), mm);
+    if (rc != IB_OK) {
+        ib_log_error(ib,
+                     "Error creating rule engine profile: %s",
+                     ib_status_to_string(rc));
+        return rc;
+    }
+
     /* Create the rule list */
     rc = ib_list_create(&(rule_engine->rule_list), mm);
     if (rc != IB_OK) {
@@ -3712,6 +4086,146 @@ bool ib_rule_is_marked(const ib_rule_t *rule) {
     return ib_flags_any(rule->flags, IB_RULE_FLAG_MARK);
 }
 
+/**
+ * Can a rule be skipped when none of its targets are present?
+ *
+ * With every target unset or an empty collection, a rule's operator and
+ * actions never run, unless the operator accepts a missing target, a
+ * transformation such as count() makes a value of an empty collection, or
+ * the rule does not use targets at all.
+ *
+ * @param[in] rule Rule to check
+ *
+ * @returns true if @a rule may be skipped, otherwise false
+ */
+static bool rule_can_skip_absent(const ib_rule_t *rule)
+{
+    assert(rule != NULL);
+
+    const ib_list_node_t *node;
+
+    if (ib_flags_any(rule->flags,
+                     IB_RULE_FLAG_EXTERNAL |
+                     IB_RULE_FLAG_STREAM |
+                     IB_RULE_FLAG_NO_TGT))
+    {
+        return false;
+    }
+    if ( (rule->opinst == NULL) || (rule->opinst->opinst == NULL) ) {
+        return false;
+    }
+    if (ib_flags_all(
+            ib_operator_capabilities(
+                ib_operator_inst_operator(rule->opinst->opinst)),
+            IB_OP_CAPABILITY_ALLOW_NULL))
+    {
+        return false;
+    }
+    if (ib_list_elements(rule->target_fields) == 0) {
+        return false;
+    }
+
+    IB_LIST_LOOP_CONST(rule->target_fields, node) {
+        const ib_rule_target_t *target =
+            (const ib_rule_target_t *)ib_list_node_data_const(node);
+
+        if (target->target == NULL) {
+            return false;
+        }
+        if ( (target->tfn_list != NULL) &&
+             (ib_list_elements(target->tfn_list) > 0) )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Flag the rules of a chain that can be skipped when no target is present.
+ *
+ * @param[in,out] rule First rule of the chain
+ */
+static void flag_skip_absent(ib_rule_t *rule)
+{
+    for (; rule != NULL; rule = rule->chained_rule) {
+        if (rule_can_skip_absent(rule)) {
+            ib_flags_set(rule->flags, IB_RULE_FLAG_SKIP_ABSENT);
+        }
+    }
+}
+
+/**
+ * Build the runnable rule arrays of a context's phases.
+ *
+ * Runs once per context so that executing a phase does not need to walk
+ * and filter the phase's rule list for each transaction.
+ *
+ * @param[in] ib IronBee engine
+ * @param[in,out] ctx IronBee context
+ *
+ * @returns
+ *   - IB_OK on success.
+ *   - IB_EALLOC on allocation failure.
+ */
+static ib_status_t build_phase_rules(ib_engine_t *ib,
+                                     ib_context_t *ctx)
+{
+    assert(ib != NULL);
+    assert(ctx != NULL);
+
+    ib_rule_phase_num_t phase_num;
+
+    for (phase_num = IB_PHASE_NONE;
+         phase_num < IB_RULE_PHASE_COUNT;
+         ++phase_num)
+    {
+        ib_ruleset_phase_t   *ruleset_phase =
+            &(ctx->rules->ruleset.phases[phase_num]);
+        const ib_list_node_t *node;
+        const ib_rule_t     **rules;
+        size_t                count = 0;
+
+        IB_LIST_LOOP_CONST(ruleset_phase->rule_list, node) {
+            if (rule_is_runnable(ib_list_node_data_const(node))) {
+                ++count;
+            }
+        }
+
+        ruleset_phase->rules = NULL;
+        ruleset_phase->rule_count = 0;
+        if (count == 0) {
+            continue;
+        }
+
+        rules = ib_mm_alloc(ctx->mm, count * sizeof(*rules));
+        if (rules == NULL) {
+            ib_log_error(ib,
+                         "Error allocating rules for phase %d "
+                         "in context \"%s\"",
+                         phase_num, ib_context_full_get(ctx));
+            return IB_EALLOC;
+        }
+
+        count = 0;
+        IB_LIST_LOOP_CONST(ruleset_phase->rule_list, node) {
+            const ib_rule_ctx_data_t *ctx_rule =
+                (const ib_rule_ctx_data_t *)ib_list_node_data_const(node);
+
+            if (rule_is_runnable(ctx_rule)) {
+                flag_skip_absent(ctx_rule->rule);
+                rules[count++] = ctx_rule->rule;
+            }
+        }
+
+        ruleset_phase->rules = rules;
+        ruleset_phase->rule_count = count;
+    }
+
+    return IB_OK;
+}
+
 /**
  * Close a context for the rule engine.
  *
@@ -3944,6 +4458,12 @@ static ib_status_t rule_engine_ctx_close(ib_engine_t *ib,
                      ib_context_full_get(ctx));
     }
 
+    /* Step 6: Build the array of runnable rules for each phase */
+    rc = build_phase_rules(ib, ctx);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
     /* Initialize var sources */
     {
         ib_rule_engine_t *re = ib->rule_engine;
@@ -4123,6 +4643,31 @@ static ib_status_t rule_engine_tx_started(ib_engine_t *ib,
     return IB_OK;
 }
 
+/**
+ * Handle the transaction finishing.
+ *
+ * @param ib Engine.
+ * @param tx Transaction.
+ * @param state State.
+ * @param cbdata Callback data.
+ *
+ * @returns IB_OK
+ */
+static ib_status_t rule_engine_tx_finished(ib_engine_t *ib,
+                                           ib_tx_t *tx,
+                                           ib_state_t state,
+                                           void *cbdata)
+{
+    assert(ib != NULL);
+    assert(tx != NULL);
+    assert(state == tx_finished_state);
+    assert(cbdata == NULL);
+
+    ib_rule_profile_tx_finished(ib);
+
+    return IB_OK;
+}
+
 ib_status_t ib_rule_engine_init(ib_engine_t *ib)
 {
     ib_status_t rc;
@@ -4147,6 +4692,13 @@ ib_status_t ib_rule_engine_init(ib_engine_t *ib)
         return rc;
     }
 
+    /* Register the tx finish event */
+    rc = ib_hook_tx_register(ib, tx_finished_state,
+                             rule_engine_tx_finished, NULL);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
     /* Register the rule callbacks */
     rc = register_callbacks(ib, ib_engine_mm_main_get(ib), ib->rule_engine);
     if (rc != IB_OK) {
@@ -4803,7 +5355,9 @@ ib_status_t ib_rule_register(ib_engine_t *ib,
         IB_LIST_LOOP(context_rules->rule_list, node) {
             ib_rule_t *r = (ib_rule_t *)ib_list_node_data(node);
             if (strcmp(r->meta.id, rule->meta.id) == 0) {
-                ib_list_node_data_set(node, rule);
+                ib_list_node_data_set(
+                    context_rules->rule_list, node, rule
+                );
             }
         }
 
@@ -31,6 +31,8 @@
 #include <ironbee/rule_engine.h>
 #include <ironbee/types.h>
 
+#include "rule_profile_private.h"
+
 /**
  * Context-specific rule object.  This is the type of the objects
  * stored in the 'rule_list' field of ib_ruleset_phase_t.
@@ -43,11 +45,15 @@ typedef struct {
 /**
  * Ruleset for a single phase.
  *  rule_list is a list of pointers to ib_rule_ctx_data_t objects.
+ *  rules is built from rule_list when the context is closed and holds the
+ *  runnable rules in execution order; it is not modified afterwards.
  */
 typedef struct {
     ib_rule_phase_num_t         phase_num;   /**< Phase number */
     const ib_rule_phase_meta_t *phase_meta;  /**< Rule phase meta-data */
     ib_list_t                  *rule_list;   /**< Rules to execute in phase */
+    const ib_rule_t           **rules;       /**< Runnable rules */
+    size_t                      rule_count;  /**< Number of @a rules */
 } ib_ruleset_phase_t;
 
 /**
@@ -88,6 +94,7 @@ struct ib_rule_engine_t {
     ib_hash_t *external_drivers; /**< Drivers for external rules. */
     ib_list_t *ownership_cbs;    /**< List of ownership callbacks. */
     size_t     index_limit;      /**< One more than highest rule index. */
+    ib_rule_profile_t *profile;  /**< Rule evaluation profile. */
 
     /**
      * Rule injection callbacks.
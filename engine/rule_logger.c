@@ -1225,6 +1225,12 @@ static void log_tx_end(
     if ( (ib_flags_all(rule_exec->tx_log->flags, IB_RULE_LOG_FLAG_TX)) &&
          (!rule_exec->tx_log->empty_tx) )
     {
+        if (rule_exec->tfn_memo_hits + rule_exec->tfn_memo_misses > 0) {
+            rule_log_exec(rule_exec,
+                          "TFN_MEMO hits:%zd misses:%zd",
+                          rule_exec->tfn_memo_hits,
+                          rule_exec->tfn_memo_misses);
+        }
         rule_log_exec(rule_exec, "TX_END");
     }
     return;
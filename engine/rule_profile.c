@@ -0,0 +1,875 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- Rule profiling
+ *
+ * Counters are kept in a fixed number of stripes, each with its own lock
+ * and an array of counters indexed by rule index.  A thread always uses
+ * the same stripe, so unless there are more threads than stripes, the lock
+ * of a stripe is never contended.  Nothing is allocated with a stripe lock
+ * held.
+ *
+ * The profile file is written by a writer thread, woken at the end of a
+ * transaction when a write is due, so that transactions never wait on
+ * the file system.
+ */
+
+#include "ironbee_config_auto.h"
+
+#include "engine_private.h"
+#include "rule_engine_private.h"
+#include "rule_profile_private.h"
+
+#include <ironbee/hash.h>
+#include <ironbee/json_writer.h>
+#include <ironbee/lock.h>
+#include <ironbee/mm_mpool_lite.h>
+#include <ironbee/mpool_lite.h>
+#include <ironbee/operator.h>
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/** Number of stripes. */
+#define RULE_PROFILE_STRIPES 8
+
+/**
+ * Number of histogram buckets.
+ *
+ * Bucket 0 counts evaluations of 0 usec; bucket @e b counts evaluations of
+ * 2^(b-1) to 2^b - 1 usec.  The last bucket also counts longer ones.
+ */
+#define RULE_PROFILE_BUCKETS 24
+
+/** Smallest number of counters allocated for a stripe. */
+#define RULE_PROFILE_MIN_COUNTERS 64
+
+/**
+ * Counters of a rule, or of an operator.
+ */
+typedef struct {
+    const ib_rule_t *rule;        /**< Rule; NULL if never evaluated. */
+    uint64_t         evaluations; /**< Number of evaluations. */
+    uint64_t         matches;     /**< Number of evaluations that matched. */
+    uint64_t         total_usec;  /**< Total time of all evaluations. */
+    uint64_t         max_usec;    /**< Time of the longest evaluation. */
+    uint32_t         histogram[RULE_PROFILE_BUCKETS]; /**< Times. */
+} rule_profile_counters_t;
+
+/**
+ * Counters of the threads using a stripe.
+ */
+typedef struct {
+    ib_spinlock_t           *lock;     /**< Protects the members below. */
+    rule_profile_counters_t *counters; /**< Indexed by rule index; malloced. */
+    size_t                   n;        /**< Number of @ref counters. */
+} rule_profile_stripe_t;
+
+struct ib_rule_profile_t {
+    /** True iff profiling; accessed atomically. */
+    bool                  enabled;
+    /** File written by the writer thread or NULL. */
+    const char           *path;
+    /** Microseconds between writes of @ref path. */
+    ib_time_t             interval;
+    /** Time of the last write of @ref path; accessed atomically. */
+    ib_time_t             last_write;
+    /** Memory manager of the profile. */
+    ib_mm_t               mm;
+    /** Engine of the profile; set with @ref path. */
+    const ib_engine_t    *ib;
+    /** Protects the writer members below. */
+    ib_lock_t            *writer_lock;
+    /** Signaled when @ref write_due or @ref writer_stop is set. */
+    ib_cond_t            *writer_cond;
+    /** Writer thread. */
+    pthread_t             writer;
+    /** True iff @ref writer is running. */
+    bool                  writer_running;
+    /** True iff the writer should write @ref path. */
+    bool                  write_due;
+    /** True iff the writer should exit. */
+    bool                  writer_stop;
+    /** Counters. */
+    rule_profile_stripe_t stripes[RULE_PROFILE_STRIPES];
+};
+
+/** Key of the calling thread's stripe number plus 1. */
+static pthread_key_t  s_thread_key;
+/** Initialization of @ref s_thread_key. */
+static pthread_once_t s_thread_once = PTHREAD_ONCE_INIT;
+/** True iff @ref s_thread_key was created. */
+static bool           s_thread_key_valid = false;
+/** Number of threads given a stripe so far. */
+static size_t         s_thread_count = 0;
+
+/**
+ * Create @ref s_thread_key.
+ */
+static void rule_profile_thread_init(void)
+{
+    s_thread_key_valid = pthread_key_create(&s_thread_key, NULL) == 0;
+}
+
+/**
+ * Get the stripe number of the calling thread.
+ *
+ * Threads are given stripes round robin on first use.
+ *
+ * @returns Stripe number.
+ */
+static size_t rule_profile_thread_stripe(void)
+{
+    uintptr_t slot;
+
+    pthread_once(&s_thread_once, &rule_profile_thread_init);
+    if (! s_thread_key_valid) {
+        return 0;
+    }
+
+    slot = (uintptr_t)pthread_getspecific(s_thread_key);
+    if (slot == 0) {
+        slot = __atomic_add_fetch(&s_thread_count, 1, __ATOMIC_RELAXED);
+        slot = (slot - 1) % RULE_PROFILE_STRIPES + 1;
+        pthread_setspecific(s_thread_key, (void *)slot);
+    }
+
+    return slot - 1;
+}
+
+/**
+ * Histogram bucket of an evaluation time.
+ *
+ * @param[in] usec Microseconds.
+ *
+ * @returns Bucket.
+ */
+static size_t rule_profile_bucket(uint64_t usec)
+{
+    size_t bucket = 0;
+
+    while (usec != 0 && bucket < RULE_PROFILE_BUCKETS - 1) {
+        usec >>= 1;
+        ++bucket;
+    }
+
+    return bucket;
+}
+
+/**
+ * Add @a src into @a dst.
+ *
+ * @param[in,out] dst Counters to add to.
+ * @param[in]     src Counters to add.
+ */
+static void rule_profile_add(
+    rule_profile_counters_t       *dst,
+    const rule_profile_counters_t *src
+)
+{
+    if (dst->rule == NULL) {
+        dst->rule = src->rule;
+    }
+    dst->evaluations += src->evaluations;
+    dst->matches     += src->matches;
+    dst->total_usec  += src->total_usec;
+    if (src->max_usec > dst->max_usec) {
+        dst->max_usec = src->max_usec;
+    }
+    for (size_t b = 0; b < RULE_PROFILE_BUCKETS; ++b) {
+        dst->histogram[b] += src->histogram[b];
+    }
+}
+
+/**
+ * Estimate the 99th percentile of the times counted in @a counters.
+ *
+ * @param[in] counters Counters.
+ *
+ * @returns Upper bound of the bucket holding the 99th percentile, or the
+ *          longest time if less.
+ */
+static uint64_t rule_profile_p99(const rule_profile_counters_t *counters)
+{
+    uint64_t need = counters->evaluations - counters->evaluations / 100;
+    uint64_t seen = 0;
+
+    for (size_t b = 0; b < RULE_PROFILE_BUCKETS - 1; ++b) {
+        seen += counters->histogram[b];
+        if (seen >= need) {
+            uint64_t upper = (b == 0) ? 0 : ((uint64_t)1 << b) - 1;
+
+            return (upper < counters->max_usec) ? upper : counters->max_usec;
+        }
+    }
+
+    return counters->max_usec;
+}
+
+/**
+ * Grow @a stripe to hold at least @a need counters.
+ *
+ * The counters are allocated and copied without holding the stripe lock,
+ * then swapped in under it.
+ *
+ * @param[in] stripe Stripe.
+ * @param[in] need   Number of counters needed.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ */
+static ib_status_t rule_profile_stripe_grow(
+    rule_profile_stripe_t *stripe,
+    size_t                 need
+)
+{
+    rule_profile_counters_t *grown;
+    rule_profile_counters_t *old;
+    size_t                   n = RULE_PROFILE_MIN_COUNTERS;
+
+    while (n < need) {
+        n <<= 1;
+    }
+
+    grown = calloc(n, sizeof(*grown));
+    if (grown == NULL) {
+        return IB_EALLOC;
+    }
+
+    ib_spinlock_lock(stripe->lock);
+    if (stripe->n < n) {
+        /* Counts are only added under the lock, so none are lost. */
+        if (stripe->counters != NULL) {
+            memcpy(grown, stripe->counters, stripe->n * sizeof(*grown));
+        }
+        old = stripe->counters;
+        stripe->counters = grown;
+        stripe->n = n;
+    }
+    else {
+        old = grown;
+    }
+    ib_spinlock_unlock(stripe->lock);
+
+    free(old);
+
+    return IB_OK;
+}
+
+/**
+ * Writer thread: write the profile file whenever it is due.
+ *
+ * Exits once stopped and no write is due.
+ *
+ * @param[in] arg Profile.
+ *
+ * @returns NULL
+ */
+static void *rule_profile_writer(void *arg)
+{
+    ib_rule_profile_t *profile = (ib_rule_profile_t *)arg;
+
+    ib_lock_lock(profile->writer_lock);
+    for (;;) {
+        while (! profile->write_due && ! profile->writer_stop) {
+            ib_cond_wait(profile->writer_cond, profile->writer_lock);
+        }
+        if (! profile->write_due) {
+            break;
+        }
+        profile->write_due = false;
+        ib_lock_unlock(profile->writer_lock);
+
+        ib_rule_profile_write(profile->ib);
+
+        ib_lock_lock(profile->writer_lock);
+    }
+    ib_lock_unlock(profile->writer_lock);
+
+    return NULL;
+}
+
+/**
+ * Stop the writer thread of @a profile, if running.
+ *
+ * A write that is due is done first.
+ *
+ * @param[in] profile Profile.
+ */
+static void rule_profile_writer_stop(ib_rule_profile_t *profile)
+{
+    bool join;
+
+    ib_lock_lock(profile->writer_lock);
+    join = profile->writer_running;
+    profile->writer_running = false;
+    profile->writer_stop = true;
+    ib_cond_broadcast(profile->writer_cond);
+    ib_lock_unlock(profile->writer_lock);
+
+    if (join) {
+        pthread_join(profile->writer, NULL);
+    }
+}
+
+/**
+ * Stop the writer and release the counters of @a profile.
+ *
+ * @param[in] cbdata Profile.
+ */
+static void rule_profile_destroy(void *cbdata)
+{
+    ib_rule_profile_t *profile = (ib_rule_profile_t *)cbdata;
+
+    rule_profile_writer_stop(profile);
+
+    for (size_t s = 0; s < RULE_PROFILE_STRIPES; ++s) {
+        free(profile->stripes[s].counters);
+        profile->stripes[s].counters = NULL;
+        profile->stripes[s].n = 0;
+    }
+}
+
+ib_status_t ib_rule_profile_create(
+    ib_rule_profile_t **profile,
+    ib_mm_t             mm
+)
+{
+    assert(profile != NULL);
+
+    ib_rule_profile_t *local_profile;
+    ib_status_t        rc;
+
+    local_profile = ib_mm_calloc(mm, 1, sizeof(*local_profile));
+    if (local_profile == NULL) {
+        return IB_EALLOC;
+    }
+    local_profile->mm = mm;
+    local_profile->interval = IB_RULE_PROFILE_INTERVAL_DEFAULT;
+
+    for (size_t s = 0; s < RULE_PROFILE_STRIPES; ++s) {
+        rc = ib_spinlock_create(&local_profile->stripes[s].lock, mm);
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+    rc = ib_lock_create(&local_profile->writer_lock, mm);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    rc = ib_cond_create(&local_profile->writer_cond, mm);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    rc = ib_mm_register_cleanup(mm, rule_profile_destroy, local_profile);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    *profile = local_profile;
+
+    return IB_OK;
+}
+
+bool ib_rule_profile_active(
+    const ib_rule_profile_t *profile
+)
+{
+    assert(profile != NULL);
+
+    return __atomic_load_n(&profile->enabled, __ATOMIC_RELAXED);
+}
+
+ib_time_t ib_rule_profile_clock(void)
+{
+    struct timespec ts;
+
+#ifdef CLOCK_MONOTONIC
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#else
+    clock_gettime(CLOCK_REALTIME, &ts);
+#endif
+
+    return ((ib_time_t)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+}
+
+void ib_rule_profile_record(
+    ib_rule_profile_t *profile,
+    const ib_rule_t   *rule,
+    ib_time_t          usec,
+    bool               matched
+)
+{
+    assert(profile != NULL);
+    assert(rule != NULL);
+
+    rule_profile_stripe_t   *stripe;
+    rule_profile_counters_t *counters;
+    size_t                   index = rule->meta.index;
+
+    stripe = &profile->stripes[rule_profile_thread_stripe()];
+    ib_spinlock_lock(stripe->lock);
+
+    /* Grow the stripe to hold the rule; stripes never shrink. */
+    if (index >= stripe->n) {
+        ib_spinlock_unlock(stripe->lock);
+        if (rule_profile_stripe_grow(stripe, index + 1) != IB_OK) {
+            return;
+        }
+        ib_spinlock_lock(stripe->lock);
+    }
+
+    counters = &stripe->counters[index];
+    counters->rule = rule;
+    ++counters->evaluations;
+    if (matched) {
+        ++counters->matches;
+    }
+    counters->total_usec += usec;
+    if ((uint64_t)usec > counters->max_usec) {
+        counters->max_usec = usec;
+    }
+    ++counters->histogram[rule_profile_bucket(usec)];
+
+    ib_spinlock_unlock(stripe->lock);
+}
+
+void ib_rule_profile_enable(
+    ib_engine_t *ib,
+    bool         enable
+)
+{
+    assert(ib != NULL);
+    assert(ib->rule_engine != NULL);
+
+    __atomic_store_n(
+        &ib->rule_engine->profile->enabled, enable, __ATOMIC_RELAXED
+    );
+}
+
+bool ib_rule_profile_enabled(
+    const ib_engine_t *ib
+)
+{
+    assert(ib != NULL);
+    assert(ib->rule_engine != NULL);
+
+    return ib_rule_profile_active(ib->rule_engine->profile);
+}
+
+void ib_rule_profile_reset(
+    ib_engine_t *ib
+)
+{
+    assert(ib != NULL);
+    assert(ib->rule_engine != NULL);
+
+    ib_rule_profile_t *profile = ib->rule_engine->profile;
+
+    for (size_t s = 0; s < RULE_PROFILE_STRIPES; ++s) {
+        rule_profile_stripe_t *stripe = &profile->stripes[s];
+
+        ib_spinlock_lock(stripe->lock);
+        if (stripe->counters != NULL) {
+            memset(stripe->counters, 0, stripe->n * sizeof(*stripe->counters));
+        }
+        ib_spinlock_unlock(stripe->lock);
+    }
+}
+
+/**
+ * Order counters by total time, most first.
+ */
+static int rule_profile_cmp(const void *a, const void *b)
+{
+    const rule_profile_counters_t *ca = *(const rule_profile_counters_t **)a;
+    const rule_profile_counters_t *cb = *(const rule_profile_counters_t **)b;
+
+    if (ca->total_usec != cb->total_usec) {
+        return (ca->total_usec > cb->total_usec) ? -1 : 1;
+    }
+    return (ca->evaluations > cb->evaluations) ? -1 :
+           (ca->evaluations < cb->evaluations) ?  1 : 0;
+}
+
+/**
+ * Name of the operator of @a rule.
+ *
+ * @param[in] rule Rule.
+ *
+ * @returns Operator name or an empty string if the rule has none.
+ */
+static const char *rule_profile_operator(const ib_rule_t *rule)
+{
+    if (rule->opinst == NULL || rule->opinst->opinst == NULL) {
+        return "";
+    }
+    return ib_operator_name(ib_operator_inst_operator(rule->opinst->opinst));
+}
+
+/**
+ * Write the statistics shared by rules and operators to @a writer.
+ *
+ * @param[in] writer   Writer, in a map.
+ * @param[in] counters Counters.
+ */
+static void rule_profile_write_counters(
+    ib_json_writer_t              *writer,
+    const rule_profile_counters_t *counters
+)
+{
+    ib_json_writer_nulstr(writer, "evaluations");
+    ib_json_writer_num(writer, (ib_num_t)counters->evaluations);
+    ib_json_writer_nulstr(writer, "matches");
+    ib_json_writer_num(writer, (ib_num_t)counters->matches);
+    ib_json_writer_nulstr(writer, "match_rate");
+    ib_json_writer_float(
+        writer,
+        (double)counters->matches / (double)counters->evaluations
+    );
+    ib_json_writer_nulstr(writer, "total_usec");
+    ib_json_writer_num(writer, (ib_num_t)counters->total_usec);
+    ib_json_writer_nulstr(writer, "p99_usec");
+    ib_json_writer_num(writer, (ib_num_t)rule_profile_p99(counters));
+}
+
+ib_status_t ib_rule_profile_json(
+    const ib_engine_t  *ib,
+    ib_mm_t             mm,
+    const char        **json,
+    size_t             *len
+)
+{
+    assert(ib != NULL);
+    assert(ib->rule_engine != NULL);
+    assert(json != NULL);
+
+    const ib_rule_profile_t  *profile = ib->rule_engine->profile;
+    rule_profile_counters_t  *merged = NULL;
+    size_t                    merged_n = 0;
+    rule_profile_counters_t **rules = NULL;
+    size_t                    rules_n = 0;
+    rule_profile_counters_t  *ops = NULL;
+    rule_profile_counters_t **ops_sorted = NULL;
+    size_t                    ops_n = 0;
+    size_t                   *ops_rules = NULL;
+    ib_hash_t                *op_index;
+    ib_json_writer_t         *writer = NULL;
+    const char               *buf;
+    size_t                    buf_len;
+    ib_status_t               rc;
+
+    /* Merge the stripes.  No rule has an index of the limit or more. */
+    merged_n = ib->rule_engine->index_limit;
+    merged = calloc(merged_n + 1, sizeof(*merged));
+    if (merged == NULL) {
+        rc = IB_EALLOC;
+        goto finish;
+    }
+    for (size_t s = 0; s < RULE_PROFILE_STRIPES; ++s) {
+        const rule_profile_stripe_t *stripe = &profile->stripes[s];
+
+        ib_spinlock_lock(stripe->lock);
+        for (size_t i = 0; i < stripe->n && i < merged_n; ++i) {
+            if (stripe->counters[i].evaluations != 0) {
+                rule_profile_add(&merged[i], &stripe->counters[i]);
+            }
+        }
+        ib_spinlock_unlock(stripe->lock);
+    }
+
+    rules      = malloc((merged_n + 1) * sizeof(*rules));
+    ops        = calloc(merged_n + 1, sizeof(*ops));
+    ops_sorted = malloc((merged_n + 1) * sizeof(*ops_sorted));
+    ops_rules  = calloc(merged_n + 1, sizeof(*ops_rules));
+    if (rules == NULL || ops == NULL || ops_sorted == NULL || ops_rules == NULL) {
+        rc = IB_EALLOC;
+        goto finish;
+    }
+
+    /* Collect evaluated rules and add them up by operator. */
+    rc = ib_hash_create(&op_index, mm);
+    if (rc != IB_OK) {
+        goto finish;
+    }
+    for (size_t i = 0; i < merged_n; ++i) {
+        const char *op_name;
+        uintptr_t   op;
+
+        if (merged[i].evaluations == 0) {
+            continue;
+        }
+        rules[rules_n++] = &merged[i];
+
+        op_name = rule_profile_operator(merged[i].rule);
+        rc = ib_hash_get(op_index, &op, op_name);
+        if (rc == IB_ENOENT) {
+            op = ++ops_n;
+            rc = ib_hash_set(op_index, op_name, (void *)op);
+        }
+        if (rc != IB_OK) {
+            goto finish;
+        }
+        rule_profile_add(&ops[op - 1], &merged[i]);
+        ++ops_rules[op - 1];
+    }
+    for (size_t i = 0; i < ops_n; ++i) {
+        ops_sorted[i] = &ops[i];
+    }
+    qsort(rules, rules_n, sizeof(*rules), &rule_profile_cmp);
+    qsort(ops_sorted, ops_n, sizeof(*ops_sorted), &rule_profile_cmp);
+
+    /* Render. */
+    rc = ib_json_writer_create(&writer, true);
+    if (rc != IB_OK) {
+        goto finish;
+    }
+    ib_json_writer_map_open(writer);
+    ib_json_writer_nulstr(writer, "enabled");
+    ib_json_writer_bool(writer, ib_rule_profile_active(profile));
+
+    ib_json_writer_nulstr(writer, "rules");
+    ib_json_writer_array_open(writer);
+    for (size_t i = 0; i < rules_n; ++i) {
+        ib_json_writer_map_open(writer);
+        ib_json_writer_nulstr(writer, "id");
+        ib_json_writer_nulstr(writer, ib_rule_id(rules[i]->rule));
+        ib_json_writer_nulstr(writer, "operator");
+        ib_json_writer_nulstr(writer, rule_profile_operator(rules[i]->rule));
+        rule_profile_write_counters(writer, rules[i]);
+        ib_json_writer_map_close(writer);
+    }
+    ib_json_writer_array_close(writer);
+
+    ib_json_writer_nulstr(writer, "operators");
+    ib_json_writer_array_open(writer);
+    for (size_t i = 0; i < ops_n; ++i) {
+        size_t op = ops_sorted[i] - ops;
+
+        ib_json_writer_map_open(writer);
+        ib_json_writer_nulstr(writer, "operator");
+        ib_json_writer_nulstr(writer, rule_profile_operator(ops[op].rule));
+        ib_json_writer_nulstr(writer, "rules");
+        ib_json_writer_num(writer, (ib_num_t)ops_rules[op]);
+        rule_profile_write_counters(writer, &ops[op]);
+        ib_json_writer_map_close(writer);
+    }
+    ib_json_writer_array_close(writer);
+    ib_json_writer_map_close(writer);
+
+    rc = ib_json_writer_buf(writer, &buf, &buf_len);
+    if (rc != IB_OK) {
+        goto finish;
+    }
+
+    *json = ib_mm_memdup(mm, buf, buf_len + 1);
+    if (*json == NULL) {
+        rc = IB_EALLOC;
+        goto finish;
+    }
+    if (len != NULL) {
+        *len = buf_len;
+    }
+
+finish:
+    ib_json_writer_destroy(writer);
+    free(ops_rules);
+    free(ops_sorted);
+    free(ops);
+    free(rules);
+    free(merged);
+
+    return rc;
+}
+
+ib_status_t ib_rule_profile_file_set(
+    ib_engine_t *ib,
+    const char  *path,
+    ib_time_t    interval
+)
+{
+    assert(ib != NULL);
+    assert(ib->rule_engine != NULL);
+
+    ib_rule_profile_t *profile = ib->rule_engine->profile;
+    const char        *path_copy = NULL;
+    ib_status_t        rc = IB_OK;
+
+    if (path != NULL) {
+        path_copy = ib_mm_strdup(profile->mm, path);
+        if (path_copy == NULL) {
+            return IB_EALLOC;
+        }
+    }
+
+    ib_lock_lock(profile->writer_lock);
+    profile->ib = ib;
+    profile->path = path_copy;
+    profile->interval = interval;
+    if (path_copy != NULL && ! profile->writer_running) {
+        profile->writer_stop = false;
+        if (
+            pthread_create(
+                &profile->writer, NULL, rule_profile_writer, profile
+            ) != 0
+        ) {
+            rc = IB_EOTHER;
+        }
+        else {
+            profile->writer_running = true;
+        }
+    }
+    ib_lock_unlock(profile->writer_lock);
+
+    return rc;
+}
+
+ib_status_t ib_rule_profile_write(
+    const ib_engine_t *ib
+)
+{
+    assert(ib != NULL);
+    assert(ib->rule_engine != NULL);
+
+    const ib_rule_profile_t *profile = ib->rule_engine->profile;
+    ib_mpool_lite_t         *mpl;
+    ib_mm_t                  mm;
+    const char              *json;
+    size_t                   json_len;
+    char                    *tmp_path;
+    size_t                   tmp_path_len;
+    FILE                    *fp;
+    ib_status_t              rc;
+
+    if (profile->path == NULL) {
+        return IB_OK;
+    }
+
+    rc = ib_mpool_lite_create(&mpl);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    mm = ib_mm_mpool_lite(mpl);
+
+    rc = ib_rule_profile_json(ib, mm, &json, &json_len);
+    if (rc != IB_OK) {
+        goto finish;
+    }
+
+    tmp_path_len = strlen(profile->path) + sizeof(".tmp");
+    tmp_path = ib_mm_alloc(mm, tmp_path_len);
+    if (tmp_path == NULL) {
+        rc = IB_EALLOC;
+        goto finish;
+    }
+    snprintf(tmp_path, tmp_path_len, "%s.tmp", profile->path);
+
+    fp = fopen(tmp_path, "w");
+    if (fp == NULL) {
+        ib_log_error(ib, "Failed to open rule profile file \"%s\".", tmp_path);
+        rc = IB_EOTHER;
+        goto finish;
+    }
+    if (
+        fwrite(json, 1, json_len, fp) != json_len ||
+        fputc('\n', fp) == EOF
+    ) {
+        fclose(fp);
+        ib_log_error(ib, "Failed to write rule profile file \"%s\".", tmp_path);
+        rc = IB_EOTHER;
+        goto finish;
+    }
+    if (fclose(fp) != 0 || rename(tmp_path, profile->path) != 0) {
+        ib_log_error(ib,
+                     "Failed to write rule profile file \"%s\".",
+                     profile->path);
+        rc = IB_EOTHER;
+        goto finish;
+    }
+
+finish:
+    ib_mpool_lite_destroy(mpl);
+
+    return rc;
+}
+
+void ib_rule_profile_tx_finished(
+    ib_engine_t *ib
+)
+{
+    assert(ib != NULL);
+    assert(ib->rule_engine != NULL);
+
+    ib_rule_profile_t *profile = ib->rule_engine->profile;
+    ib_time_t          now;
+    ib_time_t          last;
+
+    if (profile->path == NULL || ! ib_rule_profile_active(profile)) {
+        return;
+    }
+
+    now = ib_clock_get_time();
+    last = __atomic_load_n(&profile->last_write, __ATOMIC_RELAXED);
+    if (now - last < profile->interval) {
+        return;
+    }
+
+    /* Only the thread that moves the write time wakes the writer. */
+    if (
+        ! __atomic_compare_exchange_n(
+            &profile->last_write, &last, now,
+            false, __ATOMIC_RELAXED, __ATOMIC_RELAXED
+        )
+    ) {
+        return;
+    }
+
+    ib_lock_lock(profile->writer_lock);
+    profile->write_due = true;
+    ib_cond_broadcast(profile->writer_cond);
+    ib_lock_unlock(profile->writer_lock);
+}
+
+void ib_rule_profile_shutdown(
+    ib_engine_t *ib
+)
+{
+    assert(ib != NULL);
+
+    ib_rule_profile_t *profile;
+
+    if (ib->rule_engine == NULL) {
+        return;
+    }
+    profile = ib->rule_engine->profile;
+
+    rule_profile_writer_stop(profile);
+
+    /* Keep the counts since the last write. */
+    if (profile->path != NULL && ib_rule_profile_active(profile)) {
+        ib_rule_profile_write(ib);
+    }
+}
@@ -0,0 +1,115 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+#ifndef _IB_RULE_PROFILE_PRIVATE_H_
+#define _IB_RULE_PROFILE_PRIVATE_H_
+
+/**
+ * @file
+ * @brief IronBee --- Rule profiling Private Declarations
+ *
+ * These definitions and routines are called by the rule engine and nowhere
+ * else.
+ */
+
+#include <ironbee/rule_engine.h>
+#include <ironbee/rule_profile.h>
+
+/**
+ * Rule profile of an engine.
+ */
+typedef struct ib_rule_profile_t ib_rule_profile_t;
+
+/**
+ * Create a rule profile.
+ *
+ * Profiling is initially disabled.
+ *
+ * @param[out] profile Created profile.
+ * @param[in]  mm      Memory manager; the profile lives as long as it.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ */
+ib_status_t ib_rule_profile_create(
+    ib_rule_profile_t **profile,
+    ib_mm_t             mm
+);
+
+/**
+ * Is profiling enabled?
+ *
+ * @param[in] profile Profile.
+ *
+ * @returns true iff evaluations should be recorded.
+ */
+bool ib_rule_profile_active(
+    const ib_rule_profile_t *profile
+);
+
+/**
+ * Current time to time evaluations with.
+ *
+ * This is a monotonic clock read at full precision regardless of the
+ * clock mode, see ib_clock_mode_set().
+ *
+ * @returns Time in microseconds.
+ */
+ib_time_t ib_rule_profile_clock(void);
+
+/**
+ * Record one evaluation of @a rule.
+ *
+ * Times should be taken with ib_rule_profile_clock().
+ *
+ * @param[in] profile Profile.
+ * @param[in] rule    Rule evaluated.
+ * @param[in] usec    Microseconds the evaluation took.
+ * @param[in] matched True if the rule matched.
+ */
+void ib_rule_profile_record(
+    ib_rule_profile_t *profile,
+    const ib_rule_t   *rule,
+    ib_time_t          usec,
+    bool               matched
+);
+
+/**
+ * Handle the end of a transaction.
+ *
+ * Wakes the writer thread if a write of the profile file is due.
+ *
+ * @param[in] ib IronBee engine.
+ */
+void ib_rule_profile_tx_finished(
+    ib_engine_t *ib
+);
+
+/**
+ * Handle the engine shutting down.
+ *
+ * Stops the writer thread and writes the profile file a last time if
+ * profiling.  Must be called while rules and logging are still usable.
+ *
+ * @param[in] ib IronBee engine.
+ */
+void ib_rule_profile_shutdown(
+    ib_engine_t *ib
+);
+
+#endif /* _IB_RULE_PROFILE_PRIVATE_H_ */
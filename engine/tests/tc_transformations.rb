@@ -75,6 +75,26 @@ class TestTransformations < CLIPPTest::TestCase
     assert_log_match /CLIPP ANNOUNCE: result/
   end
 
+  def test_tfn_memo
+    clipp(
+      :input_hashes => [simple_hash("GET /foobar/a\n", "HTTP/1.1 200 OK\n\n")],
+      :default_site_config => <<-EOS
+        RuleEngineLogData tx
+        RuleEngineLogLevel info
+        Action id:1 rev:1 phase:REQUEST_HEADER setvar:x=AbC
+        Rule x.lowercase() @streq abc id:2 rev:1 phase:REQUEST_HEADER clipp_announce:first
+        Rule x.lowercase() @streq abc id:3 rev:1 phase:REQUEST_HEADER clipp_announce:second
+        Action id:4 rev:1 phase:REQUEST_HEADER setvar:x=DeF
+        Rule x.lowercase() @streq def id:5 rev:1 phase:REQUEST_HEADER clipp_announce:changed
+      EOS
+    )
+    assert_no_issues
+    assert_log_match /CLIPP ANNOUNCE: first/
+    assert_log_match /CLIPP ANNOUNCE: second/
+    assert_log_match /CLIPP ANNOUNCE: changed/
+    assert_log_match /TFN_MEMO hits:1 misses:2/
+  end
+
   # Obseved bug in testing.
   def test_init_collection_assert_on_missing_tfn
     clipp(
@@ -312,3 +312,34 @@ TEST_F(TestIronBee, test_module_data)
     ASSERT_EQ(IB_OK, ib_tx_set_module_data(tx, module, NULL));
     ASSERT_EQ(IB_ENOENT, ib_tx_get_module_data(tx, module, &data));
 }
+
+TEST_F(TestIronBee, test_conn_pool_reuse)
+{
+    ib_conn_t  *conn = NULL;
+    ib_tx_t    *tx = NULL;
+    ib_mpool_t *mp;
+
+    ASSERT_EQ(0UL, ib_engine->num_conn_pools);
+
+    // The pool of a small connection is kept and reused.
+    ASSERT_EQ(IB_OK, ib_conn_create(ib_engine, &conn, NULL));
+    ASSERT_EQ(IB_OK, ib_tx_create(&tx, conn, NULL));
+    ASSERT_TRUE(ib_mm_alloc(tx->mm, 1000));
+    ib_tx_destroy(tx);
+    mp = conn->mp;
+    ib_conn_destroy(conn);
+    ASSERT_EQ(1UL, ib_engine->num_conn_pools);
+
+    ASSERT_EQ(IB_OK, ib_conn_create(ib_engine, &conn, NULL));
+    ASSERT_EQ(mp, conn->mp);
+    ASSERT_EQ(0UL, ib_engine->num_conn_pools);
+
+    // The pool of a large connection, counting its transactions, is not.
+    ASSERT_EQ(IB_OK, ib_tx_create(&tx, conn, NULL));
+    for (size_t i = 0; i < 2 * IB_ENGINE_CONN_POOL_FOOTPRINT / 1000; ++i) {
+        ASSERT_TRUE(ib_mm_alloc(tx->mm, 1000));
+    }
+    ib_tx_destroy(tx);
+    ib_conn_destroy(conn);
+    ASSERT_EQ(0UL, ib_engine->num_conn_pools);
+}
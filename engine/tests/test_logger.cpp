@@ -0,0 +1,311 @@
+//////////////////////////////////////////////////////////////////////////////
+// Licensed to Qualys, Inc. (QUALYS) under one or more
+// contributor license agreements.  See the NOTICE file distributed with
+// this work for additional information regarding copyright ownership.
+// QUALYS licenses this file to You under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @file
+ * @brief IronBee --- Logger queue tests.
+ */
+
+extern "C" {
+#include "ironbee_config_auto.h"
+
+#include <ironbee/logger.h>
+#include <ironbee/mm_mpool.h>
+#include <ironbee/mpool.h>
+}
+
+#include "gtest/gtest.h"
+
+#include <boost/lexical_cast.hpp>
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+//! Non-NULL engine for records; the logger never dereferences it.
+const ib_engine_t *c_engine = reinterpret_cast<const ib_engine_t *>(1);
+
+}
+
+class TestLogger : public ::testing::Test
+{
+public:
+    virtual void SetUp()
+    {
+        ASSERT_EQ(IB_OK, ib_mpool_create(&m_mp, "TestLogger", NULL));
+        ASSERT_EQ(
+            IB_OK,
+            ib_logger_create(&m_logger, IB_LOG_DEBUG, ib_mm_mpool(m_mp))
+        );
+        m_writer  = NULL;
+        m_signals = 0;
+        m_freed   = 0;
+    }
+
+    virtual void TearDown()
+    {
+        ib_mpool_destroy(m_mp);
+    }
+
+    //! Add the writer, with a queue of @a depth, that the tests drain.
+    void add_writer(size_t depth, ib_logger_overflow_t overflow)
+    {
+        ib_logger_format_t *format;
+
+        ib_logger_queue_depth_set(m_logger, depth);
+        ib_logger_overflow_set(m_logger, overflow);
+        ASSERT_EQ(
+            IB_OK,
+            ib_logger_format_create(
+                m_logger, &format, format_fn, NULL, free_fn, this
+            )
+        );
+        ASSERT_EQ(
+            IB_OK,
+            ib_logger_writer_add(
+                m_logger,
+                NULL, NULL,
+                NULL, NULL,
+                NULL, NULL,
+                format,
+                record_fn, this
+            )
+        );
+    }
+
+    void log(int i)
+    {
+        ib_logger_log_va(
+            m_logger, IB_LOGGER_ERRORLOG_TYPE,
+            __FILE__, __func__, __LINE__,
+            c_engine, NULL, NULL, NULL,
+            IB_LOG_ERROR, "%d", i
+        );
+    }
+
+    //! Dequeue all records; returns them in order.
+    vector<string> drain()
+    {
+        vector<string> records;
+
+        /* The writer is known once it signaled the first record. */
+        if (m_writer == NULL) {
+            return records;
+        }
+        EXPECT_EQ(
+            IB_OK,
+            ib_logger_dequeue(m_logger, m_writer, handler, &records)
+        );
+
+        return records;
+    }
+
+    //! "0", "1", ... for [@a begin, @a end).
+    static vector<string> range(int begin, int end)
+    {
+        vector<string> result;
+
+        for (int i = begin; i < end; ++i) {
+            result.push_back(boost::lexical_cast<string>(i));
+        }
+
+        return result;
+    }
+
+    static ib_status_t format_fn(
+        ib_logger_t           *logger,
+        const ib_logger_rec_t *rec,
+        const uint8_t         *msg,
+        const size_t           msg_sz,
+        void                  *writer_record,
+        void                  *data
+    )
+    {
+        *reinterpret_cast<string **>(writer_record) =
+            new string(reinterpret_cast<const char *>(msg), msg_sz);
+
+        return IB_OK;
+    }
+
+    static void free_fn(ib_logger_t *logger, void *record, void *cbdata)
+    {
+        delete static_cast<string *>(record);
+        __atomic_add_fetch(
+            &static_cast<TestLogger *>(cbdata)->m_freed, 1, __ATOMIC_RELAXED
+        );
+    }
+
+    static ib_status_t record_fn(
+        ib_logger_t        *logger,
+        ib_logger_writer_t *writer,
+        void               *data
+    )
+    {
+        TestLogger *test = static_cast<TestLogger *>(data);
+
+        __atomic_store_n(&test->m_writer, writer, __ATOMIC_RELEASE);
+        __atomic_add_fetch(&test->m_signals, 1, __ATOMIC_RELAXED);
+
+        return IB_OK;
+    }
+
+    static void handler(void *element, void *cbdata)
+    {
+        static_cast<vector<string> *>(cbdata)->push_back(
+            *static_cast<string *>(element)
+        );
+    }
+
+protected:
+    ib_mpool_t         *m_mp;
+    ib_logger_t        *m_logger;
+    ib_logger_writer_t *m_writer;
+    size_t              m_signals;
+    size_t              m_freed;
+};
+
+TEST_F(TestLogger, Drain)
+{
+    add_writer(8, IB_LOGGER_OVERFLOW_BLOCK);
+
+    /* Only the record that makes the queue non-empty signals. */
+    for (int i = 0; i < 5; ++i) {
+        log(i);
+    }
+    EXPECT_EQ(1UL, m_signals);
+    EXPECT_EQ(range(0, 5), drain());
+    EXPECT_EQ(5UL, m_freed);
+    EXPECT_TRUE(drain().empty());
+
+    log(5);
+    EXPECT_EQ(2UL, m_signals);
+    EXPECT_EQ(range(5, 6), drain());
+    EXPECT_EQ(0UL, ib_logger_dropped(m_logger));
+}
+
+TEST_F(TestLogger, DropNewest)
+{
+    add_writer(4, IB_LOGGER_OVERFLOW_DROP_NEWEST);
+
+    for (int i = 0; i < 10; ++i) {
+        log(i);
+    }
+    EXPECT_EQ(6UL, ib_logger_dropped(m_logger));
+    EXPECT_EQ(6UL, m_freed);
+    EXPECT_EQ(range(0, 4), drain());
+    EXPECT_EQ(10UL, m_freed);
+
+    /* The queue has room again. */
+    log(10);
+    EXPECT_EQ(range(10, 11), drain());
+    EXPECT_EQ(6UL, ib_logger_dropped(m_logger));
+}
+
+TEST_F(TestLogger, DropOldest)
+{
+    add_writer(4, IB_LOGGER_OVERFLOW_DROP_OLDEST);
+
+    for (int i = 0; i < 10; ++i) {
+        log(i);
+    }
+    EXPECT_EQ(6UL, ib_logger_dropped(m_logger));
+    EXPECT_EQ(6UL, m_freed);
+    EXPECT_EQ(range(6, 10), drain());
+    EXPECT_EQ(10UL, m_freed);
+    EXPECT_EQ(1UL, m_signals);
+}
+
+namespace {
+
+struct producer_t {
+    TestLogger *test;
+    int         begin;
+    int         end;
+};
+
+}
+
+class TestLoggerBlock : public TestLogger
+{
+public:
+    static void *produce(void *arg)
+    {
+        producer_t *producer = static_cast<producer_t *>(arg);
+
+        for (int i = producer->begin; i < producer->end; ++i) {
+            producer->test->log(i);
+        }
+
+        return NULL;
+    }
+};
+
+TEST_F(TestLoggerBlock, Block)
+{
+    static const int c_threads = 4;
+    static const int c_records = 2000;
+
+    pthread_t      threads[c_threads];
+    producer_t     producers[c_threads];
+    vector<string> records;
+    vector<int>    next(c_threads);
+
+    add_writer(4, IB_LOGGER_OVERFLOW_BLOCK);
+
+    for (int t = 0; t < c_threads; ++t) {
+        producers[t].test  = this;
+        producers[t].begin = t * c_records;
+        producers[t].end   = (t + 1) * c_records;
+        next[t] = producers[t].begin;
+        ASSERT_EQ(
+            0, pthread_create(&threads[t], NULL, produce, &producers[t])
+        );
+    }
+
+    /* Producers wait on the full queue until it is drained. */
+    while (records.size() < size_t(c_threads * c_records)) {
+        vector<string> some;
+
+        if (__atomic_load_n(&m_writer, __ATOMIC_ACQUIRE) == NULL) {
+            sched_yield();
+            continue;
+        }
+        some = drain();
+        records.insert(records.end(), some.begin(), some.end());
+    }
+    for (int t = 0; t < c_threads; ++t) {
+        ASSERT_EQ(0, pthread_join(threads[t], NULL));
+    }
+    EXPECT_TRUE(drain().empty());
+
+    /* Nothing lost or repeated, and each producer's records in order. */
+    for (size_t i = 0; i < records.size(); ++i) {
+        int n = boost::lexical_cast<int>(records[i]);
+        int t = n / c_records;
+
+        ASSERT_EQ(next[t], n);
+        ++next[t];
+    }
+    EXPECT_EQ(0UL, ib_logger_dropped(m_logger));
+    EXPECT_EQ(size_t(c_threads * c_records), m_freed);
+}
@@ -30,6 +30,8 @@
 
 #include "gtest/gtest.h"
 
+#include <boost/lexical_cast.hpp>
+
 using IronBee::ScopedMemoryPool;
 using IronBee::MemoryPool;
 
@@ -558,6 +560,263 @@ TEST(TestVar, Target)
     EXPECT_EQ("fooA", result_list.front().name_as_s());
 }
 
+TEST(TestVar, TargetAtom)
+{
+    using namespace IronBee;
+
+    ScopedMemoryPool smp;
+    ib_status_t rc;
+    ib_mm_t mm = ib_mm_mpool(MemoryPool(smp).ib());
+    typedef List<IronBee::Field> field_list_t;
+    typedef ConstList<IronBee::Field> field_clist_t;
+    field_list_t data_list = field_list_t::create(smp);
+
+    ib_var_config_t *config = make_config(mm);
+    ASSERT_TRUE(config);
+    ib_var_source_t *source = make_source(config, "data");
+    ASSERT_TRUE(source);
+
+    /* Constant filters are interned when the target is acquired. */
+    ib_var_target_t *target;
+    rc = ib_var_target_acquire_from_string(&target, mm, config, "data:FOOA", 9);
+    ASSERT_EQ(IB_OK, rc);
+
+    const ib_atom_t *atom;
+    ASSERT_EQ(IB_OK, ib_atom_lookup(
+        ib_var_config_atoms(config), IB_S2SL("fooa"), &atom));
+    ASSERT_EQ(IB_OK, ib_atom_lookup(
+        ib_var_config_atoms(config), IB_S2SL("DATA"), &atom));
+    ib_atom_table_freeze(ib_var_config_atoms(config));
+
+    data_list.push_back(Field::create_number(smp, "fooA", 4, 5));
+    data_list.push_back(Field::create_number(smp, "fooB", 4, 6));
+    data_list.push_back(Field::create_number(smp, "fooa", 4, 7));
+    for (
+        field_list_t::iterator i = data_list.begin();
+        i != data_list.end();
+        ++i
+    ) {
+        ib_var_field_atom_set(config, i->ib());
+    }
+    EXPECT_TRUE(data_list.front().ib()->atom);
+    EXPECT_FALSE((++data_list.begin())->ib()->atom);
+
+    Field data_field =
+        Field::create_no_copy_list<Field>(smp, "data", 4, data_list);
+    ib_var_store_t *store = make_store(config);
+    rc = ib_var_source_set(source, store, data_field.ib());
+    ASSERT_EQ(IB_OK, rc);
+
+    const ib_list_t *result = NULL;
+    field_clist_t result_list;
+
+    rc = ib_var_target_get(target, &result, mm, store);
+    ASSERT_EQ(IB_OK, rc);
+    result_list = field_clist_t(result);
+    EXPECT_EQ(2UL, result_list.size());
+
+    /* Names not interned before freezing still match by name. */
+    rc = ib_var_target_acquire_from_string(&target, mm, config, "data:FOOB", 9);
+    ASSERT_EQ(IB_OK, rc);
+    rc = ib_var_target_get(target, &result, mm, store);
+    ASSERT_EQ(IB_OK, rc);
+    result_list = field_clist_t(result);
+    EXPECT_EQ(1UL, result_list.size());
+    EXPECT_EQ("fooB", result_list.front().name_as_s());
+}
+
+TEST(TestVar, TargetIndexed)
+{
+    using namespace IronBee;
+
+    ScopedMemoryPool smp;
+    ib_status_t rc;
+    ib_mm_t mm = ib_mm_mpool(MemoryPool(smp).ib());
+    typedef List<IronBee::Field> field_list_t;
+    typedef ConstList<IronBee::Field> field_clist_t;
+    field_list_t data_list = field_list_t::create(smp);
+
+    /* Large enough to be indexed. */
+    for (int i = 0; i < 100; ++i) {
+        string name = "arg" + boost::lexical_cast<string>(i % 50);
+        data_list.push_back(
+            Field::create_number(smp, name.data(), name.length(), i)
+        );
+    }
+
+    Field data_field =
+        Field::create_no_copy_list<Field>(smp, "data", 4, data_list);
+
+    ib_var_config_t *config = make_config(mm);
+    ASSERT_TRUE(config);
+    ib_var_source_t *source = make_source(config, "data");
+    ASSERT_TRUE(source);
+    ib_var_store_t *store = make_store(config);
+    rc = ib_var_source_set(source, store, data_field.ib());
+    ASSERT_EQ(IB_OK, rc);
+
+    ib_var_target_t *target;
+    const ib_list_t *result = NULL;
+    field_clist_t result_list;
+
+    rc = ib_var_target_acquire_from_string(&target, mm, config, "data:ARG7", 9);
+    ASSERT_EQ(IB_OK, rc);
+    rc = ib_var_target_get(target, &result, mm, store);
+    ASSERT_EQ(IB_OK, rc);
+    result_list = field_clist_t(result);
+    ASSERT_EQ(2UL, result_list.size());
+    EXPECT_EQ(7, result_list.front().value_as_number());
+    EXPECT_EQ(57, result_list.back().value_as_number());
+
+    rc = ib_var_target_acquire_from_string(&target, mm, config, "data:nope", 9);
+    ASSERT_EQ(IB_OK, rc);
+    rc = ib_var_target_get(target, &result, mm, store);
+    ASSERT_EQ(IB_OK, rc);
+    EXPECT_EQ(0UL, ib_list_elements(result));
+
+    /* Changes to the collection are seen. */
+    data_list.push_back(Field::create_number(smp, "nope", 4, 100));
+    rc = ib_var_target_get(target, &result, mm, store);
+    ASSERT_EQ(IB_OK, rc);
+    EXPECT_EQ(1UL, ib_list_elements(result));
+
+    rc = ib_var_target_acquire_from_string(&target, mm, config, "data:arg7", 9);
+    ASSERT_EQ(IB_OK, rc);
+    rc = ib_var_target_remove(target, NULL, IB_MM_NULL, store);
+    ASSERT_EQ(IB_OK, rc);
+    rc = ib_var_target_get(target, &result, mm, store);
+    ASSERT_EQ(IB_OK, rc);
+    EXPECT_EQ(0UL, ib_list_elements(result));
+}
+
+TEST(TestVar, TargetIndexedChanges)
+{
+    using namespace IronBee;
+
+    ScopedMemoryPool smp;
+    ib_status_t rc;
+    ib_mm_t mm = ib_mm_mpool(MemoryPool(smp).ib());
+    typedef List<IronBee::Field> field_list_t;
+    field_list_t data_list = field_list_t::create(smp);
+
+    for (int i = 0; i < 20; ++i) {
+        data_list.push_back(Field::create_number(smp, "a", 1, i));
+    }
+
+    Field data_field =
+        Field::create_no_copy_list<Field>(smp, "data", 4, data_list);
+
+    ib_var_config_t *config = make_config(mm);
+    ASSERT_TRUE(config);
+    ib_var_source_t *source = make_source(config, "data");
+    ASSERT_TRUE(source);
+    ib_var_store_t *store = make_store(config);
+    rc = ib_var_source_set(source, store, data_field.ib());
+    ASSERT_EQ(IB_OK, rc);
+
+    ib_var_target_t *target_a;
+    ib_var_target_t *target_b;
+    const ib_list_t *result = NULL;
+
+    rc = ib_var_target_acquire_from_string(&target_a, mm, config, "data:a", 6);
+    ASSERT_EQ(IB_OK, rc);
+    rc = ib_var_target_acquire_from_string(&target_b, mm, config, "data:b", 6);
+    ASSERT_EQ(IB_OK, rc);
+
+    /* Appends between filters, as a growing collection sees them. */
+    for (int i = 0; i < 200; ++i) {
+        string name = (i % 2 == 0) ? "a" : "b";
+        data_list.push_back(
+            Field::create_number(smp, name.data(), name.length(), i)
+        );
+
+        rc = ib_var_target_get(target_a, &result, mm, store);
+        ASSERT_EQ(IB_OK, rc);
+        ASSERT_EQ(size_t(20 + i / 2 + 1), ib_list_elements(result));
+        rc = ib_var_target_get(target_b, &result, mm, store);
+        ASSERT_EQ(IB_OK, rc);
+        ASSERT_EQ(size_t((i + 1) / 2), ib_list_elements(result));
+    }
+
+    /* Insertions at the front and removals are seen, also once the
+     * collection is no longer indexed. */
+    for (int i = 0; i < 10; ++i) {
+        ib_field_t *f = Field::create_number(smp, "b", 1, i).ib();
+
+        rc = ib_list_unshift(data_list.ib(), f);
+        ASSERT_EQ(IB_OK, rc);
+        rc = ib_var_target_get(target_b, &result, mm, store);
+        ASSERT_EQ(IB_OK, rc);
+        ASSERT_EQ(size_t(100 + i + 1), ib_list_elements(result));
+        EXPECT_EQ(f, ib_list_node_data_const(ib_list_first_const(result)));
+    }
+    rc = ib_var_target_remove(target_b, NULL, IB_MM_NULL, store);
+    ASSERT_EQ(IB_OK, rc);
+    rc = ib_var_target_get(target_b, &result, mm, store);
+    ASSERT_EQ(IB_OK, rc);
+    EXPECT_EQ(0UL, ib_list_elements(result));
+    rc = ib_var_target_get(target_a, &result, mm, store);
+    ASSERT_EQ(IB_OK, rc);
+    EXPECT_EQ(120UL, ib_list_elements(result));
+}
+
+TEST(TestVar, TargetIndexedReplace)
+{
+    using namespace IronBee;
+
+    ScopedMemoryPool smp;
+    ib_status_t rc;
+    ib_mm_t mm = ib_mm_mpool(MemoryPool(smp).ib());
+    typedef List<IronBee::Field> field_list_t;
+    field_list_t data_list = field_list_t::create(smp);
+
+    for (int i = 0; i < 20; ++i) {
+        data_list.push_back(Field::create_number(smp, "a", 1, i));
+    }
+
+    Field data_field =
+        Field::create_no_copy_list<Field>(smp, "data", 4, data_list);
+
+    ib_var_config_t *config = make_config(mm);
+    ASSERT_TRUE(config);
+    ib_var_source_t *source = make_source(config, "data");
+    ASSERT_TRUE(source);
+    ib_var_store_t *store = make_store(config);
+    rc = ib_var_source_set(source, store, data_field.ib());
+    ASSERT_EQ(IB_OK, rc);
+
+    ib_var_target_t *target_a;
+    ib_var_target_t *target_c;
+    const ib_list_t *first = NULL;
+    const ib_list_t *result = NULL;
+
+    rc = ib_var_target_acquire_from_string(&target_a, mm, config, "data:a", 6);
+    ASSERT_EQ(IB_OK, rc);
+    rc = ib_var_target_acquire_from_string(&target_c, mm, config, "data:c", 6);
+    ASSERT_EQ(IB_OK, rc);
+
+    /* A result does not change with the collection. */
+    rc = ib_var_target_get(target_a, &first, mm, store);
+    ASSERT_EQ(IB_OK, rc);
+    ASSERT_EQ(20UL, ib_list_elements(first));
+    data_list.push_back(Field::create_number(smp, "a", 1, 20));
+    rc = ib_var_target_get(target_a, &result, mm, store);
+    ASSERT_EQ(IB_OK, rc);
+    EXPECT_EQ(21UL, ib_list_elements(result));
+    EXPECT_EQ(20UL, ib_list_elements(first));
+
+    /* Members replaced in place are seen. */
+    ib_field_t *f = Field::create_number(smp, "c", 1, 0).ib();
+    ib_list_node_data_set(data_list.ib(), ib_list_first(data_list.ib()), f);
+    rc = ib_var_target_get(target_a, &result, mm, store);
+    ASSERT_EQ(IB_OK, rc);
+    EXPECT_EQ(20UL, ib_list_elements(result));
+    rc = ib_var_target_get(target_c, &result, mm, store);
+    ASSERT_EQ(IB_OK, rc);
+    ASSERT_EQ(1UL, ib_list_elements(result));
+    EXPECT_EQ(f, ib_list_node_data_const(ib_list_first_const(result)));
+}
+
 TEST(TestVar, TargetRemoveTrivial)
 {
     using namespace IronBee;
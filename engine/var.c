@@ -27,6 +27,7 @@
 #include <ironbee/var.h>
 
 #include <ironbee/array.h>
+#include <ironbee/atom.h>
 #include <ironbee/hash.h>
 #include <ironbee/mm_mpool_lite.h>
 #include <ironbee/string_assembly.h>
@@ -45,6 +46,9 @@ struct ib_var_config_t
     /** Hash of keys to index.  Value `ib_var_source_t *` */
     ib_hash_t *index_by_name;
 
+    /** Interned source and filter names. */
+    ib_atom_table_t *atoms;
+
     /** Next index to use. */
     size_t next_index;
 };
@@ -59,8 +63,59 @@ struct ib_var_store_t
     ib_hash_t *hash;
     /** Array of source index to value.  Value: `ib_field_t *` */
     ib_array_t *array;
+    /**
+     * Name indices of collections, created on first use.
+     *
+     * Key: address of the collection list.  Value: `filter_index_t *`
+     **/
+    ib_hash_t *filter_indices;
 };
 
+/**
+ * Index of a collection by member name, ignoring case.
+ *
+ * Filters applied through a store use the index instead of walking large
+ * collections.  When the generation of the collection list changes, members
+ * appended since the index was last updated are added to it; any other
+ * change rebuilds it.  A collection rebuilt more than
+ * @ref FILTER_INDEX_MAX_REBUILDS times is no longer indexed.
+ **/
+typedef struct
+{
+    /** Collection indexed; the key of this index in the store. */
+    const ib_list_t *collection;
+    /** Generation of @ref collection when the index was updated. */
+    size_t generation;
+    /** Elements of @ref collection when the index was updated. */
+    size_t elements;
+    /** Last node of @ref collection when the index was updated. */
+    const ib_list_node_t *last;
+    /** Number of times the index was built. */
+    size_t builds;
+    /**
+     * Name to members.  Value: `ib_list_t *` of `const ib_field_t *`
+     *
+     * NULL if the index is not built.
+     **/
+    ib_hash_t *by_name;
+} filter_index_t;
+
+/**
+ * Smallest collection to index.
+ *
+ * Smaller collections are cheaper to walk than to index.
+ **/
+#define FILTER_INDEX_MIN_ELEMENTS 16
+
+/**
+ * Number of rebuilds after which a collection is no longer indexed.
+ *
+ * Memory of a replaced index is only reclaimed with the store, so a
+ * collection that changes other than by appending between filters is
+ * walked instead.
+ **/
+#define FILTER_INDEX_MAX_REBUILDS 2
+
 struct ib_var_source_t
 {
     /** Configuration */
@@ -78,6 +133,8 @@ struct ib_var_source_t
 
     /** Length of @ref name */
     size_t name_length;
+    /** Interned @ref name or NULL if it could not be interned. */
+    const ib_atom_t *atom;
     /** Initial phase value is set. */
     ib_rule_phase_num_t initial_phase;
     /** Final phase with value is changed. */
@@ -116,6 +173,14 @@ struct ib_var_filter_t
      * Length of @ref filter_string.
      **/
     size_t filter_string_length;
+
+    /**
+     * Interned @ref filter_string or NULL.
+     *
+     * Fields whose atom is also known are matched by comparing atoms
+     * rather than names.
+     **/
+    const ib_atom_t *atom;
 };
 
 struct ib_var_target_t
@@ -249,6 +314,11 @@ ib_status_t ib_var_config_acquire(
         return rc;
     }
 
+    rc = ib_atom_table_create(&local_config->atoms, mm);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
     *config = local_config;
 
     return IB_OK;
@@ -263,6 +333,53 @@ ib_mm_t ib_var_config_mm(
     return config->mm;
 }
 
+ib_atom_table_t *ib_var_config_atoms(
+    const ib_var_config_t *config
+)
+{
+    assert(config != NULL);
+
+    return config->atoms;
+}
+
+void ib_var_field_atom_set(
+    const ib_var_config_t *config,
+    ib_field_t            *field
+)
+{
+    assert(config != NULL);
+    assert(field  != NULL);
+
+    field->atom = NULL;
+    ib_atom_lookup(config->atoms, field->name, field->nlen, &field->atom);
+}
+
+/**
+ * Does @a field pass @a filter?
+ *
+ * @param[in] filter Filter.
+ * @param[in] field  Field.
+ *
+ * @return true iff the name of @a field is @a filter, ignoring case.
+ **/
+static inline
+bool filter_match(
+    const ib_var_filter_t *filter,
+    const ib_field_t      *field
+)
+{
+    if (filter->atom != NULL && field->atom != NULL) {
+        return filter->atom == field->atom;
+    }
+
+    return
+        filter->filter_string_length == field->nlen &&
+        strncasecmp(
+            filter->filter_string,
+            field->name, field->nlen
+        ) == 0;
+}
+
 /* var_store */
 
 ib_status_t ib_var_store_acquire(
@@ -282,10 +399,19 @@ ib_status_t ib_var_store_acquire(
         return IB_EALLOC;
     }
 
-    local_store->config = config;
-    local_store->mm     = mm;
+    local_store->config         = config;
+    local_store->mm             = mm;
+    local_store->filter_indices = NULL;
 
-    rc = ib_hash_create_nocase(&local_store->hash, mm);
+    /* Looked up by name on every var access; use the flat layout. */
+    rc = ib_hash_create_ex(
+        &local_store->hash,
+        mm,
+        16,
+        IB_HASH_LAYOUT_FLAT,
+        ib_hashfunc_djb2_nocase, NULL,
+        ib_hashequal_nocase, NULL
+    );
     if (rc != IB_OK) {
         return rc;
     }
@@ -379,6 +505,18 @@ ib_status_t ib_var_source_register(
         return IB_EALLOC;
     }
 
+    rc = ib_atom_intern(
+        config->atoms,
+        local_source->name, name_length,
+        &local_source->atom
+    );
+    if (rc == IB_ENOENT) {
+        local_source->atom = NULL;
+    }
+    else if (rc != IB_OK) {
+        return rc;
+    }
+
     local_source->config        = config;
     local_source->name_length   = name_length;
     local_source->initial_phase = initial_phase;
@@ -536,6 +674,7 @@ ib_status_t ib_var_source_set(
     if (field != NULL) {
         field->name = source->name;
         field->nlen = source->name_length;
+        field->atom = source->atom;
     }
 
     if (source->is_indexed) {
@@ -590,6 +729,17 @@ ib_status_t ib_var_source_acquire(
             return IB_EALLOC;
         }
         local_source->name_length   = name_length;
+        rc = ib_atom_intern(
+            config->atoms,
+            local_source->name, name_length,
+            &local_source->atom
+        );
+        if (rc == IB_ENOENT) {
+            local_source->atom = NULL;
+        }
+        else if (rc != IB_OK) {
+            return rc;
+        }
         local_source->config        = config;
         local_source->initial_phase = IB_PHASE_NONE;
         local_source->final_phase   = IB_PHASE_NONE;
@@ -756,6 +906,7 @@ ib_status_t ib_var_filter_acquire(
     local_filter->filter_string =
         ib_mm_memdup(mm, filter_string, filter_string_length);
     local_filter->filter_string_length = filter_string_length;
+    local_filter->atom = NULL;
 
     *filter = local_filter;
 
@@ -810,14 +961,7 @@ ib_status_t ib_var_filter_apply(
         IB_LIST_LOOP_CONST(answer, node) {
             const ib_field_t *f =
                 (const ib_field_t *)ib_list_node_data_const(node);
-            bool push = (
-                filter->filter_string_length == f->nlen &&
-                strncasecmp(
-                    filter->filter_string,
-                    f->name, f->nlen
-                ) == 0
-            );
-            if (push) {
+            if (filter_match(filter, f)) {
                 /* Discard const because lists are const-generic. */
                 rc = ib_list_push(local_result, (void *)f);
                 if (rc != IB_OK) {
@@ -833,6 +977,281 @@ ib_status_t ib_var_filter_apply(
     return IB_OK;
 }
 
+/**
+ * Add the members of @a index's collection from @a node on to @a index.
+ *
+ * @param[in, out] index Index to add to.
+ * @param[in]      node  First node to add; may be NULL.
+ * @param[in]      mm    Memory manager to allocate from.
+ * @return
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ **/
+static
+ib_status_t filter_index_add(
+    filter_index_t       *index,
+    const ib_list_node_t *node,
+    ib_mm_t               mm
+)
+{
+    assert(index != NULL);
+    assert(index->by_name != NULL);
+
+    ib_status_t rc;
+
+    for (; node != NULL; node = ib_list_node_next_const(node)) {
+        const ib_field_t *f = (const ib_field_t *)ib_list_node_data_const(node);
+        ib_list_t        *members;
+
+        rc = ib_hash_get_ex(index->by_name, &members, f->name, f->nlen);
+        if (rc == IB_ENOENT) {
+            rc = ib_list_create(&members, mm);
+            if (rc != IB_OK) {
+                return rc;
+            }
+            rc = ib_hash_set_ex(index->by_name, f->name, f->nlen, members);
+        }
+        if (rc != IB_OK) {
+            return rc;
+        }
+
+        /* Discard const because lists are const-generic. */
+        rc = ib_list_push(members, (void *)f);
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
+    index->generation = ib_list_generation(index->collection);
+    index->elements   = ib_list_elements(index->collection);
+    index->last       = ib_list_last_const(index->collection);
+
+    return IB_OK;
+}
+
+/**
+ * Build @a index from its collection.
+ *
+ * @param[in, out] index Index to build.
+ * @param[in]      mm    Memory manager to allocate from.
+ * @return
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ **/
+static
+ib_status_t filter_index_build(
+    filter_index_t *index,
+    ib_mm_t         mm
+)
+{
+    assert(index != NULL);
+
+    ib_status_t rc;
+    size_t      size = 16;
+
+    while (size < ib_list_elements(index->collection)) {
+        size <<= 1;
+    }
+
+    ++index->builds;
+    rc = ib_hash_create_ex(
+        &index->by_name,
+        mm,
+        size,
+        IB_HASH_LAYOUT_FLAT,
+        ib_hashfunc_djb2_nocase, NULL,
+        ib_hashequal_nocase, NULL
+    );
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    return filter_index_add(
+        index,
+        ib_list_first_const(index->collection),
+        mm
+    );
+}
+
+/**
+ * Bring @a index up to date with its collection.
+ *
+ * Every insertion into or removal from a list changes its generation by one,
+ * and a clear changes it by one while removing all elements.  So if the
+ * generation changed by exactly the number of added elements, the collection
+ * only had elements inserted, and if as many nodes follow the last indexed
+ * node, they were all appended.  Those are added to the index; otherwise it
+ * is rebuilt.
+ *
+ * @param[in, out] index Index to update; must be built.
+ * @param[in]      mm    Memory manager to allocate from.
+ * @return
+ * - IB_OK on success.
+ * - IB_DECLINED if the index should be rebuilt.
+ * - IB_EALLOC on allocation failure.
+ **/
+static
+ib_status_t filter_index_update(
+    filter_index_t *index,
+    ib_mm_t         mm
+)
+{
+    assert(index != NULL);
+    assert(index->by_name != NULL);
+    assert(index->last != NULL);
+
+    const ib_list_t      *collection = index->collection;
+    const ib_list_node_t *node;
+    size_t                added;
+
+    if (
+        ib_list_elements(collection) < index->elements ||
+        ib_list_generation(collection) - index->generation !=
+            ib_list_elements(collection) - index->elements
+    ) {
+        return IB_DECLINED;
+    }
+
+    added = index->elements;
+    for (
+        node = ib_list_node_next_const(index->last);
+        node != NULL;
+        node = ib_list_node_next_const(node)
+    ) {
+        ++added;
+    }
+    if (added != ib_list_elements(collection)) {
+        return IB_DECLINED;
+    }
+
+    return filter_index_add(
+        index,
+        ib_list_node_next_const(index->last),
+        mm
+    );
+}
+
+/**
+ * Apply a filter through the name index of @a store.
+ *
+ * Behaves as ib_var_filter_apply() but collections of at least
+ * @ref FILTER_INDEX_MIN_ELEMENTS members are looked up in an index kept in
+ * @a store for the life of the store.  The result is a copy of the indexed
+ * members allocated from @a mm, so later changes to the collection do not
+ * show in it.
+ *
+ * @param[in]  filter Filter to apply.
+ * @param[out] result Results.
+ * @param[in]  mm     Memory manager to use.
+ * @param[in]  field  Field to apply filter to.
+ * @param[in]  store  Store holding the index.
+ * @return As ib_var_filter_apply().
+ **/
+static
+ib_status_t filter_apply_indexed(
+    const ib_var_filter_t  *filter,
+    const ib_list_t       **result,
+    ib_mm_t                 mm,
+    const ib_field_t       *field,
+    ib_var_store_t         *store
+)
+{
+    assert(filter != NULL);
+    assert(result != NULL);
+    assert(field  != NULL);
+    assert(store  != NULL);
+
+    ib_status_t      rc;
+    const ib_list_t *collection;
+    filter_index_t  *index;
+    ib_list_t       *members;
+    ib_list_t       *local_result;
+
+    if (field->type != IB_FTYPE_LIST || ib_field_is_dynamic(field)) {
+        return ib_var_filter_apply(filter, result, mm, field);
+    }
+
+    rc = ib_field_value(field, ib_ftype_list_out(&collection));
+    assert(rc == IB_OK);
+    if (ib_list_elements(collection) < FILTER_INDEX_MIN_ELEMENTS) {
+        return ib_var_filter_apply(filter, result, mm, field);
+    }
+
+    if (store->filter_indices == NULL) {
+        rc = ib_hash_create(&store->filter_indices, store->mm);
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
+    rc = ib_hash_get_ex(
+        store->filter_indices,
+        &index,
+        (const char *)&collection, sizeof(collection)
+    );
+    if (rc == IB_ENOENT) {
+        index = ib_mm_alloc(store->mm, sizeof(*index));
+        if (index == NULL) {
+            return IB_EALLOC;
+        }
+        index->collection = collection;
+        index->builds     = 0;
+        index->by_name    = NULL;
+        rc = ib_hash_set_ex(
+            store->filter_indices,
+            (const char *)&index->collection, sizeof(index->collection),
+            index
+        );
+    }
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    if (
+        index->by_name != NULL &&
+        index->generation != ib_list_generation(collection)
+    ) {
+        rc = filter_index_update(index, store->mm);
+        if (rc == IB_DECLINED) {
+            index->by_name = NULL;
+        }
+        else if (rc != IB_OK) {
+            index->by_name = NULL;
+            return rc;
+        }
+    }
+    if (index->by_name == NULL) {
+        if (index->builds > FILTER_INDEX_MAX_REBUILDS) {
+            return ib_var_filter_apply(filter, result, mm, field);
+        }
+        rc = filter_index_build(index, store->mm);
+        if (rc != IB_OK) {
+            index->by_name = NULL;
+            return rc;
+        }
+    }
+
+    rc = ib_hash_get_ex(
+        index->by_name,
+        &members,
+        filter->filter_string, filter->filter_string_length
+    );
+    if (rc == IB_ENOENT) {
+        rc = ib_list_create(&local_result, mm);
+    }
+    else if (rc == IB_OK) {
+        /* The index list grows as members are appended. */
+        rc = ib_list_copy(members, mm, &local_result);
+    }
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    *result = local_result;
+
+    return IB_OK;
+}
+
 ib_status_t ib_var_filter_remove(
     const ib_var_filter_t  *filter,
     ib_list_t             **result,
@@ -871,13 +1290,7 @@ ib_status_t ib_var_filter_remove(
     /* Can only fail on dynamic field. */
     IB_LIST_LOOP_SAFE(field_list, node, next_node) {
         ib_field_t *f = (ib_field_t *)ib_list_node_data(node);
-        if (
-            filter->filter_string_length == f->nlen &&
-            strncasecmp(
-                filter->filter_string,
-                f->name, f->nlen
-            ) == 0
-        ) {
+        if (filter_match(filter, f)) {
             if (result != NULL) {
                 rc = ib_list_push(local_result, (void *)f);
                 if (rc != IB_OK) {
@@ -997,14 +1410,36 @@ ib_status_t ib_var_target_acquire_from_string(
     if (split_at < target_string_length - 1) {
         const char *filter_string = target_string + split_at + 1;
         size_t filter_string_length = target_string_length - split_at - 1;
-        rc = ib_var_expand_acquire(
-            &expand,
-            mm,
-            filter_string, filter_string_length,
-            config
-        );
+
+        if (ib_var_expand_test(filter_string, filter_string_length)) {
+            rc = ib_var_expand_acquire(
+                &expand,
+                mm,
+                filter_string, filter_string_length,
+                config
+            );
             if (rc != IB_OK) {
-            return rc;
+                return rc;
+            }
+        }
+        else {
+            /* Constant filter; intern it so it matches by atom. */
+            rc = ib_var_filter_acquire(
+                &filter,
+                mm,
+                filter_string, filter_string_length
+            );
+            if (rc != IB_OK) {
+                return rc;
+            }
+            rc = ib_atom_intern(
+                config->atoms,
+                filter->filter_string, filter->filter_string_length,
+                &filter->atom
+            );
+            if (rc != IB_OK && rc != IB_ENOENT) {
+                return rc;
+            }
         }
     }
 
@@ -1057,6 +1492,11 @@ ib_status_t target_filter_get(
         if (rc != IB_OK) {
             return rc;
         }
+        ib_atom_lookup(
+            target->source->config->atoms,
+            filter_string, filter_string_length,
+            &local_filter->atom
+        );
         *result = local_filter;
     }
 
@@ -1136,11 +1576,12 @@ ib_status_t ib_var_target_get(
 
     if (filter != NULL) {
         /* Filter list field. */
-        rc = ib_var_filter_apply(
+        rc = filter_apply_indexed(
             filter,
             &local_result,
             mm,
-            field
+            field,
+            store
         );
         if (rc != IB_OK) {
             return rc;
@@ -1398,6 +1839,7 @@ ib_status_t ib_var_target_set(
 
     field->name = filter->filter_string;
     field->nlen = filter->filter_string_length;
+    field->atom = filter->atom;
 
     rc = ib_field_value(source_field, ib_ftype_list_mutable_out(&list));
     if (rc != IB_OK) {
@@ -125,6 +125,8 @@ void parse_options(
             "    If name is omitted the default is used instead.\n"
             "  engine_status\n"
             "    Return the current status of all engines in JSON.\n"
+            "  rule_profile [on|off|reset|dump]\n"
+            "    Control rule profiling or return the profile in JSON.\n"
             "Options"
         );
 
@@ -0,0 +1,188 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+#ifndef _IB_ATOM_H_
+#define _IB_ATOM_H_
+
+/**
+ * @file
+ * @brief IronBee --- Atom (Interned Name) Utility Functions
+ */
+
+#include <ironbee/build.h>
+#include <ironbee/mm.h>
+#include <ironbee/types.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup IronBeeUtilAtom Atom
+ * @ingroup IronBeeUtil
+ *
+ * Interned, case-insensitive names.
+ *
+ * An atom table maps each distinct name, ignoring ASCII case, to a single
+ * @ref ib_atom_t.  Two names are equal ignoring case exactly when they
+ * intern to the same atom, so names that have been interned can be compared
+ * by pointer.
+ *
+ * Names are interned while configuring.  Once the table is frozen with
+ * ib_atom_table_freeze(), it never changes and may be read from any number
+ * of threads without locking; ib_atom_intern() then only finds existing
+ * atoms.
+ *
+ * @{
+ */
+
+/**
+ * Atom table.
+ *
+ * Treat as opaque.
+ **/
+typedef struct ib_atom_table_t ib_atom_table_t;
+
+/**
+ * An interned name.
+ *
+ * Treat as opaque.  Atoms live as long as their table.
+ **/
+typedef struct ib_atom_t ib_atom_t;
+
+/**
+ * Create an atom table.
+ *
+ * @param[out] table Created table.
+ * @param[in]  mm    Memory manager for the table and its atoms.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ **/
+ib_status_t DLL_PUBLIC ib_atom_table_create(
+    ib_atom_table_t **table,
+    ib_mm_t           mm
+)
+NONNULL_ATTRIBUTE(1);
+
+/**
+ * Freeze @a table.
+ *
+ * After this, no atoms are added and @a table may be shared between threads.
+ *
+ * @param[in] table Table to freeze.
+ **/
+void DLL_PUBLIC ib_atom_table_freeze(
+    ib_atom_table_t *table
+)
+NONNULL_ATTRIBUTE(1);
+
+/**
+ * Number of atoms in @a table.
+ *
+ * @param[in] table Table.
+ *
+ * @returns Number of atoms.  Atom ids are less than this.
+ **/
+size_t DLL_PUBLIC ib_atom_table_size(
+    const ib_atom_table_t *table
+)
+NONNULL_ATTRIBUTE(1);
+
+/**
+ * Intern a name.
+ *
+ * @param[in]  table       Table.
+ * @param[in]  name        Name.  Need not be NUL terminated.
+ * @param[in]  name_length Length of @a name.
+ * @param[out] atom        Atom for @a name.  May be NULL.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_ENOENT if @a table is frozen and @a name is not in it.
+ * - IB_EALLOC on allocation failure.
+ **/
+ib_status_t DLL_PUBLIC ib_atom_intern(
+    ib_atom_table_t  *table,
+    const char       *name,
+    size_t            name_length,
+    const ib_atom_t **atom
+)
+NONNULL_ATTRIBUTE(1, 2);
+
+/**
+ * Find the atom for a name without interning it.
+ *
+ * @param[in]  table       Table.
+ * @param[in]  name        Name.  Need not be NUL terminated.
+ * @param[in]  name_length Length of @a name.
+ * @param[out] atom        Atom for @a name.  May be NULL.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_ENOENT if @a name has not been interned.
+ **/
+ib_status_t DLL_PUBLIC ib_atom_lookup(
+    const ib_atom_table_t  *table,
+    const char             *name,
+    size_t                  name_length,
+    const ib_atom_t       **atom
+)
+NONNULL_ATTRIBUTE(1, 2);
+
+/**
+ * Name of an atom.
+ *
+ * This is the name as first interned; later names may differ in case.
+ *
+ * @param[in]  atom        Atom.
+ * @param[out] name        Name.  NUL terminated.
+ * @param[out] name_length Length of @a name.
+ **/
+void DLL_PUBLIC ib_atom_name(
+    const ib_atom_t  *atom,
+    const char      **name,
+    size_t           *name_length
+)
+NONNULL_ATTRIBUTE(1, 2, 3);
+
+/**
+ * Id of an atom.
+ *
+ * Ids are assigned from zero in order of interning, so they may be used to
+ * index arrays of ib_atom_table_size() entries.
+ *
+ * @param[in] atom Atom.
+ *
+ * @returns Id of @a atom.
+ **/
+size_t DLL_PUBLIC ib_atom_id(
+    const ib_atom_t *atom
+)
+NONNULL_ATTRIBUTE(1);
+
+/** @} IronBeeUtilAtom */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _IB_ATOM_H_ */
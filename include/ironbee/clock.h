@@ -64,6 +64,24 @@ typedef enum ib_clock_type_t {
     IB_CLOCK_TYPE_MONOTONIC_COARSE
 } ib_clock_type_t;
 
+/**
+ * Clock modes.
+ *
+ * The mode applies to ib_clock_get_time() and ib_clock_gettimeofday()
+ * process wide.  ib_clock_precise_get_time() always reads the clock.
+ */
+typedef enum ib_clock_mode_t {
+    /** Read the clock on every call. The default. */
+    IB_CLOCK_MODE_PRECISE,
+    /** Read the coarse clocks where available. Resolution is the tick. */
+    IB_CLOCK_MODE_COARSE,
+    /** Read the time last published by the ticker; coarse if none runs. */
+    IB_CLOCK_MODE_CACHED
+} ib_clock_mode_t;
+
+/** Default interval of the ticker in microseconds. */
+#define IB_CLOCK_TICK_DEFAULT 1000
+
 /**
  * Convert microseconds (usec) to milliseconds (msec).
  *
@@ -150,7 +168,8 @@ ib_time_t DLL_PUBLIC ib_clock_get_time(void);
  * Get the clock time, preferring more precise clocks.
  *
  * This is to be used for time deltas, and the value may or may not be related
- * to the value returned by time(3) (i.e. seconds since epoch).
+ * to the value returned by time(3) (i.e. seconds since epoch).  It is not
+ * subject to the clock mode.
  *
  * @note This is not monotonic nor wall time on all platforms.
  *
@@ -168,6 +187,53 @@ ib_time_t DLL_PUBLIC ib_clock_precise_get_time(void);
  */
 void ib_clock_gettimeofday(ib_timeval_t *tp);
 
+/**
+ * Set the clock mode.
+ *
+ * @param[in] mode Mode.
+ */
+void DLL_PUBLIC ib_clock_mode_set(ib_clock_mode_t mode);
+
+/**
+ * Get the clock mode.
+ *
+ * @returns Mode.
+ */
+ib_clock_mode_t DLL_PUBLIC ib_clock_mode(void);
+
+/**
+ * Start the ticker or add a reference to it if running.
+ *
+ * The ticker is a thread that reads the clocks every @a interval and
+ * publishes the values for @ref IB_CLOCK_MODE_CACHED. It runs at the
+ * smallest interval of its references.
+ *
+ * Each successful call must be balanced by ib_clock_ticker_stop() with the
+ * same @a interval.
+ *
+ * @param[in] interval Interval in microseconds.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EINVAL If @a interval is 0.
+ * - IB_EOTHER If the thread could not be created.
+ */
+ib_status_t DLL_PUBLIC ib_clock_ticker_start(ib_time_t interval);
+
+/**
+ * Remove a reference to the ticker, stopping it on the last one.
+ *
+ * @param[in] interval Interval the reference was started with.
+ */
+void DLL_PUBLIC ib_clock_ticker_stop(ib_time_t interval);
+
+/**
+ * Get the interval the ticker runs at.
+ *
+ * @returns Interval in microseconds; 0 if the ticker is not running.
+ */
+ib_time_t DLL_PUBLIC ib_clock_ticker_interval(void);
+
 /**
  * Add a time from two timeval structures.  This is written in such a way that
  * @a result may be an alias for @a tv1 and/or @a tv2.
@@ -27,6 +27,7 @@
  */
 
 #include <ironbee/build.h>
+#include <ironbee/mm.h>
 #include <ironbee/types.h>
 
 #include <sys/types.h>
@@ -44,9 +45,11 @@ extern "C" {
 /**
  * Decode a URL.
  *
+ * Output is never longer than input.
+ *
  * @param[in] data_in URL data.
  * @param[in] dlen_in Length of @a data_in.
- * @param[in] data_out Where to write output.
+ * @param[in] data_out Where to write output. May be @a data_in.
  * @param[out] dlen_out Bytes written to @a data_out.
  *
  * @returns IB_OK
@@ -59,17 +62,40 @@ ib_status_t DLL_PUBLIC ib_util_decode_url(
 )
 NONNULL_ATTRIBUTE(1, 3, 4);
 
+/**
+ * Decode a URL, only copying if there is anything to decode.
+ *
+ * @param[in] mm Memory manager.
+ * @param[in] data_in URL data.
+ * @param[in] dlen_in Length of @a data_in.
+ * @param[out] data_out @a data_in itself if it has no % or +, otherwise
+ *             output data allocated from @a mm.
+ * @param[out] dlen_out Length of @a data_out.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EALLOC On allocation failure.
+ */
+ib_status_t DLL_PUBLIC ib_util_decode_url_const(
+    ib_mm_t          mm,
+    const uint8_t   *data_in,
+    size_t           dlen_in,
+    const uint8_t  **data_out,
+    size_t          *dlen_out
+)
+NONNULL_ATTRIBUTE(2, 4, 5);
+
 /**
  * Decode HTML entity.
  *
+ * Output is never longer than input.
+ *
  * @param[in] data_in HTML entity data.
  * @param[in] dlen_in Length of @a data_in.
- * @param[in] data_out Where to write output.
+ * @param[in] data_out Where to write output. May be @a data_in.
  * @param[out] dlen_out Bytes written to @a data_out.
  *
- * @returns Status code
- * - IB_OK: Success
- * - IB_EALLOC: Allocation error
+ * @returns IB_OK
  */
 ib_status_t DLL_PUBLIC ib_util_decode_html_entity(
     const uint8_t  *data_in,
@@ -79,6 +105,29 @@ ib_status_t DLL_PUBLIC ib_util_decode_html_entity(
 )
 NONNULL_ATTRIBUTE(1, 3, 4);
 
+/**
+ * Decode HTML entities, only copying if there is anything to decode.
+ *
+ * @param[in] mm Memory manager.
+ * @param[in] data_in HTML entity data.
+ * @param[in] dlen_in Length of @a data_in.
+ * @param[out] data_out @a data_in itself if it has no &, otherwise output
+ *             data allocated from @a mm.
+ * @param[out] dlen_out Length of @a data_out.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EALLOC On allocation failure.
+ */
+ib_status_t DLL_PUBLIC ib_util_decode_html_entity_const(
+    ib_mm_t          mm,
+    const uint8_t   *data_in,
+    size_t           dlen_in,
+    const uint8_t  **data_out,
+    size_t          *dlen_out
+)
+NONNULL_ATTRIBUTE(2, 4, 5);
+
 /** @} */
 
 #ifdef __cplusplus
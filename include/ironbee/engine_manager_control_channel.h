@@ -259,6 +259,8 @@ NONNULL_ATTRIBUTE(1);
  * Register the default manager control commands.
  *
  * The commands registered are:
+ * - rule_profile - enable (@c on), disable (@c off), @c reset or @c dump
+ *   the rule profile of the current engine. See ib_rule_profile_json().
  * - valgrind - run valgrind if the server container is being managed so.
  *
  * @param[in] channel The channel to register this command with.
@@ -26,6 +26,7 @@
  * @author Christopher Alfeld <calfeld@qualys.com>
  */
 
+#include <ironbee/atom.h>
 #include <ironbee/build.h>
 #include <ironbee/bytestr.h>
 #include <ironbee/clock.h>
@@ -218,6 +219,7 @@ struct ib_field_t {
     ib_ftype_t      type;      /**< Field type */
     const char     *name;      /**< Field name; not '\0' terminated! */
     size_t          nlen;      /**< Field name length */
+    const ib_atom_t *atom;     /**< Interned name or NULL if not known */
     const char     *tfn;       /**< Transformations performed */
     ib_field_val_t *val;       /**< Private value store */
 };
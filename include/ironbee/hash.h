@@ -118,6 +118,43 @@ typedef int (*ib_hash_equal_t)(
     void       *cbdata
 );
 
+/**
+ * Storage layout of a hash table.
+ *
+ * All ib_hash_* functions behave identically for either layout; the
+ * layouts differ in speed and in where memory comes from (see
+ * IB_HASH_LAYOUT_FLAT).
+ *
+ * @sa ib_hash_create_ex()
+ **/
+typedef enum {
+    /**
+     * Array of slots, each a linked list of entries.
+     *
+     * This is the layout used by ib_hash_create() and
+     * ib_hash_create_nocase().
+     **/
+    IB_HASH_LAYOUT_CHAINED,
+
+    /**
+     * Open addressed array with entries stored inline.
+     *
+     * Every slot carries a one byte tag derived from the hash value of its
+     * key.  Lookups compare groups of 16 tags at a time (using SSE2 where
+     * available) and only examine entries whose tag matches, so a lookup
+     * usually touches a single cache line of tags and a single entry.
+     * Removed entries leave tombstones which are reclaimed when the table
+     * is rebuilt.
+     *
+     * The slot arrays are allocated with malloc() rather than from the
+     * memory manager of the hash, so the arrays a rebuild replaces are
+     * released at once and a long lived hash with many removals does not
+     * grow its memory manager.  The current arrays are freed by a cleanup
+     * function registered with the memory manager.
+     **/
+    IB_HASH_LAYOUT_FLAT
+} ib_hash_layout_t;
+
 /**
  * @name Hash functions and equality predicates.
  * Functions suitable for use as ib_hash_function_t and ib_hash_equal_t.
@@ -251,6 +288,7 @@ NONNULL_ATTRIBUTE(1, 3);
  * @param[in]  mm              Memory manager to use.
  * @param[in]  size            The number of slots in the hash table.
  *                             Must be a power of 2.
+ * @param[in]  layout          Storage layout of the hash table.
  * @param[in]  hash_function   Hash function to use, e.g., ib_hashfunc_djb2().
  * @param[in]  hash_cbdata     Callback data for @a hash_function.
  * @param[in]  equal_predicate Predicate to use for key equality.
@@ -265,6 +303,7 @@ ib_status_t DLL_PUBLIC ib_hash_create_ex(
     ib_hash_t          **hash,
     ib_mm_t              mm,
     size_t               size,
+    ib_hash_layout_t     layout,
     ib_hash_function_t   hash_function,
     void                *hash_cbdata,
     ib_hash_equal_t      equal_predicate,
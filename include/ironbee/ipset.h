@@ -27,6 +27,7 @@
 
 #include <ironbee/build.h>
 #include <ironbee/ip.h>
+#include <ironbee/mm.h>
 #include <ironbee/types.h>
 
 #include <string.h>
@@ -63,6 +64,12 @@ extern "C" {
  * the number of negative networks, P is the number of positive networks, and
  * K is the number of matching positive entries.
  *
+ * Large sets may instead be initialized with ib_ipset4_init_compiled() or
+ * ib_ipset6_init_compiled().  These additionally build a lookup structure
+ * answering any query in a constant number of memory accesses: a DIR-16-8-8
+ * table for v4 and a poptrie (a multibit trie with 8 bit strides and
+ * bitmap compressed nodes) for v6.
+ *
  * The API is divided into v4 and v6 versions.  Besides the number of bytes in
  * the network address, the semantics are identical.
  *
@@ -127,6 +134,16 @@ typedef struct ib_ipset6_t ib_ipset6_t;
 
 /** @cond internal */
 
+/**
+ * Compiled lookup structure of an IPSet4.  See ib_ipset4_init_compiled().
+ */
+typedef struct ib_ipset4_compiled_t ib_ipset4_compiled_t;
+
+/**
+ * Compiled lookup structure of an IPSet6.  See ib_ipset6_init_compiled().
+ */
+typedef struct ib_ipset6_compiled_t ib_ipset6_compiled_t;
+
 /**
  * IP Set of IPv4 addresses.
  *
@@ -166,10 +183,11 @@ typedef struct ib_ipset6_t ib_ipset6_t;
  */
 struct ib_ipset4_t
 {
-    ib_ipset4_entry_t *positive;
-    size_t             num_positive;
-    ib_ipset4_entry_t *negative;
-    size_t             num_negative;
+    ib_ipset4_entry_t          *positive;
+    size_t                      num_positive;
+    ib_ipset4_entry_t          *negative;
+    size_t                      num_negative;
+    const ib_ipset4_compiled_t *compiled;
 };
 
 /**
@@ -179,10 +197,11 @@ struct ib_ipset4_t
  */
 struct ib_ipset6_t
 {
-    ib_ipset6_entry_t *positive;
-    size_t             num_positive;
-    ib_ipset6_entry_t *negative;
-    size_t             num_negative;
+    ib_ipset6_entry_t          *positive;
+    size_t                      num_positive;
+    ib_ipset6_entry_t          *negative;
+    size_t                      num_negative;
+    const ib_ipset6_compiled_t *compiled;
 };
 
 /** @endcond */
@@ -206,7 +225,7 @@ struct ib_ipset6_t
  * @param[in,out] negative     Negative networks of IP set.  Claimed by @a set
  *                             as part of creation.
  * @param[in]     num_negative Number of entries in @a negative.
- * @param[in,out] positive     Negative networks of IP set.  Claimed by @a set
+ * @param[in,out] positive     Positive networks of IP set.  Claimed by @a set
  *                             as part of creation.
  * @param[in]     num_positive Number of entries in @a positive.
  *
@@ -225,6 +244,47 @@ ib_status_t ib_ipset4_init(
     size_t             num_positive
 );
 
+/**
+ * Initialize an IPv4 set with a compiled lookup structure.
+ *
+ * As ib_ipset4_init() but additionally builds a DIR-16-8-8 table from
+ * @a mm: a table indexed by the first 16 bits of an address whose cells
+ * either hold the result directly or refer to a group of 256 cells indexed
+ * by the third byte, whose cells in turn may refer to a group indexed by
+ * the fourth byte.  A query then takes at most three memory accesses,
+ * independent of the number of networks, and reports the exact most
+ * specific and most general containing positive networks.
+ *
+ * The first table is 256 KiB.  Each distinct /16 containing a network
+ * longer than /16 and each distinct /24 containing a network longer than
+ * /24 adds a further 1 KiB, so at most 2 KiB per network.  This is
+ * intended for large sets, e.g., reputation lists.
+ *
+ * @param[out]    set          Set to initialize.
+ * @param[in,out] negative     Negative networks of IP set.  Claimed by @a set
+ *                             as part of creation.
+ * @param[in]     num_negative Number of entries in @a negative.
+ * @param[in,out] positive     Positive networks of IP set.  Claimed by @a set
+ *                             as part of creation.
+ * @param[in]     num_positive Number of entries in @a positive.
+ * @param[in]     mm           Memory manager to allocate the lookup
+ *                             structure from.  Must live at least as long
+ *                             as @a set.
+ *
+ * @return
+ * - IB_OK on success.
+ * - IB_EINVAL as for ib_ipset4_init() or if there are too many entries.
+ * - IB_EALLOC on allocation failure.
+ */
+ib_status_t ib_ipset4_init_compiled(
+    ib_ipset4_t       *set,
+    ib_ipset4_entry_t *negative,
+    size_t             num_negative,
+    ib_ipset4_entry_t *positive,
+    size_t             num_positive,
+    ib_mm_t            mm
+);
+
 /**
  * Query @a set for @a ip.
  *
@@ -246,6 +306,10 @@ ib_status_t ib_ipset4_init(
  * - \f$O(\log N + \log P + K)\f$ if K > 0 and either @a out_specific_entry or
  *   @a out_general_entry is not NULL.
  *
+ * If @a set was initialized with ib_ipset4_init_compiled(), runtime is
+ * \f$O(1)\f$ in all cases and @a out_entry is set to the most specific
+ * containing entry.
+ *
  * @param[in]  set                IP set to query.
  * @param[in]  ip                 IP to query.
  * @param[out] out_entry          If non-NULL and IP is in @a set, will be
@@ -283,6 +347,43 @@ ib_status_t ib_ipset6_init(
     size_t             num_positive
 );
 
+/**
+ * Initialize an IPv6 set with a compiled lookup structure.
+ *
+ * As ib_ipset6_init() but additionally builds a poptrie from @a mm.  Each
+ * trie node covers 8 bits of the address and stores its children and
+ * leaves contiguously, located by population counts of two 256 bit
+ * bitmaps.  Consecutive equal leaves are stored once.  A query visits at
+ * most 16 nodes and reports the exact most specific and most general
+ * containing positive networks.
+ *
+ * @sa ib_ipset4_init_compiled()
+ *
+ * @param[out]    set          Set to initialize.
+ * @param[in,out] negative     Negative networks of IP set.  Claimed by @a set
+ *                             as part of creation.
+ * @param[in]     num_negative Number of entries in @a negative.
+ * @param[in,out] positive     Positive networks of IP set.  Claimed by @a set
+ *                             as part of creation.
+ * @param[in]     num_positive Number of entries in @a positive.
+ * @param[in]     mm           Memory manager to allocate the lookup
+ *                             structure from.  Must live at least as long
+ *                             as @a set.
+ *
+ * @return
+ * - IB_OK on success.
+ * - IB_EINVAL as for ib_ipset6_init() or if there are too many entries.
+ * - IB_EALLOC on allocation failure.
+ */
+ib_status_t ib_ipset6_init_compiled(
+    ib_ipset6_t       *set,
+    ib_ipset6_entry_t *negative,
+    size_t             num_negative,
+    ib_ipset6_entry_t *positive,
+    size_t             num_positive,
+    ib_mm_t            mm
+);
+
 /**
  * As ib_ipset4_query() except for v6 addresses.
  *
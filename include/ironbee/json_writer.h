@@ -0,0 +1,346 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+#ifndef _IB_JSON_WRITER_H_
+#define _IB_JSON_WRITER_H_
+
+/**
+ * @file
+ * @brief IronBee --- Streaming JSON Writer
+ */
+
+#include <ironbee/build.h>
+#include <ironbee/field.h>
+#include <ironbee/types.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup IronBeeUtilJsonWriter Streaming JSON Writer
+ * @ingroup IronBeeUtil
+ *
+ * Write JSON directly into a growable buffer.
+ *
+ * Values are appended in document order, as with a SAX style generator.  In
+ * a map, strings alternate between keys and values; commas, colons and, for
+ * pretty output, newlines and indentation are inserted as needed.  Strings
+ * are escaped by copying runs of bytes that need no escape in bulk.  Bytes
+ * of 0x80 and above are copied as is.
+ *
+ * Errors are sticky: after the first error every call returns it and
+ * writes nothing, so a long sequence of calls may be checked once by
+ * ib_json_writer_buf().
+ *
+ * Each thread has a writer whose buffer is kept between uses; see
+ * ib_json_writer_acquire().  Writers are not thread safe.
+ *
+ * @{
+ */
+
+/**
+ * Streaming JSON writer.
+ *
+ * Treat as opaque.
+ **/
+typedef struct ib_json_writer_t ib_json_writer_t;
+
+/**
+ * Create a writer.
+ *
+ * The writer is malloc()ed and must be destroyed with
+ * ib_json_writer_destroy().
+ *
+ * @param[out] writer Created writer.
+ * @param[in]  pretty If true, indent output as yajl's beautify option does.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ **/
+ib_status_t DLL_PUBLIC ib_json_writer_create(
+    ib_json_writer_t **writer,
+    bool               pretty
+)
+NONNULL_ATTRIBUTE(1);
+
+/**
+ * Destroy a writer created by ib_json_writer_create().
+ *
+ * @param[in] writer Writer to destroy.  Nothing happens if NULL.
+ **/
+void DLL_PUBLIC ib_json_writer_destroy(
+    ib_json_writer_t *writer
+);
+
+/**
+ * Acquire the calling thread's writer.
+ *
+ * The thread's writer keeps its buffer, so once warm, writing does not
+ * allocate.  If it is already acquired, a new writer is created instead.
+ * Either way, the writer is empty and must be given back with
+ * ib_json_writer_release().
+ *
+ * @param[out] writer Writer.
+ * @param[in]  pretty If true, indent output.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ **/
+ib_status_t DLL_PUBLIC ib_json_writer_acquire(
+    ib_json_writer_t **writer,
+    bool               pretty
+)
+NONNULL_ATTRIBUTE(1);
+
+/**
+ * Release a writer acquired by ib_json_writer_acquire().
+ *
+ * The buffer of @a writer is invalid after this.
+ *
+ * @param[in] writer Writer to release.  Nothing happens if NULL.
+ **/
+void DLL_PUBLIC ib_json_writer_release(
+    ib_json_writer_t *writer
+);
+
+/**
+ * Empty @a writer, keeping its buffer, and clear any error.
+ *
+ * @param[in] writer Writer.
+ * @param[in] pretty If true, indent output.
+ **/
+void DLL_PUBLIC ib_json_writer_reset(
+    ib_json_writer_t *writer,
+    bool              pretty
+)
+NONNULL_ATTRIBUTE(1);
+
+/**
+ * Fetch the JSON written.
+ *
+ * @param[in]  writer Writer.
+ * @param[out] buf    JSON; NUL terminated.  Valid until the next call on
+ *                    @a writer.  May be NULL.
+ * @param[out] len    Length of @a buf.  May be NULL.
+ *
+ * @returns
+ * - IB_OK if a complete value has been written.
+ * - IB_EINVAL if a map or array is still open or nothing was written.
+ * - The first error of any earlier call.
+ **/
+ib_status_t DLL_PUBLIC ib_json_writer_buf(
+    const ib_json_writer_t  *writer,
+    const char             **buf,
+    size_t                  *len
+)
+NONNULL_ATTRIBUTE(1);
+
+/**
+ * Open a map.
+ *
+ * @param[in] writer Writer.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EINVAL if a key is expected or maps and arrays are nested too deep.
+ * - IB_EALLOC on allocation failure.
+ **/
+ib_status_t DLL_PUBLIC ib_json_writer_map_open(
+    ib_json_writer_t *writer
+)
+NONNULL_ATTRIBUTE(1);
+
+/**
+ * Close the innermost map.
+ *
+ * @param[in] writer Writer.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EINVAL if the innermost open value is not a map or a key has no
+ *   value.
+ * - IB_EALLOC on allocation failure.
+ **/
+ib_status_t DLL_PUBLIC ib_json_writer_map_close(
+    ib_json_writer_t *writer
+)
+NONNULL_ATTRIBUTE(1);
+
+/**
+ * Open an array.
+ *
+ * @param[in] writer Writer.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EINVAL if a key is expected or maps and arrays are nested too deep.
+ * - IB_EALLOC on allocation failure.
+ **/
+ib_status_t DLL_PUBLIC ib_json_writer_array_open(
+    ib_json_writer_t *writer
+)
+NONNULL_ATTRIBUTE(1);
+
+/**
+ * Close the innermost array.
+ *
+ * @param[in] writer Writer.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EINVAL if the innermost open value is not an array.
+ * - IB_EALLOC on allocation failure.
+ **/
+ib_status_t DLL_PUBLIC ib_json_writer_array_close(
+    ib_json_writer_t *writer
+)
+NONNULL_ATTRIBUTE(1);
+
+/**
+ * Write a string, as a key if a map key is expected.
+ *
+ * @param[in] writer Writer.
+ * @param[in] s      String; need not be NUL terminated.  May be NULL if
+ *                   @a len is 0.
+ * @param[in] len    Length of @a s.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EINVAL if a complete value has already been written.
+ * - IB_EALLOC on allocation failure.
+ **/
+ib_status_t DLL_PUBLIC ib_json_writer_string(
+    ib_json_writer_t *writer,
+    const char       *s,
+    size_t            len
+)
+NONNULL_ATTRIBUTE(1);
+
+/**
+ * Write a NUL terminated string, as a key if a map key is expected.
+ *
+ * @param[in] writer Writer.
+ * @param[in] s      String.
+ *
+ * @returns As ib_json_writer_string().
+ **/
+ib_status_t DLL_PUBLIC ib_json_writer_nulstr(
+    ib_json_writer_t *writer,
+    const char       *s
+)
+NONNULL_ATTRIBUTE(1, 2);
+
+/**
+ * Write an integer.
+ *
+ * @param[in] writer Writer.
+ * @param[in] num    Value.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EINVAL if a key is expected or a complete value has been written.
+ * - IB_EALLOC on allocation failure.
+ **/
+ib_status_t DLL_PUBLIC ib_json_writer_num(
+    ib_json_writer_t *writer,
+    ib_num_t          num
+)
+NONNULL_ATTRIBUTE(1);
+
+/**
+ * Write a floating point number.
+ *
+ * Integral values are written with a trailing `.0`, as yajl does.
+ *
+ * @param[in] writer Writer.
+ * @param[in] num    Value.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EINVAL if @a num is infinite or NaN, a key is expected or a complete
+ *   value has been written.
+ * - IB_EALLOC on allocation failure.
+ **/
+ib_status_t DLL_PUBLIC ib_json_writer_float(
+    ib_json_writer_t *writer,
+    double            num
+)
+NONNULL_ATTRIBUTE(1);
+
+/**
+ * Write a boolean.
+ *
+ * @param[in] writer Writer.
+ * @param[in] val    Value.
+ *
+ * @returns As ib_json_writer_num().
+ **/
+ib_status_t DLL_PUBLIC ib_json_writer_bool(
+    ib_json_writer_t *writer,
+    bool              val
+)
+NONNULL_ATTRIBUTE(1);
+
+/**
+ * Write null.
+ *
+ * @param[in] writer Writer.
+ *
+ * @returns As ib_json_writer_num().
+ **/
+ib_status_t DLL_PUBLIC ib_json_writer_null(
+    ib_json_writer_t *writer
+)
+NONNULL_ATTRIBUTE(1);
+
+/**
+ * Write a field.
+ *
+ * In a map, the field name is written as the key first.  Numbers, floats
+ * and strings are written as such and lists as maps of their fields.  NULL
+ * strings and other types are written as null.
+ *
+ * This is the encoding of ib_json_encode() without building a document.
+ *
+ * @param[in] writer Writer.
+ * @param[in] field  Field.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EINVAL if a key or no further value is expected.
+ * - IB_EALLOC on allocation failure.
+ * - Any error fetching the value of @a field.
+ **/
+ib_status_t DLL_PUBLIC ib_json_writer_field(
+    ib_json_writer_t *writer,
+    const ib_field_t *field
+)
+NONNULL_ATTRIBUTE(1, 2);
+
+/** @} IronBeeUtilJsonWriter */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _IB_JSON_WRITER_H_ */
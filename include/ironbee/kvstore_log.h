@@ -0,0 +1,149 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+#ifndef __IRONBEE__KVSTORE_LOG_H
+#define __IRONBEE__KVSTORE_LOG_H
+
+#include <ironbee/clock.h>
+#include <ironbee/kvstore.h>
+#include <ironbee/types.h>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+/**
+ * @file
+ * @brief IronBee --- Key-Value Log Structured Store Interface
+ */
+
+/**
+ * @addtogroup IronBeeKeyValueStore
+ * @ingroup IronBeeUtil
+ *
+ * The log structured store appends every set and remove as a record to
+ * the newest of a series of segment files in a directory and keeps the
+ * location of the current record of each key in an in-memory index.  A
+ * get is a hash lookup and a copy out of the memory mapped segment; a set
+ * is a single write.  The index is rebuilt from the segments on connect.
+ *
+ * Segments that are mostly superseded or expired records are compacted by
+ * a background thread: their current records are copied to the newest
+ * segment and the file is removed.  The store is locked for a bounded
+ * chunk of records at a time, so gets and sets proceed while a segment is
+ * compacted.
+ *
+ * A directory is used by one connection at a time; connecting fails
+ * while another connection, in this or another process, holds it.  A
+ * connection is usable only in the process that made it: in a child of
+ * that process every operation fails with IB_EOTHER until
+ * ib_kvstore_connect() is called in the child, which succeeds once the
+ * parent has disconnected.  So a forking server should connect after the
+ * fork, in the one process that uses the store.  Segments are written in
+ * host byte order.
+ *
+ * @{
+ */
+
+/**
+ * Initializes a kvstore that writes segment files to a directory.
+ *
+ * The directory is created, if needed, and read by ib_kvstore_connect().
+ *
+ * @param[out] kvstore Initialized with kvserver and some defaults.
+ * @param[in] directory The directory we will store this data in.
+ * @returns
+ *   - IB_OK on success
+ *   - IB_EALLOC on memory allocation failure using malloc.
+ */
+ib_status_t DLL_PUBLIC ib_kvstore_log_init(
+    ib_kvstore_t *kvstore,
+    const char   *directory
+);
+
+/**
+ * Set the file mode which segment files are created with.
+ *
+ * @param[in] kvstore Key-Value store.
+ * @param[in] mode The mode.
+ */
+void DLL_PUBLIC ib_kvstore_log_set_file_mode(
+    ib_kvstore_t *kvstore,
+    mode_t        mode
+);
+
+/**
+ * Set the size at which a new segment is started.
+ *
+ * A value larger than this cannot be stored.  Takes effect on the next
+ * connect.
+ *
+ * @param[in] kvstore Key-Value store.
+ * @param[in] size Segment size in bytes; at least 4096.  The default is
+ *            16 MiB.
+ */
+void DLL_PUBLIC ib_kvstore_log_set_segment_size(
+    ib_kvstore_t *kvstore,
+    size_t        size
+);
+
+/**
+ * Set how often the background thread looks for segments to compact.
+ *
+ * Takes effect on the next connect.
+ *
+ * @param[in] kvstore Key-Value store.
+ * @param[in] interval Interval in microseconds.  The default is 10
+ *            seconds.  If 0, there is no background compaction and only
+ *            ib_kvstore_log_compact() compacts.
+ */
+void DLL_PUBLIC ib_kvstore_log_set_compact_interval(
+    ib_kvstore_t *kvstore,
+    ib_time_t     interval
+);
+
+/**
+ * Compact segments now.
+ *
+ * Every segment except the newest that holds more superseded than current
+ * data, or only expired records, is compacted.
+ *
+ * @param[in] kvstore Connected key-value store.
+ *
+ * @returns
+ *   - IB_OK on success.
+ *   - IB_EALLOC on allocation failure.
+ *   - IB_EOTHER on file system failure.
+ */
+ib_status_t DLL_PUBLIC ib_kvstore_log_compact(
+    ib_kvstore_t *kvstore
+);
+
+/**
+ * Get the number of segment files.
+ *
+ * @param[in] kvstore Connected key-value store.
+ *
+ * @returns Number of segments.
+ */
+size_t DLL_PUBLIC ib_kvstore_log_segments(
+    ib_kvstore_t *kvstore
+);
+
+/**
+ * @}
+ */
+#endif /* __IRONBEE__KVSTORE_LOG_H */
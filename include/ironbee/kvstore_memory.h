@@ -0,0 +1,96 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+#ifndef __IRONBEE__KVSTORE_MEMORY_H
+#define __IRONBEE__KVSTORE_MEMORY_H
+
+#include <ironbee/kvstore.h>
+#include <ironbee/types.h>
+
+/**
+ * @file
+ * @brief IronBee --- Key-Value In-Memory Store Interface
+ */
+
+/**
+ * @addtogroup IronBeeKeyValueStore
+ * @ingroup IronBeeUtil
+ *
+ * The in-memory store keeps values in the process only; they are lost when
+ * the store is destroyed.  Keys are spread over a fixed number of shards,
+ * each a hash with its own lock, so threads using different keys rarely
+ * wait on each other.  If the store has a size limit, each shard evicts
+ * its least recently used entry to make room.
+ *
+ * As with the filesystem store, the expiration of a value is relative to
+ * the time of the set and absolute in a value returned by a get.
+ *
+ * On set of a key that holds an unexpired value, the merge policy is
+ * called with the new value as the first and the stored value as the
+ * second element of @c values, and the result is stored.  The expiration
+ * of the stored value is given relative to now.  The merge policy is
+ * called with the shard locked and must not use the store.  The default
+ * merge policy returns the new value.
+ *
+ * @{
+ */
+
+/**
+ * Initializes an in-memory kvstore.
+ *
+ * @param[out] kvstore Initialized with kvserver and some defaults.
+ * @param[in] max_entries Maximum number of entries; 0 for no limit.  The
+ *            limit is applied per shard, so entries may be evicted before
+ *            the store holds @a max_entries entries.
+ * @returns
+ *   - IB_OK on success
+ *   - IB_EALLOC on memory allocation failure.
+ */
+ib_status_t DLL_PUBLIC ib_kvstore_memory_init(
+    ib_kvstore_t *kvstore,
+    size_t        max_entries
+);
+
+/**
+ * Get the number of entries, including expired entries not yet removed.
+ *
+ * @param[in] kvstore Key-value store.
+ *
+ * @returns Number of entries.
+ */
+size_t DLL_PUBLIC ib_kvstore_memory_entries(
+    ib_kvstore_t *kvstore
+);
+
+/**
+ * Get the memory held by the store.
+ *
+ * This is the footprint of the pool holding the locks and hashes plus the
+ * size of all entries, including expired entries not yet removed.
+ *
+ * @param[in] kvstore Key-value store.
+ *
+ * @returns Bytes held.
+ */
+size_t DLL_PUBLIC ib_kvstore_memory_footprint(
+    ib_kvstore_t *kvstore
+);
+
+/**
+ * @}
+ */
+#endif /* __IRONBEE__KVSTORE_MEMORY_H */
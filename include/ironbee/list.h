@@ -44,6 +44,14 @@ extern "C" {
  *
  * This is currently implemented as a doubly linked list.
  *
+ * Nodes are allocated in chunks of up to 16 so that nodes appended one
+ * after another are mostly adjacent in memory and iteration is close to a
+ * sequential scan.
+ *
+ * Nodes removed by ib_list_pop(), ib_list_shift() or ib_list_node_remove()
+ * are released to the memory manager and may be reused by any later
+ * allocation, so a removed node must not be used; take its data first.
+ *
  * @{
  */
 
@@ -65,6 +73,10 @@ struct ib_list_node_t {
 struct ib_list_t {
     ib_mm_t mm;
     IB_LIST_GEN_REQ_FIELDS(ib_list_node_t);       /* Required fields */
+    ib_list_node_t    *spare;                 /**< Unused allocated nodes */
+    size_t             nspare;                /**< Number of spare nodes */
+    size_t             nalloc;                /**< Number of nodes allocated */
+    size_t             generation;            /**< Changed on each mutation */
 };
 /** @endcond */
 
@@ -167,6 +179,19 @@ void DLL_PUBLIC ib_list_clear(ib_list_t *list);
  */
 size_t DLL_PUBLIC ib_list_elements(const ib_list_t *list);
 
+/**
+ * Return the generation of the list.
+ *
+ * The generation changes whenever an element is inserted, removed or
+ * replaced with ib_list_node_data_set(), or the list is cleared, so it can
+ * be used to tell whether data derived from the list is stale.
+ *
+ * @param list List
+ *
+ * @returns Generation of the list
+ */
+size_t DLL_PUBLIC ib_list_generation(const ib_list_t *list);
+
 /**
  * Return first node in the list or NULL if there are no elements.
  *
@@ -242,6 +267,9 @@ const ib_list_node_t DLL_PUBLIC *ib_list_node_prev_const(const ib_list_node_t *n
 /**
  * Remove a node from the list.
  *
+ * The node may be reused by later insertions and must not be used after
+ * this call.  Fetch its data first.
+ *
  * @param list List
  * @param node Node in a list
  */
@@ -268,13 +296,17 @@ const void DLL_PUBLIC *ib_list_node_data_const(const ib_list_node_t *node);
 /**
  * Set @a node 's data value.
  *
+ * This changes the generation of @a list.
+ *
+ * @param[in] list The list holding @a node.
  * @param[in] node The node whose data element to set.
  * @param[in] data The data pointer to set.
  */
 void DLL_PUBLIC ib_list_node_data_set(
+    ib_list_t      *list,
     ib_list_node_t *node,
     void           *data
-) NONNULL_ATTRIBUTE(1);
+) NONNULL_ATTRIBUTE(1, 2);
 
 /**
  * Copy all items from @a src_list to @a dest_list.
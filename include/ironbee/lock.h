@@ -30,6 +30,8 @@
 #include <ironbee/mm.h>
 
 #include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -72,6 +74,18 @@ ib_status_t DLL_PUBLIC ib_lock_create(ib_lock_t **lock, ib_mm_t mm);
  */
 ib_status_t DLL_PUBLIC ib_lock_lock(ib_lock_t *lock);
 
+/**
+ * Acquire @a lock if it is free.
+ *
+ * @param[in] lock The lock.
+ *
+ * @returns
+ * - IB_OK If the lock was acquired.
+ * - IB_DECLINED If the lock is held.
+ * - IB_EUNKNOWN On any other failure.
+ */
+ib_status_t DLL_PUBLIC ib_lock_trylock(ib_lock_t *lock);
+
 /**
  * @param[in] lock The lock.
  */
@@ -95,6 +109,249 @@ ib_status_t DLL_PUBLIC ib_lock_create_malloc(ib_lock_t **lock);
  */
 void DLL_PUBLIC ib_lock_destroy_malloc(ib_lock_t *lock);
 
+/**
+ * @brief Condition variable waited on with an @ref ib_lock_t.
+ *
+ * As with @ref ib_lock_t, condition variables exist only as pointers.
+ */
+typedef pthread_cond_t ib_cond_t;
+
+/**
+ * Create a new condition variable using the given memory manager.
+ *
+ * @param[out] cond The condition variable.
+ * @param[in] mm The memory manager.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EALLOC If it cannot be allocated or initialized.
+ * - IB_EOTHER If it cannot be scheduled for destruction in @a mm.
+ */
+ib_status_t DLL_PUBLIC ib_cond_create(ib_cond_t **cond, ib_mm_t mm);
+
+/**
+ * Release @a lock, wait for @a cond to be signaled and reacquire @a lock.
+ *
+ * Waits may end without a signal, so check the awaited state in a loop.
+ *
+ * @param[in] cond The condition variable.
+ * @param[in] lock The lock; held by the caller.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EUNKNOWN On failure.
+ */
+ib_status_t DLL_PUBLIC ib_cond_wait(ib_cond_t *cond, ib_lock_t *lock);
+
+/**
+ * Wake all waiters on @a cond.
+ *
+ * @param[in] cond The condition variable.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EUNKNOWN On failure.
+ */
+ib_status_t DLL_PUBLIC ib_cond_broadcast(ib_cond_t *cond);
+
+/**
+ * Contention counters of a lock.
+ *
+ * Counters are only maintained while enabled on the lock, see
+ * ib_rwlock_stats_enable() and ib_spinlock_stats_enable().
+ */
+typedef struct ib_lock_stats_t ib_lock_stats_t;
+
+/**
+ * @brief Contention counters of a lock.
+ */
+struct ib_lock_stats_t {
+    uint64_t acquisitions; /**< Number of times the lock was taken. */
+    uint64_t contended;    /**< Acquisitions that had to wait. */
+    uint64_t wait_ns;      /**< Total nanoseconds spent waiting. */
+};
+
+/**
+ * @brief Reader-writer lock.
+ *
+ * Any number of readers or a single writer may hold the lock.
+ */
+typedef struct ib_rwlock_t ib_rwlock_t;
+
+/**
+ * Create a new reader-writer lock using the given memory manager.
+ *
+ * As with @ref ib_lock_t, reader-writer locks exist only as pointers.
+ *
+ * @param[out] lock The lock.
+ * @param[in] mm The memory manager.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EALLOC If the lock cannot be allocated or initialized.
+ * - IB_EOTHER If the lock cannot be schedule for destruction in @a mm.
+ */
+ib_status_t DLL_PUBLIC ib_rwlock_create(ib_rwlock_t **lock, ib_mm_t mm);
+
+/**
+ * Create a reader-writer lock when there is no memory manager available.
+ *
+ * @param[out] lock The lock.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EALLOC If the lock cannot be allocated or initialized.
+ */
+ib_status_t DLL_PUBLIC ib_rwlock_create_malloc(ib_rwlock_t **lock);
+
+/**
+ * Destroy a lock created by ib_rwlock_create_malloc().
+ *
+ * @param[in] lock The lock.
+ */
+void DLL_PUBLIC ib_rwlock_destroy_malloc(ib_rwlock_t *lock);
+
+/**
+ * Acquire @a lock for reading.
+ *
+ * @param[in] lock The lock.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EUNKNOWN On pthread failure.
+ */
+ib_status_t DLL_PUBLIC ib_rwlock_rdlock(ib_rwlock_t *lock);
+
+/**
+ * Acquire @a lock for writing.
+ *
+ * @param[in] lock The lock.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EUNKNOWN On pthread failure.
+ */
+ib_status_t DLL_PUBLIC ib_rwlock_wrlock(ib_rwlock_t *lock);
+
+/**
+ * Release @a lock held for reading or writing.
+ *
+ * @param[in] lock The lock.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EUNKNOWN On pthread failure.
+ */
+ib_status_t DLL_PUBLIC ib_rwlock_unlock(ib_rwlock_t *lock);
+
+/**
+ * Enable or disable contention counters on @a lock.
+ *
+ * Enabling resets the counters. While disabled, acquiring the lock costs
+ * nothing extra.
+ *
+ * @param[in] lock The lock.
+ * @param[in] enable Maintain counters if true.
+ */
+void DLL_PUBLIC ib_rwlock_stats_enable(ib_rwlock_t *lock, bool enable);
+
+/**
+ * Fetch the contention counters of @a lock.
+ *
+ * @param[in] lock The lock.
+ * @param[out] read Counters of read acquisitions. May be NULL.
+ * @param[out] write Counters of write acquisitions. May be NULL.
+ */
+void DLL_PUBLIC ib_rwlock_stats(
+    const ib_rwlock_t *lock,
+    ib_lock_stats_t   *read,
+    ib_lock_stats_t   *write
+);
+
+/**
+ * @brief Adaptive spin lock.
+ *
+ * A waiter spins for a short while and then yields the processor between
+ * attempts. Use it only for critical sections of a few instructions.
+ */
+typedef struct ib_spinlock_t ib_spinlock_t;
+
+/**
+ * Create a new spin lock using the given memory manager.
+ *
+ * @param[out] lock The lock.
+ * @param[in] mm The memory manager.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EALLOC If the lock cannot be allocated.
+ */
+ib_status_t DLL_PUBLIC ib_spinlock_create(ib_spinlock_t **lock, ib_mm_t mm);
+
+/**
+ * Create a spin lock when there is no memory manager available.
+ *
+ * @param[out] lock The lock.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EALLOC If the lock cannot be allocated.
+ */
+ib_status_t DLL_PUBLIC ib_spinlock_create_malloc(ib_spinlock_t **lock);
+
+/**
+ * Destroy a lock created by ib_spinlock_create_malloc().
+ *
+ * @param[in] lock The lock.
+ */
+void DLL_PUBLIC ib_spinlock_destroy_malloc(ib_spinlock_t *lock);
+
+/**
+ * Acquire @a lock, waiting as long as it takes.
+ *
+ * @param[in] lock The lock.
+ */
+void DLL_PUBLIC ib_spinlock_lock(ib_spinlock_t *lock);
+
+/**
+ * Acquire @a lock if it is free.
+ *
+ * @param[in] lock The lock.
+ *
+ * @returns
+ * - IB_OK If the lock was acquired.
+ * - IB_DECLINED If the lock is held.
+ */
+ib_status_t DLL_PUBLIC ib_spinlock_trylock(ib_spinlock_t *lock);
+
+/**
+ * Release @a lock.
+ *
+ * @param[in] lock The lock.
+ */
+void DLL_PUBLIC ib_spinlock_unlock(ib_spinlock_t *lock);
+
+/**
+ * Enable or disable contention counters on @a lock.
+ *
+ * Enabling resets the counters.
+ *
+ * @param[in] lock The lock.
+ * @param[in] enable Maintain counters if true.
+ */
+void DLL_PUBLIC ib_spinlock_stats_enable(ib_spinlock_t *lock, bool enable);
+
+/**
+ * Fetch the contention counters of @a lock.
+ *
+ * @param[in] lock The lock.
+ * @param[out] stats The counters.
+ */
+void DLL_PUBLIC ib_spinlock_stats(
+    const ib_spinlock_t *lock,
+    ib_lock_stats_t     *stats
+);
+
 /**
  * @} IronBeeUtilLocking Locking
  */
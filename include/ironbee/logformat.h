@@ -85,10 +85,21 @@ typedef struct ib_logformat_item_t {
     } item;
 } ib_logformat_item_t;
 
+/**
+ * Compiled format operation: copy a literal or fetch a field.
+ */
+typedef struct ib_logformat_op_t {
+    const ib_logformat_field_t *field; /* Field to fetch; NULL for literal */
+    const char                 *str;   /* Literal text */
+    size_t                      len;   /* Length of literal */
+} ib_logformat_op_t;
+
 struct ib_logformat_t {
-    ib_mm_t      mm;
-    char        *format;
-    ib_list_t   *items;          /* List of pointers to ib_logformat_item_t */
+    ib_mm_t            mm;
+    char              *format;
+    ib_list_t         *items;    /* List of pointers to ib_logformat_item_t */
+    ib_logformat_op_t *ops;      /* Items compiled by ib_logformat_parse() */
+    size_t             num_ops;  /* Number of elements of ops */
 };
 
 /**
@@ -107,6 +118,25 @@ typedef ib_status_t (* ib_logformat_fn_t)(
     const void                  *cbdata,
     const char                 **str);
 
+/**
+ * Callback function to get an individual data item and its length
+ *
+ * @param[in] lf Logformat data
+ * @param[in] field Data on the field to get
+ * @param[in] cbdata Callback-specific data
+ * @param[out] str String representation of the item to add to line; need
+ *             not be NUL terminated
+ * @param[out] len Length of @a str
+ *
+ * @returns Status code
+ */
+typedef ib_status_t (* ib_logformat_len_fn_t)(
+    const ib_logformat_t        *lf,
+    const ib_logformat_field_t  *field,
+    const void                  *cbdata,
+    const char                 **str,
+    size_t                      *len);
+
 /**
  * Creates a logformat helper
  *
@@ -120,6 +150,9 @@ ib_status_t ib_logformat_create(ib_mm_t mm, ib_logformat_t **lf);
 /**
  * Used to parse and store the specified format
  *
+ * The format is compiled into a flat list of operations so that formatting
+ * a line never looks at the format string again.
+ *
  * @param lf pointer to the logformat helper
  * @param format string with the format to process
  *
@@ -146,6 +179,31 @@ ib_status_t ib_logformat_format(const ib_logformat_t *lf,
                                 ib_logformat_fn_t fn,
                                 void *fndata);
 
+/**
+ * Used to format a parsed logformat line with length aware callbacks.
+ *
+ * As ib_logformat_format() but @a fn reports the length of each field, so
+ * the line is written in one pass with no string length scans.
+ *
+ * @param[in] lf Pointer to the logformat helper
+ * @param[in,out] line Line buffer
+ * @param[in] line_size Size of @a line
+ * @param[out] line_len Length of data written to @a line_size
+ * @param[in] fn Callback function to get an individual field
+ * @param[in] fndata Callback specific data
+ *
+ * @returns Status code
+ * - IB_OK On success.
+ * - IB_ETRUNC If the line was truncated to fit @a line.
+ * - Any error from @a fn.
+ */
+ib_status_t ib_logformat_write(const ib_logformat_t *lf,
+                               char *line,
+                               size_t line_size,
+                               size_t *line_len,
+                               ib_logformat_len_fn_t fn,
+                               void *fndata);
+
 /** @} IronBeeUtilLogformat */
 
 
@@ -555,7 +555,9 @@ ib_status_t ib_logger_reopen(
  *
  * @returns
  * - IB_OK On success.
- * - Other On failure.
+ * - Other On failure to lock the queue or to wake producers blocked on it.
+ *   All queued records are handled even if waking fails, and the first
+ *   error is returned.
  */
 ib_status_t DLL_PUBLIC ib_logger_dequeue(
     ib_logger_t           *logger,
@@ -564,6 +566,67 @@ ib_status_t DLL_PUBLIC ib_logger_dequeue(
     void                  *cbdata
 );
 
+/**
+ * What a writer does with a new record when its queue is full.
+ */
+enum ib_logger_overflow_t {
+    /**
+     * Wait until the writer dequeues records. This is the default.
+     */
+    IB_LOGGER_OVERFLOW_BLOCK,
+
+    /**
+     * Discard the new record.
+     */
+    IB_LOGGER_OVERFLOW_DROP_NEWEST,
+
+    /**
+     * Discard the oldest queued record to make room for the new one.
+     */
+    IB_LOGGER_OVERFLOW_DROP_OLDEST
+};
+typedef enum ib_logger_overflow_t ib_logger_overflow_t;
+
+/**
+ * Set what writers of @a logger do when their queue is full.
+ *
+ * Records discarded because of this policy are freed with
+ * the writer's @ref ib_logger_format_free_fn_t and counted by
+ * ib_logger_dropped().
+ *
+ * @param[in] logger The logger.
+ * @param[in] overflow The overflow policy.
+ */
+void DLL_PUBLIC ib_logger_overflow_set(
+    ib_logger_t          *logger,
+    ib_logger_overflow_t  overflow
+);
+
+/**
+ * Set the queue capacity of writers added to @a logger after this call.
+ *
+ * Queues are lock-free rings; @a depth is rounded up to a power of two.
+ * The default is 1024.
+ *
+ * @param[in] logger The logger.
+ * @param[in] depth Minimum number of records a writer queue holds.
+ */
+void DLL_PUBLIC ib_logger_queue_depth_set(
+    ib_logger_t *logger,
+    size_t       depth
+);
+
+/**
+ * Number of records discarded because a writer queue was full.
+ *
+ * @param[in] logger The logger.
+ *
+ * @returns The number of dropped records.
+ */
+size_t DLL_PUBLIC ib_logger_dropped(
+    const ib_logger_t *logger
+);
+
 /**
  * A standard logger log message format.
  *
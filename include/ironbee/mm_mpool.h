@@ -47,6 +47,30 @@ extern "C" {
 ib_mm_t DLL_PUBLIC ib_mm_mpool(ib_mpool_t *mp)
 NONNULL_ATTRIBUTE(1);
 
+/**
+ * Allocate a small fixed size object.
+ *
+ * If @a mm was created by ib_mm_mpool(), this is ib_mpool_alloc_fixed();
+ * otherwise it is ib_mm_alloc().
+ *
+ * @param[in] mm   Memory manager.
+ * @param[in] size Size of object in bytes.
+ * @return Address of allocated memory or NULL on any error.
+ **/
+void DLL_PUBLIC *ib_mm_alloc_fixed(ib_mm_t mm, size_t size);
+
+/**
+ * Release an object allocated by ib_mm_alloc_fixed().
+ *
+ * If @a mm was created by ib_mm_mpool(), this is ib_mpool_free_fixed();
+ * otherwise it does nothing.  Either way, @a ptr must not be used after.
+ *
+ * @param[in] mm   Memory manager @a ptr was allocated from.
+ * @param[in] ptr  Object to release.  Nothing happens if NULL.
+ * @param[in] size Size passed to ib_mm_alloc_fixed().
+ **/
+void DLL_PUBLIC ib_mm_free_fixed(ib_mm_t mm, void *ptr, size_t size);
+
 /** @} IronBeeUtilMM */
 
 #ifdef __cplusplus
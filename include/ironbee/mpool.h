@@ -215,6 +215,22 @@ size_t DLL_PUBLIC ib_mpool_inuse(
     const ib_mpool_t* mp
 );
 
+/**
+ * Get the amount of memory held by a memory pool and its descendants.
+ *
+ * This is the size of all pages of @a mp and of its current and released
+ * child pools, whether in use or kept free for reuse, plus large
+ * allocations.  It is the memory that ib_mpool_reset() retains.
+ *
+ * This function is not thread safe with respect to @a mp.
+ *
+ * @param[in] mp Memory pool to query.
+ * @returns Bytes held.
+ */
+size_t DLL_PUBLIC ib_mpool_footprint(
+    const ib_mpool_t *mp
+);
+
 /**
  * Assure that at least @a pages pages are preallocated in the free pages list.
  *
@@ -232,6 +248,56 @@ ib_status_t DLL_PUBLIC ib_mpool_prealloc_pages(
     int pages
 );
 
+/**
+ * Set the per-thread page cache high-water mark.
+ *
+ * Pools with the default page size, malloc() and free() return their pages
+ * and large allocation pointer pages to a cache local to the destroying
+ * thread instead of freeing them.  Pools created on the same thread then
+ * take pages from that cache before calling malloc().  This avoids a
+ * malloc()/free() round trip per page for short lived pools such as
+ * connection and transaction pools.
+ *
+ * Each thread keeps at most @a limit pages and @a limit pointer pages;
+ * further pages are freed.  Pages still cached when a thread exits are
+ * freed.  A limit of 0 disables the cache.  Lowering the limit does not
+ * trim existing caches; see ib_mpool_page_cache_flush().
+ *
+ * This should be called before worker threads begin to use pools.
+ *
+ * @param[in] limit Maximum number of cached pages per thread.
+ */
+void DLL_PUBLIC ib_mpool_page_cache_set_limit(
+    size_t limit
+);
+
+/**
+ * Get the per-thread page cache high-water mark.
+ *
+ * @sa ib_mpool_page_cache_set_limit()
+ *
+ * @returns Maximum number of cached pages per thread.
+ */
+size_t DLL_PUBLIC ib_mpool_page_cache_limit(void);
+
+/**
+ * Get the number of pages in the calling thread's page cache.
+ *
+ * Pointer pages are not counted.
+ *
+ * @sa ib_mpool_page_cache_set_limit()
+ *
+ * @returns Number of cached pages.
+ */
+size_t DLL_PUBLIC ib_mpool_page_cache_size(void);
+
+/**
+ * Free all pages in the calling thread's page cache.
+ *
+ * @sa ib_mpool_page_cache_set_limit()
+ */
+void DLL_PUBLIC ib_mpool_page_cache_flush(void);
+
 /**
  * Allocate memory from a memory pool.
  *
@@ -249,6 +315,45 @@ void DLL_PUBLIC *ib_mpool_alloc(
 )
 NONNULL_ATTRIBUTE(1);
 
+/**
+ * Allocate a small fixed size object from a memory pool.
+ *
+ * Each small size has its own free list, filled by ib_mpool_free_fixed(),
+ * and otherwise objects are carved from the pool many at a time.  This is
+ * faster than ib_mpool_alloc() for objects that are allocated very often,
+ * such as fields and list nodes, and lets released objects be reused before
+ * the pool is cleared.
+ *
+ * Sizes above 160 bytes are passed to ib_mpool_alloc().
+ *
+ * @param[in] mp   Memory pool to allocate from.
+ * @param[in] size Size of object in bytes.
+ *
+ * @returns Address of allocated memory or NULL on any error.
+ */
+void DLL_PUBLIC *ib_mpool_alloc_fixed(
+    ib_mpool_t *mp,
+    size_t      size
+)
+NONNULL_ATTRIBUTE(1);
+
+/**
+ * Release an object allocated by ib_mpool_alloc_fixed().
+ *
+ * The object is reused by a later ib_mpool_alloc_fixed() of a similar size.
+ * It must not be used after this call.
+ *
+ * @param[in] mp   Memory pool @a ptr was allocated from.
+ * @param[in] ptr  Object to release.  Nothing happens if NULL.
+ * @param[in] size Size passed to ib_mpool_alloc_fixed().
+ */
+void DLL_PUBLIC ib_mpool_free_fixed(
+    ib_mpool_t *mp,
+    void       *ptr,
+    size_t      size
+)
+NONNULL_ATTRIBUTE(1);
+
 /**
  * Deallocate all memory allocated from the pool and any descendant pools.
  *
@@ -306,6 +411,24 @@ void DLL_PUBLIC ib_mpool_release(
     ib_mpool_t *mp
 );
 
+/**
+ * Clear pool and release all child pools to it.
+ *
+ * This resets @a mp in place for reuse: all memory allocated from @a mp is
+ * retained for future allocations as with ib_mpool_clear() and all child
+ * pools are released as with ib_mpool_release(), so that ib_mpool_create()
+ * with @a mp as parent reuses them along with their pages.
+ *
+ * This will call all cleanup functions of @a mp and its descendants.
+ *
+ * Nothing happens if @a mp is NULL.
+ *
+ * @param[in] mp Memory pool to reset.
+ */
+void DLL_PUBLIC ib_mpool_reset(
+    ib_mpool_t *mp
+);
+
 /**
  * Register a function to be called when a memory pool is cleared or
  * destroyed.
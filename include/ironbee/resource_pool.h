@@ -252,6 +252,36 @@ ib_status_t DLL_PUBLIC ib_resource_pool_set_max(
 )
 NONNULL_ATTRIBUTE(1);
 
+/**
+ * Make @a pool safe to use from several threads without external locking.
+ *
+ * The pool then guards itself with an internal lock and gives each thread
+ * a cache slot holding the resource that thread last released.
+ * ib_resource_acquire() takes the resource in the calling thread's slot,
+ * if any, and ib_resource_release() puts the resource in it. Both do so
+ * with a single atomic exchange, without the lock. Only a resource pushed
+ * out of a slot, a slot miss and resource creation or destruction take the
+ * lock. When the pool has reached its maximum, an acquire that misses
+ * takes a cached resource from another thread's slot before declining.
+ *
+ * The preuse and postuse callbacks are still called on every acquire and
+ * release. The minimum and maximum limits count cached resources.
+ *
+ * This must be called before @a pool is shared between threads and cannot
+ * be undone.
+ *
+ * @param[in] pool The pool.
+ *
+ * @return
+ * - IB_OK On success.
+ * - IB_EALLOC On allocation failure.
+ * - Other If the lock cannot be created.
+ */
+ib_status_t DLL_PUBLIC ib_resource_pool_set_threaded(
+    ib_resource_pool_t *pool
+)
+NONNULL_ATTRIBUTE(1);
+
 /** @} IronBeeUtilResourcePool */
 
 #ifdef __cplusplus
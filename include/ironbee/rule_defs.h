@@ -72,6 +72,11 @@ typedef enum {
  * If the external flag is set, the rule engine will always execute the
  * operator, passing NULL in as the field pointer.  The external rule is
  * expected to extract whatever fields, etc. it requires itself.
+ *
+ * The skip-absent flag is set by the rule engine when a context is closed
+ * on rules that can have no effect if none of their targets are present;
+ * such rules are not evaluated in a transaction where every target source
+ * is unset or an empty collection.
  */
 #define IB_RULE_FLAG_NONE     (0x0)     /**< No flags */
 #define IB_RULE_FLAG_VALID    (1 << 0)  /**< Rule is valid */
@@ -87,6 +92,7 @@ typedef enum {
 #define IB_RULE_FLAG_ACTION   (IB_RULE_FLAG_NO_TGT)
 #define IB_RULE_FLAG_FIELDS   (1 << 9) /**< Create FIELD_xxx fields */
 #define IB_RULE_FLAG_TRACE    (1 << 10) /**< Trace rule */
+#define IB_RULE_FLAG_SKIP_ABSENT (1 << 11) /**< Skip if no target present */
 
 /**
  * Rule execution flags
@@ -28,6 +28,7 @@
 #include <ironbee/action.h>
 #include <ironbee/build.h>
 #include <ironbee/config.h>
+#include <ironbee/hash.h>
 #include <ironbee/operator.h>
 #include <ironbee/rule_defs.h>
 #include <ironbee/types.h>
@@ -156,14 +157,28 @@ struct ib_rule_exec_t {
     /* Rule stack (for chains) */
     ib_list_t              *rule_stack;  /**< Stack of rules */
 
-    /* List of all rules to run during the current phase. */
-    ib_list_t              *phase_rules; /**< List of ib_rule_t */
+    /**
+     * List of ib_rule_t injected for the current phase.
+     *
+     * Created on first use by a phase with rule injectors; the context's
+     * own rules are not copied here.
+     */
+    ib_list_t              *phase_rules;
 
     /**
      * Stack of @ref ib_field_t used for creating FIELD* targets
      */
     ib_list_t              *value_stack;
 
+    /**
+     * Transformation results of this transaction, shared by all rules.
+     *
+     * Created on first use.
+     */
+    ib_hash_t              *tfn_memo;
+    size_t                  tfn_memo_hits;   /**< Results found in tfn_memo */
+    size_t                  tfn_memo_misses; /**< Results added to tfn_memo */
+
 #ifdef IB_RULE_TRACE
     ib_rule_trace_t        *traces; /**< Rule trace information. */
 #endif
@@ -0,0 +1,182 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+#ifndef _IB_RULE_PROFILE_H_
+#define _IB_RULE_PROFILE_H_
+
+/**
+ * @file
+ * @brief IronBee --- Rule profiling
+ */
+
+#include <ironbee/build.h>
+#include <ironbee/clock.h>
+#include <ironbee/engine_types.h>
+#include <ironbee/mm.h>
+#include <ironbee/types.h>
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup IronBeeRuleProfile Rule Profiling
+ * @ingroup IronBeeRule
+ *
+ * Count and time rule evaluations across transactions.
+ *
+ * While profiling is enabled, each evaluation of a rule's operator on its
+ * targets is timed and counted along with whether the rule matched.  Time
+ * spent in chained rules is counted in those rules.  Each thread adds to
+ * its own counters, so threads do not wait on each other; the counters of
+ * all threads are merged when the profile is read.
+ *
+ * The profile is rendered as JSON:
+ *
+ * @code
+ * {
+ *   "enabled": true,
+ *   "rules": [
+ *     { "id": "...", "operator": "rx", "evaluations": 10, "matches": 1,
+ *       "match_rate": 0.1, "total_usec": 120, "p99_usec": 31 }
+ *   ],
+ *   "operators": [
+ *     { "operator": "rx", "rules": 1, "evaluations": 10, "matches": 1,
+ *       "match_rate": 0.1, "total_usec": 120, "p99_usec": 31 }
+ *   ]
+ * }
+ * @endcode
+ *
+ * Only rules evaluated at least once are listed; rules and operators are
+ * ordered by total time, most first.  The 99th percentile is taken from a
+ * histogram with power of two buckets, so it is an upper bound that is at
+ * most twice the true value, and never more than the longest evaluation.
+ *
+ * @{
+ */
+
+/**
+ * Default interval between writes of the profile file.
+ */
+#define IB_RULE_PROFILE_INTERVAL_DEFAULT (60 * 1000000LU)
+
+/**
+ * Enable or disable profiling.
+ *
+ * May be called at any time, from any thread.  Disabling keeps the counts
+ * collected so far.
+ *
+ * @param[in] ib     IronBee engine.
+ * @param[in] enable True to enable, false to disable.
+ */
+void DLL_PUBLIC ib_rule_profile_enable(
+    ib_engine_t *ib,
+    bool         enable
+)
+NONNULL_ATTRIBUTE(1);
+
+/**
+ * Is profiling enabled?
+ *
+ * @param[in] ib IronBee engine.
+ *
+ * @returns true iff profiling is enabled.
+ */
+bool DLL_PUBLIC ib_rule_profile_enabled(
+    const ib_engine_t *ib
+)
+NONNULL_ATTRIBUTE(1);
+
+/**
+ * Discard all counts.
+ *
+ * @param[in] ib IronBee engine.
+ */
+void DLL_PUBLIC ib_rule_profile_reset(
+    ib_engine_t *ib
+)
+NONNULL_ATTRIBUTE(1);
+
+/**
+ * Render the profile as JSON.
+ *
+ * @param[in]  ib   IronBee engine.
+ * @param[in]  mm   Memory manager to allocate @a json from.
+ * @param[out] json JSON; NUL terminated.
+ * @param[out] len  Length of @a json.  May be NULL.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ */
+ib_status_t DLL_PUBLIC ib_rule_profile_json(
+    const ib_engine_t  *ib,
+    ib_mm_t             mm,
+    const char        **json,
+    size_t             *len
+)
+NONNULL_ATTRIBUTE(1, 3);
+
+/**
+ * Write the profile to @a path periodically.
+ *
+ * At the end of a transaction, if at least @a interval has passed since
+ * the last write, a writer thread is woken to write the profile to a
+ * temporary file that is then renamed to @a path, so readers never see a
+ * partial profile.  The profile is written a last time when the engine is
+ * destroyed.  Nothing is written while profiling is disabled.
+ *
+ * @param[in] ib       IronBee engine.
+ * @param[in] path     File to write; copied.  NULL to stop writing.
+ * @param[in] interval Microseconds between writes.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ * - IB_EOTHER if the writer thread could not be started.
+ */
+ib_status_t DLL_PUBLIC ib_rule_profile_file_set(
+    ib_engine_t *ib,
+    const char  *path,
+    ib_time_t    interval
+)
+NONNULL_ATTRIBUTE(1);
+
+/**
+ * Write the profile to the file set by ib_rule_profile_file_set() now.
+ *
+ * @param[in] ib IronBee engine.
+ *
+ * @returns
+ * - IB_OK on success or if no file is set.
+ * - IB_EALLOC on allocation failure.
+ * - IB_EOTHER if the file could not be written.
+ */
+ib_status_t DLL_PUBLIC ib_rule_profile_write(
+    const ib_engine_t *ib
+)
+NONNULL_ATTRIBUTE(1);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _IB_RULE_PROFILE_H_ */
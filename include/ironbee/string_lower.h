@@ -57,6 +57,27 @@ ib_status_t ib_strlower(
 )
 NONNULL_ATTRIBUTE(2, 4);
 
+/**
+ * ASCII lowercase that only copies when something changes.
+ *
+ * @param[in] mm Memory manager to allocate @a out from.
+ * @param[in] in Input to convert to lowercase.
+ * @param[in] in_len Length of @a in.
+ * @param[out] out @a in itself if it has no upper case characters,
+ *             otherwise a lower case copy allocated from @a mm.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EALLOC On allocation failure.
+ */
+ib_status_t ib_strlower_const(
+    ib_mm_t          mm,
+    const uint8_t   *in,
+    size_t           in_len,
+    const uint8_t  **out
+)
+NONNULL_ATTRIBUTE(2, 4);
+
 /** @} */
 
 #ifdef __cplusplus
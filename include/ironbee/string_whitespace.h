@@ -59,6 +59,29 @@ ib_status_t DLL_PUBLIC ib_str_whitespace_remove(
 )
 NONNULL_ATTRIBUTE(2, 4, 5);
 
+/**
+ * Delete all whitespace from a string, only copying if there is any.
+ *
+ * @param[in] mm Memory manager.
+ * @param[in] data_in Pointer to input data.
+ * @param[in] dlen_in Length of @a data_in.
+ * @param[out] data_out @a data_in itself if it has no whitespace,
+ *             otherwise output data allocated from @a mm.
+ * @param[out] dlen_out Length of @a data_out.
+ *
+ * @result
+ * - IB_OK On success.
+ * - IB_EALLOC On allocation failure.
+ */
+ib_status_t DLL_PUBLIC ib_str_whitespace_remove_const(
+    ib_mm_t          mm,
+    const uint8_t   *data_in,
+    size_t           dlen_in,
+    const uint8_t  **data_out,
+    size_t          *dlen_out
+)
+NONNULL_ATTRIBUTE(2, 4, 5);
+
 /**
  * Compress whitespace in a string.
  *
@@ -79,6 +102,29 @@ ib_status_t DLL_PUBLIC ib_str_whitespace_compress(
 )
 NONNULL_ATTRIBUTE(2, 4, 5);
 
+/**
+ * Compress whitespace in a string, only copying if there is any to compress.
+ *
+ * @param[in] mm Memory manager
+ * @param[in] data_in Pointer to input data
+ * @param[in] dlen_in Length of @a data_in
+ * @param[out] data_out @a data_in itself if no two whitespace characters
+ *             are adjacent, otherwise output data allocated from @a mm.
+ * @param[out] dlen_out Length of @a data_out
+ *
+ * @result
+ * - IB_OK On success.
+ * - IB_EALLOC On allocation failure.
+ */
+ib_status_t DLL_PUBLIC ib_str_whitespace_compress_const(
+    ib_mm_t          mm,
+    const uint8_t   *data_in,
+    size_t           dlen_in,
+    const uint8_t  **data_out,
+    size_t          *dlen_out
+)
+NONNULL_ATTRIBUTE(2, 4, 5);
+
 /** @} */
 
 #ifdef __cplusplus
@@ -26,6 +26,7 @@
  */
 
 #include <ironbee/build.h>
+#include <ironbee/mm.h>
 #include <ironbee/types.h>
 
 #include <sys/types.h>
@@ -51,6 +52,11 @@ extern "C" {
  *   as the stringset.
  * - Query the stringset as desired.
  *
+ * For large sets, use ib_stringset_init_trie() instead of
+ * ib_stringset_init().  It additionally compiles the set into a trie so that
+ * a query is a single walk over the query string rather than a binary search
+ * of string comparisons.
+ *
  * @{
  */
 
@@ -83,6 +89,11 @@ typedef struct ib_stringset_t ib_stringset_t;
 
 /** @cond internal */
 
+/**
+ * Compiled form of a string set.  See ib_stringset_init_trie().
+ **/
+typedef struct ib_stringset_trie_t ib_stringset_trie_t;
+
 /**
  * Set of strings.
  *
@@ -94,6 +105,8 @@ struct ib_stringset_t
     const ib_stringset_entry_t *entries;
     /** Number of entries. */
     size_t num_entries;
+    /** Compiled trie or NULL if queries should binary search @c entries. */
+    const ib_stringset_trie_t *trie;
 };
 
 /** @endcond */
@@ -114,6 +127,33 @@ ib_status_t DLL_PUBLIC ib_stringset_init(
 )
 NONNULL_ATTRIBUTE(1, 2);
 
+/**
+ * Initialize a String Set and compile it into a trie.
+ *
+ * As ib_stringset_init() but additionally builds a double-array trie of
+ * @a entries in memory from @a mm.  Queries of the resulting set walk the
+ * trie once over the query string, taking time linear in the length of the
+ * matched prefix and independent of the number of entries.
+ *
+ * @param[in] set Set to initialized.  Should be allocated by user.
+ * @param[in] entries Entries to add to set.  Should not be used after calling
+ *                    this function.  Must live at least as long as @a set.
+ * @param[in] num_entries Number of entries in @a entries.
+ * @param[in] mm Memory manager to allocate trie from.  Must live at least as
+ *               long as @a set.
+ * @return
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ * - IB_EINVAL if @a num_entries is too large.
+ */
+ib_status_t DLL_PUBLIC ib_stringset_init_trie(
+    ib_stringset_t       *set,
+    ib_stringset_entry_t *entries,
+    size_t                num_entries,
+    ib_mm_t               mm
+)
+NONNULL_ATTRIBUTE(1, 2);
+
 /**
  * Query a String Set.
  *
@@ -49,16 +49,27 @@ extern "C" {
  * @{
  */
 
+/**
+ * Size of a buffer large enough for any formatted @ref ib_num_t or
+ * @ref ib_time_t, including the NUL.
+ */
+#define IB_TYPE_NUM_BUF_SIZE 21
+
 /**
  * Convert a string to a number, with error checking.
  *
+ * Accepts what strtol() accepts in the C locale, but all of @a s must be
+ * consumed. The string is parsed in place; no copy is made.
+ *
  * @param[in] s String to convert.
  * @param[in] slen Length of string.
- * @param[in] base Base passed to strtol() -- see strtol() documentation
+ * @param[in] base Base as for strtol() -- see strtol() documentation
  * for details.
  * @param[out] result Resulting number.
  *
- * @returns Status code.
+ * @returns
+ *   - IB_OK On success.
+ *   - IB_EINVAL If @a s is empty, is not a number or is out of range.
  */
 ib_status_t DLL_PUBLIC ib_type_atoi_ex(
     const char *s,
@@ -72,11 +83,13 @@ NONNULL_ATTRIBUTE(4);
  * Convert a string to a number, with error checking
  *
  * @param[in] s String to convert
- * @param[in] base Base passed to strtol() -- see strtol() documentation
+ * @param[in] base Base as for strtol() -- see strtol() documentation
  * for details.
  * @param[out] result Resulting number.
  *
- * @returns Status code.
+ * @returns
+ *   - IB_OK On success.
+ *   - IB_EINVAL If @a s is empty, is not a number or is out of range.
  */
 ib_status_t DLL_PUBLIC ib_type_atoi(
     const char *s,
@@ -89,7 +102,7 @@ NONNULL_ATTRIBUTE(3);
  * Convert a string to a time type, with error checking.
  *
  * The time string is an integer representing the number of microseconds
- * since the Epoch.
+ * since the Epoch. Negative values are rejected.
  *
  * @param[in] s String of integers representing microseconds since the epoch.
  * @param[in] slen Length of string.
@@ -128,8 +141,10 @@ NONNULL_ATTRIBUTE(2);
 /**
  * Convert a string to an @ref ib_float_t with error checking.
  *
- * Avoid using this function because it requires that a copy of the
- * input string be made to pass to strtold(). Prefer ib_type_atof().
+ * Plain decimals such as "12.5" or "-3e4" are converted in place without
+ * regard to locale, giving the same result as strtold(). Anything else,
+ * such as hexadecimal floats, infinities or very long mantissas, is handed
+ * to strtold(), which requires a copy of the input string.
  *
  * @param[in] s The string to convert.
  * @param[in] slen The string length.
@@ -178,6 +193,20 @@ const char DLL_PUBLIC *ib_type_itoa(
     int64_t value
 );
 
+/**
+ * Write the decimal representation of a number to a buffer.
+ *
+ * @param[in] value The number to operate on
+ * @param[out] buf Buffer of at least @ref IB_TYPE_NUM_BUF_SIZE bytes.
+ *
+ * @returns Length of the string written to @a buf, not including the NUL.
+ */
+size_t DLL_PUBLIC ib_type_itoa_buf(
+    int64_t  value,
+    char    *buf
+)
+NONNULL_ATTRIBUTE(2);
+
 /**
  * Get a string representation of a time.
  *
@@ -194,6 +223,20 @@ const char DLL_PUBLIC *ib_type_ttoa(
     ib_time_t value
 );
 
+/**
+ * Write the decimal representation of a time to a buffer.
+ *
+ * @param[in] value The time to operate on
+ * @param[out] buf Buffer of at least @ref IB_TYPE_NUM_BUF_SIZE bytes.
+ *
+ * @returns Length of the string written to @a buf, not including the NUL.
+ */
+size_t DLL_PUBLIC ib_type_ttoa_buf(
+    ib_time_t  value,
+    char      *buf
+)
+NONNULL_ATTRIBUTE(2);
+
 /**
  * Get a string representation of a floating point number.
  *
@@ -49,23 +49,30 @@ extern "C" {
 /**
  * Initialize UUID library.
  *
- * ib_util_initialize() will call this.
+ * ib_util_initialize() will call this. It may be called more than once.
  */
 ib_status_t DLL_PUBLIC ib_uuid_initialize(void);
 
 /**
  * Shutdown UUID library.
  *
- * ib_util_shutdown() will call this.
+ * ib_util_shutdown() will call this. Releases the generator state of the
+ * calling thread; other threads release theirs when they exit.
  */
 ib_status_t DLL_PUBLIC ib_uuid_shutdown(void);
 
 /**
  * Creates a new, random, v4 uuid (static buffer version).
  *
+ * Each thread has its own generator, seeded from the operating system on
+ * first use, so this takes no lock. The UUIDs are unique but, unlike
+ * those of a cryptographic generator, predictable from earlier ones; do
+ * not use them as secrets.
+ *
  * @param[in] uuid Where to write UUID.  Must be IB_UUID_LENGTH long.
  *
  * @returns
+ * - IB_OK on success.
  * - IB_EALLOC on allocation failure.
  * - IB_EOTHER on other failure.
  */
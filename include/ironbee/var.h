@@ -167,6 +167,34 @@ ib_mm_t DLL_PUBLIC ib_var_config_mm(
 )
 NONNULL_ATTRIBUTE(1);
 
+/**
+ * Access atom table of @a config.
+ *
+ * Source names and constant filter strings are interned here as they are
+ * acquired.  The engine freezes the table when configuration is finished;
+ * after that, names are only looked up.
+ **/
+ib_atom_table_t DLL_PUBLIC *ib_var_config_atoms(
+    const ib_var_config_t *config
+)
+NONNULL_ATTRIBUTE(1);
+
+/**
+ * Set the atom of @a field from its name.
+ *
+ * The atom is set to NULL if the name has not been interned in @a config.
+ * Call this on fields added to collections, such as headers, so that
+ * filters can match them by atom instead of by name.
+ *
+ * @param[in] config Var configuration.
+ * @param[in] field  Field to update.
+ **/
+void DLL_PUBLIC ib_var_field_atom_set(
+    const ib_var_config_t *config,
+    ib_field_t            *field
+)
+NONNULL_ATTRIBUTE(1, 2);
+
 /**@}*/
 
 /**
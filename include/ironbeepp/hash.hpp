@@ -644,7 +644,7 @@ public:
         ib_hash_t* h;
         throw_if_error(
             ib_hash_create_ex(
-                &h, memory_manager.ib(), slots,
+                &h, memory_manager.ib(), slots, IB_HASH_LAYOUT_CHAINED,
                 &ib_hashfunc_djb2, NULL,
                 &ib_hashequal_default, NULL
             )
@@ -666,7 +666,7 @@ public:
         ib_hash_t* h;
         throw_if_error(
             ib_hash_create_ex(
-                &h, memory_manager.ib(), slots,
+                &h, memory_manager.ib(), slots, IB_HASH_LAYOUT_CHAINED,
                 &ib_hashfunc_djb2_nocase, NULL,
                 &ib_hashequal_nocase, NULL
             )
@@ -710,7 +710,7 @@ public:
         );
         throw_if_error(
             ib_hash_create_ex(
-                &h, memory_manager.ib(), slots,
+                &h, memory_manager.ib(), slots, IB_HASH_LAYOUT_CHAINED,
                 hash_trampoline.first, hash_trampoline.second,
                 equal_trampoline.first, equal_trampoline.second
             )
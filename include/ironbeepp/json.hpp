@@ -31,75 +31,14 @@
 
 #include <ironbeepp/exception.hpp>
 
-#include <boost/any.hpp>
+#include <ironbee/json_writer.h>
+
 #include <boost/date_time/posix_time/posix_time_types.hpp>
 #include <boost/function.hpp>
 #include <boost/noncopyable.hpp>
 
-#include <yajl/yajl_common.h>
-#include <yajl/yajl_gen.h>
-
 namespace IronBee {
 
-/**
- * An alternative buffer, we control, to the default YAJL buffer.
- *
- * This allows Json to divorce a malloc-backed
- * buffer containing JSON from the yajl_gen generator that
- * rendered it so that the buffer will exist past the lifetime
- * of the generator.
- */
-class JsonBuffer : public boost::noncopyable {
-public:
-    //! Constructor.
-    JsonBuffer();
-
-    /**
-     * Free C resources (memory) acquired over the lifetime of this obj.
-     *
-     * Any buffer given to the user by a call to
-     * JsonBuffer::divorce_buffer() is not freed.
-     */
-    ~JsonBuffer();
-
-    /**
-     * Extend the internal buffer by @a len and append @a str.
-     *
-     * This allows C-implemented clients to this class to
-     * append without building a new std::string instance.
-     *
-     * @param[in] str The string to append.
-     * @param[in] str_len The length of the string to append.
-
-     * @throws JsonError on failures.
-     */
-    void append(const char* str, size_t str_len);
-
-    /**
-     * Divorce the malloc buffer from this object.
-     *
-     * The buffer will not be free'ed at object destruction time
-     * and is the user's responsibility to free() the buffer.
-     *
-     * After this is called, the internal buffer is NULL and all
-     * size and length values are 0.
-     *
-     * @param[out] buf The buffer.
-     * @param[out] buf_sz The buffer size.
-     */
-    void divorce_buffer(char*& buf, size_t& buf_sz);
-
-private:
-    //! Length of the string in m_json_buffer.
-    size_t m_json_buffer_len;
-
-    //! The size of m_json_buffer.
-    size_t m_json_buffer_sz;
-
-    //! Buffer containing the currently rendered JSON.
-    char* m_json_buffer;
-};
-
 // Forward define classes that reference each other.
 template <typename PARENT> class JsonMap;
 template <typename PARENT> class JsonArray;
@@ -108,12 +47,13 @@ template <typename PARENT> class JsonArray;
 struct JsonError : public IronBee::eother {};
 
 /**
- * A rendering wrapper around YAJL's JSON generation api.
+ * A rendering wrapper around the streaming JSON writer.
  *
- * This class creates a JSON generator backed by a JsonBuffer.
+ * This class acquires the calling thread's @ref ib_json_writer_t, so
+ * rendering into its buffer does not allocate once the buffer is warm.
  * The user may make calls against this class to append
  * JSON information to the buffer using the same semantics as
- * the YAJL API presents.
+ * the writer presents.
  *
  * User's may also use the JsonArray and JsonMap
  * instances returned by Json::withArray() and Json::withMap()
@@ -151,22 +91,16 @@ struct JsonError : public IronBee::eother {};
  * Json.render(&str, &str_len);
  * @endcode
  *
- * @note This class does as much validation as YAJL, which is almost nothing.
- *       It is trivial to produce invalid JSON by not closing maps and arrays.
+ * @note Misplaced values and closes throw JsonError, but maps and arrays
+ *       that are never closed are only detected by render().
  */
 class Json : boost::noncopyable {
 public:
     //! The generator type.
-    typedef yajl_gen json_generator_t;
+    typedef ib_json_writer_t* json_generator_t;
 
 private:
-    //! The buffer we will render into.
-    JsonBuffer  m_buffer;
-
-    //! A protective wrapper for @c m_buffer used to pass it to C.
-    boost::any       m_any;
-
-    //! The yajl_gen instance.
+    //! The writer; the calling thread's unless it was in use.
     json_generator_t m_json_generator;
 
 public:
@@ -200,7 +134,7 @@ public:
     //! Render a NULL.
     void withNull();
 
-    //! Accessor for the JSON Generator (YAJL).
+    //! Accessor for the JSON Generator.
     json_generator_t& getJsonGenerator() { return m_json_generator; }
 
     //! Render and return a map that, when closed, will return @c this.
@@ -212,8 +146,8 @@ public:
     /**
      * Render the JSON to the buffer and return it to @a buf and @ buf_sz.
      *
-     * Rendering divorces the internal buffer of this class
-     * from it, requiring the caller to call free() on @a buf
+     * Rendering copies the JSON into a malloc'ed buffer,
+     * requiring the caller to call free() on @a buf
      * when the caller is done with it.
      *
      * Calling render() leaves @c this with an empty buffer, allowing
@@ -224,6 +158,8 @@ public:
      * @param[out] buf Malloc'ed buffer of rendered JSON. This must be passed
      *             to free() by the caller. This is not a null-terminated string.
      * @param[out] buf_sz The size of @a buf.
+     *
+     * @throws JsonError if the JSON is incomplete.
      */
     void render(char*& buf, size_t& buf_sz);
 };
@@ -431,8 +367,8 @@ JsonArray<PARENT>::JsonArray
     m_Json(Json),
     m_parent(parent)
 {
-    int yg_rc = yajl_gen_array_open(m_Json.getJsonGenerator());
-    if (yg_rc != yajl_gen_status_ok) {
+    ib_status_t rc = ib_json_writer_array_open(m_Json.getJsonGenerator());
+    if (rc != IB_OK) {
         BOOST_THROW_EXCEPTION(JsonError() <<
             IronBee::errinfo_what("Failed to open array."));
     }
@@ -441,8 +377,8 @@ JsonArray<PARENT>::JsonArray
 template <typename PARENT>
 PARENT& JsonArray<PARENT>::close()
 {
-    int yg_rc = yajl_gen_array_close(m_Json.getJsonGenerator());
-    if (yg_rc != yajl_gen_status_ok) {
+    ib_status_t rc = ib_json_writer_array_close(m_Json.getJsonGenerator());
+    if (rc != IB_OK) {
         BOOST_THROW_EXCEPTION(JsonError() <<
             IronBee::errinfo_what("Failed close array."));
     }
@@ -472,8 +408,8 @@ JsonMap<PARENT>::JsonMap(
     m_Json(Json),
     m_parent(parent)
 {
-    int yg_rc = yajl_gen_map_open(Json.getJsonGenerator());
-    if (yg_rc != yajl_gen_status_ok) {
+    ib_status_t rc = ib_json_writer_map_open(Json.getJsonGenerator());
+    if (rc != IB_OK) {
         BOOST_THROW_EXCEPTION(JsonError() <<
             IronBee::errinfo_what("Failed to open map"));
     }
@@ -482,10 +418,10 @@ JsonMap<PARENT>::JsonMap(
 template <typename PARENT>
 PARENT& JsonMap<PARENT>::close()
 {
-    int yg_rc = yajl_gen_map_close(m_Json.getJsonGenerator());
-    if (yg_rc != yajl_gen_status_ok) {
+    ib_status_t rc = ib_json_writer_map_close(m_Json.getJsonGenerator());
+    if (rc != IB_OK) {
         BOOST_THROW_EXCEPTION(JsonError() <<
-            IronBee::errinfo_what("Failed to open map"));
+            IronBee::errinfo_what("Failed to close map"));
     }
 
     return m_parent;
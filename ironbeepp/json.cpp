@@ -24,7 +24,6 @@
 
 #include <ironbeepp/json.hpp>
 
-#include <boost/any.hpp>
 #ifdef __clang__
 #pragma clang diagnostic push
 #if __has_warning("-Wunused-local-typedef")
@@ -38,116 +37,67 @@
 #include <boost/date_time/time_facet.hpp>
 #include <boost/foreach.hpp>
 
-#include <yajl/yajl_common.h>
-#include <yajl/yajl_gen.h>
-
 #include <cstdlib>
+#include <cstring>
 
 namespace IronBee {
 
-JsonBuffer::JsonBuffer():
-    m_json_buffer_len(0),
-    m_json_buffer_sz(1024),
-    m_json_buffer(reinterpret_cast<char *>(malloc(m_json_buffer_sz)))
- {
-    if (m_json_buffer == NULL)
-    {
-        BOOST_THROW_EXCEPTION(
-            IronBee::ealloc()
-                << IronBee::errinfo_what("Allocating JSON buffer."));
-    }
-}
+namespace {
 
-JsonBuffer::~JsonBuffer()
+/**
+ * Throw JsonError with @a what if @a rc is not IB_OK.
+ */
+void check_json(ib_status_t rc, const char* what)
 {
-    if (m_json_buffer)
-    {
-        free(m_json_buffer);
+    if (rc == IB_EALLOC) {
+        BOOST_THROW_EXCEPTION(
+            IronBee::ealloc() << IronBee::errinfo_what(what));
     }
-}
-
-void JsonBuffer::divorce_buffer(char*& buf, size_t& buf_len)
-{
-    buf = m_json_buffer;
-    buf_len = m_json_buffer_len;
-
-    m_json_buffer_len = 0;
-    m_json_buffer_sz = 0;
-    m_json_buffer = NULL;
-}
-
-void JsonBuffer::append(const char *str, size_t str_len)
-{
-    size_t new_len = m_json_buffer_len + str_len;
-
-    /* Grow the buffer by 1k as that should satisfy most conditions.
-     * Should we be in an unexpected situation, loop until we get it right.
-     */
-    if (new_len > m_json_buffer_sz)
-    {
-        /* Compute the new buffer length on a 1024-length page. */
-        m_json_buffer_sz = new_len + (new_len % 1024);
-        m_json_buffer = reinterpret_cast<char *>(
-            realloc(m_json_buffer, m_json_buffer_sz));
-
-        if (m_json_buffer == NULL)
-        {
-            BOOST_THROW_EXCEPTION(
-                IronBee::ealloc()
-                    << IronBee::errinfo_what("Allocating JSON buffer."));
-        }
+    if (rc != IB_OK) {
+        BOOST_THROW_EXCEPTION(
+            JsonError() << IronBee::errinfo_what(what));
     }
-
-    std::copy(str, str + str_len, m_json_buffer + m_json_buffer_len);
-    m_json_buffer_len = new_len;
 }
 
-extern "C" {
-
-/**
- * @ref Json callback to print given JSON into a malloc'ed buffer.
- */
-static void txlog_json_print_callback(void *ctx, const char *str, size_t len)
-{
-    JsonBuffer *buffer =
-        boost::any_cast<JsonBuffer*>(
-            *reinterpret_cast<boost::any *>(ctx));
-
-    buffer->append(str, len);
 }
 
-} /* extern "C" */
-
-Json::Json():
-    m_any(&m_buffer),
-    m_json_generator(yajl_gen_alloc(NULL))
+Json::Json()
 {
-    if (m_json_generator == NULL) {
+    ib_status_t rc = ib_json_writer_acquire(&m_json_generator, false);
+    if (rc != IB_OK) {
         BOOST_THROW_EXCEPTION(
             JsonError()
                 << IronBee::errinfo_what("Could not create JSON generator."));
     }
-
-    yajl_gen_config(m_json_generator, yajl_gen_beautify, 0);
-    yajl_gen_config(m_json_generator, yajl_gen_indent_string, "");
-    yajl_gen_config(
-        m_json_generator,
-        yajl_gen_print_callback,
-        &txlog_json_print_callback,
-        reinterpret_cast<void *>(&m_any)
-    );
 }
 
 Json::~Json()
 {
     assert (m_json_generator);
 
-    yajl_gen_free(m_json_generator);
+    ib_json_writer_release(m_json_generator);
 }
 
 void Json::render(char*& buf, size_t& buf_sz)
 {
-    m_buffer.divorce_buffer(buf, buf_sz);
+    const char* json;
+    size_t      json_len;
+
+    check_json(
+        ib_json_writer_buf(m_json_generator, &json, &json_len),
+        "Failed to render JSON."
+    );
+
+    buf = reinterpret_cast<char *>(malloc(json_len));
+    if (buf == NULL) {
+        BOOST_THROW_EXCEPTION(
+            IronBee::ealloc()
+                << IronBee::errinfo_what("Allocating JSON buffer."));
+    }
+    memcpy(buf, json, json_len);
+    buf_sz = json_len;
+
+    ib_json_writer_reset(m_json_generator, false);
 }
 
 JsonMap<Json> Json::withMap()
@@ -162,8 +112,6 @@ JsonArray<Json> Json::withArray()
 
 void Json::withTime(const boost::posix_time::ptime& val)
 {
-    int yajl_rc;
-
     /* The output stream the does the formatting for the date using facets. */
     std::ostringstream osstream;
 
@@ -205,17 +153,7 @@ void Json::withTime(const boost::posix_time::ptime& val)
     str = str.replace(dot_loc + 4, dash_loc - dot_loc - 4, "");
 
     /* Finally, convert the string to JSON. */
-    yajl_rc = yajl_gen_string(
-        m_json_generator,
-        reinterpret_cast<const unsigned char *>(str.data()),
-        str.length());
-
-    /* Check and throw if there was a problem. */
-    if (yajl_rc != yajl_gen_status_ok)
-    {
-        BOOST_THROW_EXCEPTION(JsonError() <<
-            IronBee::errinfo_what("Failed to write string."));
-    }
+    withString(str.data(), str.length());
 }
 
 void Json::withString(const std::string& val)
@@ -230,51 +168,42 @@ void Json::withString(const char* val)
 
 void Json::withString(const char* val, size_t len)
 {
-    int yajl_rc = yajl_gen_string(
-        m_json_generator,
-        reinterpret_cast<const unsigned char *>(val),
-        len);
-
-    if (yajl_rc != yajl_gen_status_ok) {
-        BOOST_THROW_EXCEPTION(JsonError() <<
-            IronBee::errinfo_what("Failed to write string."));
-    }
+    check_json(
+        ib_json_writer_string(m_json_generator, val, len),
+        "Failed to write string."
+    );
 }
 
 void Json::withInt(int val)
 {
-    int yg_rc = yajl_gen_integer(m_json_generator, val);
-    if (yg_rc != yajl_gen_status_ok) {
-        BOOST_THROW_EXCEPTION(JsonError()
-            << IronBee::errinfo_what("Failed to generate type."));
-    }
+    check_json(
+        ib_json_writer_num(m_json_generator, val),
+        "Failed to generate type."
+    );
 }
 
 void Json::withDouble(double val)
 {
-    int yg_rc = yajl_gen_double(m_json_generator, val);
-    if (yg_rc != yajl_gen_status_ok) {
-        BOOST_THROW_EXCEPTION(JsonError()
-            << IronBee::errinfo_what("Failed to generate type."));
-    }
+    check_json(
+        ib_json_writer_float(m_json_generator, val),
+        "Failed to generate type."
+    );
 }
 
 void Json::withBool(bool val)
 {
-    int yg_rc = yajl_gen_bool(m_json_generator, (val)?1:0);
-    if (yg_rc != yajl_gen_status_ok) {
-        BOOST_THROW_EXCEPTION(JsonError()
-            << IronBee::errinfo_what("Failed to generate type."));
-    }
+    check_json(
+        ib_json_writer_bool(m_json_generator, val),
+        "Failed to generate type."
+    );
 }
 
 void Json::withNull()
 {
-    int yg_rc = yajl_gen_null(m_json_generator);
-    if (yg_rc != yajl_gen_status_ok) {
-        BOOST_THROW_EXCEPTION(JsonError()
-            << IronBee::errinfo_what("Failed to generate type."));
-    }
+    check_json(
+        ib_json_writer_null(m_json_generator),
+        "Failed to generate type."
+    );
 }
 
-} // namespace IronBee
\ No newline at end of file
+} // namespace IronBee
@@ -590,12 +590,6 @@ static ib_status_t modlua_init(
         return rc;
     }
 
-    rc = ib_lock_create(&(cfg->lua_pool_lock), mm);
-    if (rc != IB_OK) {
-        ib_log_error(ib, "Failed to configure Lua resource pool lock.");
-        return rc;
-    }
-
     rc = modlua_runtime_resource_pool_create(
         &(cfg->lua_pool),
         ib,
@@ -716,6 +716,12 @@ ib_status_t modlua_runtime_resource_pool_create(
         return rc;
     }
 
+    /* Stacks are acquired and released by every worker thread. */
+    rc = ib_resource_pool_set_threaded(*resource_pool);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
     *cfg = &(modlua_runtime_cbdata->cfg);
 
     return IB_OK;
@@ -730,25 +736,7 @@ ib_status_t modlua_releasestate(
     assert(ib != NULL);
     assert(cfg != NULL);
 
-    ib_status_t rc;
-
-    rc = ib_lock_lock(cfg->lua_pool_lock);
-    if (rc != IB_OK) {
-        return rc;
-    }
-
-    rc = ib_resource_release(modlua_runtime->resource);
-    if (rc != IB_OK) {
-        ib_lock_unlock(cfg->lua_pool_lock);
-        return rc;
-    }
-
-    rc = ib_lock_unlock(cfg->lua_pool_lock);
-    if (rc != IB_OK) {
-        return rc;
-    }
-
-    return IB_OK;
+    return ib_resource_release(modlua_runtime->resource);
 }
 
 ib_status_t modlua_acquirestate(
@@ -763,18 +751,7 @@ ib_status_t modlua_acquirestate(
     ib_status_t    rc;
     ib_resource_t *resource;
 
-    rc = ib_lock_lock(cfg->lua_pool_lock);
-    if (rc != IB_OK) {
-        return rc;
-    }
-
     rc = ib_resource_acquire(cfg->lua_pool, &resource);
-    if (rc != IB_OK) {
-        ib_lock_unlock(cfg->lua_pool_lock);
-        return rc;
-    }
-
-    rc = ib_lock_unlock(cfg->lua_pool_lock);
     if (rc != IB_OK) {
         return rc;
     }
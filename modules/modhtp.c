@@ -314,6 +314,7 @@ static ib_status_t modhtp_field_list_callback(
                          ib_status_to_string(rc));
         return IB_OK;
     }
+    ib_var_field_atom_set(ib_var_store_config(tx->var_store), field);
 
     /* Add the field to the field list. */
     rc = ib_field_list_add(flist, field);
@@ -389,6 +390,7 @@ static ib_status_t modhtp_param_iter_callback(
                          ib_status_to_string(rc));
         return IB_OK;
     }
+    ib_var_field_atom_set(ib_var_store_config(tx->var_store), field);
 
     /* Add the field to the field list. */
     rc = ib_field_list_add(idata->field_list, field);
@@ -29,6 +29,8 @@
 #include <ironbee/json.h>
 #include <ironbee/kvstore.h>
 #include <ironbee/kvstore_filesystem.h>
+#include <ironbee/kvstore_log.h>
+#include <ironbee/kvstore_memory.h>
 #include <ironbee/list.h>
 #include <ironbee/mm.h>
 #include <ironbee/module.h>
@@ -48,6 +50,8 @@
 static const ib_num_t DEFAULT_EXPIRATION = 60;
 
 static const char FILE_URI_PREFIX[] = "persist-fs://";
+static const char LOG_URI_PREFIX[] = "persist-log://";
+static const char MEMORY_URI_PREFIX[] = "persist-memory://";
 static const char JSON_TYPE[] = "application_json";
 
 /* Define the module name as well as a string version of it. */
@@ -185,10 +189,38 @@ ib_status_t file_rw_create_fn(
             ib_log_error(ib, "Failed to initialize kvstore.");
             return rc;
         }
+    }
+    else if (strncmp(uri, LOG_URI_PREFIX, sizeof(LOG_URI_PREFIX)-1) == 0) {
+        const char *dir = uri + sizeof(LOG_URI_PREFIX)-1;
+        ib_log_debug(ib, "Creating log key-value store in directory: %s", dir);
+
+        rc = ib_kvstore_log_init(file_rw->kvstore, dir);
+        if (rc != IB_OK) {
+            ib_log_error(ib, "Failed to initialize kvstore.");
+            return rc;
+        }
+    }
+    else if (
+        strncmp(uri, MEMORY_URI_PREFIX, sizeof(MEMORY_URI_PREFIX)-1) == 0
+    ) {
+        const char *max = uri + sizeof(MEMORY_URI_PREFIX)-1;
+        ib_num_t    max_entries = 0;
+
+        if (*max != '\0') {
+            rc = ib_type_atoi(max, 10, &max_entries);
+            if (rc != IB_OK || max_entries < 0) {
+                ib_log_error(ib, "Invalid maximum entries in URI: %s", uri);
+                return IB_EINVAL;
+            }
+        }
+        ib_log_debug(
+            ib,
+            "Creating in-memory key-value store with max entries: %" PRId64,
+            max_entries);
 
-        rc = ib_kvstore_connect(file_rw->kvstore);
+        rc = ib_kvstore_memory_init(file_rw->kvstore, max_entries);
         if (rc != IB_OK) {
-            ib_log_error(ib, "Failed to connect to kvstore.");
+            ib_log_error(ib, "Failed to initialize kvstore.");
             return rc;
         }
     }
@@ -197,6 +229,12 @@ ib_status_t file_rw_create_fn(
         return IB_EINVAL;
     }
 
+    rc = ib_kvstore_connect(file_rw->kvstore);
+    if (rc != IB_OK) {
+        ib_log_error(ib, "Failed to connect to kvstore.");
+        return rc;
+    }
+
     *(file_rw_t **)impl = file_rw;
     return IB_OK;
 }
@@ -39,7 +39,9 @@
 #include <ironbee/operator.h>
 #include <ironbee/path.h>
 #include <ironbee/rule_engine.h>
+#include <ironbee/rule_profile.h>
 #include <ironbee/string.h>
+#include <ironbee/type_convert.h>
 #include <ironbee/util.h>
 
 #include <assert.h>
@@ -1583,6 +1585,94 @@ ib_status_t parse_ruletracefile_params(
 #endif
 }
 
+/**
+ * Parse RuleProfile directive.
+ *
+ * @param[in] cp Configuration parser.
+ * @param[in] name Name of directive.
+ * @param[in] onoff On or off.
+ * @param[in] cbdata Callback data; Unused.
+ * @returns IB_OK.
+ **/
+static
+ib_status_t parse_ruleprofile_params(
+    ib_cfgparser_t *cp,
+    const char     *name,
+    int             onoff,
+    void           *cbdata
+)
+{
+    assert(cp != NULL);
+
+    ib_rule_profile_enable(cp->ib, onoff != 0);
+
+    return IB_OK;
+}
+
+/**
+ * Parse RuleProfileFile directive.
+ *
+ * @param[in] cp Configuration parser.
+ * @param[in] name Name of directive.
+ * @param[in] vars Path to write the profile to and optional seconds between
+ *                 writes.
+ * @param[in] cbdata Callback data; Unused.
+ * @returns IB_OK on success; IB_EINVAL on bad parameters; IB_E* on error.
+ **/
+static
+ib_status_t parse_ruleprofilefile_params(
+    ib_cfgparser_t  *cp,
+    const char      *name,
+    const ib_list_t *vars,
+    void            *cbdata
+)
+{
+    assert(cp != NULL);
+    assert(vars != NULL);
+
+    const ib_list_node_t *node;
+    const char           *path;
+    ib_time_t             interval = IB_RULE_PROFILE_INTERVAL_DEFAULT;
+    ib_status_t           rc;
+
+    if (ib_list_elements(vars) < 1 || ib_list_elements(vars) > 2) {
+        ib_cfg_log_error(cp, "%s takes a path and optional seconds.", name);
+        return IB_EINVAL;
+    }
+
+    node = ib_list_first_const(vars);
+    path = (const char *)ib_list_node_data_const(node);
+
+    node = ib_list_node_next_const(node);
+    if (node != NULL) {
+        const char *seconds = (const char *)ib_list_node_data_const(node);
+        ib_num_t    num;
+
+        rc = ib_type_atoi(seconds, 10, &num);
+        if (rc != IB_OK || num <= 0) {
+            ib_cfg_log_error(
+                cp,
+                "%s was not given a positive integer but \"%s\".",
+                name, seconds
+            );
+            return IB_EINVAL;
+        }
+        interval = (ib_time_t)num * 1000000LU;
+    }
+
+    rc = ib_rule_profile_file_set(cp->ib, path, interval);
+    if (rc != IB_OK) {
+        ib_cfg_log_error(
+            cp,
+            "%s could not set profile file %s: %s",
+            name, path, ib_status_to_string(rc)
+        );
+        return rc;
+    }
+
+    return IB_OK;
+}
+
 /**
  * Handle postprocessing.
  *
@@ -1725,6 +1815,18 @@ static IB_DIRMAP_INIT_STRUCTURE(rules_directive_map) = {
         NULL
     ),
 
+    IB_DIRMAP_INIT_ONOFF(
+        "RuleProfile",
+        parse_ruleprofile_params,
+        NULL
+    ),
+
+    IB_DIRMAP_INIT_LIST(
+        "RuleProfileFile",
+        parse_ruleprofilefile_params,
+        NULL
+    ),
+
     /* signal the end of the list */
     IB_DIRMAP_INIT_LAST
 };
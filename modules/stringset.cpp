@@ -99,7 +99,9 @@ const ib_stringset_t* construct_set(
         entries[i].data   = NULL;
     }
 
-    throw_if_error(ib_stringset_init(set, entries, items.size()));
+    throw_if_error(
+        ib_stringset_init_trie(set, entries, items.size(), mm.ib())
+    );
 
     return set;
 }
@@ -238,4 +238,59 @@ class TestRules < CLIPPTest::TestCase
     assert_log_no_match /clipp_print \[A1\]: 1/
     assert_log_no_match /clipp_print \[A2\]: 2/
   end
-end
\ No newline at end of file
+
+  def test_rule_profile_file
+    path = File.join(BUILDDIR, "clipp_test_rule_profile_#{rand(10000)}.json")
+    clipp(
+      config: <<-EOS,
+        RuleProfile On
+        RuleProfileFile #{path} 1
+        InitVar A1 1
+        Rule A1 @eq 1 id:r1 rev:1 phase:REQUEST
+      EOS
+      default_site_config: <<-EOS
+        RuleEnable all
+      EOS
+    ) do
+      transaction do |t|
+        t.request(raw: "GET / HTTP/1.1\nHost: foo.bar\n\n")
+        t.response(raw: "HTTP/1.1 200 OK")
+      end
+    end
+
+    assert_no_issues
+    assert(File.exist?(path), "Rule profile was not written.")
+    profile = File.read(path)
+    FileUtils.rm_f(path)
+    assert_match(/"enabled":\s*true/, profile)
+    assert_match(/"id":\s*"r1"/, profile)
+    assert_match(/"operator":\s*"eq"/, profile)
+  end
+
+  def test_rule_skip_absent_targets
+    clipp(
+      config: '''
+        Set RuleEngineDebugLogLevel Debug
+        Rule ARGS @clipp_print "ARGS" id:r1 rev:1 phase:REQUEST
+        Rule &ARGS @eq 0 id:r2 rev:1 phase:REQUEST clipp_announce:NO_ARGS
+        Rule REQUEST_METHOD @streq GET id:r3 rev:1 phase:REQUEST setvar:LATE=1
+        Rule LATE @clipp_print "LATE" id:r4 rev:1 phase:REQUEST
+      ''',
+      default_site_config: <<-EOS
+        RuleEnable all
+      EOS
+    ) do
+      transaction do |t|
+        t.request(raw: "GET / HTTP/1.1\nHost: foo.bar\n\n")
+        t.response(raw: "HTTP/1.1 200 OK")
+      end
+    end
+
+    assert_no_issues
+    assert_log_match /r1" rev:1\] Rule not running because none of its targets are present\./
+    assert_log_no_match /r[234]" rev:1\] Rule not running because/
+    assert_log_no_match /clipp_print \[ARGS\]/
+    assert_log_match /CLIPP ANNOUNCE: NO_ARGS/
+    assert_log_match 'clipp_print [LATE]: 1'
+  end
+end
@@ -63,6 +63,7 @@
 #include <boost/date_time/time_facet.hpp>
 #include <boost/function.hpp>
 #include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/range/iterator_range.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/shared_ptr.hpp>
 #ifdef __clang__
@@ -309,6 +310,39 @@ void eventsToJson(
     events.close();
 }
 
+/**
+ * View the bytes of @a bs as a range for string algorithms, without a copy.
+ */
+boost::iterator_range<const char*> byteStringRange(
+    IronBee::ConstByteString bs
+)
+{
+    return boost::make_iterator_range(
+        bs.const_data(),
+        bs.const_data() + bs.length()
+    );
+}
+
+/**
+ * Render a header as a map of its name and value.
+ */
+void headerToJson(
+    IronBee::JsonArray<IronBee::Json>& headers,
+    IronBee::ConstParsedHeader         header
+)
+{
+    headers.withMap()
+            .withString(
+                "name",
+                header.name().const_data(),
+                header.name().length())
+            .withString(
+                "value",
+                header.value().const_data(),
+                header.value().length())
+        .close();
+}
+
 void requestHeadersToJson(
     IronBee::ConstTransaction tx,
     IronBee::Json& txLogJson
@@ -324,8 +358,8 @@ void requestHeadersToJson(
             headerNvp = headerNvp.next()
         )
         {
-            std::string headerName = headerNvp.name().to_s();
-            std::string headerValue = headerNvp.value().to_s();
+            boost::iterator_range<const char*> headerName =
+                byteStringRange(headerNvp.name());
 
             // TODO: These need to be configurable (string set?).
             if (boost::algorithm::istarts_with(headerName, "Content-") ||
@@ -334,10 +368,7 @@ void requestHeadersToJson(
                 boost::algorithm::iequals(headerName, "Referer") ||
                 boost::algorithm::iequals(headerName, "TE"))
             {
-                headers.withMap()
-                        .withString("name", headerNvp.name().to_s())
-                        .withString("value", headerNvp.value().to_s())
-                    .close();
+                headerToJson(headers, headerNvp);
             }
         }
     }
@@ -360,8 +391,8 @@ void responseHeadersToJson(
             headerNvp = headerNvp.next()
         )
         {
-            std::string headerName = headerNvp.name().to_s();
-            std::string headerValue = headerNvp.value().to_s();
+            boost::iterator_range<const char*> headerName =
+                byteStringRange(headerNvp.name());
 
             // TODO: These need to be configurable (string set?).
             if (boost::algorithm::istarts_with(headerName, "Content-") ||
@@ -369,10 +400,7 @@ void responseHeadersToJson(
                 boost::algorithm::iequals(headerName, "Server") ||
                 boost::algorithm::iequals(headerName, "Allow"))
             {
-                headers.withMap()
-                        .withString("name", headerNvp.name().to_s())
-                        .withString("value", headerNvp.value().to_s())
-                    .close();
+                headerToJson(headers, headerNvp);
             }
         }
     }
@@ -648,7 +648,8 @@ void XRulesModule::build_ip_xrule(IronBee::Engine ib, IronBee::Context ctx) {
     XRulesModuleConfig &cfg =
         module().configuration_data<XRulesModuleConfig>(ctx);
 
-    cfg.req_xrules.push_back(xrule_ptr(new XRuleIP(cfg)));
+    cfg.req_xrules.push_back(
+        xrule_ptr(new XRuleIP(cfg, ctx.memory_manager())));
 }
 
 void XRulesModule::disable_xrule_events(IronBee::Engine ib, IronBee::Transaction tx) {
@@ -645,25 +645,40 @@ void XRuleTime::xrule_impl(
 /* End XRuleTime Impl */
 
 /* RuleIP Impl */
-XRuleIP::XRuleIP(XRulesModuleConfig& cfg)
+XRuleIP::XRuleIP(XRulesModuleConfig& cfg, IronBee::MemoryManager mm)
 {
-    IronBee::throw_if_error(
-        ib_ipset4_init(
-            &m_ipset4,
-            NULL,
-            0,
-            &(cfg.ipv4_list[0]),
-            cfg.ipv4_list.size()),
-        "Failed to initialize IPv4 set."
-    );
+    if (cfg.ipv4_list.size() >= COMPILE_THRESHOLD) {
+        IronBee::throw_if_error(
+            ib_ipset4_init_compiled(
+                &m_ipset4,
+                NULL,
+                0,
+                &(cfg.ipv4_list[0]),
+                cfg.ipv4_list.size(),
+                mm.ib()),
+            "Failed to initialize IPv4 set."
+        );
+    }
+    else {
+        IronBee::throw_if_error(
+            ib_ipset4_init(
+                &m_ipset4,
+                NULL,
+                0,
+                &(cfg.ipv4_list[0]),
+                cfg.ipv4_list.size()),
+            "Failed to initialize IPv4 set."
+        );
+    }
 
     IronBee::throw_if_error(
-        ib_ipset6_init(
+        ib_ipset6_init_compiled(
             &m_ipset6,
             NULL,
             0,
             &(cfg.ipv6_list[0]),
-            cfg.ipv6_list.size()),
+            cfg.ipv6_list.size(),
+            mm.ib()),
         "Failed to initialize IPv6 set."
     );
 }
@@ -446,11 +446,21 @@ public:
     /**
      * Build a single rule check for the configuration context.
      *
+     * IPv6 sets and IPv4 sets of at least XRuleIP::COMPILE_THRESHOLD
+     * networks are compiled (see ib_ipset4_init_compiled()).  Smaller IPv4
+     * sets are searched directly, as a compiled IPv4 set costs at least
+     * 256 KiB.
+     *
      * @param[in] cfg The configuration for the closing configuration c
      *            context. The IPv4 and IPv6 lists are used from
      *            this configuration context to build the final rule.
+     * @param[in] mm Memory manager of the configuration context to allocate
+     *            compiled sets from.
      */
-    explicit XRuleIP(XRulesModuleConfig& cfg);
+    XRuleIP(XRulesModuleConfig& cfg, IronBee::MemoryManager mm);
+
+    //! Minimum number of IPv4 networks to compile the IPv4 set for.
+    static const size_t COMPILE_THRESHOLD = 1024;
 
     /**
      * Normalize @a str into a v6 network address if it is not already one.
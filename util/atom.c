@@ -0,0 +1,204 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- Atom Implementation
+ *
+ * Atoms are kept in a case-insensitive flat hash keyed by the atom's own
+ * copy of its name.  Lookups never modify the hash, so a frozen table is
+ * safe to read concurrently.
+ */
+
+#include "ironbee_config_auto.h"
+
+#include <ironbee/atom.h>
+
+#include <ironbee/hash.h>
+
+#include <assert.h>
+#include <string.h>
+
+struct ib_atom_table_t
+{
+    /** Memory manager. */
+    ib_mm_t mm;
+    /** Name to atom.  Value: `ib_atom_t *` */
+    ib_hash_t *by_name;
+    /** Number of atoms; the next id. */
+    size_t size;
+    /** If true, no atoms may be added. */
+    bool frozen;
+};
+
+struct ib_atom_t
+{
+    /** Name; NUL terminated. */
+    const char *name;
+    /** Length of @ref name. */
+    size_t name_length;
+    /** Id; order of interning. */
+    size_t id;
+};
+
+ib_status_t ib_atom_table_create(
+    ib_atom_table_t **table,
+    ib_mm_t           mm
+)
+{
+    assert(table != NULL);
+
+    ib_atom_table_t *local_table;
+    ib_status_t      rc;
+
+    local_table = ib_mm_alloc(mm, sizeof(*local_table));
+    if (local_table == NULL) {
+        return IB_EALLOC;
+    }
+
+    rc = ib_hash_create_ex(
+        &local_table->by_name,
+        mm,
+        64,
+        IB_HASH_LAYOUT_FLAT,
+        ib_hashfunc_djb2_nocase, NULL,
+        ib_hashequal_nocase, NULL
+    );
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    local_table->mm     = mm;
+    local_table->size   = 0;
+    local_table->frozen = false;
+
+    *table = local_table;
+
+    return IB_OK;
+}
+
+void ib_atom_table_freeze(
+    ib_atom_table_t *table
+)
+{
+    assert(table != NULL);
+
+    table->frozen = true;
+}
+
+size_t ib_atom_table_size(
+    const ib_atom_table_t *table
+)
+{
+    assert(table != NULL);
+
+    return table->size;
+}
+
+ib_status_t ib_atom_intern(
+    ib_atom_table_t  *table,
+    const char       *name,
+    size_t            name_length,
+    const ib_atom_t **atom
+)
+{
+    assert(table != NULL);
+    assert(name  != NULL);
+
+    ib_atom_t   *local_atom;
+    ib_status_t  rc;
+
+    rc = ib_atom_lookup(table, name, name_length, atom);
+    if (rc != IB_ENOENT || table->frozen) {
+        return rc;
+    }
+
+    local_atom = ib_mm_alloc(table->mm, sizeof(*local_atom));
+    if (local_atom == NULL) {
+        return IB_EALLOC;
+    }
+    local_atom->name = ib_mm_memdup_to_str(table->mm, name, name_length);
+    if (local_atom->name == NULL) {
+        return IB_EALLOC;
+    }
+    local_atom->name_length = name_length;
+    local_atom->id          = table->size;
+
+    rc = ib_hash_set_ex(
+        table->by_name,
+        local_atom->name, local_atom->name_length,
+        local_atom
+    );
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    ++table->size;
+    if (atom != NULL) {
+        *atom = local_atom;
+    }
+
+    return IB_OK;
+}
+
+ib_status_t ib_atom_lookup(
+    const ib_atom_table_t  *table,
+    const char             *name,
+    size_t                  name_length,
+    const ib_atom_t       **atom
+)
+{
+    assert(table != NULL);
+    assert(name  != NULL);
+
+    const ib_atom_t *local_atom;
+    ib_status_t      rc;
+
+    rc = ib_hash_get_ex(table->by_name, &local_atom, name, name_length);
+    if (rc != IB_OK) {
+        return IB_ENOENT;
+    }
+
+    if (atom != NULL) {
+        *atom = local_atom;
+    }
+
+    return IB_OK;
+}
+
+void ib_atom_name(
+    const ib_atom_t  *atom,
+    const char      **name,
+    size_t           *name_length
+)
+{
+    assert(atom        != NULL);
+    assert(name        != NULL);
+    assert(name_length != NULL);
+
+    *name        = atom->name;
+    *name_length = atom->name_length;
+}
+
+size_t ib_atom_id(
+    const ib_atom_t *atom
+)
+{
+    assert(atom != NULL);
+
+    return atom->id;
+}
@@ -27,6 +27,7 @@
 #include <ironbee/bytestr.h>
 
 #include <ironbee/mm.h>
+#include <ironbee/mm_mpool.h>
 #include <ironbee/string.h>
 
 #include <assert.h>
@@ -91,7 +92,7 @@ ib_status_t ib_bytestr_create(
     ib_status_t rc;
 
     /* Create the structure. */
-    *pdst = (ib_bytestr_t *)ib_mm_alloc(mm, sizeof(**pdst));
+    *pdst = (ib_bytestr_t *)ib_mm_alloc_fixed(mm, sizeof(**pdst));
     if (*pdst == NULL) {
         rc = IB_EALLOC;
         goto failed;
@@ -106,6 +107,7 @@ ib_status_t ib_bytestr_create(
     if (size != 0) {
         (*pdst)->data = (uint8_t *)ib_mm_alloc(mm, size);
         if ((*pdst)->data == NULL) {
+            ib_mm_free_fixed(mm, *pdst, sizeof(**pdst));
             rc = IB_EALLOC;
             goto failed;
         }
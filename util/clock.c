@@ -28,7 +28,10 @@
 #include <ironbee/clock.h>
 
 #include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <time.h>
 
 #include <sys/time.h>
@@ -57,6 +60,124 @@
 #endif /* CLOCK_MONOTONIC_RAW */
 #endif /* CLOCK_MONOTONIC_COARSE */
 
+#ifdef CLOCK_MONOTONIC_COARSE
+#define IB_COARSE_CLOCK                   CLOCK_MONOTONIC_COARSE
+#else
+#ifdef CLOCK_MONOTONIC
+#define IB_COARSE_CLOCK                   CLOCK_MONOTONIC
+#endif /* CLOCK_MONOTONIC */
+#endif /* CLOCK_MONOTONIC_COARSE */
+
+#ifdef CLOCK_REALTIME_COARSE
+#define IB_COARSE_REALTIME_CLOCK          CLOCK_REALTIME_COARSE
+#else
+#define IB_COARSE_REALTIME_CLOCK          CLOCK_REALTIME
+#endif /* CLOCK_REALTIME_COARSE */
+
+/**
+ * Current clock mode; an ib_clock_mode_t.
+ */
+static int g_clock_mode = IB_CLOCK_MODE_PRECISE;
+
+/**
+ * Clock the ticker waits with.
+ *
+ * Waits are against a monotonic clock where available so that steps of the
+ * wall clock do not stall the ticker.
+ */
+#ifdef CLOCK_MONOTONIC
+#define IB_TICKER_WAIT_CLOCK              CLOCK_MONOTONIC
+#else
+#define IB_TICKER_WAIT_CLOCK              CLOCK_REALTIME
+#endif /* CLOCK_MONOTONIC */
+
+/**
+ * The clock ticker.
+ *
+ * The ticker thread publishes the clocks in @a mono and @a real; zero if
+ * it is not running.  The other members are protected by @a lock.
+ * Starting and stopping hold @a control throughout so that a start cannot
+ * find a thread that is still stopping.  @a cond exists only while the
+ * thread runs.
+ */
+static struct {
+    ib_time_t       mono;      /**< Monotonic time published. */
+    ib_time_t       real;      /**< Epoch time published. */
+    pthread_mutex_t control;   /**< Serializes start and stop. */
+    pthread_mutex_t lock;      /**< Protects the following. */
+    pthread_cond_t  cond;      /**< Signalled on changes to the following. */
+    pthread_t       thread;    /**< Ticker thread. */
+    size_t          refs;      /**< References; running if non-zero. */
+    ib_time_t       interval;  /**< Interval in microseconds. */
+    ib_time_t      *intervals; /**< Interval of each reference; malloced. */
+    size_t          capacity;  /**< Capacity of @a intervals. */
+} g_ticker = {
+    0, 0, PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER,
+    PTHREAD_COND_INITIALIZER,
+    (pthread_t)0, 0, 0, NULL, 0
+};
+
+/**
+ * Read @a clock in microseconds.
+ *
+ * @param[in] clock Clock id.
+ *
+ * @returns Microsecond time value.
+ */
+static inline ib_time_t clock_read(clockid_t clock)
+{
+    struct timespec ts;
+
+    clock_gettime(clock, &ts);
+
+    /* There are 1 million microsecs in a sec.
+     * There are 1000 nanosecs in a microsec
+     */
+    return ((ib_time_t)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+}
+
+/**
+ * Publish the clocks for @ref IB_CLOCK_MODE_CACHED.
+ */
+static void ticker_publish(void)
+{
+#ifdef IB_CLOCK
+    __atomic_store_n(&g_ticker.mono, clock_read(IB_CLOCK), __ATOMIC_RELAXED);
+#else
+    __atomic_store_n(
+        &g_ticker.mono, clock_read(CLOCK_REALTIME), __ATOMIC_RELAXED);
+#endif
+    __atomic_store_n(
+        &g_ticker.real, clock_read(CLOCK_REALTIME), __ATOMIC_RELAXED);
+}
+
+/**
+ * Ticker thread: publish the clocks every interval until no references.
+ *
+ * @param[in] arg Unused.
+ *
+ * @returns NULL
+ */
+static void *ticker_main(void *arg)
+{
+    pthread_mutex_lock(&g_ticker.lock);
+    while (g_ticker.refs > 0) {
+        struct timespec deadline;
+        ib_time_t       t;
+
+        ticker_publish();
+
+        clock_gettime(IB_TICKER_WAIT_CLOCK, &deadline);
+        t = (ib_time_t)deadline.tv_nsec + g_ticker.interval * 1000;
+        deadline.tv_sec  += t / 1000000000;
+        deadline.tv_nsec  = t % 1000000000;
+        pthread_cond_timedwait(&g_ticker.cond, &g_ticker.lock, &deadline);
+    }
+    pthread_mutex_unlock(&g_ticker.lock);
+
+    return NULL;
+}
+
 /**
  * Assign values between two timeval structures.
  *
@@ -121,9 +242,25 @@ ib_time_t ib_clock_get_time(void)
 {
     uint64_t usec;
 
-#ifdef IB_CLOCK
-    struct timespec ts;
+    switch (__atomic_load_n(&g_clock_mode, __ATOMIC_RELAXED)) {
+    case IB_CLOCK_MODE_CACHED:
+        usec = __atomic_load_n(&g_ticker.mono, __ATOMIC_RELAXED);
+        if (usec != 0) {
+            return usec;
+        }
+        /* No ticker. */
+        /* Fall through */
+    case IB_CLOCK_MODE_COARSE:
+#ifdef IB_COARSE_CLOCK
+        return clock_read(IB_COARSE_CLOCK);
+#else
+        break;
+#endif
+    default:
+        break;
+    }
 
+#ifdef IB_CLOCK
     /* Ticks seem to be an undesirable due for many reasons.
      * IB_CLOCK is set to CLOCK_MONOTONIC which is vulnerable to slew or
      * if available set to CLOCK_MONOTONIC_RAW which does not suffer from
@@ -132,12 +269,7 @@ ib_time_t ib_clock_get_time(void)
      * timespec provides sec and nsec resolution so we have to convert to
      * msec.
      */
-    clock_gettime(IB_CLOCK, &ts);
-
-    /* There are 1 million microsecs in a sec.
-     * There are 1000 nanosecs in a microsec
-     */
-    usec = (ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+    usec = clock_read(IB_CLOCK);
 #else
     struct timeval tv;
 
@@ -150,17 +282,9 @@ ib_time_t ib_clock_get_time(void)
 
 ib_time_t ib_clock_precise_get_time(void)
 {
+    /* Not subject to the clock mode; used to time short intervals. */
 #ifdef IB_PRECISE_CLOCK
-    uint64_t usec;
-    struct timespec ts;
-
-    clock_gettime(IB_PRECISE_CLOCK, &ts);
-
-    /* There are 1 million microsecs in a sec.
-     * There are 1000 nanosecs in a microsec
-     */
-    usec = (ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
-    return usec;
+    return clock_read(IB_PRECISE_CLOCK);
 #else
     return ib_clock_get_time();
 #endif
@@ -171,6 +295,24 @@ void ib_clock_gettimeofday(ib_timeval_t *tp)
     assert(tp != NULL);
 
     struct timeval tv;
+    ib_time_t      usec;
+
+    switch (__atomic_load_n(&g_clock_mode, __ATOMIC_RELAXED)) {
+    case IB_CLOCK_MODE_CACHED:
+        usec = __atomic_load_n(&g_ticker.real, __ATOMIC_RELAXED);
+        if (usec != 0) {
+            IB_CLOCK_TIMEVAL(*tp, usec);
+            return;
+        }
+        /* No ticker. */
+        /* Fall through */
+    case IB_CLOCK_MODE_COARSE:
+        usec = clock_read(IB_COARSE_REALTIME_CLOCK);
+        IB_CLOCK_TIMEVAL(*tp, usec);
+        return;
+    default:
+        break;
+    }
 
     gettimeofday(&tv, NULL);
 
@@ -178,6 +320,160 @@ void ib_clock_gettimeofday(ib_timeval_t *tp)
     tp->tv_usec = (uint32_t)tv.tv_usec;
 }
 
+void ib_clock_mode_set(ib_clock_mode_t mode)
+{
+    __atomic_store_n(&g_clock_mode, mode, __ATOMIC_RELAXED);
+}
+
+ib_clock_mode_t ib_clock_mode(void)
+{
+    return __atomic_load_n(&g_clock_mode, __ATOMIC_RELAXED);
+}
+
+/**
+ * Initialize @a cond to wait against @ref IB_TICKER_WAIT_CLOCK.
+ *
+ * @param[out] cond Condition variable.
+ *
+ * @returns 0 on success; an error number on failure.
+ */
+static int ticker_cond_init(pthread_cond_t *cond)
+{
+    pthread_condattr_t attr;
+    int                rc;
+
+    rc = pthread_condattr_init(&attr);
+    if (rc != 0) {
+        return rc;
+    }
+    rc = pthread_condattr_setclock(&attr, IB_TICKER_WAIT_CLOCK);
+    if (rc == 0) {
+        rc = pthread_cond_init(cond, &attr);
+    }
+    pthread_condattr_destroy(&attr);
+
+    return rc;
+}
+
+ib_status_t ib_clock_ticker_start(ib_time_t interval)
+{
+    ib_status_t rc = IB_OK;
+
+    if (interval == 0) {
+        return IB_EINVAL;
+    }
+
+    pthread_mutex_lock(&g_ticker.control);
+    pthread_mutex_lock(&g_ticker.lock);
+    if (g_ticker.refs == g_ticker.capacity) {
+        size_t     capacity = (g_ticker.capacity == 0) ?
+                              4 : 2 * g_ticker.capacity;
+        ib_time_t *intervals = realloc(
+            g_ticker.intervals, capacity * sizeof(*intervals)
+        );
+
+        if (intervals == NULL) {
+            rc = IB_EALLOC;
+            goto finish;
+        }
+        g_ticker.intervals = intervals;
+        g_ticker.capacity = capacity;
+    }
+
+    if (g_ticker.refs == 0) {
+        g_ticker.interval = interval;
+        g_ticker.refs = 1;
+        /* Publish now so readers never see the ticker without values. */
+        ticker_publish();
+        if (ticker_cond_init(&g_ticker.cond) != 0) {
+            rc = IB_EOTHER;
+        }
+        else if (
+            pthread_create(&g_ticker.thread, NULL, ticker_main, NULL) != 0
+        ) {
+            pthread_cond_destroy(&g_ticker.cond);
+            rc = IB_EOTHER;
+        }
+        if (rc != IB_OK) {
+            g_ticker.refs = 0;
+            __atomic_store_n(&g_ticker.mono, 0, __ATOMIC_RELAXED);
+            __atomic_store_n(&g_ticker.real, 0, __ATOMIC_RELAXED);
+            goto finish;
+        }
+    }
+    else {
+        ++g_ticker.refs;
+        if (interval < g_ticker.interval) {
+            g_ticker.interval = interval;
+            pthread_cond_signal(&g_ticker.cond);
+        }
+    }
+    g_ticker.intervals[g_ticker.refs - 1] = interval;
+
+finish:
+    pthread_mutex_unlock(&g_ticker.lock);
+    pthread_mutex_unlock(&g_ticker.control);
+
+    return rc;
+}
+
+void ib_clock_ticker_stop(ib_time_t interval)
+{
+    pthread_t thread;
+    bool      join = false;
+    size_t    i;
+
+    pthread_mutex_lock(&g_ticker.control);
+    pthread_mutex_lock(&g_ticker.lock);
+    assert(g_ticker.refs > 0);
+
+    /* Drop the reference and run at the smallest remaining interval. */
+    for (i = 0; i < g_ticker.refs - 1; ++i) {
+        if (g_ticker.intervals[i] == interval) {
+            break;
+        }
+    }
+    assert(g_ticker.intervals[i] == interval);
+    g_ticker.intervals[i] = g_ticker.intervals[g_ticker.refs - 1];
+
+    if (--g_ticker.refs == 0) {
+        __atomic_store_n(&g_ticker.mono, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&g_ticker.real, 0, __ATOMIC_RELAXED);
+        thread = g_ticker.thread;
+        join = true;
+        pthread_cond_signal(&g_ticker.cond);
+    }
+    else {
+        g_ticker.interval = g_ticker.intervals[0];
+        for (i = 1; i < g_ticker.refs; ++i) {
+            if (g_ticker.intervals[i] < g_ticker.interval) {
+                g_ticker.interval = g_ticker.intervals[i];
+            }
+        }
+    }
+    pthread_mutex_unlock(&g_ticker.lock);
+
+    if (join) {
+        pthread_join(thread, NULL);
+        pthread_cond_destroy(&g_ticker.cond);
+        free(g_ticker.intervals);
+        g_ticker.intervals = NULL;
+        g_ticker.capacity = 0;
+    }
+    pthread_mutex_unlock(&g_ticker.control);
+}
+
+ib_time_t ib_clock_ticker_interval(void)
+{
+    ib_time_t interval;
+
+    pthread_mutex_lock(&g_ticker.lock);
+    interval = (g_ticker.refs == 0) ? 0 : g_ticker.interval;
+    pthread_mutex_unlock(&g_ticker.lock);
+
+    return interval;
+}
+
 void ib_clock_timestamp(char *buf, const ib_timeval_t *ptv)
 {
     struct timeval tv;
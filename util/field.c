@@ -32,6 +32,7 @@
 #include <ironbee/escape.h>
 #include <ironbee/log.h>
 #include <ironbee/mm.h>
+#include <ironbee/mm_mpool.h>
 #include <ironbee/string.h>
 #include <ironbee/stream.h>
 #include <ironbee/type_convert.h>
@@ -72,6 +73,14 @@ struct ib_field_val_t {
     ib_field_val_union_t  u;             /**< Union of value types */
 };
 
+/**
+ * A field and its value store, allocated together.
+ */
+typedef struct {
+    ib_field_t     field;                /**< Field */
+    ib_field_val_t val;                  /**< Value store of @c field */
+} ib_field_block_t;
+
 const char *ib_field_type_name(
     ib_ftype_t ftype
 )
@@ -408,36 +417,34 @@ ib_status_t ib_field_create_alias(
 )
 {
     ib_status_t rc;
+    ib_field_block_t *block;
     char *name_copy;
 
-    /* Allocate the field structure. */
-    *pf = (ib_field_t *)ib_mm_alloc(mm, sizeof(**pf));
-    if (*pf == NULL) {
+    /* Allocate the field structure and value store. */
+    block = (ib_field_block_t *)ib_mm_alloc_fixed(mm, sizeof(*block));
+    if (block == NULL) {
         rc = IB_EALLOC;
         goto failed;
     }
+    *pf = &(block->field);
     (*pf)->mm = mm;
     (*pf)->type = type;
     (*pf)->tfn = NULL;
 
     /* Copy the name. */
     (*pf)->nlen = nlen;
+    (*pf)->atom = NULL;
     name_copy = (char *)ib_mm_alloc(mm, nlen);
     if (name_copy == NULL) {
+        ib_mm_free_fixed(mm, block, sizeof(*block));
         rc = IB_EALLOC;
         goto failed;
     }
     memcpy(name_copy, name, nlen);
     (*pf)->name = (const char *)name_copy;
 
-    (*pf)->val = (ib_field_val_t *)ib_mm_calloc(mm,
-        1, sizeof(*((*pf)->val))
-    );
-    if ((*pf)->val == NULL) {
-        rc = IB_EALLOC;
-        goto failed;
-    }
-
+    memset(&(block->val), 0, sizeof(block->val));
+    (*pf)->val = &(block->val);
     (*pf)->val->pval = storage_pval;
 
     ib_field_util_log_debug("FIELD_CREATE_ALIAS", (*pf));
@@ -1149,16 +1156,18 @@ ib_status_t ib_field_convert(
             new_field_value = ib_ftype_nulstr_in(str);
             break;
         case IB_FTYPE_BYTESTR:
-            str = ib_type_ttoa(mm, tme);
-            if (! str) {
-                return IB_EINVAL;
-            }
-            rc = ib_bytestr_dup_nulstr((ib_bytestr_t **)&bstr, mm, str);
+        {
+            char buf[IB_TYPE_NUM_BUF_SIZE];
+
+            sz = ib_type_ttoa_buf(tme, buf);
+            rc = ib_bytestr_dup_mem(
+                (ib_bytestr_t **)&bstr, mm, (const uint8_t *)buf, sz);
             if (rc != IB_OK){
                 return rc;
             }
             new_field_value = ib_ftype_bytestr_in(bstr);
             break;
+        }
         case IB_FTYPE_FLOAT:
             flt = (ib_float_t)tme;
             /* Check that our assignment is within error=1, or fail. */
@@ -1189,16 +1198,18 @@ ib_status_t ib_field_convert(
             new_field_value = ib_ftype_nulstr_in(str);
             break;
         case IB_FTYPE_BYTESTR:
-            str = ib_type_itoa(mm, num);
-            if (! str) {
-                return IB_EINVAL;
-            }
-            rc = ib_bytestr_dup_nulstr((ib_bytestr_t **)&bstr, mm, str);
+        {
+            char buf[IB_TYPE_NUM_BUF_SIZE];
+
+            sz = ib_type_itoa_buf(num, buf);
+            rc = ib_bytestr_dup_mem(
+                (ib_bytestr_t **)&bstr, mm, (const uint8_t *)buf, sz);
             if (rc != IB_OK){
                 return rc;
             }
             new_field_value = ib_ftype_bytestr_in(bstr);
             break;
+        }
         case IB_FTYPE_TIME:
             if (num < 0) {
                 return IB_EINVAL;
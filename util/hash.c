@@ -33,6 +33,10 @@
 #include <string.h>
 #include <time.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 /* Internal Declarations */
 
 /**
@@ -49,6 +53,25 @@
  **/
 #define IB_HASH_INITIAL_SIZE 16
 
+/**
+ * Number of slots in a probe group of an IB_HASH_LAYOUT_FLAT hash.
+ *
+ * The tags of a group are compared in a single SIMD operation.
+ **/
+#define IB_HASH_FLAT_GROUP_SIZE 16
+
+/**
+ * Tag of a flat slot that is empty and has been so since the last rehash.
+ *
+ * Tags of occupied slots never have the high bit set.
+ **/
+#define IB_HASH_FLAT_EMPTY 0x80
+
+/**
+ * Tag of a flat slot whose entry has been removed.
+ **/
+#define IB_HASH_FLAT_DELETED 0xfe
+
 /**
  * See ib_hash_entry_t()
  */
@@ -70,21 +93,46 @@ struct ib_hash_entry_t {
     ib_hash_entry_t     *next_entry;
 };
 
+/**
+ * See ib_hash_flat_entry_t()
+ */
+typedef struct ib_hash_flat_entry_t ib_hash_flat_entry_t;
+
+/**
+ * Entry in a ib_hash_t with IB_HASH_LAYOUT_FLAT.
+ *
+ * Entries are stored inline in the slot array.  Whether an entry is in use
+ * is determined by the tag of its slot.
+ **/
+struct ib_hash_flat_entry_t {
+    /** Key. */
+    const char          *key;
+    /** Length of @c key. */
+    size_t               key_length;
+    /** Value. */
+    void                *value;
+    /** Hash of @c key. */
+    uint32_t             hash_value;
+};
+
 /**
  * External iterator for ib_hash_t.
  *
- * The end of the sequence is indicated by @c current_entry being NULL.
- * Any iterator is invalidated by any mutating operation on the hash.
+ * The end of the sequence is indicated by both @c current_entry and
+ * @c current_flat being NULL.  Any iterator is invalidated by any mutating
+ * operation on the hash other than removal of the current entry.
  **/
 struct ib_hash_iterator_t {
     /** Hash table we are iterating through. */
-    const ib_hash_t     *hash;
-    /** Current entry. */
-    ib_hash_entry_t     *current_entry;
-    /** Next entry. */
-    ib_hash_entry_t     *next_entry;
+    const ib_hash_t      *hash;
+    /** Current entry (IB_HASH_LAYOUT_CHAINED). */
+    ib_hash_entry_t      *current_entry;
+    /** Next entry (IB_HASH_LAYOUT_CHAINED). */
+    ib_hash_entry_t      *next_entry;
+    /** Current entry (IB_HASH_LAYOUT_FLAT). */
+    ib_hash_flat_entry_t *current_flat;
     /** Which slot to look in next. */
-    size_t               slot_index;
+    size_t                slot_index;
 };
 
 /**
@@ -99,14 +147,32 @@ struct ib_hash_t {
     ib_hash_equal_t      equal_predicate;
     /** Key equality callback data. */
     void                *equal_cbdata;
+    /** Storage layout. */
+    ib_hash_layout_t     layout;
 
     /**
-     * Slots.
+     * Slots (IB_HASH_LAYOUT_CHAINED).
      *
      * Each slot holds a (possibly empty) linked list of ib_hash_entry_t's,
      * all of which have the same hash value.
      **/
     ib_hash_entry_t    **slots;
+    /**
+     * Slot tags (IB_HASH_LAYOUT_FLAT).
+     *
+     * The tag of an occupied slot is the low 7 bits of the hash value of its
+     * key.  Otherwise it is IB_HASH_FLAT_EMPTY or IB_HASH_FLAT_DELETED.
+     * Allocated with malloc(), as is @c entries, so that a rehash can free
+     * the arrays it replaces.
+     **/
+    uint8_t             *tags;
+    /** Entries, parallel to @c tags (IB_HASH_LAYOUT_FLAT). */
+    ib_hash_flat_entry_t *entries;
+    /**
+     * Number of empty slots that may be filled before a rehash
+     * (IB_HASH_LAYOUT_FLAT).
+     **/
+    size_t               growth_left;
     /** Maximum slot index. */
     size_t               max_slot;
     /** Memory manager. */
@@ -199,6 +265,96 @@ static char ib_hash_tolower(
     char c
 );
 
+/**
+ * Allocate and initialize the tag and entry arrays of a flat hash.
+ *
+ * The arrays are allocated with malloc() rather than from the memory
+ * manager of the hash so that a rehash can release the arrays it replaces.
+ * The current arrays are freed by ib_hash_flat_cleanup().
+ *
+ * @param[in]  capacity Number of slots; a power of 2 and a multiple of
+ *                      IB_HASH_FLAT_GROUP_SIZE.
+ * @param[out] tags     Tags, all IB_HASH_FLAT_EMPTY.
+ * @param[out] entries  Uninitialized entries.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ */
+static ib_status_t ib_hash_flat_alloc(
+    size_t                 capacity,
+    uint8_t              **tags,
+    ib_hash_flat_entry_t **entries
+);
+
+/**
+ * Free the tag and entry arrays of a flat hash.
+ *
+ * Registered with the memory manager of the hash.
+ *
+ * @param[in] cbdata The hash.
+ */
+static void ib_hash_flat_cleanup(
+    void *cbdata
+);
+
+/**
+ * Search for an entry in flat @a hash matching @a key.
+ *
+ * @param[in] hash       Hash table.
+ * @param[in] key        Key to search for.
+ * @param[in] key_length Length of @a key.
+ * @param[in] hash_value Hash value of @a key.
+ *
+ * @returns Hash entry if found and NULL otherwise.
+ */
+static ib_hash_flat_entry_t *ib_hash_flat_find(
+    const ib_hash_t *hash,
+    const char      *key,
+    size_t           key_length,
+    uint32_t         hash_value
+);
+
+/**
+ * Find the first empty or deleted slot in the probe sequence of a hash value.
+ *
+ * @param[in] tags       Tags to search.
+ * @param[in] max_slot   Maximum slot index of @a tags.
+ * @param[in] hash_value Hash value to probe for.
+ *
+ * @returns Index of the slot.
+ */
+static size_t ib_hash_flat_find_free(
+    const uint8_t *tags,
+    size_t         max_slot,
+    uint32_t       hash_value
+);
+
+/**
+ * Rebuild a flat hash, dropping tombstones and growing if needed.
+ *
+ * @param[in] hash Hash table.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ */
+static ib_status_t ib_hash_flat_rehash(
+    ib_hash_t *hash
+);
+
+/**
+ * Set value of @a key in flat @a hash, removing it if @a value is NULL.
+ *
+ * @sa ib_hash_set_ex()
+ */
+static ib_status_t ib_hash_flat_set(
+    ib_hash_t  *hash,
+    const char *key,
+    size_t      key_length,
+    void       *value
+);
+
 /* End Internal Declarations */
 
 /* Internal Definitions */
@@ -286,7 +442,7 @@ ib_hash_iterator_t *ib_hash_iterator_create_malloc()
 
 bool ib_hash_iterator_at_end(const ib_hash_iterator_t *iterator)
 {
-    return iterator->current_entry == NULL;
+    return iterator->current_entry == NULL && iterator->current_flat == NULL;
 }
 
 void ib_hash_iterator_first(
@@ -311,6 +467,19 @@ void ib_hash_iterator_fetch(
 {
     assert(iterator != NULL);
 
+    if (iterator->current_flat != NULL) {
+        if (key != NULL) {
+            *key            = iterator->current_flat->key;
+        }
+        if (key_length != NULL) {
+            *key_length     = iterator->current_flat->key_length;
+        }
+        if (value != NULL) {
+            *(void **)value = iterator->current_flat->value;
+        }
+        return;
+    }
+
     if (key != NULL) {
         *key            = iterator->current_entry->key;
     }
@@ -327,6 +496,22 @@ void ib_hash_iterator_next(
 ) {
     assert(iterator != NULL);
 
+    if (iterator->hash->layout == IB_HASH_LAYOUT_FLAT) {
+        const ib_hash_t *hash = iterator->hash;
+
+        iterator->current_flat = NULL;
+        while (iterator->slot_index <= hash->max_slot) {
+            size_t i = iterator->slot_index;
+
+            ++iterator->slot_index;
+            if ((hash->tags[i] & IB_HASH_FLAT_EMPTY) == 0) {
+                iterator->current_flat = &hash->entries[i];
+                return;
+            }
+        }
+        return;
+    }
+
     iterator->current_entry = iterator->next_entry;
     while (! iterator->current_entry) {
         if (iterator->slot_index > iterator->hash->max_slot) {
@@ -355,6 +540,7 @@ bool ib_hash_iterator_equal(
         a->hash          == b->hash          &&
         a->current_entry == b->current_entry &&
         a->next_entry    == b->next_entry    &&
+        a->current_flat  == b->current_flat  &&
         a->slot_index    == b->slot_index
         ;
 }
@@ -434,6 +620,378 @@ static char ib_hash_tolower(
     return s_table[(unsigned char)c];
 }
 
+/**
+ * Tag stored for an occupied flat slot with hash value @a hash_value.
+ *
+ * @param[in] hash_value Hash value.
+ * @return Tag.
+ */
+inline
+static uint8_t ib_hash_flat_tag(
+    uint32_t hash_value
+)
+{
+    return (uint8_t)(hash_value & 0x7f);
+}
+
+/**
+ * Index of the first probe group for hash value @a hash_value.
+ *
+ * The bits used for the tag are skipped so that group and tag are
+ * independent.
+ *
+ * @param[in] hash_value Hash value.
+ * @param[in] max_slot   Maximum slot index.
+ * @return Group index.
+ */
+inline
+static size_t ib_hash_flat_first_group(
+    uint32_t hash_value,
+    size_t   max_slot
+)
+{
+    return (hash_value >> 7) & (max_slot / IB_HASH_FLAT_GROUP_SIZE);
+}
+
+/**
+ * Bit mask of the slots in @a group whose tag is @a tag.
+ *
+ * @param[in] group IB_HASH_FLAT_GROUP_SIZE tags.
+ * @param[in] tag   Tag to look for.
+ * @return Mask with bit i set iff @a group[i] == @a tag.
+ */
+inline
+static unsigned int ib_hash_flat_match(
+    const uint8_t *group,
+    uint8_t        tag
+)
+{
+#ifdef __SSE2__
+    __m128i tags = _mm_loadu_si128((const __m128i *)group);
+
+    return (unsigned int)_mm_movemask_epi8(
+        _mm_cmpeq_epi8(tags, _mm_set1_epi8((char)tag))
+    );
+#else
+    unsigned int mask = 0;
+
+    for (size_t i = 0; i < IB_HASH_FLAT_GROUP_SIZE; ++i) {
+        if (group[i] == tag) {
+            mask |= 1U << i;
+        }
+    }
+
+    return mask;
+#endif
+}
+
+/**
+ * Bit mask of the slots in @a group that are empty or deleted.
+ *
+ * @param[in] group IB_HASH_FLAT_GROUP_SIZE tags.
+ * @return Mask with bit i set iff @a group[i] is not occupied.
+ */
+inline
+static unsigned int ib_hash_flat_match_free(
+    const uint8_t *group
+)
+{
+#ifdef __SSE2__
+    return (unsigned int)_mm_movemask_epi8(
+        _mm_loadu_si128((const __m128i *)group)
+    );
+#else
+    unsigned int mask = 0;
+
+    for (size_t i = 0; i < IB_HASH_FLAT_GROUP_SIZE; ++i) {
+        if ((group[i] & IB_HASH_FLAT_EMPTY) != 0) {
+            mask |= 1U << i;
+        }
+    }
+
+    return mask;
+#endif
+}
+
+/**
+ * Index of the lowest set bit of @a mask.
+ *
+ * @param[in] mask Non-zero mask.
+ * @return Index of lowest set bit.
+ */
+inline
+static unsigned int ib_hash_flat_lowest(
+    unsigned int mask
+)
+{
+    assert(mask != 0);
+
+#ifdef __GNUC__
+    return (unsigned int)__builtin_ctz(mask);
+#else
+    unsigned int i = 0;
+
+    while ((mask & 1) == 0) {
+        mask >>= 1;
+        ++i;
+    }
+
+    return i;
+#endif
+}
+
+/**
+ * Number of slots of a flat hash of @a capacity that may be occupied or
+ * deleted before it must be rehashed.
+ *
+ * @param[in] capacity Number of slots.
+ * @return Maximum load.
+ */
+inline
+static size_t ib_hash_flat_max_load(
+    size_t capacity
+)
+{
+    return capacity - capacity / 8;
+}
+
+ib_status_t ib_hash_flat_alloc(
+    size_t                 capacity,
+    uint8_t              **tags,
+    ib_hash_flat_entry_t **entries
+)
+{
+    assert(tags    != NULL);
+    assert(entries != NULL);
+    assert(capacity % IB_HASH_FLAT_GROUP_SIZE == 0);
+
+    uint8_t              *new_tags;
+    ib_hash_flat_entry_t *new_entries;
+
+    new_tags = (uint8_t *)malloc(capacity);
+    if (new_tags == NULL) {
+        return IB_EALLOC;
+    }
+    new_entries = (ib_hash_flat_entry_t *)malloc(
+        capacity * sizeof(*new_entries)
+    );
+    if (new_entries == NULL) {
+        free(new_tags);
+        return IB_EALLOC;
+    }
+    memset(new_tags, IB_HASH_FLAT_EMPTY, capacity);
+
+    *tags    = new_tags;
+    *entries = new_entries;
+
+    return IB_OK;
+}
+
+void ib_hash_flat_cleanup(
+    void *cbdata
+)
+{
+    assert(cbdata != NULL);
+
+    ib_hash_t *hash = (ib_hash_t *)cbdata;
+
+    free(hash->tags);
+    free(hash->entries);
+    hash->tags    = NULL;
+    hash->entries = NULL;
+}
+
+ib_hash_flat_entry_t *ib_hash_flat_find(
+    const ib_hash_t *hash,
+    const char      *key,
+    size_t           key_length,
+    uint32_t         hash_value
+)
+{
+    assert(hash != NULL);
+    assert(key  != NULL);
+
+    const size_t  group_mask = hash->max_slot / IB_HASH_FLAT_GROUP_SIZE;
+    const uint8_t tag        = ib_hash_flat_tag(hash_value);
+    size_t        group      =
+        ib_hash_flat_first_group(hash_value, hash->max_slot);
+
+    /* Triangular probing visits every group as the group count is a power
+     * of 2, and the load limit guarantees at least one empty slot. */
+    for (size_t step = 1; ; ++step) {
+        const size_t   base = group * IB_HASH_FLAT_GROUP_SIZE;
+        const uint8_t *tags = hash->tags + base;
+        unsigned int   mask = ib_hash_flat_match(tags, tag);
+
+        while (mask != 0) {
+            ib_hash_flat_entry_t *entry =
+                &hash->entries[base + ib_hash_flat_lowest(mask)];
+
+            if (
+                entry->hash_value == hash_value &&
+                hash->equal_predicate(
+                    key,        key_length,
+                    entry->key, entry->key_length,
+                    hash->equal_cbdata
+                )
+            ) {
+                return entry;
+            }
+            mask &= mask - 1;
+        }
+
+        /* An empty slot terminates every probe sequence through it. */
+        if (ib_hash_flat_match(tags, IB_HASH_FLAT_EMPTY) != 0) {
+            return NULL;
+        }
+
+        group = (group + step) & group_mask;
+    }
+}
+
+size_t ib_hash_flat_find_free(
+    const uint8_t *tags,
+    size_t         max_slot,
+    uint32_t       hash_value
+)
+{
+    assert(tags != NULL);
+
+    const size_t group_mask = max_slot / IB_HASH_FLAT_GROUP_SIZE;
+    size_t       group      = ib_hash_flat_first_group(hash_value, max_slot);
+
+    for (size_t step = 1; ; ++step) {
+        const size_t base = group * IB_HASH_FLAT_GROUP_SIZE;
+        unsigned int mask = ib_hash_flat_match_free(tags + base);
+
+        if (mask != 0) {
+            return base + ib_hash_flat_lowest(mask);
+        }
+
+        group = (group + step) & group_mask;
+    }
+}
+
+ib_status_t ib_hash_flat_rehash(
+    ib_hash_t *hash
+)
+{
+    assert(hash != NULL);
+
+    ib_status_t           rc;
+    size_t                capacity = hash->max_slot + 1;
+    uint8_t              *new_tags;
+    ib_hash_flat_entry_t *new_entries;
+
+    /* Grow unless most of the load is tombstones. */
+    if (hash->size >= ib_hash_flat_max_load(capacity) / 2) {
+        capacity *= 2;
+    }
+
+    rc = ib_hash_flat_alloc(capacity, &new_tags, &new_entries);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    for (size_t i = 0; i <= hash->max_slot; ++i) {
+        if ((hash->tags[i] & IB_HASH_FLAT_EMPTY) == 0) {
+            size_t j = ib_hash_flat_find_free(
+                new_tags,
+                capacity - 1,
+                hash->entries[i].hash_value
+            );
+
+            new_tags[j]    = hash->tags[i];
+            new_entries[j] = hash->entries[i];
+        }
+    }
+
+    free(hash->tags);
+    free(hash->entries);
+
+    hash->tags        = new_tags;
+    hash->entries     = new_entries;
+    hash->max_slot    = capacity - 1;
+    hash->growth_left = ib_hash_flat_max_load(capacity) - hash->size;
+
+    return IB_OK;
+}
+
+ib_status_t ib_hash_flat_set(
+    ib_hash_t  *hash,
+    const char *key,
+    size_t      key_length,
+    void       *value
+)
+{
+    assert(hash != NULL);
+    assert(key  != NULL);
+
+    uint32_t              hash_value;
+    ib_hash_flat_entry_t *entry;
+    size_t                slot;
+
+    hash_value = hash->hash_function(
+        key, key_length,
+        hash->randomizer,
+        hash->hash_cbdata
+    );
+
+    entry = ib_hash_flat_find(hash, key, key_length, hash_value);
+    if (entry != NULL) {
+        if (value != NULL) {
+            /* Update. */
+            entry->value = value;
+            return IB_OK;
+        }
+
+        /* Delete.  If the group still has an empty slot, no probe sequence
+         * continues past it and the slot can become empty again. */
+        slot = (size_t)(entry - hash->entries);
+        if (
+            ib_hash_flat_match(
+                hash->tags + (slot & ~(size_t)(IB_HASH_FLAT_GROUP_SIZE - 1)),
+                IB_HASH_FLAT_EMPTY
+            ) != 0
+        ) {
+            hash->tags[slot] = IB_HASH_FLAT_EMPTY;
+            ++hash->growth_left;
+        }
+        else {
+            hash->tags[slot] = IB_HASH_FLAT_DELETED;
+        }
+        entry->value = NULL;
+        --hash->size;
+
+        return IB_OK;
+    }
+
+    /* Not present and nothing to remove. */
+    if (value == NULL) {
+        return IB_OK;
+    }
+
+    if (hash->growth_left == 0) {
+        ib_status_t rc = ib_hash_flat_rehash(hash);
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
+    slot = ib_hash_flat_find_free(hash->tags, hash->max_slot, hash_value);
+    if (hash->tags[slot] == IB_HASH_FLAT_EMPTY) {
+        --hash->growth_left;
+    }
+    hash->tags[slot]                = ib_hash_flat_tag(hash_value);
+    hash->entries[slot].key         = key;
+    hash->entries[slot].key_length  = key_length;
+    hash->entries[slot].value       = value;
+    hash->entries[slot].hash_value  = hash_value;
+    ++hash->size;
+
+    return IB_OK;
+}
+
 /* End Internal Definitions */
 
 uint32_t ib_hashfunc_djb2(
@@ -515,6 +1073,7 @@ ib_status_t ib_hash_create_ex(
     ib_hash_t          **hash,
     ib_mm_t              mm,
     size_t               size,
+    ib_hash_layout_t     layout,
     ib_hash_function_t   hash_function,
     void                *hash_cbdata,
     ib_hash_equal_t      equal_predicate,
@@ -541,28 +1100,63 @@ ib_status_t ib_hash_create_ex(
         }
     }
 
-    new_hash = (ib_hash_t *)ib_mm_alloc(mm, sizeof(*new_hash));
+    new_hash = (ib_hash_t *)ib_mm_calloc(mm, 1, sizeof(*new_hash));
     if (new_hash == NULL) {
         *hash = NULL;
         return IB_EALLOC;
     }
 
-    ib_hash_entry_t **slots = (ib_hash_entry_t **)ib_mm_calloc(
-        mm,
-        size + 1,
-        sizeof(*slots)
-    );
-    if (slots == NULL) {
-        *hash = NULL;
-        return IB_EALLOC;
+    switch (layout) {
+        case IB_HASH_LAYOUT_CHAINED: {
+            ib_hash_entry_t **slots = (ib_hash_entry_t **)ib_mm_calloc(
+                mm,
+                size + 1,
+                sizeof(*slots)
+            );
+            if (slots == NULL) {
+                *hash = NULL;
+                return IB_EALLOC;
+            }
+            new_hash->slots = slots;
+            break;
+        }
+        case IB_HASH_LAYOUT_FLAT: {
+            ib_status_t rc;
+
+            /* Slots are probed a whole group at a time. */
+            if (size < IB_HASH_FLAT_GROUP_SIZE) {
+                size = IB_HASH_FLAT_GROUP_SIZE;
+            }
+            rc = ib_hash_flat_alloc(
+                size,
+                &new_hash->tags,
+                &new_hash->entries
+            );
+            if (rc != IB_OK) {
+                *hash = NULL;
+                return rc;
+            }
+            rc = ib_mm_register_cleanup(mm, ib_hash_flat_cleanup, new_hash);
+            if (rc != IB_OK) {
+                free(new_hash->tags);
+                free(new_hash->entries);
+                *hash = NULL;
+                return rc;
+            }
+            new_hash->growth_left = ib_hash_flat_max_load(size);
+            break;
+        }
+        default:
+            *hash = NULL;
+            return IB_EINVAL;
     }
 
     new_hash->hash_function   = hash_function;
     new_hash->hash_cbdata     = hash_cbdata;
     new_hash->equal_predicate = equal_predicate;
     new_hash->equal_cbdata    = equal_cbdata;
+    new_hash->layout          = layout;
     new_hash->max_slot        = size-1;
-    new_hash->slots           = slots;
     new_hash->mm              = mm;
     new_hash->free            = NULL;
     new_hash->size            = 0;
@@ -583,6 +1177,7 @@ ib_status_t ib_hash_create(
         hash,
         mm,
         IB_HASH_INITIAL_SIZE,
+        IB_HASH_LAYOUT_CHAINED,
         ib_hashfunc_djb2, NULL,
         ib_hashequal_default, NULL
     );
@@ -598,6 +1193,7 @@ ib_status_t ib_hash_create_nocase(
         hash,
         mm,
         IB_HASH_INITIAL_SIZE,
+        IB_HASH_LAYOUT_CHAINED,
         ib_hashfunc_djb2_nocase, NULL,
         ib_hashequal_nocase, NULL
     );
@@ -629,29 +1225,50 @@ ib_status_t ib_hash_get_ex(
 
     ib_status_t      rc;
     ib_hash_entry_t *current_entry = NULL;
+    void            *local_value   = NULL;
 
     if (key == NULL) {
         *(void **)value = NULL;
         return IB_EINVAL;
     }
 
-    rc = ib_hash_find_entry(
-        hash,
-        &current_entry,
-        key,
-        key_length
-    );
-    if (value != NULL) {
+    if (hash->layout == IB_HASH_LAYOUT_FLAT) {
+        ib_hash_flat_entry_t *flat_entry = ib_hash_flat_find(
+            hash,
+            key,
+            key_length,
+            hash->hash_function(
+                key, key_length,
+                hash->randomizer,
+                hash->hash_cbdata
+            )
+        );
+        if (flat_entry != NULL) {
+            local_value = flat_entry->value;
+            rc = IB_OK;
+        }
+        else {
+            rc = IB_ENOENT;
+        }
+    }
+    else {
+        rc = ib_hash_find_entry(
+            hash,
+            &current_entry,
+            key,
+            key_length
+        );
         if (rc == IB_OK) {
             assert(current_entry != NULL);
 
-            *(void **)value = current_entry->value;
-        }
-        else {
-            *(void **)value = NULL;
+            local_value = current_entry->value;
         }
     }
 
+    if (value != NULL) {
+        *(void **)value = local_value;
+    }
+
     return rc;
 }
 
@@ -686,7 +1303,10 @@ ib_status_t ib_hash_get_all(
 
     ib_hash_iterator_t i;
     IB_HASH_LOOP(i, hash) {
-        ib_list_push(list, i.current_entry->value);
+        void *value;
+
+        ib_hash_iterator_fetch(NULL, NULL, &value, &i);
+        ib_list_push(list, value);
     }
 
     if (ib_list_elements(list) <= 0) {
@@ -713,6 +1333,10 @@ ib_status_t ib_hash_set_ex(
     /* Points to pointer that points to current_entry */
     ib_hash_entry_t **current_entry_handle  = NULL;
 
+    if (hash->layout == IB_HASH_LAYOUT_FLAT) {
+        return ib_hash_flat_set(hash, key, key_length, value);
+    }
+
     hash_value = hash->hash_function(
         key, key_length,
         hash->randomizer,
@@ -819,6 +1443,13 @@ ib_status_t ib_hash_set(
 void ib_hash_clear(ib_hash_t *hash) {
     assert(hash != NULL);
 
+    if (hash->layout == IB_HASH_LAYOUT_FLAT) {
+        memset(hash->tags, IB_HASH_FLAT_EMPTY, hash->max_slot + 1);
+        hash->growth_left = ib_hash_flat_max_load(hash->max_slot + 1);
+        hash->size        = 0;
+        return;
+    }
+
     for (size_t i = 0; i <= hash->max_slot; ++i) {
         if (hash->slots[i] != NULL) {
             ib_hash_entry_t *current_entry;
@@ -31,6 +31,7 @@
 #include <assert.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
 
 /**
  * Helper typedef of a stdlib compare function.
@@ -137,6 +138,9 @@ bool ib_ipset6_is_prefix(
             return false;
         }
     }
+    if (initial_bytes == 4) {
+        return true;
+    }
 
     return
         (a_net.ip.ip[initial_bytes] & ib_ipset4_mask(remaining_bits)) ==
@@ -177,7 +181,7 @@ int ib_ipset4_compare_strict(
             return -1;
         }
         if (a_net->size > b_net->size) {
-            return -1;
+            return 1;
         }
         return 0;
     }
@@ -495,6 +499,841 @@ ib_status_t ib_ipset_query(
     return IB_OK;
 }
 
+/**
+ * @name Compiled Lookup
+ *
+ * Both compiled forms map an address to a 32 bit cell value.  A value of 0
+ * means no containing positive network; any other value is one plus the
+ * index of the most specific containing positive network.  The most general
+ * containing network is then found via a precomputed per entry array.
+ *
+ * During construction, the negative bit marks cells covered by a negative
+ * network.  Networks are painted from shortest to longest and positive and
+ * negative networks are independent: a positive network replaces the
+ * positive index but retains the negative bit.  All cells with the negative
+ * bit are cleared once construction is complete.
+ */
+/**@{*/
+
+/** Cell bit: cell refers to a tbl8 group (v4) / construction flag. */
+#define IB_IPSET_CELL_GROUP    0x80000000
+/** Cell bit: cell is covered by a negative network (construction only). */
+#define IB_IPSET_CELL_NEGATIVE 0x40000000
+/** Cell bits: positive index plus one. */
+#define IB_IPSET_CELL_VALUE    0x3fffffff
+/** Maximum number of positive or negative entries of a compiled set. */
+#define IB_IPSET_COMPILED_MAX  0x3fffffff
+
+/** Reference bit: entry is negative. */
+#define IB_IPSET_REF_NEGATIVE  0x80000000
+
+/** Number of entries in a v4 tbl16. */
+#define IB_IPSET4_TBL16_SIZE   (1 << 16)
+/** Number of entries in a v4 tbl8 group. */
+#define IB_IPSET4_TBL8_SIZE    256
+
+/** Number of levels of the v6 trie. */
+#define IB_IPSET6_LEVELS       16
+
+struct ib_ipset4_compiled_t
+{
+    /** Cells indexed by the first 16 bits of the address. */
+    const uint32_t *tbl16;
+    /** Groups of 256 cells indexed by the third or fourth byte. */
+    const uint32_t *tbl8;
+    /** Index of most general containing network of each positive entry. */
+    const uint32_t *general;
+};
+
+/**
+ * Poptrie node.
+ *
+ * Slot @c c of a node is a child if bit @c c of @c vector is set.  The child
+ * is then node `base1 + popcount(vector bits below c)`.  Otherwise the slot
+ * is a leaf; consecutive leaf slots with the same value share a leaf and a
+ * set bit in @c leafvec marks the first slot of each.  The leaf is then
+ * `base0 + popcount(leafvec bits up to c) - 1`.
+ */
+typedef struct ib_ipset6_node_t ib_ipset6_node_t;
+struct ib_ipset6_node_t
+{
+    uint64_t vector[4];
+    uint64_t leafvec[4];
+    uint32_t base0;
+    uint32_t base1;
+};
+
+struct ib_ipset6_compiled_t
+{
+    /** Nodes; node 0 is the root. */
+    const ib_ipset6_node_t *nodes;
+    /** Leaf cells. */
+    const uint32_t         *leaves;
+    /** Index of most general containing network of each positive entry. */
+    const uint32_t         *general;
+};
+
+/**
+ * Paint a cell with an entry reference.
+ *
+ * @param[in,out] cell Cell to paint.
+ * @param[in]     ref  Entry index, or'd with IB_IPSET_REF_NEGATIVE if
+ *                     negative.
+ */
+static inline
+void ib_ipset_paint(uint32_t *cell, uint32_t ref)
+{
+    if ((ref & IB_IPSET_REF_NEGATIVE) != 0) {
+        *cell |= IB_IPSET_CELL_NEGATIVE;
+    }
+    else {
+        *cell = (*cell & IB_IPSET_CELL_NEGATIVE) | (ref + 1);
+    }
+}
+
+/**
+ * Final value of a cell: 0 if covered by a negative network.
+ *
+ * @param[in] cell Cell.
+ * @return Value of @a cell.
+ */
+static inline
+uint32_t ib_ipset_finish(uint32_t cell)
+{
+    return (cell & IB_IPSET_CELL_NEGATIVE) != 0 ? 0 : cell;
+}
+
+/**
+ * Number of bits set in @a vector strictly below @a c.
+ *
+ * @param[in] vector 256 bit vector.
+ * @param[in] c      Bit index.
+ * @return Number of bits set in @a vector below @a c.
+ */
+static inline
+uint32_t ib_ipset6_popcount_below(const uint64_t vector[4], unsigned c)
+{
+    uint32_t n = 0;
+    unsigned w = c >> 6;
+
+    for (unsigned i = 0; i < w; ++i) {
+        n += (uint32_t)__builtin_popcountll(vector[i]);
+    }
+    return n +
+        (uint32_t)__builtin_popcountll(
+            vector[w] & ((UINT64_C(1) << (c & 63)) - 1)
+        );
+}
+
+/**
+ * Number of bits set in @a vector up to and including @a c.
+ *
+ * @param[in] vector 256 bit vector.
+ * @param[in] c      Bit index.
+ * @return Number of bits set in @a vector up to @a c.
+ */
+static inline
+uint32_t ib_ipset6_popcount_upto(const uint64_t vector[4], unsigned c)
+{
+    return
+        ib_ipset6_popcount_below(vector, c) +
+        (uint32_t)((vector[c >> 6] >> (c & 63)) & 1);
+}
+
+/**
+ * Byte @a depth of @a ip, most significant first.
+ *
+ * @param[in] ip    Address.
+ * @param[in] depth Byte index.
+ * @return Byte.
+ */
+static inline
+unsigned ib_ipset6_byte(const ib_ip6_t *ip, unsigned depth)
+{
+    return (ip->ip[depth >> 2] >> (24 - 8 * (depth & 3))) & 0xff;
+}
+
+/**
+ * Compute index of most general containing network of each positive entry.
+ *
+ * Positive entries are sorted, i.e., in depth first order of the prefix
+ * tree, so a stack of the current chain of prefixes suffices.  Equal
+ * networks are pushed once, bounding the stack by the address bits.
+ *
+ * @param[in]  positive     Sorted positive entries.
+ * @param[in]  num_positive Number of entries in @a positive.
+ * @param[out] general      Output array of @a num_positive indices.
+ */
+static
+void ib_ipset4_compute_general(
+    const ib_ipset4_entry_t *positive,
+    size_t                   num_positive,
+    uint32_t                *general
+)
+{
+    uint32_t stack[33];
+    size_t   depth = 0;
+
+    for (size_t i = 0; i < num_positive; ++i) {
+        const ib_ip4_network_t *net = &positive[i].network;
+
+        while (
+            depth > 0 &&
+            ! ib_ipset4_is_prefix(positive[stack[depth - 1]].network, *net)
+        ) {
+            --depth;
+        }
+        general[i] = depth > 0 ? stack[0] : (uint32_t)i;
+        if (
+            depth == 0 ||
+            ib_ipset4_compare_strict(
+                &positive[stack[depth - 1]].network, net
+            ) != 0
+        ) {
+            assert(depth < sizeof(stack) / sizeof(*stack));
+            stack[depth++] = (uint32_t)i;
+        }
+    }
+}
+
+/**
+ * As ib_ipset4_compute_general() but for v6 entries.
+ *
+ * @param[in]  positive     Sorted positive entries.
+ * @param[in]  num_positive Number of entries in @a positive.
+ * @param[out] general      Output array of @a num_positive indices.
+ */
+static
+void ib_ipset6_compute_general(
+    const ib_ipset6_entry_t *positive,
+    size_t                   num_positive,
+    uint32_t                *general
+)
+{
+    uint32_t stack[129];
+    size_t   depth = 0;
+
+    for (size_t i = 0; i < num_positive; ++i) {
+        const ib_ip6_network_t *net = &positive[i].network;
+
+        while (
+            depth > 0 &&
+            ! ib_ipset6_is_prefix(positive[stack[depth - 1]].network, *net)
+        ) {
+            --depth;
+        }
+        general[i] = depth > 0 ? stack[0] : (uint32_t)i;
+        if (
+            depth == 0 ||
+            ib_ipset6_compare_strict(
+                &positive[stack[depth - 1]].network, net
+            ) != 0
+        ) {
+            assert(depth < sizeof(stack) / sizeof(*stack));
+            stack[depth++] = (uint32_t)i;
+        }
+    }
+}
+
+/**
+ * Append a tbl8 group whose cells are all @a value.
+ *
+ * @param[in,out] tbl8     Groups; grown with realloc.
+ * @param[in,out] num_tbl8 Number of groups.
+ * @param[in,out] cap_tbl8 Capacity of @a tbl8 in groups; doubled when full.
+ * @param[in]     value    Value of the new cells.
+ * @return Cell referring to the new group or 0 on allocation failure.
+ */
+static
+uint32_t ib_ipset4_add_group(
+    uint32_t **tbl8,
+    size_t    *num_tbl8,
+    size_t    *cap_tbl8,
+    uint32_t   value
+)
+{
+    uint32_t *group;
+
+    if (*num_tbl8 >= IB_IPSET_CELL_VALUE) {
+        return 0;
+    }
+    if (*num_tbl8 == *cap_tbl8) {
+        size_t    cap = *cap_tbl8 * 2 + 16;
+        uint32_t *new_tbl8;
+
+        new_tbl8 = realloc(
+            *tbl8, sizeof(**tbl8) * IB_IPSET4_TBL8_SIZE * cap
+        );
+        if (new_tbl8 == NULL) {
+            return 0;
+        }
+        *tbl8     = new_tbl8;
+        *cap_tbl8 = cap;
+    }
+    group = &(*tbl8)[*num_tbl8 * IB_IPSET4_TBL8_SIZE];
+    for (size_t j = 0; j < IB_IPSET4_TBL8_SIZE; ++j) {
+        group[j] = value;
+    }
+
+    return IB_IPSET_CELL_GROUP | (uint32_t)(*num_tbl8)++;
+}
+
+/**
+ * Build the DIR-16-8-8 table of a v4 set.
+ *
+ * @param[in] set Set with sorted canonical entries.
+ * @param[in] mm  Memory manager to allocate from.
+ * @return Compiled form or NULL on allocation failure.
+ */
+static
+const ib_ipset4_compiled_t *ib_ipset4_compile(
+    const ib_ipset4_t *set,
+    ib_mm_t            mm
+)
+{
+    ib_ipset4_compiled_t *compiled;
+    uint32_t             *tbl16;
+    uint32_t             *tbl8 = NULL;
+    uint32_t             *general;
+    uint32_t             *order;
+    size_t                num_tbl8 = 0;
+    size_t                cap_tbl8 = 0;
+    size_t                num_refs = set->num_negative + set->num_positive;
+    size_t                by_size[34] = {0};
+
+    compiled = ib_mm_alloc(mm, sizeof(*compiled));
+    tbl16    = ib_mm_calloc(mm, IB_IPSET4_TBL16_SIZE, sizeof(*tbl16));
+    general  = ib_mm_alloc(mm, sizeof(*general) * (set->num_positive + 1));
+    order    = malloc(sizeof(*order) * (num_refs + 1));
+    if (compiled == NULL || tbl16 == NULL || general == NULL || order == NULL) {
+        free(order);
+        return NULL;
+    }
+
+    /* Counting sort of entries by size; stable, so that the last of equal
+     * positive networks wins. */
+    for (size_t i = 0; i < num_refs; ++i) {
+        const ib_ipset4_entry_t *entry = i < set->num_negative ?
+            &set->negative[i] : &set->positive[i - set->num_negative];
+        size_t size = entry->network.size > 32 ? 32 : entry->network.size;
+        ++by_size[size + 1];
+    }
+    for (size_t i = 1; i < sizeof(by_size) / sizeof(*by_size); ++i) {
+        by_size[i] += by_size[i - 1];
+    }
+    for (size_t i = 0; i < num_refs; ++i) {
+        const ib_ipset4_entry_t *entry;
+        uint32_t ref;
+        if (i < set->num_negative) {
+            entry = &set->negative[i];
+            ref   = (uint32_t)i | IB_IPSET_REF_NEGATIVE;
+        }
+        else {
+            entry = &set->positive[i - set->num_negative];
+            ref   = (uint32_t)(i - set->num_negative);
+        }
+        size_t size = entry->network.size > 32 ? 32 : entry->network.size;
+        order[by_size[size]++] = ref;
+    }
+
+    /* Shorter networks are painted first, so a level only has groups once
+     * all networks ending at or above it are painted. */
+    for (size_t i = 0; i < num_refs; ++i) {
+        uint32_t ref = order[i];
+        const ib_ip4_network_t *net =
+            (ref & IB_IPSET_REF_NEGATIVE) != 0 ?
+            &set->negative[ref & ~IB_IPSET_REF_NEGATIVE].network :
+            &set->positive[ref].network;
+        size_t    size = net->size > 32 ? 32 : net->size;
+        uint32_t *cells;
+        size_t    first;
+        size_t    span;
+
+        if (size <= 16) {
+            cells = tbl16;
+            first = net->ip >> 16;
+            span  = (size_t)1 << (16 - size);
+        }
+        else {
+            uint32_t *cell = &tbl16[net->ip >> 16];
+            size_t    group;
+
+            if ((*cell & IB_IPSET_CELL_GROUP) == 0) {
+                *cell = ib_ipset4_add_group(
+                    &tbl8, &num_tbl8, &cap_tbl8, *cell
+                );
+                if (*cell == 0) {
+                    goto failure;
+                }
+            }
+            group = (size_t)(*cell & ~IB_IPSET_CELL_GROUP) *
+                IB_IPSET4_TBL8_SIZE;
+
+            if (size <= 24) {
+                first = (net->ip >> 8) & 0xff;
+                span  = (size_t)1 << (24 - size);
+            }
+            else {
+                size_t   mid   = group + ((net->ip >> 8) & 0xff);
+                uint32_t value = tbl8[mid];
+
+                if ((value & IB_IPSET_CELL_GROUP) == 0) {
+                    value = ib_ipset4_add_group(
+                        &tbl8, &num_tbl8, &cap_tbl8, value
+                    );
+                    if (value == 0) {
+                        goto failure;
+                    }
+                    tbl8[mid] = value;
+                }
+                group = (size_t)(value & ~IB_IPSET_CELL_GROUP) *
+                    IB_IPSET4_TBL8_SIZE;
+                first = net->ip & 0xff;
+                span  = (size_t)1 << (32 - size);
+            }
+            cells = &tbl8[group];
+        }
+
+        for (size_t j = first; j < first + span; ++j) {
+            ib_ipset_paint(&cells[j], ref);
+        }
+    }
+    free(order);
+    order = NULL;
+
+    for (size_t j = 0; j < IB_IPSET4_TBL16_SIZE; ++j) {
+        if ((tbl16[j] & IB_IPSET_CELL_GROUP) == 0) {
+            tbl16[j] = ib_ipset_finish(tbl16[j]);
+        }
+    }
+    for (size_t j = 0; j < num_tbl8 * IB_IPSET4_TBL8_SIZE; ++j) {
+        if ((tbl8[j] & IB_IPSET_CELL_GROUP) == 0) {
+            tbl8[j] = ib_ipset_finish(tbl8[j]);
+        }
+    }
+
+    compiled->tbl8 = NULL;
+    if (num_tbl8 > 0) {
+        compiled->tbl8 = ib_mm_memdup(
+            mm, tbl8, sizeof(*tbl8) * IB_IPSET4_TBL8_SIZE * num_tbl8
+        );
+        free(tbl8);
+        if (compiled->tbl8 == NULL) {
+            return NULL;
+        }
+    }
+
+    ib_ipset4_compute_general(set->positive, set->num_positive, general);
+    compiled->tbl16   = tbl16;
+    compiled->general = general;
+
+    return compiled;
+
+failure:
+    free(tbl8);
+    free(order);
+    return NULL;
+}
+
+/**
+ * Temporary state of a v6 trie construction.
+ */
+typedef struct ib_ipset6_builder_t ib_ipset6_builder_t;
+struct ib_ipset6_builder_t
+{
+    const ib_ipset6_t *set;        /**< Set being compiled. */
+    uint32_t          *refs;       /**< Merged sorted entry references. */
+    ib_ipset6_node_t  *nodes;      /**< Nodes; grown with realloc. */
+    size_t             num_nodes;  /**< Number of nodes. */
+    size_t             cap_nodes;  /**< Capacity of @c nodes. */
+    uint32_t          *leaves;     /**< Leaves; grown with realloc. */
+    size_t             num_leaves; /**< Number of leaves. */
+    size_t             cap_leaves; /**< Capacity of @c leaves. */
+};
+
+/**
+ * Network referred to by @a ref.
+ *
+ * @param[in] set Set.
+ * @param[in] ref Entry reference.
+ * @return Network.
+ */
+static inline
+const ib_ip6_network_t *ib_ipset6_ref_network(
+    const ib_ipset6_t *set,
+    uint32_t           ref
+)
+{
+    return (ref & IB_IPSET_REF_NEGATIVE) != 0 ?
+        &set->negative[ref & ~IB_IPSET_REF_NEGATIVE].network :
+        &set->positive[ref].network;
+}
+
+/**
+ * Size of network referred to by @a ref, clamped to 128.
+ *
+ * @param[in] set Set.
+ * @param[in] ref Entry reference.
+ * @return Size.
+ */
+static inline
+size_t ib_ipset6_ref_size(
+    const ib_ipset6_t *set,
+    uint32_t           ref
+)
+{
+    size_t size = ib_ipset6_ref_network(set, ref)->size;
+    return size > 128 ? 128 : size;
+}
+
+/**
+ * Build trie node @a node_index.
+ *
+ * All references in [@a begin, @a end) are to networks longer than
+ * `8 * depth` bits that share the prefix of the node.  The range is reordered
+ * and compacted as part of construction.
+ *
+ * @param[in] builder    Builder.
+ * @param[in] node_index Index of node to build; already allocated.
+ * @param[in] depth      Depth of node.
+ * @param[in] inherited  Cell value of the prefix of the node.
+ * @param[in] begin      First reference.
+ * @param[in] end        End of references.
+ * @return
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ */
+static
+ib_status_t ib_ipset6_build_node(
+    ib_ipset6_builder_t *builder,
+    size_t               node_index,
+    unsigned             depth,
+    uint32_t             inherited,
+    size_t               begin,
+    size_t               end
+)
+{
+    const ib_ipset6_t *set = builder->set;
+    uint32_t          *refs = builder->refs;
+    uint32_t           slots[256];
+    ib_ipset6_node_t   node;
+    size_t             level_end = 8 * (depth + 1);
+    size_t             deep_end = begin;
+    size_t             num_children = 0;
+    bool               first_leaf = true;
+    uint32_t           previous = 0;
+
+    memset(&node, 0, sizeof(node));
+    for (size_t c = 0; c < 256; ++c) {
+        slots[c] = inherited;
+    }
+
+    /* Paint networks ending in this level, shortest first. */
+    for (size_t size = 8 * depth + 1; size <= level_end; ++size) {
+        for (size_t i = begin; i < end; ++i) {
+            if (ib_ipset6_ref_size(set, refs[i]) == size) {
+                const ib_ip6_network_t *net =
+                    ib_ipset6_ref_network(set, refs[i]);
+                unsigned first = ib_ipset6_byte(&net->ip, depth);
+                unsigned span  = 1U << (level_end - size);
+                for (unsigned c = first; c < first + span; ++c) {
+                    ib_ipset_paint(&slots[c], refs[i]);
+                }
+            }
+        }
+    }
+
+    /* Compact longer networks; they are grouped by byte as refs are
+     * sorted. */
+    for (size_t i = begin; i < end; ++i) {
+        if (ib_ipset6_ref_size(set, refs[i]) > level_end) {
+            unsigned c =
+                ib_ipset6_byte(&ib_ipset6_ref_network(set, refs[i])->ip, depth);
+            if ((node.vector[c >> 6] & (UINT64_C(1) << (c & 63))) == 0) {
+                node.vector[c >> 6] |= UINT64_C(1) << (c & 63);
+                ++num_children;
+            }
+            refs[deep_end++] = refs[i];
+        }
+    }
+
+    /* Leaves. */
+    node.base0 = (uint32_t)builder->num_leaves;
+    for (unsigned c = 0; c < 256; ++c) {
+        if ((node.vector[c >> 6] & (UINT64_C(1) << (c & 63))) != 0) {
+            continue;
+        }
+        uint32_t value = ib_ipset_finish(slots[c]);
+        if (first_leaf || value != previous) {
+            if (builder->num_leaves == builder->cap_leaves) {
+                size_t    cap = builder->cap_leaves * 2 + 256;
+                uint32_t *leaves =
+                    realloc(builder->leaves, sizeof(*leaves) * cap);
+                if (leaves == NULL) {
+                    return IB_EALLOC;
+                }
+                builder->leaves     = leaves;
+                builder->cap_leaves = cap;
+            }
+            builder->leaves[builder->num_leaves++] = value;
+            node.leafvec[c >> 6] |= UINT64_C(1) << (c & 63);
+            first_leaf = false;
+            previous = value;
+        }
+    }
+
+    /* Children. */
+    node.base1 = (uint32_t)builder->num_nodes;
+    if (builder->num_nodes + num_children > builder->cap_nodes) {
+        size_t cap = builder->cap_nodes * 2 + num_children;
+        ib_ipset6_node_t *nodes =
+            realloc(builder->nodes, sizeof(*nodes) * cap);
+        if (nodes == NULL) {
+            return IB_EALLOC;
+        }
+        builder->nodes     = nodes;
+        builder->cap_nodes = cap;
+    }
+    builder->num_nodes += num_children;
+    builder->nodes[node_index] = node;
+
+    for (size_t i = begin, child = node.base1; i < deep_end; ++child) {
+        unsigned c =
+            ib_ipset6_byte(&ib_ipset6_ref_network(set, refs[i])->ip, depth);
+        size_t group_end = i + 1;
+        while (
+            group_end < deep_end &&
+            ib_ipset6_byte(
+                &ib_ipset6_ref_network(set, refs[group_end])->ip, depth
+            ) == c
+        ) {
+            ++group_end;
+        }
+
+        ib_status_t rc = ib_ipset6_build_node(
+            builder, child, depth + 1, slots[c], i, group_end
+        );
+        if (rc != IB_OK) {
+            return rc;
+        }
+        i = group_end;
+    }
+
+    return IB_OK;
+}
+
+/**
+ * Build the poptrie of a v6 set.
+ *
+ * @param[in] set Set with sorted canonical entries.
+ * @param[in] mm  Memory manager to allocate from.
+ * @return Compiled form or NULL on allocation failure.
+ */
+static
+const ib_ipset6_compiled_t *ib_ipset6_compile(
+    const ib_ipset6_t *set,
+    ib_mm_t            mm
+)
+{
+    ib_ipset6_compiled_t *compiled;
+    uint32_t             *general;
+    ib_ipset6_builder_t   builder;
+    size_t                num_refs = 0;
+    size_t                n = 0;
+    size_t                p = 0;
+    uint32_t              root = 0;
+    ib_status_t           rc;
+
+    memset(&builder, 0, sizeof(builder));
+    builder.set = set;
+
+    compiled = ib_mm_alloc(mm, sizeof(*compiled));
+    general  = ib_mm_alloc(mm, sizeof(*general) * (set->num_positive + 1));
+    builder.refs =
+        malloc(sizeof(*builder.refs) *
+               (set->num_negative + set->num_positive + 1));
+    builder.nodes = malloc(sizeof(*builder.nodes));
+    if (
+        compiled == NULL || general == NULL ||
+        builder.refs == NULL || builder.nodes == NULL
+    ) {
+        free(builder.refs);
+        free(builder.nodes);
+        return NULL;
+    }
+    builder.num_nodes = 1;
+    builder.cap_nodes = 1;
+
+    /* Merge negative and positive entries in network order; /0 networks
+     * apply to the root as a whole. */
+    while (n < set->num_negative || p < set->num_positive) {
+        uint32_t ref;
+        if (
+            p == set->num_positive ||
+            (
+                n < set->num_negative &&
+                ib_ipset6_compare_strict(
+                    &set->negative[n].network, &set->positive[p].network
+                ) <= 0
+            )
+        ) {
+            ref = (uint32_t)n++ | IB_IPSET_REF_NEGATIVE;
+        }
+        else {
+            ref = (uint32_t)p++;
+        }
+        if (ib_ipset6_ref_size(set, ref) == 0) {
+            ib_ipset_paint(&root, ref);
+        }
+        else {
+            builder.refs[num_refs++] = ref;
+        }
+    }
+
+    rc = ib_ipset6_build_node(&builder, 0, 0, root, 0, num_refs);
+    free(builder.refs);
+    if (rc == IB_OK) {
+        compiled->nodes = ib_mm_memdup(
+            mm, builder.nodes, sizeof(*builder.nodes) * builder.num_nodes
+        );
+        compiled->leaves = ib_mm_memdup(
+            mm, builder.leaves, sizeof(*builder.leaves) * builder.num_leaves
+        );
+    }
+    free(builder.nodes);
+    free(builder.leaves);
+    if (rc != IB_OK || compiled->nodes == NULL || compiled->leaves == NULL) {
+        return NULL;
+    }
+
+    ib_ipset6_compute_general(set->positive, set->num_positive, general);
+    compiled->general = general;
+
+    return compiled;
+}
+
+/**
+ * Look up @a ip in the compiled form of a v4 set.
+ *
+ * @param[in] compiled Compiled form.
+ * @param[in] ip       Address.
+ * @return Cell value of @a ip.
+ */
+static inline
+uint32_t ib_ipset4_compiled_lookup(
+    const ib_ipset4_compiled_t *compiled,
+    ib_ip4_t                    ip
+)
+{
+    uint32_t value = compiled->tbl16[ip >> 16];
+
+    if ((value & IB_IPSET_CELL_GROUP) != 0) {
+        value = compiled->tbl8[
+            (size_t)(value & ~IB_IPSET_CELL_GROUP) * IB_IPSET4_TBL8_SIZE +
+            ((ip >> 8) & 0xff)
+        ];
+        if ((value & IB_IPSET_CELL_GROUP) != 0) {
+            value = compiled->tbl8[
+                (size_t)(value & ~IB_IPSET_CELL_GROUP) * IB_IPSET4_TBL8_SIZE +
+                (ip & 0xff)
+            ];
+        }
+    }
+    return value;
+}
+
+/**
+ * Look up @a ip in the compiled form of a v6 set.
+ *
+ * @param[in] compiled Compiled form.
+ * @param[in] ip       Address.
+ * @return Cell value of @a ip.
+ */
+static inline
+uint32_t ib_ipset6_compiled_lookup(
+    const ib_ipset6_compiled_t *compiled,
+    const ib_ip6_t             *ip
+)
+{
+    const ib_ipset6_node_t *node = compiled->nodes;
+
+    for (unsigned depth = 0; depth < IB_IPSET6_LEVELS; ++depth) {
+        unsigned c = ib_ipset6_byte(ip, depth);
+
+        if ((node->vector[c >> 6] & (UINT64_C(1) << (c & 63))) != 0) {
+            node = &compiled->nodes[
+                node->base1 + ib_ipset6_popcount_below(node->vector, c)
+            ];
+            continue;
+        }
+        return compiled->leaves[
+            node->base0 + ib_ipset6_popcount_upto(node->leafvec, c) - 1
+        ];
+    }
+
+    /* Unreachable: no network is longer than 128 bits. */
+    assert(false);
+    return 0;
+}
+
+/**
+ * Fill query outputs from a compiled cell value.
+ *
+ * @param[in]  value              Cell value.
+ * @param[in]  positive           Positive entries.
+ * @param[in]  general            General index array.
+ * @param[in]  entry_size         Size of an entry.
+ * @param[out] out_entry          As ib_ipset_query().
+ * @param[out] out_specific_entry As ib_ipset_query().
+ * @param[out] out_general_entry  As ib_ipset_query().
+ * @return
+ * - IB_OK if @a value refers to an entry.
+ * - IB_ENOENT otherwise.
+ */
+static
+ib_status_t ib_ipset_compiled_result(
+    uint32_t        value,
+    const void     *positive,
+    const uint32_t *general,
+    size_t          entry_size,
+    const void     *out_entry,
+    const void     *out_specific_entry,
+    const void     *out_general_entry
+)
+{
+    const char *specific;
+
+    if (out_entry != NULL) {
+        *(const void **)out_entry = NULL;
+    }
+    if (out_specific_entry != NULL) {
+        *(const void **)out_specific_entry = NULL;
+    }
+    if (out_general_entry != NULL) {
+        *(const void **)out_general_entry = NULL;
+    }
+
+    if (value == 0) {
+        return IB_ENOENT;
+    }
+
+    specific = (const char *)positive + entry_size * (value - 1);
+    if (out_entry != NULL) {
+        *(const void **)out_entry = specific;
+    }
+    if (out_specific_entry != NULL) {
+        *(const void **)out_specific_entry = specific;
+    }
+    if (out_general_entry != NULL) {
+        *(const void **)out_general_entry =
+            (const char *)positive + entry_size * general[value - 1];
+    }
+
+    return IB_OK;
+}
+
+/**@}*/
+
 /* Public API */
 
 ib_status_t ib_ipset4_query(
@@ -511,6 +1350,18 @@ ib_status_t ib_ipset4_query(
         return IB_EINVAL;
     }
 
+    if (set->compiled != NULL) {
+        return ib_ipset_compiled_result(
+            ib_ipset4_compiled_lookup(set->compiled, ip),
+            set->positive,
+            set->compiled->general,
+            sizeof(ib_ipset4_entry_t),
+            out_entry,
+            out_specific_entry,
+            out_general_entry
+        );
+    }
+
     return ib_ipset_query(
         &net,
         set->negative,
@@ -539,6 +1390,18 @@ ib_status_t ib_ipset6_query(
         return IB_EINVAL;
     }
 
+    if (set->compiled != NULL) {
+        return ib_ipset_compiled_result(
+            ib_ipset6_compiled_lookup(set->compiled, &ip),
+            set->positive,
+            set->compiled->general,
+            sizeof(ib_ipset6_entry_t),
+            out_entry,
+            out_specific_entry,
+            out_general_entry
+        );
+    }
+
     return ib_ipset_query(
         &net,
         set->negative,
@@ -573,6 +1436,7 @@ ib_status_t ib_ipset4_init(
     set->num_negative = num_negative;
     set->positive     = positive;
     set->num_positive = num_positive;
+    set->compiled     = NULL;
 
     for (size_t i = 0; i < set->num_negative; ++i) {
         set->negative[i].network.ip =
@@ -620,6 +1484,7 @@ ib_status_t ib_ipset6_init(
     set->num_negative = num_negative;
     set->positive     = positive;
     set->num_positive = num_positive;
+    set->compiled     = NULL;
 
     for (size_t i = 0; i < set->num_negative; ++i) {
         set->negative[i].network.ip =
@@ -646,3 +1511,65 @@ ib_status_t ib_ipset6_init(
 
     return IB_OK;
 }
+
+ib_status_t ib_ipset4_init_compiled(
+    ib_ipset4_t       *set,
+    ib_ipset4_entry_t *negative,
+    size_t             num_negative,
+    ib_ipset4_entry_t *positive,
+    size_t             num_positive,
+    ib_mm_t            mm
+)
+{
+    ib_status_t rc;
+
+    if (
+        num_negative > IB_IPSET_COMPILED_MAX ||
+        num_positive > IB_IPSET_COMPILED_MAX
+    ) {
+        return IB_EINVAL;
+    }
+
+    rc = ib_ipset4_init(set, negative, num_negative, positive, num_positive);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    set->compiled = ib_ipset4_compile(set, mm);
+    if (set->compiled == NULL) {
+        return IB_EALLOC;
+    }
+
+    return IB_OK;
+}
+
+ib_status_t ib_ipset6_init_compiled(
+    ib_ipset6_t       *set,
+    ib_ipset6_entry_t *negative,
+    size_t             num_negative,
+    ib_ipset6_entry_t *positive,
+    size_t             num_positive,
+    ib_mm_t            mm
+)
+{
+    ib_status_t rc;
+
+    if (
+        num_negative > IB_IPSET_COMPILED_MAX ||
+        num_positive > IB_IPSET_COMPILED_MAX
+    ) {
+        return IB_EINVAL;
+    }
+
+    rc = ib_ipset6_init(set, negative, num_negative, positive, num_positive);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    set->compiled = ib_ipset6_compile(set, mm);
+    if (set->compiled == NULL) {
+        return IB_EALLOC;
+    }
+
+    return IB_OK;
+}
@@ -0,0 +1,795 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- Streaming JSON Writer Implementation
+ *
+ * The writer keeps a stack of open maps and arrays.  Each value first
+ * writes the separator its position needs, so nothing is ever rewritten.
+ */
+
+#include "ironbee_config_auto.h"
+
+#include <ironbee/json_writer.h>
+
+#include "string_scan_private.h"
+
+#include <ironbee/bytestr.h>
+#include <ironbee/list.h>
+#include <ironbee/type_convert.h>
+
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Deepest nesting of maps and arrays. */
+#define JSON_WRITER_MAX_DEPTH 64
+
+/** Initial buffer size. */
+#define JSON_WRITER_INITIAL_SIZE 1024
+
+/**
+ * Largest buffer a thread's writer keeps when released.
+ *
+ * An unusually large document should not pin its memory to the thread.
+ */
+#define JSON_WRITER_KEEP_SIZE (64 * 1024)
+
+/** Indent per level of pretty output. */
+#define JSON_WRITER_INDENT 4
+
+/** Kind of an open value. */
+enum json_frame_type_t {
+    JSON_FRAME_TOP,   /**< The document; holds one value. */
+    JSON_FRAME_MAP,   /**< A map. */
+    JSON_FRAME_ARRAY  /**< An array. */
+};
+
+/** An open value. */
+typedef struct {
+    /** Kind; a json_frame_type_t. */
+    uint8_t type;
+    /** True if a key was written and its value is expected. */
+    bool    key;
+    /** Number of elements or keys so far. */
+    size_t  count;
+} json_frame_t;
+
+struct ib_json_writer_t
+{
+    /** Output; always NUL terminated if not NULL. */
+    char         *buf;
+    /** Length of @ref buf. */
+    size_t        len;
+    /** Allocated size of @ref buf. */
+    size_t        size;
+    /** First error or IB_OK. */
+    ib_status_t   status;
+    /** If true, indent output. */
+    bool          pretty;
+    /** True if this is the thread's writer. */
+    bool          thread;
+    /** Depth of the innermost open value; 0 is the document. */
+    size_t        depth;
+    /** Open values. */
+    json_frame_t  frames[JSON_WRITER_MAX_DEPTH + 1];
+};
+
+/** Key of the calling thread's writer. */
+static pthread_key_t  s_thread_key;
+/** Initialization of @ref s_thread_key. */
+static pthread_once_t s_thread_once = PTHREAD_ONCE_INIT;
+/** True iff @ref s_thread_key was created. */
+static bool           s_thread_key_valid = false;
+
+/**
+ * Marker stored under @ref s_thread_key while the thread's writer is
+ * acquired.  Otherwise the key holds the writer itself or NULL.
+ */
+static char s_thread_busy;
+
+/**
+ * Destroy a thread's writer at thread exit.
+ */
+static void json_writer_thread_destroy(void *data)
+{
+    if (data != &s_thread_busy) {
+        ib_json_writer_destroy((ib_json_writer_t *)data);
+    }
+}
+
+/**
+ * Create @ref s_thread_key.
+ */
+static void json_writer_thread_init(void)
+{
+    s_thread_key_valid =
+        pthread_key_create(&s_thread_key, &json_writer_thread_destroy) == 0;
+}
+
+/**
+ * Make room for @a n more bytes and the NUL.
+ *
+ * @returns True on success; otherwise sets IB_EALLOC.
+ */
+static bool json_reserve(ib_json_writer_t *writer, size_t n)
+{
+    size_t need = writer->len + n + 1;
+    size_t size;
+    char  *buf;
+
+    if (need <= writer->size) {
+        return true;
+    }
+
+    size = (writer->size == 0) ? JSON_WRITER_INITIAL_SIZE : writer->size;
+    while (size < need) {
+        size *= 2;
+    }
+
+    buf = realloc(writer->buf, size);
+    if (buf == NULL) {
+        writer->status = IB_EALLOC;
+        return false;
+    }
+    writer->buf  = buf;
+    writer->size = size;
+
+    return true;
+}
+
+/**
+ * Append @a n bytes from @a s.  Room must be reserved.
+ */
+static inline void json_put(ib_json_writer_t *writer, const char *s, size_t n)
+{
+    memcpy(writer->buf + writer->len, s, n);
+    writer->len += n;
+}
+
+/**
+ * Append a newline and indentation to depth @a depth.  Room must be
+ * reserved.
+ */
+static void json_put_newline(ib_json_writer_t *writer, size_t depth)
+{
+    writer->buf[writer->len++] = '\n';
+    memset(writer->buf + writer->len, ' ', depth * JSON_WRITER_INDENT);
+    writer->len += depth * JSON_WRITER_INDENT;
+}
+
+/**
+ * Write the comma and, for pretty output, line break before an element of
+ * the innermost map or array.
+ *
+ * @returns True on success; otherwise sets IB_EALLOC.
+ */
+static bool json_put_separator(ib_json_writer_t *writer, json_frame_t *frame)
+{
+    size_t n = 1;
+
+    if (writer->pretty) {
+        n += 1 + writer->depth * JSON_WRITER_INDENT;
+    }
+    if (! json_reserve(writer, n)) {
+        return false;
+    }
+    if (frame->count > 0) {
+        writer->buf[writer->len++] = ',';
+    }
+    if (writer->pretty) {
+        json_put_newline(writer, writer->depth);
+    }
+    ++frame->count;
+
+    return true;
+}
+
+/**
+ * Start a value or key and write what separates it from the previous.
+ *
+ * @param[in]  writer    Writer.
+ * @param[in]  is_string True if the value is a string and may be a key.
+ * @param[out] is_key    True if the string is a map key.  May be NULL if
+ *                       @a is_string is false.
+ *
+ * @returns True on success; otherwise sets the status.
+ */
+static bool json_begin(ib_json_writer_t *writer, bool is_string, bool *is_key)
+{
+    json_frame_t *frame = &(writer->frames[writer->depth]);
+    bool          key   = false;
+
+    if (writer->status != IB_OK) {
+        return false;
+    }
+
+    switch (frame->type) {
+    case JSON_FRAME_TOP:
+        if (frame->count > 0) {
+            writer->status = IB_EINVAL;
+            return false;
+        }
+        ++frame->count;
+        break;
+
+    case JSON_FRAME_MAP:
+        if (frame->key) {
+            /* Value of a key. */
+            if (! json_reserve(writer, 2)) {
+                return false;
+            }
+            json_put(writer, ": ", writer->pretty ? 2 : 1);
+            frame->key = false;
+        }
+        else if (! is_string) {
+            writer->status = IB_EINVAL;
+            return false;
+        }
+        else {
+            if (! json_put_separator(writer, frame)) {
+                return false;
+            }
+            frame->key = true;
+            key = true;
+        }
+        break;
+
+    case JSON_FRAME_ARRAY:
+        if (! json_put_separator(writer, frame)) {
+            return false;
+        }
+        break;
+    }
+
+    if (is_key != NULL) {
+        *is_key = key;
+    }
+
+    return true;
+}
+
+/**
+ * Finish a value; at the top level of pretty output, end the line.
+ */
+static ib_status_t json_end(ib_json_writer_t *writer)
+{
+    if (writer->depth == 0 && writer->pretty) {
+        if (! json_reserve(writer, 1)) {
+            return writer->status;
+        }
+        writer->buf[writer->len++] = '\n';
+    }
+    writer->buf[writer->len] = '\0';
+
+    return IB_OK;
+}
+
+/**
+ * Write a value that is a token of @a n bytes at @a s.
+ */
+static ib_status_t json_token(
+    ib_json_writer_t *writer,
+    const char       *s,
+    size_t            n
+)
+{
+    if (! json_begin(writer, false, NULL) || ! json_reserve(writer, n)) {
+        return writer->status;
+    }
+    json_put(writer, s, n);
+
+    return json_end(writer);
+}
+
+/**
+ * Open a map or array.
+ */
+static ib_status_t json_open(ib_json_writer_t *writer, uint8_t type)
+{
+    json_frame_t *frame;
+
+    if (writer->status == IB_OK && writer->depth == JSON_WRITER_MAX_DEPTH) {
+        writer->status = IB_EINVAL;
+    }
+    if (! json_begin(writer, false, NULL) || ! json_reserve(writer, 1)) {
+        return writer->status;
+    }
+    writer->buf[writer->len++] = (type == JSON_FRAME_MAP) ? '{' : '[';
+    writer->buf[writer->len]   = '\0';
+
+    frame = &(writer->frames[++writer->depth]);
+    frame->type  = type;
+    frame->key   = false;
+    frame->count = 0;
+
+    return IB_OK;
+}
+
+/**
+ * Close the innermost map or array, which must be of @a type.
+ */
+static ib_status_t json_close(ib_json_writer_t *writer, uint8_t type)
+{
+    json_frame_t *frame = &(writer->frames[writer->depth]);
+
+    if (writer->status != IB_OK) {
+        return writer->status;
+    }
+    if (frame->type != type || frame->key) {
+        writer->status = IB_EINVAL;
+        return writer->status;
+    }
+    if (! json_reserve(
+            writer,
+            1 + (writer->pretty ? 1 + writer->depth * JSON_WRITER_INDENT : 0)))
+    {
+        return writer->status;
+    }
+
+    --writer->depth;
+    if (writer->pretty && frame->count > 0) {
+        json_put_newline(writer, writer->depth);
+    }
+    writer->buf[writer->len++] = (type == JSON_FRAME_MAP) ? '}' : ']';
+
+    return json_end(writer);
+}
+
+/**
+ * Append @a s quoted and escaped.
+ */
+static ib_status_t json_put_string(
+    ib_json_writer_t *writer,
+    const uint8_t    *s,
+    size_t            len
+)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    /* Most strings need no escapes. */
+    if (! json_reserve(writer, len + 2)) {
+        return writer->status;
+    }
+    writer->buf[writer->len++] = '"';
+
+    while (len > 0) {
+        size_t      run = ib_scan_json(s, len);
+        char        esc[6];
+        size_t      esc_len = 2;
+
+        if (run > 0) {
+            if (! json_reserve(writer, run + 1)) {
+                return writer->status;
+            }
+            json_put(writer, (const char *)s, run);
+            s   += run;
+            len -= run;
+            if (len == 0) {
+                break;
+            }
+        }
+
+        esc[0] = '\\';
+        switch (*s) {
+        case '"':  esc[1] = '"';  break;
+        case '\\': esc[1] = '\\'; break;
+        case '\b': esc[1] = 'b';  break;
+        case '\f': esc[1] = 'f';  break;
+        case '\n': esc[1] = 'n';  break;
+        case '\r': esc[1] = 'r';  break;
+        case '\t': esc[1] = 't';  break;
+        default:
+            esc[1]  = 'u';
+            esc[2]  = '0';
+            esc[3]  = '0';
+            esc[4]  = hex[*s >> 4];
+            esc[5]  = hex[*s & 0xf];
+            esc_len = 6;
+            break;
+        }
+        if (! json_reserve(writer, esc_len + 1)) {
+            return writer->status;
+        }
+        json_put(writer, esc, esc_len);
+        ++s;
+        --len;
+    }
+
+    writer->buf[writer->len++] = '"';
+
+    return IB_OK;
+}
+
+ib_status_t ib_json_writer_create(
+    ib_json_writer_t **writer,
+    bool               pretty
+)
+{
+    assert(writer != NULL);
+
+    ib_json_writer_t *local_writer;
+
+    local_writer = malloc(sizeof(*local_writer));
+    if (local_writer == NULL) {
+        return IB_EALLOC;
+    }
+    local_writer->buf    = NULL;
+    local_writer->size   = 0;
+    local_writer->thread = false;
+    ib_json_writer_reset(local_writer, pretty);
+
+    *writer = local_writer;
+
+    return IB_OK;
+}
+
+void ib_json_writer_destroy(
+    ib_json_writer_t *writer
+)
+{
+    if (writer == NULL) {
+        return;
+    }
+
+    free(writer->buf);
+    free(writer);
+}
+
+ib_status_t ib_json_writer_acquire(
+    ib_json_writer_t **writer,
+    bool               pretty
+)
+{
+    assert(writer != NULL);
+
+    ib_json_writer_t *local_writer = NULL;
+    ib_status_t       rc;
+
+    pthread_once(&s_thread_once, &json_writer_thread_init);
+    if (s_thread_key_valid) {
+        void *data = pthread_getspecific(s_thread_key);
+
+        if (data == NULL) {
+            rc = ib_json_writer_create(&local_writer, pretty);
+            if (rc != IB_OK) {
+                return rc;
+            }
+            /* Only a writer the key can hold is the thread's. */
+            local_writer->thread =
+                pthread_setspecific(s_thread_key, &s_thread_busy) == 0;
+            *writer = local_writer;
+            return IB_OK;
+        }
+        if (data != &s_thread_busy) {
+            local_writer = (ib_json_writer_t *)data;
+            pthread_setspecific(s_thread_key, &s_thread_busy);
+            ib_json_writer_reset(local_writer, pretty);
+            *writer = local_writer;
+            return IB_OK;
+        }
+    }
+
+    /* Already acquired or no thread writers: use a new one. */
+    return ib_json_writer_create(writer, pretty);
+}
+
+void ib_json_writer_release(
+    ib_json_writer_t *writer
+)
+{
+    if (writer == NULL) {
+        return;
+    }
+
+    if (! writer->thread) {
+        ib_json_writer_destroy(writer);
+        return;
+    }
+
+    if (writer->size > JSON_WRITER_KEEP_SIZE) {
+        free(writer->buf);
+        writer->buf  = NULL;
+        writer->size = 0;
+    }
+    /* Replacing an existing value does not allocate. */
+    pthread_setspecific(s_thread_key, writer);
+}
+
+void ib_json_writer_reset(
+    ib_json_writer_t *writer,
+    bool              pretty
+)
+{
+    assert(writer != NULL);
+
+    writer->len             = 0;
+    writer->status          = IB_OK;
+    writer->pretty          = pretty;
+    writer->depth           = 0;
+    writer->frames[0].type  = JSON_FRAME_TOP;
+    writer->frames[0].key   = false;
+    writer->frames[0].count = 0;
+    if (writer->buf != NULL) {
+        writer->buf[0] = '\0';
+    }
+}
+
+ib_status_t ib_json_writer_buf(
+    const ib_json_writer_t  *writer,
+    const char             **buf,
+    size_t                  *len
+)
+{
+    assert(writer != NULL);
+
+    if (writer->status != IB_OK) {
+        return writer->status;
+    }
+    if (writer->depth != 0 || writer->frames[0].count == 0) {
+        return IB_EINVAL;
+    }
+
+    if (buf != NULL) {
+        *buf = writer->buf;
+    }
+    if (len != NULL) {
+        *len = writer->len;
+    }
+
+    return IB_OK;
+}
+
+ib_status_t ib_json_writer_map_open(
+    ib_json_writer_t *writer
+)
+{
+    assert(writer != NULL);
+
+    return json_open(writer, JSON_FRAME_MAP);
+}
+
+ib_status_t ib_json_writer_map_close(
+    ib_json_writer_t *writer
+)
+{
+    assert(writer != NULL);
+
+    return json_close(writer, JSON_FRAME_MAP);
+}
+
+ib_status_t ib_json_writer_array_open(
+    ib_json_writer_t *writer
+)
+{
+    assert(writer != NULL);
+
+    return json_open(writer, JSON_FRAME_ARRAY);
+}
+
+ib_status_t ib_json_writer_array_close(
+    ib_json_writer_t *writer
+)
+{
+    assert(writer != NULL);
+
+    return json_close(writer, JSON_FRAME_ARRAY);
+}
+
+ib_status_t ib_json_writer_string(
+    ib_json_writer_t *writer,
+    const char       *s,
+    size_t            len
+)
+{
+    assert(writer != NULL);
+    assert(s != NULL || len == 0);
+
+    ib_status_t rc;
+    bool        is_key;
+
+    if (! json_begin(writer, true, &is_key)) {
+        return writer->status;
+    }
+    rc = json_put_string(writer, (const uint8_t *)s, len);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    if (is_key) {
+        writer->buf[writer->len] = '\0';
+        return IB_OK;
+    }
+
+    return json_end(writer);
+}
+
+ib_status_t ib_json_writer_nulstr(
+    ib_json_writer_t *writer,
+    const char       *s
+)
+{
+    assert(writer != NULL);
+    assert(s != NULL);
+
+    return ib_json_writer_string(writer, s, strlen(s));
+}
+
+ib_status_t ib_json_writer_num(
+    ib_json_writer_t *writer,
+    ib_num_t          num
+)
+{
+    assert(writer != NULL);
+
+    char   buf[IB_TYPE_NUM_BUF_SIZE];
+    size_t len = ib_type_itoa_buf(num, buf);
+
+    return json_token(writer, buf, len);
+}
+
+ib_status_t ib_json_writer_float(
+    ib_json_writer_t *writer,
+    double            num
+)
+{
+    assert(writer != NULL);
+
+    char buf[32];
+    int  len;
+
+    if (! isfinite(num)) {
+        if (writer->status == IB_OK) {
+            writer->status = IB_EINVAL;
+        }
+        return writer->status;
+    }
+
+    len = snprintf(buf, sizeof(buf) - 2, "%.17g", num);
+    if (strspn(buf, "0123456789-") == (size_t)len) {
+        buf[len++] = '.';
+        buf[len++] = '0';
+    }
+
+    return json_token(writer, buf, len);
+}
+
+ib_status_t ib_json_writer_bool(
+    ib_json_writer_t *writer,
+    bool              val
+)
+{
+    assert(writer != NULL);
+
+    return val ?
+        json_token(writer, "true", 4) :
+        json_token(writer, "false", 5);
+}
+
+ib_status_t ib_json_writer_null(
+    ib_json_writer_t *writer
+)
+{
+    assert(writer != NULL);
+
+    return json_token(writer, "null", 4);
+}
+
+ib_status_t ib_json_writer_field(
+    ib_json_writer_t *writer,
+    const ib_field_t *field
+)
+{
+    assert(writer != NULL);
+    assert(field != NULL);
+
+    ib_status_t rc;
+
+    if (writer->status != IB_OK) {
+        return writer->status;
+    }
+
+    if (
+        writer->frames[writer->depth].type == JSON_FRAME_MAP &&
+        ! writer->frames[writer->depth].key
+    ) {
+        rc = ib_json_writer_string(writer, field->name, field->nlen);
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
+    switch (field->type) {
+    case IB_FTYPE_NUM: {
+        ib_num_t num;
+
+        rc = ib_field_value(field, ib_ftype_num_out(&num));
+        if (rc != IB_OK) {
+            break;
+        }
+        return ib_json_writer_num(writer, num);
+    }
+
+    case IB_FTYPE_FLOAT: {
+        ib_float_t num;
+
+        rc = ib_field_value(field, ib_ftype_float_out(&num));
+        if (rc != IB_OK) {
+            break;
+        }
+        return ib_json_writer_float(writer, (double)num);
+    }
+
+    case IB_FTYPE_NULSTR: {
+        const char *s;
+
+        rc = ib_field_value(field, ib_ftype_nulstr_out(&s));
+        if (rc != IB_OK) {
+            break;
+        }
+        if (s == NULL) {
+            return ib_json_writer_null(writer);
+        }
+        return ib_json_writer_nulstr(writer, s);
+    }
+
+    case IB_FTYPE_BYTESTR: {
+        const ib_bytestr_t *bs;
+
+        rc = ib_field_value(field, ib_ftype_bytestr_out(&bs));
+        if (rc != IB_OK) {
+            break;
+        }
+        if (bs == NULL) {
+            return ib_json_writer_null(writer);
+        }
+        return ib_json_writer_string(
+            writer,
+            (const char *)ib_bytestr_const_ptr(bs),
+            ib_bytestr_length(bs)
+        );
+    }
+
+    case IB_FTYPE_LIST: {
+        const ib_list_t      *list;
+        const ib_list_node_t *node;
+
+        rc = ib_field_value(field, ib_ftype_list_out(&list));
+        if (rc != IB_OK) {
+            break;
+        }
+        ib_json_writer_map_open(writer);
+        IB_LIST_LOOP_CONST(list, node) {
+            ib_json_writer_field(
+                writer,
+                (const ib_field_t *)ib_list_node_data_const(node)
+            );
+        }
+        return ib_json_writer_map_close(writer);
+    }
+
+    default:
+        return ib_json_writer_null(writer);
+    }
+
+    writer->status = rc;
+    return rc;
+}
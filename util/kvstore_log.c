@@ -0,0 +1,1744 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- Log structured key-value store.
+ *
+ * A segment is a file of records.  Each record is a @ref kvlog_record_t
+ * followed by the key, type and value, padded to @ref KVLOG_ALIGN bytes.
+ * Segments are named by a 16 digit hexadecimal id; the highest id is the
+ * active segment which records are appended to.  Each segment is mapped
+ * read-only at its full size, so records appended by write() are readable
+ * through the mapping without remapping.
+ *
+ * The index maps each key to the location of its current record.  Every
+ * segment counts the bytes of its records the index refers to, so the
+ * compactor can find segments that are mostly superseded records.
+ *
+ * Remove records (tombstones) only matter while an older segment may hold
+ * a record for the same key, so compaction drops them from the oldest
+ * segment and copies them forward otherwise.
+ */
+
+#include "ironbee_config_auto.h"
+
+#include <ironbee/kvstore_log.h>
+
+#include "kvstore_private.h"
+
+#include <ironbee/hash.h>
+#include <ironbee/kvstore.h>
+#include <ironbee/lock.h>
+#include <ironbee/mm_mpool.h>
+#include <ironbee/mpool.h>
+#include <ironbee/util.h>
+
+#include <assert.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+/** Record magic: "KVL1". */
+#define KVLOG_MAGIC 0x314c564bU
+
+/** Records start on multiples of this. */
+#define KVLOG_ALIGN 8
+
+/** The record is a remove. */
+#define KVLOG_FLAG_REMOVE 0x1U
+
+/** Default segment size. */
+#define KVLOG_SEGMENT_SIZE (16 * 1024 * 1024)
+
+/** Minimum segment size. */
+#define KVLOG_SEGMENT_SIZE_MIN 4096
+
+/** Bytes of records compacted per hold of the write lock. */
+#define KVLOG_COMPACT_CHUNK (256 * 1024)
+
+/** Default compaction interval (usec). */
+#define KVLOG_COMPACT_INTERVAL (10 * 1000000)
+
+/** Name of the file locked while a process uses the directory. */
+#define KVLOG_LOCK_FILE "LOCK"
+
+/** Segment file name suffix. */
+#define KVLOG_SEGMENT_SUFFIX ".log"
+
+/** Length of a segment file name. */
+#define KVLOG_SEGMENT_NAME_LEN (16 + sizeof(KVLOG_SEGMENT_SUFFIX) - 1)
+
+/** The default mode of created files. */
+static const mode_t DEFAULT_FILE_MODE = 0644;
+
+/** The mode of a created directory. */
+static const mode_t DEFAULT_DIRECTORY_MODE = 0755;
+
+/**
+ * Record header.
+ *
+ * The checksum covers the header after the checksum and the key, type and
+ * value.
+ */
+typedef struct {
+    uint32_t magic;        /**< KVLOG_MAGIC. */
+    uint32_t checksum;     /**< FNV-1a checksum. */
+    uint32_t key_length;   /**< Length of the key. */
+    uint32_t type_length;  /**< Length of the type. */
+    uint32_t value_length; /**< Length of the value. */
+    uint32_t flags;        /**< KVLOG_FLAG_* */
+    uint64_t expiration;   /**< Expiration; 0 for a remove. */
+    uint64_t creation;     /**< Creation; 0 for a remove. */
+} kvlog_record_t;
+
+/** A segment file. */
+typedef struct {
+    uint64_t   id;       /**< Id; order of creation. */
+    int        fd;       /**< Open descriptor. */
+    uint8_t   *map;      /**< Read-only mapping of @ref map_size bytes. */
+    size_t     map_size; /**< Size of @ref map. */
+    size_t     size;     /**< Bytes of records. */
+    size_t     live;     /**< Bytes of records the index refers to. */
+    ib_time_t  expires;  /**< Latest expiration of any set record. */
+} kvlog_segment_t;
+
+/** Index entry: the current record of a key. */
+typedef struct {
+    kvlog_segment_t *segment;    /**< Segment of the record. */
+    size_t           offset;     /**< Offset of the record in segment. */
+    size_t           length;     /**< Padded length of the record. */
+    ib_time_t        expiration; /**< Expiration of the record. */
+    size_t           key_length; /**< Length of @ref key. */
+    char             key[];      /**< Key; the index refers to this. */
+} kvlog_entry_t;
+
+typedef struct kvlog_server_t kvlog_server_t;
+
+/** Server data. */
+struct kvlog_server_t {
+    char             *directory;        /**< Directory of the segments. */
+    mode_t            fmode;            /**< Mode of created files. */
+    size_t            segment_size;     /**< Size to roll segments at. */
+    ib_time_t         compact_interval; /**< Compactor interval (usec). */
+
+    /* Present while connected. */
+    bool              connected;   /**< Connected? */
+    pid_t             pid;         /**< Process that connected. */
+    int               lock_fd;     /**< Locked file; excludes processes. */
+    dev_t             lock_dev;    /**< Device of the locked file. */
+    ino_t             lock_ino;    /**< Inode of the locked file. */
+    kvlog_server_t   *held_next;   /**< Next in @ref s_held. */
+    ib_lock_t        *compact_lock;/**< Held while compacting. */
+    ib_rwlock_t      *lock;        /**< Guards all below but the thread. */
+    ib_mpool_t       *mp;          /**< Pool of the index. */
+    ib_hash_t        *index;       /**< Key to kvlog_entry_t. */
+    kvlog_segment_t **segments;    /**< Segments ordered by id. */
+    size_t            segments_n;  /**< Number of @ref segments. */
+    size_t            segments_cap;/**< Capacity of @ref segments. */
+
+    /* Compactor; started by the first set. */
+    bool              thread_started; /**< Is @ref thread running? */
+    bool              thread_stop;    /**< Tell the thread to exit. */
+    pthread_t         thread;         /**< Compactor thread. */
+    pthread_mutex_t   thread_lock;    /**< Guards @ref thread_stop. */
+    pthread_cond_t    thread_cond;    /**< Signaled to stop early. */
+};
+
+/**
+ * Connections of this process that hold a directory.
+ *
+ * fcntl() locks exclude other processes only, so connections of this
+ * process are found here.
+ */
+static kvlog_server_t *s_held = NULL;
+
+/** Guards @ref s_held and taking directory locks. */
+static pthread_mutex_t s_held_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * FNV-1a over @a data, continuing from @a hash.
+ */
+static uint32_t kvlog_checksum(uint32_t hash, const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+
+    for (size_t i = 0; i < len; ++i) {
+        hash ^= p[i];
+        hash *= 16777619U;
+    }
+
+    return hash;
+}
+
+/**
+ * Checksum of a record.
+ */
+static uint32_t kvlog_record_checksum(
+    const kvlog_record_t *hdr,
+    const void           *payload
+)
+{
+    uint32_t hash = 2166136261U;
+
+    hash = kvlog_checksum(
+        hash,
+        &hdr->key_length,
+        sizeof(*hdr) - offsetof(kvlog_record_t, key_length)
+    );
+    return kvlog_checksum(
+        hash,
+        payload,
+        (size_t)hdr->key_length + hdr->type_length + hdr->value_length
+    );
+}
+
+/**
+ * Padded length of a record with @a payload bytes after the header.
+ */
+static size_t kvlog_record_length(size_t payload)
+{
+    size_t len = sizeof(kvlog_record_t) + payload;
+
+    return (len + KVLOG_ALIGN - 1) & ~(size_t)(KVLOG_ALIGN - 1);
+}
+
+/**
+ * Read and validate the record at @a offset of @a segment.
+ *
+ * @param[in]  segment Segment.
+ * @param[in]  offset Offset of the record.
+ * @param[in]  size Bytes of @a segment that may hold records.
+ * @param[out] hdr Header.
+ * @param[out] length Padded length of the record.
+ *
+ * @returns
+ * - IB_OK if the record is valid.
+ * - IB_EINVAL otherwise.
+ */
+static ib_status_t kvlog_record_read(
+    const kvlog_segment_t *segment,
+    size_t                 offset,
+    size_t                 size,
+    kvlog_record_t        *hdr,
+    size_t                *length
+)
+{
+    uint64_t payload;
+
+    if (size - offset < sizeof(*hdr)) {
+        return IB_EINVAL;
+    }
+    memcpy(hdr, segment->map + offset, sizeof(*hdr));
+    if (hdr->magic != KVLOG_MAGIC) {
+        return IB_EINVAL;
+    }
+
+    payload = (uint64_t)hdr->key_length + hdr->type_length +
+        hdr->value_length;
+    if (payload > size - offset - sizeof(*hdr)) {
+        return IB_EINVAL;
+    }
+    if (
+        kvlog_record_checksum(hdr, segment->map + offset + sizeof(*hdr)) !=
+        hdr->checksum
+    ) {
+        return IB_EINVAL;
+    }
+
+    *length = kvlog_record_length((size_t)payload);
+    if (*length > size - offset) {
+        /* Only the padding of the last record may be missing. */
+        *length = size - offset;
+    }
+
+    return IB_OK;
+}
+
+/**
+ * Build the path of a file in the directory of @a server.
+ *
+ * @returns Path to free() or NULL on allocation failure.
+ */
+static char *kvlog_path(const kvlog_server_t *server, const char *name)
+{
+    size_t  len  = strlen(server->directory) + strlen(name) + 2;
+    char   *path = malloc(len);
+
+    if (path != NULL) {
+        snprintf(path, len, "%s/%s", server->directory, name);
+    }
+
+    return path;
+}
+
+/**
+ * Build the path of segment @a id.
+ *
+ * @returns Path to free() or NULL on allocation failure.
+ */
+static char *kvlog_segment_path(const kvlog_server_t *server, uint64_t id)
+{
+    char name[KVLOG_SEGMENT_NAME_LEN + 1];
+
+    snprintf(name, sizeof(name), "%016" PRIx64 KVLOG_SEGMENT_SUFFIX, id);
+
+    return kvlog_path(server, name);
+}
+
+/**
+ * Unmap and close @a segment and free it.
+ */
+static void kvlog_segment_close(kvlog_segment_t *segment)
+{
+    if (segment->map != NULL) {
+        munmap(segment->map, segment->map_size);
+    }
+    if (segment->fd >= 0) {
+        close(segment->fd);
+    }
+    free(segment);
+}
+
+/**
+ * Open, and possibly create, segment @a id and add it to the segments.
+ *
+ * @param[in]  server Server.
+ * @param[in]  id Segment id; greater than that of any segment.
+ * @param[in]  create Create a new, empty segment.
+ * @param[out] segment Segment.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ * - IB_EOTHER on file system failure.
+ */
+static ib_status_t kvlog_segment_open(
+    kvlog_server_t   *server,
+    uint64_t          id,
+    bool              create,
+    kvlog_segment_t **segment
+)
+{
+    kvlog_segment_t *local_segment;
+    char            *path;
+    struct stat      sb;
+    ib_status_t      rc = IB_EOTHER;
+
+    if (server->segments_n == server->segments_cap) {
+        size_t            cap = server->segments_cap * 2 + 8;
+        kvlog_segment_t **segments;
+
+        segments = realloc(server->segments, cap * sizeof(*segments));
+        if (segments == NULL) {
+            return IB_EALLOC;
+        }
+        server->segments     = segments;
+        server->segments_cap = cap;
+    }
+
+    path = kvlog_segment_path(server, id);
+    if (path == NULL) {
+        return IB_EALLOC;
+    }
+    local_segment = calloc(1, sizeof(*local_segment));
+    if (local_segment == NULL) {
+        free(path);
+        return IB_EALLOC;
+    }
+    local_segment->id = id;
+    local_segment->fd = open(
+        path,
+        create ? O_RDWR | O_CREAT | O_EXCL : O_RDWR,
+        server->fmode
+    );
+    if (local_segment->fd < 0) {
+        ib_util_log_error("kvstore: Failed to open \"%s\": %s",
+                          path, strerror(errno));
+        goto failure;
+    }
+    if (fstat(local_segment->fd, &sb) != 0) {
+        goto failure;
+    }
+
+    local_segment->size = (size_t)sb.st_size;
+    local_segment->map_size = server->segment_size;
+    if (local_segment->size > local_segment->map_size) {
+        local_segment->map_size = local_segment->size;
+    }
+    local_segment->map = mmap(
+        NULL,
+        local_segment->map_size,
+        PROT_READ,
+        MAP_SHARED,
+        local_segment->fd,
+        0
+    );
+    if (local_segment->map == MAP_FAILED) {
+        local_segment->map = NULL;
+        ib_util_log_error("kvstore: Failed to map \"%s\": %s",
+                          path, strerror(errno));
+        goto failure;
+    }
+
+    free(path);
+    server->segments[server->segments_n++] = local_segment;
+    *segment = local_segment;
+
+    return IB_OK;
+
+failure:
+    free(path);
+    kvlog_segment_close(local_segment);
+    return rc;
+}
+
+/**
+ * Remove @a segment from the segments and the file system.
+ */
+static void kvlog_segment_remove(kvlog_server_t *server, size_t i)
+{
+    kvlog_segment_t *segment = server->segments[i];
+    char            *path    = kvlog_segment_path(server, segment->id);
+
+    if (path != NULL) {
+        unlink(path);
+        free(path);
+    }
+    kvlog_segment_close(segment);
+
+    memmove(
+        server->segments + i,
+        server->segments + i + 1,
+        (server->segments_n - i - 1) * sizeof(*server->segments)
+    );
+    --server->segments_n;
+}
+
+/**
+ * The active segment.
+ */
+static kvlog_segment_t *kvlog_active(const kvlog_server_t *server)
+{
+    assert(server->segments_n > 0);
+
+    return server->segments[server->segments_n - 1];
+}
+
+/**
+ * Append a record to the active segment, starting a new one if needed.
+ *
+ * @param[in]  server Server.
+ * @param[in]  iov Record; the padding is added.
+ * @param[in]  iovcnt Number of elements of @a iov; at most 4.
+ * @param[in]  payload Bytes of @a iov after the header.
+ * @param[out] segment Segment of the record.
+ * @param[out] offset Offset of the record.
+ * @param[out] length Padded length of the record.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EINVAL if the record is larger than a segment.
+ * - IB_EALLOC on allocation failure.
+ * - IB_EOTHER on file system failure.
+ */
+static ib_status_t kvlog_append(
+    kvlog_server_t    *server,
+    const struct iovec *iov,
+    int                iovcnt,
+    size_t             payload,
+    kvlog_segment_t  **segment,
+    size_t            *offset,
+    size_t            *length
+)
+{
+    static const uint8_t  padding[KVLOG_ALIGN];
+    struct iovec          local_iov[5];
+    kvlog_segment_t      *active = kvlog_active(server);
+    size_t                len    = kvlog_record_length(payload);
+    ssize_t               written;
+    ib_status_t           rc;
+
+    assert(iovcnt <= 4);
+
+    if (len > server->segment_size) {
+        return IB_EINVAL;
+    }
+
+    if (active->size + len > active->map_size) {
+        rc = kvlog_segment_open(server, active->id + 1, true, &active);
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
+    memcpy(local_iov, iov, iovcnt * sizeof(*iov));
+    local_iov[iovcnt].iov_base = (void *)padding;
+    local_iov[iovcnt].iov_len  = len - sizeof(kvlog_record_t) - payload;
+
+    written = pwritev(active->fd, local_iov, iovcnt + 1, active->size);
+    if (written != (ssize_t)len) {
+        ib_util_log_error("kvstore: Failed to write segment: %s",
+                          written < 0 ? strerror(errno) : "short write");
+        /* Drop anything partially written. */
+        if (ftruncate(active->fd, active->size) != 0) {
+            ib_util_log_error("kvstore: Failed to truncate segment: %s",
+                              strerror(errno));
+        }
+        return IB_EOTHER;
+    }
+
+    *segment = active;
+    *offset  = active->size;
+    *length  = len;
+    active->size += len;
+
+    return IB_OK;
+}
+
+/**
+ * Look up the index entry of a key.
+ *
+ * @returns Entry or NULL.
+ */
+static kvlog_entry_t *kvlog_index_get(
+    const kvlog_server_t *server,
+    const void           *key,
+    size_t                key_length
+)
+{
+    kvlog_entry_t *entry;
+
+    if (
+        ib_hash_get_ex(server->index, &entry, key, key_length) != IB_OK
+    ) {
+        return NULL;
+    }
+
+    return entry;
+}
+
+/**
+ * Make the record at @a offset of @a segment the current record of its key.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ */
+static ib_status_t kvlog_index_put(
+    kvlog_server_t  *server,
+    kvlog_segment_t *segment,
+    size_t           offset,
+    size_t           length,
+    const void      *key,
+    size_t           key_length,
+    ib_time_t        expiration
+)
+{
+    kvlog_entry_t *entry = kvlog_index_get(server, key, key_length);
+    ib_status_t    rc;
+
+    if (entry != NULL) {
+        entry->segment->live -= entry->length;
+    }
+    else {
+        entry = malloc(sizeof(*entry) + key_length);
+        if (entry == NULL) {
+            return IB_EALLOC;
+        }
+        entry->key_length = key_length;
+        memcpy(entry->key, key, key_length);
+        rc = ib_hash_set_ex(server->index, entry->key, key_length, entry);
+        if (rc != IB_OK) {
+            free(entry);
+            return rc;
+        }
+    }
+
+    entry->segment    = segment;
+    entry->offset     = offset;
+    entry->length     = length;
+    entry->expiration = expiration;
+    segment->live    += length;
+    if (segment->expires < expiration) {
+        segment->expires = expiration;
+    }
+
+    return IB_OK;
+}
+
+/**
+ * Remove @a entry from the index.
+ */
+static void kvlog_index_drop(kvlog_server_t *server, kvlog_entry_t *entry)
+{
+    entry->segment->live -= entry->length;
+    ib_hash_remove_ex(server->index, NULL, entry->key, entry->key_length);
+    free(entry);
+}
+
+/**
+ * Append a set record.
+ *
+ * @returns As kvlog_append().
+ */
+static ib_status_t kvlog_write_set(
+    kvlog_server_t  *server,
+    const void      *key,
+    size_t           key_length,
+    const char      *type,
+    size_t           type_length,
+    const uint8_t   *value,
+    size_t           value_length,
+    ib_time_t        expiration,
+    ib_time_t        creation
+)
+{
+    kvlog_record_t   hdr;
+    struct iovec     iov[4];
+    kvlog_segment_t *segment;
+    size_t           offset;
+    size_t           length;
+    uint32_t         hash;
+    ib_status_t      rc;
+
+    if (
+        key_length   > UINT32_MAX ||
+        type_length  > UINT32_MAX ||
+        value_length > UINT32_MAX
+    ) {
+        return IB_EINVAL;
+    }
+
+    hdr.magic        = KVLOG_MAGIC;
+    hdr.key_length   = (uint32_t)key_length;
+    hdr.type_length  = (uint32_t)type_length;
+    hdr.value_length = (uint32_t)value_length;
+    hdr.flags        = 0;
+    hdr.expiration   = expiration;
+    hdr.creation     = creation;
+
+    hash = kvlog_checksum(
+        2166136261U,
+        &hdr.key_length,
+        sizeof(hdr) - offsetof(kvlog_record_t, key_length)
+    );
+    hash = kvlog_checksum(hash, key, key_length);
+    hash = kvlog_checksum(hash, type, type_length);
+    hdr.checksum = kvlog_checksum(hash, value, value_length);
+
+    iov[0].iov_base = &hdr;
+    iov[0].iov_len  = sizeof(hdr);
+    iov[1].iov_base = (void *)key;
+    iov[1].iov_len  = key_length;
+    iov[2].iov_base = (void *)type;
+    iov[2].iov_len  = type_length;
+    iov[3].iov_base = (void *)value;
+    iov[3].iov_len  = value_length;
+
+    rc = kvlog_append(
+        server, iov, 4, key_length + type_length + value_length,
+        &segment, &offset, &length
+    );
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    return kvlog_index_put(
+        server, segment, offset, length, key, key_length, expiration
+    );
+}
+
+/**
+ * Append a remove record.
+ *
+ * @returns As kvlog_append().
+ */
+static ib_status_t kvlog_write_remove(
+    kvlog_server_t *server,
+    const void     *key,
+    size_t          key_length
+)
+{
+    kvlog_record_t   hdr;
+    struct iovec     iov[2];
+    kvlog_segment_t *segment;
+    size_t           offset;
+    size_t           length;
+
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic      = KVLOG_MAGIC;
+    hdr.key_length = (uint32_t)key_length;
+    hdr.flags      = KVLOG_FLAG_REMOVE;
+    hdr.checksum   = kvlog_record_checksum(&hdr, key);
+
+    iov[0].iov_base = &hdr;
+    iov[0].iov_len  = sizeof(hdr);
+    iov[1].iov_base = (void *)key;
+    iov[1].iov_len  = key_length;
+
+    return kvlog_append(
+        server, iov, 2, key_length, &segment, &offset, &length
+    );
+}
+
+/**
+ * Apply the records of @a segment to the index.
+ *
+ * An invalid record ends the segment.  In the last segment this is a write
+ * that was cut short and the segment is truncated to drop it.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ */
+static ib_status_t kvlog_segment_replay(
+    kvlog_server_t  *server,
+    kvlog_segment_t *segment,
+    bool             last
+)
+{
+    size_t      offset = 0;
+    ib_status_t rc;
+
+    while (offset < segment->size) {
+        kvlog_record_t  hdr;
+        size_t          length;
+        const uint8_t  *key = segment->map + offset + sizeof(hdr);
+
+        if (
+            kvlog_record_read(segment, offset, segment->size, &hdr, &length)
+            != IB_OK
+        ) {
+            ib_util_log_error(
+                "kvstore: Invalid record in segment %016" PRIx64
+                " at %zd; ignoring the rest of the segment.",
+                segment->id, offset
+            );
+            segment->size = offset;
+            if (last && ftruncate(segment->fd, offset) != 0) {
+                ib_util_log_error("kvstore: Failed to truncate segment: %s",
+                                  strerror(errno));
+            }
+            break;
+        }
+
+        if (hdr.flags & KVLOG_FLAG_REMOVE) {
+            kvlog_entry_t *entry =
+                kvlog_index_get(server, key, hdr.key_length);
+            if (entry != NULL) {
+                kvlog_index_drop(server, entry);
+            }
+        }
+        else {
+            rc = kvlog_index_put(
+                server, segment, offset, length,
+                key, hdr.key_length, hdr.expiration
+            );
+            if (rc != IB_OK) {
+                return rc;
+            }
+        }
+
+        offset += length;
+    }
+
+    return IB_OK;
+}
+
+/**
+ * Compare segment ids for qsort().
+ */
+static int kvlog_id_cmp(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+/**
+ * Open and replay the segments in the directory and start a new active
+ * segment.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ * - IB_EOTHER on file system failure.
+ */
+static ib_status_t kvlog_load(kvlog_server_t *server)
+{
+    DIR            *dir;
+    struct dirent  *de;
+    uint64_t       *ids    = NULL;
+    size_t          ids_n  = 0;
+    size_t          ids_cap = 0;
+    uint64_t        next_id = 0;
+    ib_status_t     rc     = IB_OK;
+
+    dir = opendir(server->directory);
+    if (dir == NULL) {
+        return IB_EOTHER;
+    }
+
+    while ((de = readdir(dir)) != NULL) {
+        char     *end;
+        uint64_t  id;
+
+        if (
+            strlen(de->d_name) != KVLOG_SEGMENT_NAME_LEN ||
+            strcmp(de->d_name + 16, KVLOG_SEGMENT_SUFFIX) != 0
+        ) {
+            continue;
+        }
+        id = strtoull(de->d_name, &end, 16);
+        if (end != de->d_name + 16) {
+            continue;
+        }
+
+        if (ids_n == ids_cap) {
+            uint64_t *local_ids;
+
+            ids_cap = ids_cap * 2 + 16;
+            local_ids = realloc(ids, ids_cap * sizeof(*ids));
+            if (local_ids == NULL) {
+                rc = IB_EALLOC;
+                goto cleanup;
+            }
+            ids = local_ids;
+        }
+        ids[ids_n++] = id;
+    }
+
+    if (ids_n > 0) {
+        qsort(ids, ids_n, sizeof(*ids), kvlog_id_cmp);
+    }
+
+    for (size_t i = 0; i < ids_n; ++i) {
+        kvlog_segment_t *segment;
+
+        rc = kvlog_segment_open(server, ids[i], false, &segment);
+        if (rc != IB_OK) {
+            goto cleanup;
+        }
+        rc = kvlog_segment_replay(server, segment, i + 1 == ids_n);
+        if (rc != IB_OK) {
+            goto cleanup;
+        }
+        next_id = ids[i] + 1;
+    }
+
+    /* Always append to a new segment. */
+    {
+        kvlog_segment_t *segment;
+
+        rc = kvlog_segment_open(server, next_id, true, &segment);
+    }
+
+cleanup:
+    closedir(dir);
+    free(ids);
+
+    return rc;
+}
+
+/**
+ * Compact up to KVLOG_COMPACT_CHUNK bytes of records of @a segment.
+ *
+ * Caller must hold the write lock.
+ *
+ * @param[in]     server Server.
+ * @param[in]     segment Segment to compact; not the active segment.
+ * @param[in]     oldest Is @a segment the oldest segment?
+ * @param[in]     now Current time.
+ * @param[in,out] offset Offset of the next record to compact; at least the
+ *                size of @a segment once it is done.
+ *
+ * @returns As kvlog_append().
+ */
+static ib_status_t kvlog_compact_chunk(
+    kvlog_server_t  *server,
+    kvlog_segment_t *segment,
+    bool             oldest,
+    ib_time_t        now,
+    size_t          *offset
+)
+{
+    size_t      end = *offset + KVLOG_COMPACT_CHUNK;
+    ib_status_t rc;
+
+    while (*offset < segment->size && *offset < end) {
+        kvlog_record_t  hdr;
+        size_t          length;
+        const uint8_t  *record = segment->map + *offset;
+        const uint8_t  *key    = record + sizeof(hdr);
+        kvlog_entry_t  *entry;
+
+        rc = kvlog_record_read(
+            segment, *offset, segment->size, &hdr, &length
+        );
+        if (rc != IB_OK) {
+            /* Replay stopped here too. */
+            *offset = segment->size;
+            break;
+        }
+
+        entry = kvlog_index_get(server, key, hdr.key_length);
+
+        if (hdr.flags & KVLOG_FLAG_REMOVE) {
+            /* Still shadows records in older segments, unless the key
+             * was set again since. */
+            if (! oldest && entry == NULL) {
+                rc = kvlog_write_remove(server, key, hdr.key_length);
+                if (rc != IB_OK) {
+                    return rc;
+                }
+            }
+        }
+        else if (
+            entry == NULL ||
+            entry->segment != segment ||
+            entry->offset != *offset
+        ) {
+            /* Superseded. */
+        }
+        else if (now > entry->expiration) {
+            kvlog_index_drop(server, entry);
+            if (! oldest) {
+                rc = kvlog_write_remove(server, key, hdr.key_length);
+                if (rc != IB_OK) {
+                    return rc;
+                }
+            }
+        }
+        else {
+            /* Current: copy as is. */
+            struct iovec     iov;
+            kvlog_segment_t *to;
+            size_t           to_offset;
+            size_t           to_length;
+
+            iov.iov_base = (void *)record;
+            iov.iov_len  = sizeof(hdr) +
+                hdr.key_length + hdr.type_length + hdr.value_length;
+            rc = kvlog_append(
+                server, &iov, 1, iov.iov_len - sizeof(hdr),
+                &to, &to_offset, &to_length
+            );
+            if (rc != IB_OK) {
+                return rc;
+            }
+            rc = kvlog_index_put(
+                server, to, to_offset, to_length,
+                key, hdr.key_length, hdr.expiration
+            );
+            if (rc != IB_OK) {
+                return rc;
+            }
+        }
+
+        *offset += length;
+    }
+
+    return IB_OK;
+}
+
+/**
+ * Compact segments.
+ *
+ * The write lock is taken for one chunk of a segment at a time, so gets
+ * and sets wait for at most a chunk.  Between chunks the segment stays as
+ * it is: records are only appended to the active segment and only
+ * compaction, which one thread at a time does, removes segments.  Each
+ * record is checked against the index when its chunk is compacted.
+ *
+ * Caller must hold neither lock.
+ *
+ * @returns As kvlog_append().
+ */
+static ib_status_t kvlog_compact(kvlog_server_t *server)
+{
+    ib_status_t rc;
+
+    rc = ib_lock_lock(server->compact_lock);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    for (;;) {
+        kvlog_segment_t *segment = NULL;
+        bool             oldest  = false;
+        size_t           offset  = 0;
+        ib_timeval_t     tv;
+        ib_time_t        now;
+
+        ib_clock_gettimeofday(&tv);
+        now = IB_CLOCK_TIMEVAL_TIME(tv);
+
+        rc = ib_rwlock_rdlock(server->lock);
+        if (rc != IB_OK) {
+            break;
+        }
+        /* The active segment is never compacted. */
+        for (size_t i = 0; i + 1 < server->segments_n; ++i) {
+            kvlog_segment_t *candidate = server->segments[i];
+
+            if (
+                candidate->live * 2 < candidate->size ||
+                now > candidate->expires
+            ) {
+                segment = candidate;
+                oldest  = (i == 0);
+                break;
+            }
+        }
+        ib_rwlock_unlock(server->lock);
+
+        if (segment == NULL) {
+            break;
+        }
+
+        for (;;) {
+            bool done;
+
+            rc = ib_rwlock_wrlock(server->lock);
+            if (rc != IB_OK) {
+                break;
+            }
+            rc = kvlog_compact_chunk(server, segment, oldest, now, &offset);
+            done = (rc == IB_OK && offset >= segment->size);
+            if (done) {
+                size_t i = 0;
+
+                while (server->segments[i] != segment) {
+                    ++i;
+                }
+                assert(segment->live == 0);
+                kvlog_segment_remove(server, i);
+            }
+            ib_rwlock_unlock(server->lock);
+
+            if (rc != IB_OK || done) {
+                break;
+            }
+        }
+        if (rc != IB_OK) {
+            break;
+        }
+    }
+
+    ib_lock_unlock(server->compact_lock);
+
+    return rc;
+}
+
+/**
+ * Compactor thread.
+ */
+static void *kvlog_compactor(void *arg)
+{
+    kvlog_server_t  *server = (kvlog_server_t *)arg;
+    struct timespec  deadline;
+    ib_status_t      rc;
+
+    pthread_mutex_lock(&server->thread_lock);
+    while (! server->thread_stop) {
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec  += server->compact_interval / 1000000;
+        deadline.tv_nsec += (server->compact_interval % 1000000) * 1000;
+        if (deadline.tv_nsec >= 1000000000) {
+            deadline.tv_nsec -= 1000000000;
+            ++deadline.tv_sec;
+        }
+
+        while (
+            ! server->thread_stop &&
+            pthread_cond_timedwait(
+                &server->thread_cond, &server->thread_lock, &deadline
+            ) == 0
+        ) {
+            /* Spurious wake up. */
+        }
+        if (server->thread_stop) {
+            break;
+        }
+        pthread_mutex_unlock(&server->thread_lock);
+
+        rc = kvlog_compact(server);
+        if (rc != IB_OK) {
+            ib_util_log_error("kvstore: Compaction failed: %s",
+                              ib_status_to_string(rc));
+        }
+
+        pthread_mutex_lock(&server->thread_lock);
+    }
+    pthread_mutex_unlock(&server->thread_lock);
+
+    return NULL;
+}
+
+/**
+ * Lock the directory of @a server.
+ *
+ * The lock file is locked with fcntl().  A child does not inherit the lock,
+ * so a child connecting for itself is refused while its parent is
+ * connected.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ * - IB_EOTHER if the directory is in use or on file system failure.
+ */
+static ib_status_t kvlog_lock_directory(kvlog_server_t *server)
+{
+    struct flock  fl;
+    struct stat   sb;
+    char         *path;
+    ib_status_t   rc = IB_OK;
+
+    path = kvlog_path(server, KVLOG_LOCK_FILE);
+    if (path == NULL) {
+        return IB_EALLOC;
+    }
+
+    pthread_mutex_lock(&s_held_lock);
+
+    /* Checked before opening: closing any descriptor of the file would
+     * release the lock of the connection holding it. */
+    if (stat(path, &sb) == 0) {
+        for (
+            const kvlog_server_t *held = s_held;
+            held != NULL;
+            held = held->held_next
+        ) {
+            if (held->lock_dev == sb.st_dev && held->lock_ino == sb.st_ino) {
+                goto busy;
+            }
+        }
+    }
+
+    server->lock_fd = open(path, O_RDWR | O_CREAT, server->fmode);
+    if (server->lock_fd < 0 || fstat(server->lock_fd, &sb) != 0) {
+        ib_util_log_error("kvstore: Failed to open \"%s\": %s",
+                          path, strerror(errno));
+        rc = IB_EOTHER;
+        goto cleanup;
+    }
+
+    memset(&fl, 0, sizeof(fl));
+    fl.l_type   = F_WRLCK;
+    fl.l_whence = SEEK_SET;
+    if (fcntl(server->lock_fd, F_SETLK, &fl) != 0) {
+        goto busy;
+    }
+
+    server->lock_dev  = sb.st_dev;
+    server->lock_ino  = sb.st_ino;
+    server->held_next = s_held;
+    s_held            = server;
+    goto cleanup;
+
+busy:
+    ib_util_log_error("kvstore: \"%s\" is in use by another connection.",
+                      server->directory);
+    rc = IB_EOTHER;
+
+cleanup:
+    pthread_mutex_unlock(&s_held_lock);
+    free(path);
+
+    return rc;
+}
+
+/**
+ * Unlock the directory of @a server.
+ */
+static void kvlog_unlock_directory(kvlog_server_t *server)
+{
+    pthread_mutex_lock(&s_held_lock);
+    for (
+        kvlog_server_t **held = &s_held;
+        *held != NULL;
+        held = &(*held)->held_next
+    ) {
+        if (*held == server) {
+            *held = server->held_next;
+            break;
+        }
+    }
+    server->held_next = NULL;
+    close(server->lock_fd);
+    server->lock_fd = -1;
+    pthread_mutex_unlock(&s_held_lock);
+}
+
+/**
+ * Check that @a server is connected and usable by this process.
+ *
+ * A connection inherited through fork() is refused: the parent appends
+ * to the same segments and neither would see the other's records.
+ *
+ * @returns
+ * - IB_OK if usable.
+ * - IB_EINVAL if not connected.
+ * - IB_EOTHER if connected by another process.
+ */
+static ib_status_t kvlog_check(const kvlog_server_t *server)
+{
+    if (! server->connected) {
+        return IB_EINVAL;
+    }
+    if (server->pid != getpid()) {
+        ib_util_log_error(
+            "kvstore: \"%s\" was connected by process %ld; "
+            "connect in this process to use it.",
+            server->directory, (long)server->pid
+        );
+        return IB_EOTHER;
+    }
+
+    return IB_OK;
+}
+
+/**
+ * Release everything acquired by kvconnect().
+ *
+ * In a child of the connecting process, only the child's copies are
+ * released; the parent keeps the directory.
+ */
+static void kvlog_close(kvlog_server_t *server)
+{
+    /* fork() does not copy the compactor thread. */
+    if (server->thread_started && server->pid == getpid()) {
+        pthread_mutex_lock(&server->thread_lock);
+        server->thread_stop = true;
+        pthread_cond_signal(&server->thread_cond);
+        pthread_mutex_unlock(&server->thread_lock);
+        pthread_join(server->thread, NULL);
+    }
+    server->thread_started = false;
+
+    if (server->index != NULL) {
+        ib_hash_iterator_t *iterator = ib_hash_iterator_create_malloc();
+
+        /* Without an iterator the entries leak; nothing else to do. */
+        if (iterator != NULL) {
+            for (
+                ib_hash_iterator_first(iterator, server->index);
+                ! ib_hash_iterator_at_end(iterator);
+                ib_hash_iterator_next(iterator)
+            ) {
+                kvlog_entry_t *entry;
+
+                ib_hash_iterator_fetch(NULL, NULL, &entry, iterator);
+                free(entry);
+            }
+            free(iterator);
+        }
+        server->index = NULL;
+    }
+    if (server->mp != NULL) {
+        ib_mpool_destroy(server->mp);
+        server->mp = NULL;
+    }
+
+    for (size_t i = 0; i < server->segments_n; ++i) {
+        kvlog_segment_close(server->segments[i]);
+    }
+    free(server->segments);
+    server->segments     = NULL;
+    server->segments_n   = 0;
+    server->segments_cap = 0;
+
+    if (server->lock != NULL) {
+        ib_rwlock_destroy_malloc(server->lock);
+        server->lock = NULL;
+    }
+    if (server->compact_lock != NULL) {
+        ib_lock_destroy_malloc(server->compact_lock);
+        server->compact_lock = NULL;
+    }
+    if (server->lock_fd >= 0) {
+        kvlog_unlock_directory(server);
+    }
+
+    server->connected = false;
+}
+
+static ib_status_t kvconnect(
+    ib_kvstore_t        *kvstore,
+    ib_kvstore_cbdata_t *cbdata)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+
+    kvlog_server_t *server = (kvlog_server_t *)kvstore->server;
+    ib_status_t     rc;
+
+    if (server->connected) {
+        if (server->pid == getpid()) {
+            return IB_OK;
+        }
+        /* Inherited through fork(): connect anew. */
+        kvlog_close(server);
+    }
+    server->connected   = true;
+    server->pid         = getpid();
+    server->thread_stop = false;
+
+    if (
+        mkdir(server->directory, DEFAULT_DIRECTORY_MODE) != 0 &&
+        errno != EEXIST
+    ) {
+        ib_util_log_error("kvstore: Failed to create \"%s\": %s",
+                          server->directory, strerror(errno));
+        rc = IB_EOTHER;
+        goto failure;
+    }
+
+    rc = kvlog_lock_directory(server);
+    if (rc != IB_OK) {
+        goto failure;
+    }
+
+    rc = ib_rwlock_create_malloc(&server->lock);
+    if (rc != IB_OK) {
+        goto failure;
+    }
+    rc = ib_lock_create_malloc(&server->compact_lock);
+    if (rc != IB_OK) {
+        goto failure;
+    }
+    rc = ib_mpool_create(&server->mp, "kvstore_log", NULL);
+    if (rc != IB_OK) {
+        goto failure;
+    }
+    rc = ib_hash_create_ex(
+        &server->index,
+        ib_mm_mpool(server->mp),
+        1024,
+        IB_HASH_LAYOUT_CHAINED,
+        ib_hashfunc_djb2, NULL,
+        ib_hashequal_default, NULL
+    );
+    if (rc != IB_OK) {
+        goto failure;
+    }
+
+    rc = kvlog_load(server);
+    if (rc != IB_OK) {
+        goto failure;
+    }
+
+    return IB_OK;
+
+failure:
+    kvlog_close(server);
+    return rc;
+}
+
+static ib_status_t kvdisconnect(
+    ib_kvstore_t        *kvstore,
+    ib_kvstore_cbdata_t *cbdata)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+
+    kvlog_close((kvlog_server_t *)kvstore->server);
+
+    return IB_OK;
+}
+
+/**
+ * Get implementation.
+ *
+ * @param[in] kvstore The key-value store.
+ * @param[in] mm Memory manager to allocate @a values out of.
+ * @param[in] key The key to fetch.
+ * @param[out] values A pointer to an array of pointers.
+ * @param[out] values_length The length of *values.
+ * @param[in,out] cbdata Callback data. Unused.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_ENOENT if @a key is not stored or expired.
+ * - IB_EALLOC on allocation failure.
+ */
+static ib_status_t kvget(
+    ib_kvstore_t             *kvstore,
+    ib_mm_t                   mm,
+    const ib_kvstore_key_t   *key,
+    ib_kvstore_value_t     ***values,
+    size_t                   *values_length,
+    ib_kvstore_cbdata_t      *cbdata
+)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+    assert(key != NULL);
+
+    kvlog_server_t      *server = (kvlog_server_t *)kvstore->server;
+    const uint8_t       *key_data;
+    size_t               key_length;
+    const kvlog_entry_t *entry;
+    kvlog_record_t       hdr;
+    const uint8_t       *payload;
+    ib_kvstore_value_t  *value;
+    ib_kvstore_value_t **local_values;
+    char                *type;
+    uint8_t             *data;
+    ib_timeval_t         tv;
+    ib_status_t          rc;
+
+    rc = kvlog_check(server);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    ib_kvstore_key_get(key, &key_data, &key_length);
+    ib_clock_gettimeofday(&tv);
+
+    rc = ib_rwlock_rdlock(server->lock);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    entry = kvlog_index_get(server, key_data, key_length);
+    if (entry == NULL || IB_CLOCK_TIMEVAL_TIME(tv) > entry->expiration) {
+        rc = IB_ENOENT;
+        goto cleanup;
+    }
+
+    memcpy(&hdr, entry->segment->map + entry->offset, sizeof(hdr));
+    payload = entry->segment->map + entry->offset + sizeof(hdr) +
+        hdr.key_length;
+
+    rc = ib_kvstore_value_create(&value, mm);
+    if (rc != IB_OK) {
+        goto cleanup;
+    }
+    local_values = ib_mm_alloc(mm, sizeof(*local_values));
+    type = ib_mm_memdup_to_str(mm, payload, hdr.type_length);
+    data = ib_mm_memdup(mm, payload + hdr.type_length, hdr.value_length);
+    if (
+        local_values == NULL ||
+        type == NULL ||
+        (data == NULL && hdr.value_length > 0)
+    ) {
+        rc = IB_EALLOC;
+        goto cleanup;
+    }
+
+    ib_kvstore_value_type_set(value, type, hdr.type_length);
+    ib_kvstore_value_value_set(value, data, hdr.value_length);
+    ib_kvstore_value_expiration_set(value, hdr.expiration);
+    ib_kvstore_value_creation_set(value, hdr.creation);
+
+    local_values[0] = value;
+    *values         = local_values;
+    *values_length  = 1;
+
+cleanup:
+    ib_rwlock_unlock(server->lock);
+
+    return rc;
+}
+
+/**
+ * Set implementation.
+ *
+ * @param[in] kvstore Key-value store.
+ * @param[in] merge_policy Unused; a set replaces the value.
+ * @param[in] key The key to set.
+ * @param[in] value The value to write.
+ * @param[in,out] cbdata Callback data. Unused.
+ *
+ * @returns As kvlog_append().
+ */
+static ib_status_t kvset(
+    ib_kvstore_t                 *kvstore,
+    ib_kvstore_merge_policy_fn_t  merge_policy,
+    const ib_kvstore_key_t       *key,
+    ib_kvstore_value_t           *value,
+    ib_kvstore_cbdata_t          *cbdata
+)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+    assert(key != NULL);
+    assert(value != NULL);
+
+    kvlog_server_t *server = (kvlog_server_t *)kvstore->server;
+    const uint8_t  *key_data;
+    size_t          key_length;
+    const char     *type;
+    size_t          type_length;
+    const uint8_t  *data;
+    size_t          data_length;
+    ib_time_t       expiration;
+    ib_timeval_t    tv;
+    ib_time_t       now;
+    ib_status_t     rc;
+
+    rc = kvlog_check(server);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    ib_kvstore_key_get(key, &key_data, &key_length);
+    ib_kvstore_value_type_get(value, &type, &type_length);
+    ib_kvstore_value_value_get(value, &data, &data_length);
+
+    /* As the filesystem store: expiration is relative to now on set and
+     * absolute on get. */
+    ib_clock_gettimeofday(&tv);
+    now = IB_CLOCK_TIMEVAL_TIME(tv);
+    expiration = ib_kvstore_value_expiration_get(value);
+    if (expiration > 0) {
+        expiration += now;
+    }
+
+    rc = ib_rwlock_wrlock(server->lock);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    /* Started here rather than on connect so that a store that is only
+     * read has no thread. */
+    if (! server->thread_started && server->compact_interval > 0) {
+        if (
+            pthread_create(
+                &server->thread, NULL, kvlog_compactor, server
+            ) == 0
+        ) {
+            server->thread_started = true;
+        }
+        else {
+            ib_util_log_error("kvstore: Failed to start compactor.");
+        }
+    }
+
+    rc = kvlog_write_set(
+        server,
+        key_data, key_length,
+        type, type_length,
+        data, data_length,
+        expiration,
+        now
+    );
+
+    ib_rwlock_unlock(server->lock);
+
+    return rc;
+}
+
+/**
+ * Remove implementation.
+ *
+ * @param[in] kvstore Store.
+ * @param[in] key Key.
+ * @param[in,out] cbdata Callback data. Unused.
+ *
+ * @returns As kvlog_append().
+ */
+static ib_status_t kvremove(
+    ib_kvstore_t           *kvstore,
+    const ib_kvstore_key_t *key,
+    ib_kvstore_cbdata_t    *cbdata)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+    assert(key != NULL);
+
+    kvlog_server_t *server = (kvlog_server_t *)kvstore->server;
+    const uint8_t  *key_data;
+    size_t          key_length;
+    kvlog_entry_t  *entry;
+    ib_status_t     rc;
+
+    rc = kvlog_check(server);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    ib_kvstore_key_get(key, &key_data, &key_length);
+
+    rc = ib_rwlock_wrlock(server->lock);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    entry = kvlog_index_get(server, key_data, key_length);
+    if (entry != NULL) {
+        rc = kvlog_write_remove(server, key_data, key_length);
+        if (rc == IB_OK) {
+            kvlog_index_drop(server, entry);
+        }
+    }
+
+    ib_rwlock_unlock(server->lock);
+
+    return rc;
+}
+
+/**
+ * Destroy any allocated elements of the kvstore structure.
+ *
+ * @param[out] kvstore to be destroyed. The segments on disk are untouched.
+ * @param[in] cbdata Unused.
+ */
+static void kvdestroy(ib_kvstore_t* kvstore, ib_kvstore_cbdata_t *cbdata)
+{
+    assert(kvstore != NULL);
+
+    kvlog_server_t *server = (kvlog_server_t *)kvstore->server;
+
+    kvlog_close(server);
+    pthread_mutex_destroy(&server->thread_lock);
+    pthread_cond_destroy(&server->thread_cond);
+    free(server->directory);
+    free(server);
+    kvstore->server = NULL;
+}
+
+ib_status_t ib_kvstore_log_init(
+    ib_kvstore_t *kvstore,
+    const char   *directory
+)
+{
+    assert(kvstore != NULL);
+    assert(directory != NULL);
+
+    kvlog_server_t *server;
+
+    ib_kvstore_init(kvstore);
+
+    server = calloc(1, sizeof(*server));
+    if (server == NULL) {
+        return IB_EALLOC;
+    }
+
+    server->directory = strdup(directory);
+    if (server->directory == NULL) {
+        free(server);
+        return IB_EALLOC;
+    }
+    server->fmode            = DEFAULT_FILE_MODE;
+    server->segment_size     = KVLOG_SEGMENT_SIZE;
+    server->compact_interval = KVLOG_COMPACT_INTERVAL;
+    server->lock_fd          = -1;
+    pthread_mutex_init(&server->thread_lock, NULL);
+    pthread_cond_init(&server->thread_cond, NULL);
+
+    kvstore->server = (ib_kvstore_server_t *)server;
+    kvstore->get = kvget;
+    kvstore->set = kvset;
+    kvstore->remove = kvremove;
+    kvstore->connect = kvconnect;
+    kvstore->disconnect = kvdisconnect;
+    kvstore->destroy = kvdestroy;
+
+    kvstore->malloc_cbdata = NULL;
+    kvstore->free_cbdata = NULL;
+    kvstore->connect_cbdata = NULL;
+    kvstore->disconnect_cbdata = NULL;
+    kvstore->get_cbdata = NULL;
+    kvstore->set_cbdata = NULL;
+    kvstore->remove_cbdata = NULL;
+    kvstore->merge_policy_cbdata = NULL;
+    kvstore->destroy_cbdata = NULL;
+
+    return IB_OK;
+}
+
+void ib_kvstore_log_set_file_mode(ib_kvstore_t *kvstore, mode_t mode)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+
+    ((kvlog_server_t *)kvstore->server)->fmode = mode;
+}
+
+void ib_kvstore_log_set_segment_size(ib_kvstore_t *kvstore, size_t size)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+
+    if (size < KVLOG_SEGMENT_SIZE_MIN) {
+        size = KVLOG_SEGMENT_SIZE_MIN;
+    }
+    ((kvlog_server_t *)kvstore->server)->segment_size = size;
+}
+
+void ib_kvstore_log_set_compact_interval(
+    ib_kvstore_t *kvstore,
+    ib_time_t     interval
+)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+
+    ((kvlog_server_t *)kvstore->server)->compact_interval = interval;
+}
+
+ib_status_t ib_kvstore_log_compact(ib_kvstore_t *kvstore)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+
+    kvlog_server_t *server = (kvlog_server_t *)kvstore->server;
+    ib_status_t     rc;
+
+    rc = kvlog_check(server);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    return kvlog_compact(server);
+}
+
+size_t ib_kvstore_log_segments(ib_kvstore_t *kvstore)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+
+    kvlog_server_t *server = (kvlog_server_t *)kvstore->server;
+    size_t          n;
+
+    if (
+        kvlog_check(server) != IB_OK ||
+        ib_rwlock_rdlock(server->lock) != IB_OK
+    ) {
+        return 0;
+    }
+    n = server->segments_n;
+    ib_rwlock_unlock(server->lock);
+
+    return n;
+}
@@ -0,0 +1,719 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- In-memory key-value store.
+ *
+ * Each entry is a single allocation holding the key, type and value.  Each
+ * shard's entries are in a hash, keyed by the key in the entry, and in a
+ * list ordered by last use for eviction.
+ */
+
+#include "ironbee_config_auto.h"
+
+#include <ironbee/kvstore_memory.h>
+
+#include "kvstore_private.h"
+
+#include <ironbee/hash.h>
+#include <ironbee/lock.h>
+#include <ironbee/mm_mpool.h>
+#include <ironbee/mm_mpool_lite.h>
+#include <ironbee/mpool.h>
+#include <ironbee/mpool_lite.h>
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Log 2 of the number of shards. */
+#define KVMEMORY_SHARDS_BITS 4
+
+/** Number of shards. */
+#define KVMEMORY_SHARDS (1 << KVMEMORY_SHARDS_BITS)
+
+/** An entry. */
+typedef struct kvmemory_entry_t kvmemory_entry_t;
+struct kvmemory_entry_t {
+    kvmemory_entry_t *prev;         /**< More recently used. */
+    kvmemory_entry_t *next;         /**< Less recently used. */
+    ib_time_t         expiration;   /**< Absolute expiration. */
+    ib_time_t         creation;     /**< Creation. */
+    size_t            key_length;   /**< Length of key. */
+    size_t            type_length;  /**< Length of type. */
+    size_t            value_length; /**< Length of value. */
+    uint8_t           data[];       /**< Key, type and value. */
+};
+
+/** A shard. */
+typedef struct {
+    ib_lock_t        *lock;    /**< Guards the shard. */
+    ib_hash_t        *hash;    /**< Key to kvmemory_entry_t. */
+    kvmemory_entry_t *head;    /**< Most recently used. */
+    kvmemory_entry_t *tail;    /**< Least recently used. */
+    size_t            entries; /**< Number of entries. */
+} kvmemory_shard_t;
+
+/** Server data. */
+typedef struct {
+    ib_mpool_t       *mp;          /**< Locks and hashes. */
+    size_t            max_entries; /**< Per shard; 0 for no limit. */
+    kvmemory_shard_t  shards[KVMEMORY_SHARDS]; /**< Shards. */
+} kvmemory_server_t;
+
+/**
+ * Find the shard of a key.
+ */
+static kvmemory_shard_t *kvmemory_shard(
+    kvmemory_server_t *server,
+    const uint8_t     *key,
+    size_t             key_length
+)
+{
+    /* Keys that differ in their last bytes differ only in the low bits,
+     * which each shard's hash uses.  The top bits of the product depend on
+     * all bits. */
+    uint32_t h = ib_hashfunc_djb2((const char *)key, key_length, 0, NULL);
+
+    h *= UINT32_C(2654435761);
+
+    return &server->shards[h >> (32 - KVMEMORY_SHARDS_BITS)];
+}
+
+/**
+ * Unlink @a entry from the use list of @a shard.
+ */
+static void kvmemory_unlink(kvmemory_shard_t *shard, kvmemory_entry_t *entry)
+{
+    if (entry->prev != NULL) {
+        entry->prev->next = entry->next;
+    }
+    else {
+        shard->head = entry->next;
+    }
+    if (entry->next != NULL) {
+        entry->next->prev = entry->prev;
+    }
+    else {
+        shard->tail = entry->prev;
+    }
+}
+
+/**
+ * Link @a entry as most recently used entry of @a shard.
+ */
+static void kvmemory_link(kvmemory_shard_t *shard, kvmemory_entry_t *entry)
+{
+    entry->prev = NULL;
+    entry->next = shard->head;
+    if (shard->head != NULL) {
+        shard->head->prev = entry;
+    }
+    else {
+        shard->tail = entry;
+    }
+    shard->head = entry;
+}
+
+/**
+ * Remove and free @a entry.
+ */
+static void kvmemory_drop(kvmemory_shard_t *shard, kvmemory_entry_t *entry)
+{
+    ib_hash_remove_ex(shard->hash, NULL, (const char *)entry->data,
+                      entry->key_length);
+    kvmemory_unlink(shard, entry);
+    --shard->entries;
+    free(entry);
+}
+
+/**
+ * Look up an entry, dropping it if expired.
+ *
+ * @returns Entry or NULL.
+ */
+static kvmemory_entry_t *kvmemory_find(
+    kvmemory_shard_t *shard,
+    const uint8_t    *key,
+    size_t            key_length,
+    ib_time_t         now
+)
+{
+    kvmemory_entry_t *entry;
+
+    if (
+        ib_hash_get_ex(
+            shard->hash, &entry, (const char *)key, key_length
+        ) != IB_OK
+    ) {
+        return NULL;
+    }
+    if (now > entry->expiration) {
+        kvmemory_drop(shard, entry);
+        return NULL;
+    }
+
+    return entry;
+}
+
+/**
+ * Merge policy that returns the first value, the value being set.
+ *
+ * @param[in] kvstore Key-value store.
+ * @param[in] key The key being considered.
+ * @param[in] values Array of @ref ib_kvstore_value_t pointers.
+ * @param[in] value_size The length of values.
+ * @param[out] resultant_value Pointer to values[0] if value_size > 0.
+ * @param[in,out] cbdata Context callback data.
+ * @returns IB_OK
+ */
+static ib_status_t kvmemory_merge_policy(
+    ib_kvstore_t            *kvstore,
+    const ib_kvstore_key_t  *key,
+    ib_kvstore_value_t     **values,
+    size_t                   value_size,
+    ib_kvstore_value_t     **resultant_value,
+    ib_kvstore_cbdata_t     *cbdata
+)
+{
+    assert(kvstore != NULL);
+    assert(resultant_value != NULL);
+
+    if (value_size > 0) {
+        *resultant_value = values[0];
+    }
+
+    return IB_OK;
+}
+
+static ib_status_t kvconnect(
+    ib_kvstore_t *kvstore,
+    ib_kvstore_cbdata_t *cbdata)
+{
+    assert(kvstore != NULL);
+
+    /* Nop. */
+
+    return IB_OK;
+}
+
+static ib_status_t kvdisconnect(
+    ib_kvstore_t *kvstore,
+    ib_kvstore_cbdata_t *cbdata)
+{
+    assert(kvstore != NULL);
+
+    /* Nop. */
+
+    return IB_OK;
+}
+
+/**
+ * Get implementation.
+ *
+ * @param[in] kvstore The key-value store.
+ * @param[in] mm Memory manager to allocate @a values out of.
+ * @param[in] key The key to fetch.
+ * @param[out] values A pointer to an array of pointers.
+ * @param[out] values_length The length of *values.
+ * @param[in,out] cbdata Callback data. Unused.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_ENOENT if @a key is not stored or expired.
+ * - IB_EALLOC on allocation failure.
+ */
+static ib_status_t kvget(
+    ib_kvstore_t             *kvstore,
+    ib_mm_t                   mm,
+    const ib_kvstore_key_t   *key,
+    ib_kvstore_value_t     ***values,
+    size_t                   *values_length,
+    ib_kvstore_cbdata_t      *cbdata
+)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+    assert(key != NULL);
+
+    kvmemory_server_t   *server = (kvmemory_server_t *)kvstore->server;
+    kvmemory_shard_t    *shard;
+    kvmemory_entry_t    *entry;
+    const uint8_t       *key_data;
+    size_t               key_length;
+    ib_kvstore_value_t  *value;
+    ib_kvstore_value_t **local_values;
+    char                *type;
+    uint8_t             *data;
+    ib_timeval_t         tv;
+    ib_status_t          rc;
+
+    ib_kvstore_key_get(key, &key_data, &key_length);
+    ib_clock_gettimeofday(&tv);
+    shard = kvmemory_shard(server, key_data, key_length);
+
+    rc = ib_lock_lock(shard->lock);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    entry = kvmemory_find(
+        shard, key_data, key_length, IB_CLOCK_TIMEVAL_TIME(tv)
+    );
+    if (entry == NULL) {
+        rc = IB_ENOENT;
+        goto cleanup;
+    }
+    kvmemory_unlink(shard, entry);
+    kvmemory_link(shard, entry);
+
+    rc = ib_kvstore_value_create(&value, mm);
+    if (rc != IB_OK) {
+        goto cleanup;
+    }
+    local_values = ib_mm_alloc(mm, sizeof(*local_values));
+    type = ib_mm_memdup_to_str(
+        mm, entry->data + entry->key_length, entry->type_length
+    );
+    data = ib_mm_memdup(
+        mm,
+        entry->data + entry->key_length + entry->type_length,
+        entry->value_length
+    );
+    if (
+        local_values == NULL ||
+        type == NULL ||
+        (data == NULL && entry->value_length > 0)
+    ) {
+        rc = IB_EALLOC;
+        goto cleanup;
+    }
+
+    ib_kvstore_value_type_set(value, type, entry->type_length);
+    ib_kvstore_value_value_set(value, data, entry->value_length);
+    ib_kvstore_value_expiration_set(value, entry->expiration);
+    ib_kvstore_value_creation_set(value, entry->creation);
+
+    local_values[0] = value;
+    *values         = local_values;
+    *values_length  = 1;
+
+cleanup:
+    ib_lock_unlock(shard->lock);
+
+    return rc;
+}
+
+/**
+ * Merge @a value with the stored value of @a entry.
+ *
+ * @param[in] kvstore Key-value store.
+ * @param[in] merge_policy Merge policy.
+ * @param[in] mm Memory manager for temporary values.
+ * @param[in] key Key.
+ * @param[in] entry Stored entry.
+ * @param[in] value Value being set.
+ * @param[in] now Now.
+ * @param[out] merged Merged value.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ * - Any error of @a merge_policy.
+ */
+static ib_status_t kvmemory_merge(
+    ib_kvstore_t                 *kvstore,
+    ib_kvstore_merge_policy_fn_t  merge_policy,
+    ib_mm_t                       mm,
+    const ib_kvstore_key_t       *key,
+    const kvmemory_entry_t       *entry,
+    ib_kvstore_value_t           *value,
+    ib_time_t                     now,
+    ib_kvstore_value_t          **merged
+)
+{
+    ib_kvstore_value_t *values[2];
+    ib_kvstore_value_t *stored;
+    ib_kvstore_value_t *result = NULL;
+    ib_status_t         rc;
+
+    rc = ib_kvstore_value_create(&stored, mm);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    ib_kvstore_value_type_set(
+        stored,
+        (const char *)entry->data + entry->key_length,
+        entry->type_length
+    );
+    ib_kvstore_value_value_set(
+        stored,
+        entry->data + entry->key_length + entry->type_length,
+        entry->value_length
+    );
+    ib_kvstore_value_expiration_set(stored, entry->expiration - now);
+    ib_kvstore_value_creation_set(stored, entry->creation);
+
+    values[0] = value;
+    values[1] = stored;
+    rc = merge_policy(
+        kvstore, key, values, 2, &result, kvstore->merge_policy_cbdata
+    );
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    *merged = (result != NULL) ? result : value;
+
+    return IB_OK;
+}
+
+/**
+ * Set implementation.
+ *
+ * @param[in] kvstore Key-value store.
+ * @param[in] merge_policy Merges @a value with a stored value.
+ * @param[in] key The key to set.
+ * @param[in] value The value to write.
+ * @param[in,out] cbdata Callback data. Unused.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ * - Any error of @a merge_policy.
+ */
+static ib_status_t kvset(
+    ib_kvstore_t                 *kvstore,
+    ib_kvstore_merge_policy_fn_t  merge_policy,
+    const ib_kvstore_key_t       *key,
+    ib_kvstore_value_t           *value,
+    ib_kvstore_cbdata_t          *cbdata
+)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+    assert(key != NULL);
+    assert(value != NULL);
+
+    kvmemory_server_t *server = (kvmemory_server_t *)kvstore->server;
+    kvmemory_shard_t  *shard;
+    kvmemory_entry_t  *entry;
+    kvmemory_entry_t  *new_entry;
+    ib_mpool_lite_t   *mp_tmp  = NULL;
+    const uint8_t     *key_data;
+    size_t             key_length;
+    const char        *type;
+    size_t             type_length;
+    const uint8_t     *data;
+    size_t             data_length;
+    ib_time_t          expiration;
+    ib_timeval_t       tv;
+    ib_time_t          now;
+    ib_status_t        rc;
+
+    ib_kvstore_key_get(key, &key_data, &key_length);
+    ib_clock_gettimeofday(&tv);
+    now = IB_CLOCK_TIMEVAL_TIME(tv);
+    shard = kvmemory_shard(server, key_data, key_length);
+
+    rc = ib_lock_lock(shard->lock);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    entry = kvmemory_find(shard, key_data, key_length, now);
+    if (
+        entry != NULL &&
+        merge_policy != NULL &&
+        merge_policy != kvmemory_merge_policy
+    ) {
+        rc = ib_mpool_lite_create(&mp_tmp);
+        if (rc != IB_OK) {
+            goto cleanup;
+        }
+        rc = kvmemory_merge(
+            kvstore, merge_policy, ib_mm_mpool_lite(mp_tmp),
+            key, entry, value, now, &value
+        );
+        if (rc != IB_OK) {
+            goto cleanup;
+        }
+    }
+
+    ib_kvstore_value_type_get(value, &type, &type_length);
+    ib_kvstore_value_value_get(value, &data, &data_length);
+    expiration = ib_kvstore_value_expiration_get(value);
+    if (expiration > 0) {
+        expiration += now;
+    }
+
+    new_entry = malloc(
+        sizeof(*new_entry) + key_length + type_length + data_length
+    );
+    if (new_entry == NULL) {
+        rc = IB_EALLOC;
+        goto cleanup;
+    }
+    new_entry->expiration   = expiration;
+    new_entry->creation     = now;
+    new_entry->key_length   = key_length;
+    new_entry->type_length  = type_length;
+    new_entry->value_length = data_length;
+    memcpy(new_entry->data, key_data, key_length);
+    if (type_length > 0) {
+        memcpy(new_entry->data + key_length, type, type_length);
+    }
+    if (data_length > 0) {
+        memcpy(new_entry->data + key_length + type_length, data, data_length);
+    }
+
+    /* The merged value may refer to entry, so it goes only now. */
+    if (entry != NULL) {
+        kvmemory_drop(shard, entry);
+    }
+    else if (server->max_entries > 0 && shard->entries >= server->max_entries) {
+        kvmemory_drop(shard, shard->tail);
+    }
+
+    rc = ib_hash_set_ex(
+        shard->hash, (const char *)new_entry->data, key_length, new_entry
+    );
+    if (rc != IB_OK) {
+        free(new_entry);
+        goto cleanup;
+    }
+    kvmemory_link(shard, new_entry);
+    ++shard->entries;
+
+cleanup:
+    ib_lock_unlock(shard->lock);
+    if (mp_tmp != NULL) {
+        ib_mpool_lite_destroy(mp_tmp);
+    }
+
+    return rc;
+}
+
+/**
+ * Remove implementation.
+ *
+ * @param[in] kvstore Store.
+ * @param[in] key Key.
+ * @param[in,out] cbdata Callback data. Unused.
+ *
+ * @returns IB_OK or an error locking.
+ */
+static ib_status_t kvremove(
+    ib_kvstore_t           *kvstore,
+    const ib_kvstore_key_t *key,
+    ib_kvstore_cbdata_t    *cbdata)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+    assert(key != NULL);
+
+    kvmemory_server_t *server = (kvmemory_server_t *)kvstore->server;
+    kvmemory_shard_t  *shard;
+    kvmemory_entry_t  *entry;
+    const uint8_t     *key_data;
+    size_t             key_length;
+    ib_status_t        rc;
+
+    ib_kvstore_key_get(key, &key_data, &key_length);
+    shard = kvmemory_shard(server, key_data, key_length);
+
+    rc = ib_lock_lock(shard->lock);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    if (
+        ib_hash_get_ex(
+            shard->hash, &entry, (const char *)key_data, key_length
+        ) == IB_OK
+    ) {
+        kvmemory_drop(shard, entry);
+    }
+    ib_lock_unlock(shard->lock);
+
+    return IB_OK;
+}
+
+/**
+ * Destroy any allocated elements of the kvstore structure.
+ *
+ * @param[out] kvstore to be destroyed. All entries are freed.
+ * @param[in] cbdata Unused.
+ */
+static void kvdestroy(ib_kvstore_t* kvstore, ib_kvstore_cbdata_t *cbdata)
+{
+    assert(kvstore != NULL);
+
+    kvmemory_server_t *server = (kvmemory_server_t *)kvstore->server;
+
+    for (size_t i = 0; i < KVMEMORY_SHARDS; ++i) {
+        kvmemory_entry_t *entry = server->shards[i].head;
+
+        while (entry != NULL) {
+            kvmemory_entry_t *next = entry->next;
+
+            free(entry);
+            entry = next;
+        }
+    }
+    ib_mpool_destroy(server->mp);
+    free(server);
+    kvstore->server = NULL;
+}
+
+ib_status_t ib_kvstore_memory_init(
+    ib_kvstore_t *kvstore,
+    size_t        max_entries
+)
+{
+    assert(kvstore != NULL);
+
+    kvmemory_server_t *server;
+    ib_mm_t            mm;
+    ib_status_t        rc;
+
+    ib_kvstore_init(kvstore);
+
+    server = calloc(1, sizeof(*server));
+    if (server == NULL) {
+        return IB_EALLOC;
+    }
+
+    rc = ib_mpool_create(&server->mp, "kvstore_memory", NULL);
+    if (rc != IB_OK) {
+        free(server);
+        return rc;
+    }
+    mm = ib_mm_mpool(server->mp);
+
+    if (max_entries > 0) {
+        server->max_entries = max_entries / KVMEMORY_SHARDS;
+        if (server->max_entries == 0) {
+            server->max_entries = 1;
+        }
+    }
+
+    for (size_t i = 0; i < KVMEMORY_SHARDS; ++i) {
+        kvmemory_shard_t *shard = &server->shards[i];
+
+        rc = ib_lock_create(&shard->lock, mm);
+        if (rc != IB_OK) {
+            goto failure;
+        }
+        rc = ib_hash_create_ex(
+            &shard->hash,
+            mm,
+            64,
+            IB_HASH_LAYOUT_FLAT,
+            ib_hashfunc_djb2, NULL,
+            ib_hashequal_default, NULL
+        );
+        if (rc != IB_OK) {
+            goto failure;
+        }
+    }
+
+    kvstore->server = (ib_kvstore_server_t *)server;
+    kvstore->get = kvget;
+    kvstore->set = kvset;
+    kvstore->remove = kvremove;
+    kvstore->connect = kvconnect;
+    kvstore->disconnect = kvdisconnect;
+    kvstore->destroy = kvdestroy;
+    kvstore->default_merge_policy = kvmemory_merge_policy;
+
+    kvstore->malloc_cbdata = NULL;
+    kvstore->free_cbdata = NULL;
+    kvstore->connect_cbdata = NULL;
+    kvstore->disconnect_cbdata = NULL;
+    kvstore->get_cbdata = NULL;
+    kvstore->set_cbdata = NULL;
+    kvstore->remove_cbdata = NULL;
+    kvstore->merge_policy_cbdata = NULL;
+    kvstore->destroy_cbdata = NULL;
+
+    return IB_OK;
+
+failure:
+    ib_mpool_destroy(server->mp);
+    free(server);
+    return rc;
+}
+
+size_t ib_kvstore_memory_entries(ib_kvstore_t *kvstore)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+
+    kvmemory_server_t *server  = (kvmemory_server_t *)kvstore->server;
+    size_t             entries = 0;
+
+    for (size_t i = 0; i < KVMEMORY_SHARDS; ++i) {
+        kvmemory_shard_t *shard = &server->shards[i];
+
+        if (ib_lock_lock(shard->lock) == IB_OK) {
+            entries += shard->entries;
+            ib_lock_unlock(shard->lock);
+        }
+    }
+
+    return entries;
+}
+
+size_t ib_kvstore_memory_footprint(ib_kvstore_t *kvstore)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+
+    kvmemory_server_t *server = (kvmemory_server_t *)kvstore->server;
+    size_t             bytes  = 0;
+    size_t             locked;
+
+    /* A set may grow a hash in the pool, so hold every shard. */
+    for (locked = 0; locked < KVMEMORY_SHARDS; ++locked) {
+        const kvmemory_shard_t *shard = &server->shards[locked];
+
+        if (ib_lock_lock(shard->lock) != IB_OK) {
+            break;
+        }
+        for (
+            const kvmemory_entry_t *entry = shard->head;
+            entry != NULL;
+            entry = entry->next
+        ) {
+            bytes += sizeof(*entry) +
+                     entry->key_length +
+                     entry->type_length +
+                     entry->value_length;
+        }
+    }
+
+    if (locked == KVMEMORY_SHARDS) {
+        bytes += ib_mpool_footprint(server->mp);
+    }
+
+    while (locked > 0) {
+        ib_lock_unlock(server->shards[--locked].lock);
+    }
+
+    return bytes;
+}
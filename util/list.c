@@ -29,7 +29,104 @@
 
 #include <ironbee/list.h>
 
+#include <ironbee/mm_mpool.h>
+
 #include <assert.h>
+#include <string.h>
+
+/**
+ * The largest number of nodes allocated at once.
+ *
+ * Chunks grow with the list, 1, 1, 2, 4, ... up to this, so short lists do
+ * not waste memory.
+ */
+#define IB_LIST_CHUNK_MAX 16
+
+/**
+ * Allocate @a n spare nodes for @a list in one chunk.
+ *
+ * Remaining spare nodes are discarded.  A single node comes from the fixed
+ * size allocator, so it may be one released by another list.
+ *
+ * @param[in] list The list.
+ * @param[in] n Number of nodes.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EALLOC On allocation failure.
+ */
+static ib_status_t list_node_reserve(ib_list_t *list, size_t n)
+{
+    ib_list_node_t *chunk;
+
+    if (n == 1) {
+        chunk = (ib_list_node_t *)ib_mm_alloc_fixed(list->mm, sizeof(*chunk));
+        if (chunk != NULL) {
+            memset(chunk, 0, sizeof(*chunk));
+        }
+    }
+    else {
+        chunk = (ib_list_node_t *)ib_mm_calloc(list->mm, n, sizeof(*chunk));
+    }
+    if (chunk == NULL) {
+        return IB_EALLOC;
+    }
+
+    list->spare   = chunk;
+    list->nspare  = n;
+    list->nalloc += n;
+
+    return IB_OK;
+}
+
+/**
+ * Take a zeroed node holding @a data from the spare nodes of @a list.
+ *
+ * @param[in] list The list.
+ * @param[in] data The node data.
+ *
+ * @returns The node or NULL on allocation failure.
+ */
+static ib_list_node_t *list_node_create(ib_list_t *list, void *data)
+{
+    ib_list_node_t *node;
+
+    if (list->nspare == 0) {
+        size_t n = list->nalloc;
+
+        if (n == 0) {
+            n = 1;
+        }
+        else if (n > IB_LIST_CHUNK_MAX) {
+            n = IB_LIST_CHUNK_MAX;
+        }
+
+        if (list_node_reserve(list, n) != IB_OK) {
+            return NULL;
+        }
+    }
+
+    node = list->spare;
+    ++(list->spare);
+    --(list->nspare);
+    ++(list->generation);
+
+    node->data = data;
+
+    return node;
+}
+
+/**
+ * Release a node removed from @a list for reuse.
+ *
+ * @param[in] list The list.
+ * @param[in] node The node.
+ */
+static void list_node_release(ib_list_t *list, ib_list_node_t *node)
+{
+    ++(list->generation);
+    ib_mm_free_fixed(list->mm, node, sizeof(*node));
+}
 
 ib_status_t ib_list_create(ib_list_t **plist, ib_mm_t mm)
 {
@@ -53,6 +150,14 @@ ib_status_t ib_list_copy_nodes(const ib_list_t *src_list,
     ib_status_t rc;
     const ib_list_node_t *node;
 
+    /* Copy into a single chunk. */
+    if (dest_list->nspare < src_list->nelts) {
+        rc = list_node_reserve(dest_list, src_list->nelts);
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
     IB_LIST_LOOP_CONST(src_list, node) {
         assert(node->data != NULL);
         rc = ib_list_push(dest_list, node->data);
@@ -89,13 +194,10 @@ ib_status_t ib_list_copy(const ib_list_t *src,
 
 ib_status_t ib_list_push(ib_list_t *list, void *data)
 {
-    ib_list_node_t *node = (ib_list_node_t *)ib_mm_calloc(list->mm,
-        1, sizeof(*node)
-    );
+    ib_list_node_t *node = list_node_create(list, data);
     if (node == NULL) {
         return IB_EALLOC;
     }
-    node->data = data;
 
     if (list->nelts == 0) {
         IB_LIST_GEN_NODE_INSERT_INITIAL(list, node);
@@ -116,23 +218,23 @@ ib_status_t ib_list_pop(ib_list_t *list, void *pdata)
         return IB_ENOENT;
     }
 
+    ib_list_node_t *node = list->tail;
+
     if (pdata != NULL) {
-        *(void **)pdata = IB_LIST_GEN_NODE_DATA(list->tail);
+        *(void **)pdata = IB_LIST_GEN_NODE_DATA(node);
     }
     IB_LIST_GEN_NODE_REMOVE_LAST(list);
+    list_node_release(list, node);
 
     return IB_OK;
 }
 
 ib_status_t ib_list_unshift(ib_list_t *list, void *data)
 {
-    ib_list_node_t *node = (ib_list_node_t *)ib_mm_calloc(list->mm,
-        1, sizeof(*node)
-    );
+    ib_list_node_t *node = list_node_create(list, data);
     if (node == NULL) {
         return IB_EALLOC;
     }
-    node->data = data;
 
     if (list->nelts == 0) {
         IB_LIST_GEN_NODE_INSERT_INITIAL(list, node);
@@ -153,10 +255,13 @@ ib_status_t ib_list_shift(ib_list_t *list, void *pdata)
         return IB_ENOENT;
     }
 
+    ib_list_node_t *node = list->head;
+
     if (pdata != NULL) {
-        *(void **)pdata = IB_LIST_GEN_NODE_DATA(list->head);
+        *(void **)pdata = IB_LIST_GEN_NODE_DATA(node);
     }
     IB_LIST_GEN_NODE_REMOVE_FIRST(list);
+    list_node_release(list, node);
 
     return IB_OK;
 }
@@ -165,6 +270,7 @@ void ib_list_clear(ib_list_t *list)
 {
     list->nelts = 0;
     list->head = list->tail = NULL;
+    ++(list->generation);
     return;
 }
 
@@ -173,6 +279,11 @@ size_t ib_list_elements(const ib_list_t *list)
     return list->nelts;
 }
 
+size_t ib_list_generation(const ib_list_t *list)
+{
+    return list->generation;
+}
+
 ib_list_node_t *ib_list_first(ib_list_t *list)
 {
     return IB_LIST_GEN_FIRST(list);
@@ -216,6 +327,7 @@ const ib_list_node_t *ib_list_node_prev_const(const ib_list_node_t *node)
 void ib_list_node_remove(ib_list_t *list, ib_list_node_t *node)
 {
     IB_LIST_GEN_NODE_REMOVE(list, node);
+    list_node_release(list, node);
     return;
 }
 
@@ -230,13 +342,16 @@ const void *ib_list_node_data_const(const ib_list_node_t *node)
 }
 
 void ib_list_node_data_set(
+    ib_list_t      *list,
     ib_list_node_t *node,
     void           *data
 )
 {
+    assert(list != NULL);
     assert(node != NULL);
 
     node->data = data;
+    ++list->generation;
 }
 
 ib_status_t ib_list_insert(ib_list_t *list, void *data, const size_t index)
@@ -251,12 +366,10 @@ ib_status_t ib_list_insert(ib_list_t *list, void *data, const size_t index)
     }
 
     /* Create the new node. */
-    insert_node =
-        (ib_list_node_t *)ib_mm_calloc(list->mm, 1, sizeof(*insert_node));
+    insert_node = list_node_create(list, data);
     if (insert_node == NULL) {
         return IB_EALLOC;
     }
-    insert_node->data = data;
 
     /* If the input is valid and the list is size 0, initialize it. */
     if (IB_LIST_GEN_ELEMENTS(list) == 0) {
@@ -25,6 +25,40 @@
 
 #include <ironbee/lock.h>
 
+#include <assert.h>
+#include <errno.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * Number of attempts a spin lock waiter makes before yielding.
+ */
+#define IB_SPINLOCK_SPINS 128
+
+/**
+ * Hint to the processor that this is a spin-wait loop.
+ */
+#if defined(__i386__) || defined(__x86_64__)
+#define IB_SPIN_PAUSE() __builtin_ia32_pause()
+#else
+#define IB_SPIN_PAUSE() do { } while (0)
+#endif
+
+struct ib_rwlock_t {
+    pthread_rwlock_t rwlock;    /**< The lock. */
+    bool             enabled;   /**< Maintain counters. */
+    ib_lock_stats_t  read;      /**< Counters of read acquisitions. */
+    ib_lock_stats_t  write;     /**< Counters of write acquisitions. */
+};
+
+struct ib_spinlock_t {
+    int              locked;    /**< Non-zero while held. */
+    bool             enabled;   /**< Maintain counters. */
+    ib_lock_stats_t  stats;     /**< Counters. */
+};
+
 static void lock_destroy(void *cbdata)
 {
     ib_lock_t *lock = (ib_lock_t *)cbdata;
@@ -107,6 +141,19 @@ ib_status_t ib_lock_lock(ib_lock_t *lock)
     return IB_OK;
 }
 
+ib_status_t ib_lock_trylock(ib_lock_t *lock)
+{
+    int rc = pthread_mutex_trylock(lock);
+    if (rc == EBUSY) {
+        return IB_DECLINED;
+    }
+    if (rc != 0) {
+        return IB_EUNKNOWN;
+    }
+
+    return IB_OK;
+}
+
 ib_status_t ib_lock_unlock(ib_lock_t *lock)
 {
     int rc = pthread_mutex_unlock(lock);
@@ -116,3 +163,400 @@ ib_status_t ib_lock_unlock(ib_lock_t *lock)
 
     return IB_OK;
 }
+
+static void cond_destroy(void *cbdata)
+{
+    pthread_cond_destroy((ib_cond_t *)cbdata);
+}
+
+ib_status_t ib_cond_create(ib_cond_t **cond, ib_mm_t mm)
+{
+    ib_cond_t *c;
+    int        rc;
+
+    c = ib_mm_alloc(mm, sizeof(*c));
+    if (c == NULL) {
+        return IB_EALLOC;
+    }
+
+    rc = pthread_cond_init(c, NULL);
+    if (rc != 0) {
+        return IB_EALLOC;
+    }
+
+    rc = ib_mm_register_cleanup(mm, &cond_destroy, c);
+    if (rc != 0) {
+        return IB_EOTHER;
+    }
+
+    *cond = c;
+
+    return IB_OK;
+}
+
+ib_status_t ib_cond_wait(ib_cond_t *cond, ib_lock_t *lock)
+{
+    int rc = pthread_cond_wait(cond, lock);
+    if (rc != 0) {
+        return IB_EUNKNOWN;
+    }
+
+    return IB_OK;
+}
+
+ib_status_t ib_cond_broadcast(ib_cond_t *cond)
+{
+    int rc = pthread_cond_broadcast(cond);
+    if (rc != 0) {
+        return IB_EUNKNOWN;
+    }
+
+    return IB_OK;
+}
+
+/**
+ * Current monotonic time in nanoseconds.
+ */
+static uint64_t lock_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * Record an acquisition in @a stats.
+ *
+ * @param[in] stats The counters.
+ * @param[in] start Time waiting started or 0 if the acquisition was not
+ *            contended.
+ */
+static void lock_stats_record(ib_lock_stats_t *stats, uint64_t start)
+{
+    __atomic_add_fetch(&stats->acquisitions, 1, __ATOMIC_RELAXED);
+    if (start != 0) {
+        __atomic_add_fetch(&stats->contended, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(
+            &stats->wait_ns,
+            lock_now_ns() - start,
+            __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * Copy @a src to @a dst.
+ *
+ * @param[out] dst Destination. May be NULL.
+ * @param[in] src Source.
+ */
+static void lock_stats_copy(ib_lock_stats_t *dst, const ib_lock_stats_t *src)
+{
+    if (dst != NULL) {
+        dst->acquisitions =
+            __atomic_load_n(&src->acquisitions, __ATOMIC_RELAXED);
+        dst->contended = __atomic_load_n(&src->contended, __ATOMIC_RELAXED);
+        dst->wait_ns   = __atomic_load_n(&src->wait_ns, __ATOMIC_RELAXED);
+    }
+}
+
+static void rwlock_destroy(void *cbdata)
+{
+    ib_rwlock_t *lock = (ib_rwlock_t *)cbdata;
+
+    if (lock == NULL) {
+        return;
+    }
+
+    pthread_rwlock_destroy(&(lock->rwlock));
+}
+
+/**
+ * Initialize @a lock.
+ *
+ * @param[in] lock The lock.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EALLOC On failure.
+ */
+static ib_status_t rwlock_init(ib_rwlock_t *lock)
+{
+    memset(lock, 0, sizeof(*lock));
+
+    if (pthread_rwlock_init(&(lock->rwlock), NULL) != 0) {
+        return IB_EALLOC;
+    }
+
+    return IB_OK;
+}
+
+ib_status_t ib_rwlock_create(ib_rwlock_t **lock, ib_mm_t mm)
+{
+    assert(lock != NULL);
+
+    ib_rwlock_t *l;
+    ib_status_t  rc;
+
+    l = ib_mm_alloc(mm, sizeof(*l));
+    if (l == NULL) {
+        return IB_EALLOC;
+    }
+
+    rc = rwlock_init(l);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    rc = ib_mm_register_cleanup(mm, &rwlock_destroy, l);
+    if (rc != IB_OK) {
+        return IB_EOTHER;
+    }
+
+    *lock = l;
+
+    return IB_OK;
+}
+
+ib_status_t ib_rwlock_create_malloc(ib_rwlock_t **lock)
+{
+    assert(lock != NULL);
+
+    ib_rwlock_t *l;
+    ib_status_t  rc;
+
+    l = malloc(sizeof(*l));
+    if (l == NULL) {
+        return IB_EALLOC;
+    }
+
+    rc = rwlock_init(l);
+    if (rc != IB_OK) {
+        free(l);
+        return rc;
+    }
+
+    *lock = l;
+
+    return IB_OK;
+}
+
+void ib_rwlock_destroy_malloc(ib_rwlock_t *lock)
+{
+    if (lock != NULL) {
+        rwlock_destroy(lock);
+
+        free(lock);
+    }
+}
+
+ib_status_t ib_rwlock_rdlock(ib_rwlock_t *lock)
+{
+    assert(lock != NULL);
+
+    uint64_t start = 0;
+    int      rc;
+
+    if (! lock->enabled) {
+        rc = pthread_rwlock_rdlock(&(lock->rwlock));
+        return (rc == 0) ? IB_OK : IB_EUNKNOWN;
+    }
+
+    rc = pthread_rwlock_tryrdlock(&(lock->rwlock));
+    if (rc == EBUSY) {
+        start = lock_now_ns();
+        rc = pthread_rwlock_rdlock(&(lock->rwlock));
+    }
+    if (rc != 0) {
+        return IB_EUNKNOWN;
+    }
+
+    lock_stats_record(&(lock->read), start);
+
+    return IB_OK;
+}
+
+ib_status_t ib_rwlock_wrlock(ib_rwlock_t *lock)
+{
+    assert(lock != NULL);
+
+    uint64_t start = 0;
+    int      rc;
+
+    if (! lock->enabled) {
+        rc = pthread_rwlock_wrlock(&(lock->rwlock));
+        return (rc == 0) ? IB_OK : IB_EUNKNOWN;
+    }
+
+    rc = pthread_rwlock_trywrlock(&(lock->rwlock));
+    if (rc == EBUSY) {
+        start = lock_now_ns();
+        rc = pthread_rwlock_wrlock(&(lock->rwlock));
+    }
+    if (rc != 0) {
+        return IB_EUNKNOWN;
+    }
+
+    lock_stats_record(&(lock->write), start);
+
+    return IB_OK;
+}
+
+ib_status_t ib_rwlock_unlock(ib_rwlock_t *lock)
+{
+    assert(lock != NULL);
+
+    int rc = pthread_rwlock_unlock(&(lock->rwlock));
+    if (rc != 0) {
+        return IB_EUNKNOWN;
+    }
+
+    return IB_OK;
+}
+
+void ib_rwlock_stats_enable(ib_rwlock_t *lock, bool enable)
+{
+    assert(lock != NULL);
+
+    if (enable) {
+        memset(&(lock->read), 0, sizeof(lock->read));
+        memset(&(lock->write), 0, sizeof(lock->write));
+    }
+    lock->enabled = enable;
+}
+
+void ib_rwlock_stats(
+    const ib_rwlock_t *lock,
+    ib_lock_stats_t   *read,
+    ib_lock_stats_t   *write
+)
+{
+    assert(lock != NULL);
+
+    lock_stats_copy(read, &(lock->read));
+    lock_stats_copy(write, &(lock->write));
+}
+
+ib_status_t ib_spinlock_create(ib_spinlock_t **lock, ib_mm_t mm)
+{
+    assert(lock != NULL);
+
+    ib_spinlock_t *l;
+
+    l = ib_mm_calloc(mm, 1, sizeof(*l));
+    if (l == NULL) {
+        return IB_EALLOC;
+    }
+
+    *lock = l;
+
+    return IB_OK;
+}
+
+ib_status_t ib_spinlock_create_malloc(ib_spinlock_t **lock)
+{
+    assert(lock != NULL);
+
+    ib_spinlock_t *l;
+
+    l = calloc(1, sizeof(*l));
+    if (l == NULL) {
+        return IB_EALLOC;
+    }
+
+    *lock = l;
+
+    return IB_OK;
+}
+
+void ib_spinlock_destroy_malloc(ib_spinlock_t *lock)
+{
+    free(lock);
+}
+
+/**
+ * Make one attempt to take @a lock.
+ *
+ * @param[in] lock The lock.
+ *
+ * @returns True if the lock was taken.
+ */
+static bool spinlock_try(ib_spinlock_t *lock)
+{
+    return __atomic_load_n(&(lock->locked), __ATOMIC_RELAXED) == 0 &&
+           __atomic_exchange_n(&(lock->locked), 1, __ATOMIC_ACQUIRE) == 0;
+}
+
+void ib_spinlock_lock(ib_spinlock_t *lock)
+{
+    assert(lock != NULL);
+
+    uint64_t start = 0;
+    size_t   spins = 0;
+
+    if (! spinlock_try(lock)) {
+        if (lock->enabled) {
+            start = lock_now_ns();
+        }
+
+        /* Spin briefly as the holder is expected to be running, then
+         * give up the processor between attempts. */
+        do {
+            if (spins < IB_SPINLOCK_SPINS) {
+                ++spins;
+                IB_SPIN_PAUSE();
+            }
+            else {
+                sched_yield();
+            }
+        } while (! spinlock_try(lock));
+    }
+
+    if (lock->enabled) {
+        lock_stats_record(&(lock->stats), start);
+    }
+}
+
+ib_status_t ib_spinlock_trylock(ib_spinlock_t *lock)
+{
+    assert(lock != NULL);
+
+    if (! spinlock_try(lock)) {
+        return IB_DECLINED;
+    }
+
+    if (lock->enabled) {
+        lock_stats_record(&(lock->stats), 0);
+    }
+
+    return IB_OK;
+}
+
+void ib_spinlock_unlock(ib_spinlock_t *lock)
+{
+    assert(lock != NULL);
+
+    __atomic_store_n(&(lock->locked), 0, __ATOMIC_RELEASE);
+}
+
+void ib_spinlock_stats_enable(ib_spinlock_t *lock, bool enable)
+{
+    assert(lock != NULL);
+
+    if (enable) {
+        memset(&(lock->stats), 0, sizeof(lock->stats));
+    }
+    lock->enabled = enable;
+}
+
+void ib_spinlock_stats(
+    const ib_spinlock_t *lock,
+    ib_lock_stats_t     *stats
+)
+{
+    assert(lock != NULL);
+    assert(stats != NULL);
+
+    lock_stats_copy(stats, &(lock->stats));
+}
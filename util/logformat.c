@@ -30,6 +30,7 @@
 #include <ironbee/logformat.h>
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 
 typedef enum {
     STATE_NORMAL,
@@ -147,6 +148,50 @@ static ib_status_t create_item_field(ib_logformat_t *lf,
     return IB_OK;
 }
 
+/**
+ * Compile the items of @a lf into @a lf->ops.
+ *
+ * @param[in] lf Logformat.
+ *
+ * @returns IB_OK or IB_EALLOC.
+ */
+static ib_status_t compile_ops(ib_logformat_t *lf)
+{
+    assert(lf != NULL);
+
+    const ib_list_node_t *node;
+    ib_logformat_op_t    *op;
+    size_t                n = ib_list_elements(lf->items);
+
+    lf->ops = ib_mm_alloc(lf->mm, (n == 0 ? 1 : n) * sizeof(*lf->ops));
+    if (lf->ops == NULL) {
+        return IB_EALLOC;
+    }
+    lf->num_ops = n;
+
+    op = lf->ops;
+    IB_LIST_LOOP_CONST(lf->items, node) {
+        const ib_logformat_item_t *item =
+            (const ib_logformat_item_t *)ib_list_node_data_const(node);
+
+        if (item->itype == item_type_literal) {
+            op->field = NULL;
+            op->len   = item->item.literal.len;
+            op->str   = op->len <= IB_LOGFORMAT_MAX_SHORT_LITERAL ?
+                        item->item.literal.buf.short_str :
+                        item->item.literal.buf.str;
+        }
+        else {
+            op->field = &(item->item.field);
+            op->str   = NULL;
+            op->len   = 0;
+        }
+        ++op;
+    }
+
+    return IB_OK;
+}
+
 ib_status_t ib_logformat_parse(ib_logformat_t *lf,
                                const char *format)
 {
@@ -264,6 +309,11 @@ ib_status_t ib_logformat_parse(ib_logformat_t *lf,
 
     /* Add any literal string we might be in the middle of */
     rc = create_item_literal(lf, literal_buf, literal_cur);
+    if (rc != IB_OK) {
+        goto cleanup;
+    }
+
+    rc = compile_ops(lf);
 
 cleanup:
     if (literal_buf != NULL) {
@@ -272,60 +322,70 @@ cleanup:
     return rc;
 }
 
-ib_status_t ib_logformat_format(const ib_logformat_t *lf,
-                                char *line,
-                                size_t line_size,
-                                size_t *line_len,
-                                ib_logformat_fn_t fn,
-                                void *fndata)
+/**
+ * Format a line from the compiled operations of @a lf.
+ *
+ * Exactly one of @a fn and @a len_fn is non-NULL.
+ *
+ * @param[in] lf Logformat.
+ * @param[in] line Line buffer.
+ * @param[in] line_size Size of @a line.
+ * @param[out] line_len Length of data written to @a line.
+ * @param[in] fn Field callback without lengths.
+ * @param[in] len_fn Field callback with lengths.
+ * @param[in] fndata Callback data.
+ *
+ * @returns IB_OK, IB_ETRUNC or an error from the callback.
+ */
+static ib_status_t logformat_run(const ib_logformat_t  *lf,
+                                 char                  *line,
+                                 size_t                 line_size,
+                                 size_t                *line_len,
+                                 ib_logformat_fn_t      fn,
+                                 ib_logformat_len_fn_t  len_fn,
+                                 void                  *fndata)
 {
     assert(lf != NULL);
     assert(line != NULL);
+    assert(line_size > 0);
     assert(line_len != NULL);
-    assert(fn != NULL);
+    assert((fn == NULL) != (len_fn == NULL));
 
     ib_status_t rc;
-    const ib_list_node_t *node;
     size_t line_remain = line_size - 1;
     char *line_cur = line;
     bool truncated = false;
 
-    IB_LIST_LOOP_CONST(lf->items, node) {
-        const ib_logformat_item_t *item =
-            (const ib_logformat_item_t *)ib_list_node_data_const(node);
+    for (size_t i = 0; i < lf->num_ops; ++i) {
+        const ib_logformat_op_t *op = &(lf->ops[i]);
         const char *str;
         size_t len;
 
-        switch (item->itype) {
-        case item_type_literal:
-            len = item->item.literal.len;
-            if (len <= IB_LOGFORMAT_MAX_SHORT_LITERAL) {
-                str = item->item.literal.buf.short_str;
-            }
-            else {
-                str = item->item.literal.buf.str;
+        if (op->field == NULL) {
+            str = op->str;
+            len = op->len;
+        }
+        else if (len_fn != NULL) {
+            rc = len_fn(lf, op->field, fndata, &str, &len);
+            if (rc != IB_OK) {
+                return rc;
             }
-            break;
-
-        case item_type_format:
-            rc = fn(lf, &(item->item.field), fndata, &str);
+        }
+        else {
+            rc = fn(lf, op->field, fndata, &str);
             if (rc != IB_OK) {
                 return rc;
             }
-            len = strlen(str);
-            break;
-
-        default:
-            assert(0);
-            return IB_EINVAL;
+            /* Only as much as could fit, plus one to detect truncation. */
+            len = strnlen(str, line_remain + 1);
         }
 
         /* Copy into buffer */
-        strncpy(line_cur, str, line_remain);
         if (len > line_remain) {
             len = line_remain;
             truncated = true;
         }
+        memcpy(line_cur, str, len);
         line_cur += len;
         line_remain -= len;
 
@@ -342,3 +402,27 @@ ib_status_t ib_logformat_format(const ib_logformat_t *lf,
 
     return truncated ? IB_ETRUNC : IB_OK;
 }
+
+ib_status_t ib_logformat_format(const ib_logformat_t *lf,
+                                char *line,
+                                size_t line_size,
+                                size_t *line_len,
+                                ib_logformat_fn_t fn,
+                                void *fndata)
+{
+    assert(fn != NULL);
+
+    return logformat_run(lf, line, line_size, line_len, fn, NULL, fndata);
+}
+
+ib_status_t ib_logformat_write(const ib_logformat_t *lf,
+                               char *line,
+                               size_t line_size,
+                               size_t *line_len,
+                               ib_logformat_len_fn_t fn,
+                               void *fndata)
+{
+    assert(fn != NULL);
+
+    return logformat_run(lf, line, line_size, line_len, NULL, fn, fndata);
+}
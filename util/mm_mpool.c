@@ -58,3 +58,19 @@ ib_mm_t ib_mm_mpool(ib_mpool_t *mp)
     };
     return mm;
 }
+
+void *ib_mm_alloc_fixed(ib_mm_t mm, size_t size)
+{
+    if (mm.alloc == &ib_mm_mpool_alloc) {
+        return ib_mpool_alloc_fixed((ib_mpool_t *)mm.alloc_data, size);
+    }
+
+    return ib_mm_alloc(mm, size);
+}
+
+void ib_mm_free_fixed(ib_mm_t mm, void *ptr, size_t size)
+{
+    if (mm.alloc == &ib_mm_mpool_alloc) {
+        ib_mpool_free_fixed((ib_mpool_t *)mm.alloc_data, ptr, size);
+    }
+}
@@ -23,6 +23,8 @@
 
 #include "ironbee_config_auto.h"
 
+#include "string_scan_private.h"
+
 #include <ironbee/decode.h>
 #include <ironbee/path.h>
 #include <ironbee/string.h>
@@ -31,6 +33,8 @@
 #include <assert.h>
 #include <ctype.h>
 #include <libgen.h>
+#include <limits.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -79,77 +83,82 @@ static uint8_t x2c(const uint8_t *ptr)
     return digit;
 }
 
-ib_status_t ib_util_decode_url(
-    const uint8_t  *data_in,
-    size_t          dlen_in,
-    uint8_t        *data_out,
-    size_t         *dlen_out
-)
+/**
+ * Append @a len bytes at @a src to @a out.
+ *
+ * @a out may be @a src or before it, as when decoding in place.
+ *
+ * @param[in] out Output position.
+ * @param[in] src Bytes to append.
+ * @param[in] len Length of @a src.
+ *
+ * @returns Output position after the appended bytes.
+ */
+static inline uint8_t *copy_run(uint8_t *out, const uint8_t *src, size_t len)
 {
-    assert(data_in != NULL);
-    assert(data_out != NULL);
-    assert(dlen_out != NULL);
-
-    uint8_t *out = data_out;
-    const uint8_t *in  = data_in;
-    const uint8_t *end = data_in + dlen_in;
+    if (out != src && len > 0) {
+        memmove(out, src, len);
+    }
 
-    while (in < end) {
-        if (*in == '%') {
-            /* Character is a percent sign. */
+    return out + len;
+}
 
-            /* Are there enough bytes available? */
-            if (in + 2 < end) {
-                char c1 = *(in + 1);
-                char c2 = *(in + 2);
+/**
+ * Decode URL data.
+ *
+ * @param[in] out Output. May be @a in.
+ * @param[in] in Input.
+ * @param[in] len Length of @a in.
+ * @param[in] first Offset of the first % or + in @a in.
+ *
+ * @returns Length of output.
+ */
+static size_t url_decode(
+    uint8_t       *out,
+    const uint8_t *in,
+    size_t         len,
+    size_t         first
+)
+{
+    uint8_t *o   = out;
+    size_t   i   = 0;
+    size_t   run = first;
+
+    for (;;) {
+        /* Copy the run before the next escape as a whole. */
+        o = copy_run(o, in + i, run);
+        i += run;
+        if (i >= len) {
+            break;
+        }
 
-                if (IS_HEX_CHAR(c1) && IS_HEX_CHAR(c2)) {
-                    /* Valid encoding - decode it. */
-                    *out++ = x2c(in + 1);
-                    in += 3;
-                }
-                else {
-                    /* Not a valid encoding, skip this % */
-                    if (in == out) {
-                        ++out;
-                        ++in;
-                    }
-                    else {
-                        *out++ = *in++;
-                    }
-                }
-            }
-            else {
-                /* Not enough bytes available, copy the raw bytes. */
-                if (in == out) {
-                    ++out;
-                    ++in;
-                }
-                else {
-                    *out++ = *in++;
-                }
-            }
+        if (in[i] == '+') {
+            *o++ = ' ';
+            ++i;
+        }
+        else if (
+            i + 2 < len &&
+            IS_HEX_CHAR(in[i + 1]) &&
+            IS_HEX_CHAR(in[i + 2])
+        )
+        {
+            /* Valid encoding - decode it. */
+            *o++ = x2c(in + i + 1);
+            i += 3;
         }
         else {
-            /* Character is not a percent sign. */
-            if (*in == '+') {
-                *out++ = ' ';
-            }
-            else if (out != in) {
-                *out++ = *in;
-            }
-            else {
-                ++out;
-            }
-            ++in;
+            /* Not a valid encoding, copy the % as is. */
+            *o++ = in[i];
+            ++i;
         }
+
+        run = ib_scan_url(in + i, len - i);
     }
-    *dlen_out = (out - data_out);
 
-    return IB_OK;
+    return o - out;
 }
 
-ib_status_t ib_util_decode_html_entity(
+ib_status_t ib_util_decode_url(
     const uint8_t  *data_in,
     size_t          dlen_in,
     uint8_t        *data_out,
@@ -160,451 +169,389 @@ ib_status_t ib_util_decode_html_entity(
     assert(data_out != NULL);
     assert(dlen_out != NULL);
 
-    uint8_t *out = data_out;
-    const uint8_t *in = data_in;
-    const uint8_t *end;
+    *dlen_out = url_decode(
+        data_out, data_in, dlen_in, ib_scan_url(data_in, dlen_in));
 
-    end = in + dlen_in;
-    while (in < end) {
-        size_t copy = 1;
+    return IB_OK;
+}
 
-        /* Require an ampersand and at least one character to
-         * start looking into the entity.
-         */
-        if ( (*in == '&') && (in + 1 < end) ) {
-            const uint8_t *t1 = in + 1;
+ib_status_t ib_util_decode_url_const(
+    ib_mm_t          mm,
+    const uint8_t   *data_in,
+    size_t           dlen_in,
+    const uint8_t  **data_out,
+    size_t          *dlen_out
+)
+{
+    assert(data_in != NULL);
+    assert(data_out != NULL);
+    assert(dlen_out != NULL);
 
-            if (*t1 == '#') {
-                /* Numerical entity. */
-                ++copy;
+    size_t   first = ib_scan_url(data_in, dlen_in);
+    uint8_t *buf;
 
-                if (t1 + 1 >= end) {
-                    goto HTML_ENT_OUT; /* Not enough bytes. */
-                }
-                ++t1;
+    if (first == dlen_in) {
+        *data_out = data_in;
+        *dlen_out = dlen_in;
+        return IB_OK;
+    }
 
-                if ( (*t1 == 'x') || (*t1 == 'X') ) {
-                    const uint8_t *t2;
+    buf = ib_mm_alloc(mm, dlen_in);
+    if (buf == NULL) {
+        return IB_EALLOC;
+    }
 
-                    /* Hexadecimal entity. */
-                    ++copy;
+    *data_out = buf;
+    *dlen_out = url_decode(buf, data_in, dlen_in, first);
 
-                    if (t1 + 1 >= end) {
-                        goto HTML_ENT_OUT; /* Not enough bytes. */
-                    }
-                    ++t1; /* j is the position of the first digit now. */
+    return IB_OK;
+}
 
-                    t2 = t1;
-                    while( (t1 < end) && (isxdigit(*t1)) ) {
-                        ++t1;
-                    }
-                    if (t1 > t2) { /* Do we have at least one digit? */
-                        /* Decode the entity. */
-                        char *tmp = ib_util_memdup_to_string(t2, t1 - t2);
-                        if (tmp == NULL) {
-                            return IB_EALLOC;
-                        }
-                        *out++ = (uint8_t)strtol(tmp, NULL, 16);
-                        free(tmp);
-
-                        /* Skip over the semicolon if it's there. */
-                        if ( (t1 < end) && (*t1 == ';') ) {
-                             in = t1 + 1;
-                        }
-                        else {
-                            in = t1;
-                        }
-
-                        continue;
-                    }
-                    else {
-                        goto HTML_ENT_OUT;
-                    }
-                }
-                else {
-                    /* Decimal entity. */
-                    const uint8_t *t2 = t1;
+/**
+ * Named HTML entities and the byte each decodes to.
+ *
+ * Names are matched without regard to case and the first match wins, so
+ * order matters.
+ */
+static const struct {
+    const char *name;  /**< Entity name. */
+    uint8_t     value; /**< Decoded byte. */
+} html_entities[] = {
+    /* ENH What about others? */
+    { "quot", '"' },
+    { "amp", '&' },
+    { "lt", '<' },
+    { "gt", '>' },
+    { "nbsp", NBSP },
+    { "quot", 0x22 },
+    { "iexcl", 0xa1 },
+    { "cent", 0xa2 },
+    { "pound", 0xa3 },
+    { "curren", 0xa4 },
+    { "yen", 0xa5 },
+    { "brvbar", 0xa6 },
+    { "sect", 0xa7 },
+    { "uml", 0xa8 },
+    { "copy", 0xa9 },
+    { "ordf", 0xaa },
+    { "laquo", 0xab },
+    { "not", 0xac },
+    { "shy", 0xad },
+    { "reg", 0xae },
+    { "macr", 0xaf },
+    { "deg", 0xb0 },
+    { "plusmn", 0xb1 },
+    { "sup2", 0xb2 },
+    { "sup3", 0xb3 },
+    { "acute", 0xb4 },
+    { "micro", 0xb5 },
+    { "para", 0xb6 },
+    { "middot", 0xb7 },
+    { "cedil", 0xb8 },
+    { "sup1", 0xb9 },
+    { "ordm", 0xba },
+    { "raquo", 0xbb },
+    { "frac14", 0xbc },
+    { "frac12", 0xbd },
+    { "frac34", 0xbe },
+    { "iquest", 0xbf },
+    { "Agrave", 0xc0 },
+    { "Aacute", 0xc1 },
+    { "Acirc", 0xc2 },
+    { "Atilde", 0xc3 },
+    { "Auml", 0xc4 },
+    { "Aring", 0xc5 },
+    { "AElig", 0xc6 },
+    { "Ccedil", 0xc7 },
+    { "Egrave", 0xc8 },
+    { "Eacute", 0xc9 },
+    { "Ecirc", 0xca },
+    { "Euml", 0xcb },
+    { "Igrave", 0xcc },
+    { "Iacute", 0xcd },
+    { "Icirc", 0xce },
+    { "Iuml", 0xcf },
+    { "ETH", 0xd0 },
+    { "Ntilde", 0xd1 },
+    { "Ograve", 0xd2 },
+    { "Oacute", 0xd3 },
+    { "Ocirc", 0xd4 },
+    { "Otilde", 0xd5 },
+    { "Ouml", 0xd6 },
+    { "times", 0xd7 },
+    { "Oslash", 0xd8 },
+    { "Ugrave", 0xd9 },
+    { "Uacute", 0xda },
+    { "Ucirc", 0xdb },
+    { "Uuml", 0xdc },
+    { "Yacute", 0xdd },
+    { "THORN", 0xde },
+    { "szlig", 0xdf },
+    { "agrave", 0xe0 },
+    { "aacute", 0xe1 },
+    { "acirc", 0xe2 },
+    { "atilde", 0xe3 },
+    { "auml", 0xe4 },
+    { "aring", 0xe5 },
+    { "aelig", 0xe6 },
+    { "ccedil", 0xe7 },
+    { "egrave", 0xe8 },
+    { "eacute", 0xe9 },
+    { "ecirc", 0xea },
+    { "euml", 0xeb },
+    { "igrave", 0xec },
+    { "iacute", 0xed },
+    { "icirc", 0xee },
+    { "iuml", 0xef },
+    { "eth", 0xf0 },
+    { "ntilde", 0xf1 },
+    { "ograve", 0xf2 },
+    { "oacute", 0xf3 },
+    { "ocirc", 0xf4 },
+    { "otilde", 0xf5 },
+    { "ouml", 0xf6 },
+    { "divide", 0xf7 },
+    { "oslash", 0xf8 },
+    { "ugrave", 0xf9 },
+    { "uacute", 0xfa },
+    { "ucirc", 0xfb },
+    { "uuml", 0xfc },
+    { "yacute", 0xfd },
+    { "thorn", 0xfe },
+    { "yuml", 0xff },
+    { NULL, 0 }
+};
+
+/** Longest name in @ref html_entities. */
+#define HTML_ENTITY_NAME_MAX 6
 
-                    while( (t1 < end) && (isdigit(*t1)) ) {
-                        ++t1;
-                    }
-                    if (t1 > t2) { /* Do we have at least one digit? */
-                        /* Decode the entity. */
-                        char *tmp = ib_util_memdup_to_string(t2, t1 - t2);
-                        if (tmp == NULL) {
-                            return IB_EALLOC;
-                        }
-                        *out++ = (uint8_t)strtol(tmp, NULL, 10);
-                        free(tmp);
-
-                        /* Skip over the semicolon if it's there. */
-                        if ( (t1 < end) && (*t1 == ';') ) {
-                             in = t1 + 1;
-                        }
-                        else {
-                            in = t1;
-                        }
-
-                        continue;
-                    }
-                    else {
-                        goto HTML_ENT_OUT;
-                    }
-                }
-            }
-            else {
-                /* Text entity. */
-                const uint8_t *t2 = t1;
+/**
+ * Look up a named entity.
+ *
+ * @param[in] name Name; not NUL terminated.
+ * @param[in] len Length of @a name.
+ * @param[out] value Decoded byte.
+ *
+ * @returns True if @a name is a known entity.
+ */
+static bool html_entity_named(const uint8_t *name, size_t len, uint8_t *value)
+{
+    char buf[HTML_ENTITY_NAME_MAX + 1];
 
-                while( (t1 < end) && (isalnum(*t1)) ) {
-                    ++t1;
-                }
-                if (t1 > t2) { /* Do we have at least one digit? */
-                    size_t tlen = t1 - t2;
-                    char *tmp = ib_util_memdup_to_string(t2, tlen);
-                    if (tmp == NULL) {
-                        return IB_EALLOC;
-                    }
+    if (len > HTML_ENTITY_NAME_MAX) {
+        return false;
+    }
+    memcpy(buf, name, len);
+    buf[len] = '\0';
 
-                    /* Decode the entity. */
-                    /* ENH What about others? */
-                    if (strcasecmp(tmp, "quot") == 0) {
-                        *out++ = '"';
-                    }
-                    else if (strcasecmp(tmp, "amp") == 0) {
-                        *out++ = '&';
-                    }
-                    else if (strcasecmp(tmp, "lt") == 0) {
-                        *out++ = '<';
-                    }
-                    else if (strcasecmp(tmp, "gt") == 0) {
-                        *out++ = '>';
-                    }
-                    else if (strcasecmp(tmp, "nbsp") == 0) {
-                        *out++ = NBSP;
-                    }
+    for (size_t i = 0; html_entities[i].name != NULL; ++i) {
+        if (strcasecmp(buf, html_entities[i].name) == 0) {
+            *value = html_entities[i].value;
+            return true;
+        }
+    }
 
-                    /* Remaining 1-byte entities. */
-                    /* ENH Rewrite this to be faster lookup. */
-                    else if (strcasecmp(tmp, "quot") == 0) {
-                        *out++ = 0x22;
-                    }
-                    else if (strcasecmp(tmp, "iexcl") == 0) {
-                        *out++ = 0xa1;
-                    }
-                    else if (strcasecmp(tmp, "cent") == 0) {
-                        *out++ = 0xa2;
-                    }
-                    else if (strcasecmp(tmp, "pound") == 0) {
-                        *out++ = 0xa3;
-                    }
-                    else if (strcasecmp(tmp, "curren") == 0) {
-                        *out++ = 0xa4;
-                    }
-                    else if (strcasecmp(tmp, "yen") == 0) {
-                        *out++ = 0xa5;
-                    }
-                    else if (strcasecmp(tmp, "brvbar") == 0) {
-                        *out++ = 0xa6;
-                    }
-                    else if (strcasecmp(tmp, "sect") == 0) {
-                        *out++ = 0xa7;
-                    }
-                    else if (strcasecmp(tmp, "uml") == 0) {
-                        *out++ = 0xa8;
-                    }
-                    else if (strcasecmp(tmp, "copy") == 0) {
-                        *out++ = 0xa9;
-                    }
-                    else if (strcasecmp(tmp, "ordf") == 0) {
-                        *out++ = 0xaa;
-                    }
-                    else if (strcasecmp(tmp, "laquo") == 0) {
-                        *out++ = 0xab;
-                    }
-                    else if (strcasecmp(tmp, "not") == 0) {
-                        *out++ = 0xac;
-                    }
-                    else if (strcasecmp(tmp, "shy") == 0) {
-                        *out++ = 0xad;
-                    }
-                    else if (strcasecmp(tmp, "reg") == 0) {
-                        *out++ = 0xae;
-                    }
-                    else if (strcasecmp(tmp, "macr") == 0) {
-                        *out++ = 0xaf;
-                    }
-                    else if (strcasecmp(tmp, "deg") == 0) {
-                        *out++ = 0xb0;
-                    }
-                    else if (strcasecmp(tmp, "plusmn") == 0) {
-                        *out++ = 0xb1;
-                    }
-                    else if (strcasecmp(tmp, "sup2") == 0) {
-                        *out++ = 0xb2;
-                    }
-                    else if (strcasecmp(tmp, "sup3") == 0) {
-                        *out++ = 0xb3;
-                    }
-                    else if (strcasecmp(tmp, "acute") == 0) {
-                        *out++ = 0xb4;
-                    }
-                    else if (strcasecmp(tmp, "micro") == 0) {
-                        *out++ = 0xb5;
-                    }
-                    else if (strcasecmp(tmp, "para") == 0) {
-                        *out++ = 0xb6;
-                    }
-                    else if (strcasecmp(tmp, "middot") == 0) {
-                        *out++ = 0xb7;
-                    }
-                    else if (strcasecmp(tmp, "cedil") == 0) {
-                        *out++ = 0xb8;
-                    }
-                    else if (strcasecmp(tmp, "sup1") == 0) {
-                        *out++ = 0xb9;
-                    }
-                    else if (strcasecmp(tmp, "ordm") == 0) {
-                        *out++ = 0xba;
-                    }
-                    else if (strcasecmp(tmp, "raquo") == 0) {
-                        *out++ = 0xbb;
-                    }
-                    else if (strcasecmp(tmp, "frac14") == 0) {
-                        *out++ = 0xbc;
-                    }
-                    else if (strcasecmp(tmp, "frac12") == 0) {
-                        *out++ = 0xbd;
-                    }
-                    else if (strcasecmp(tmp, "frac34") == 0) {
-                        *out++ = 0xbe;
-                    }
-                    else if (strcasecmp(tmp, "iquest") == 0) {
-                        *out++ = 0xbf;
-                    }
-                    else if (strcasecmp(tmp, "Agrave") == 0) {
-                        *out++ = 0xc0;
-                    }
-                    else if (strcasecmp(tmp, "Aacute") == 0) {
-                        *out++ = 0xc1;
-                    }
-                    else if (strcasecmp(tmp, "Acirc") == 0) {
-                        *out++ = 0xc2;
-                    }
-                    else if (strcasecmp(tmp, "Atilde") == 0) {
-                        *out++ = 0xc3;
-                    }
-                    else if (strcasecmp(tmp, "Auml") == 0) {
-                        *out++ = 0xc4;
-                    }
-                    else if (strcasecmp(tmp, "Aring") == 0) {
-                        *out++ = 0xc5;
-                    }
-                    else if (strcasecmp(tmp, "AElig") == 0) {
-                        *out++ = 0xc6;
-                    }
-                    else if (strcasecmp(tmp, "Ccedil") == 0) {
-                        *out++ = 0xc7;
-                    }
-                    else if (strcasecmp(tmp, "Egrave") == 0) {
-                        *out++ = 0xc8;
-                    }
-                    else if (strcasecmp(tmp, "Eacute") == 0) {
-                        *out++ = 0xc9;
-                    }
-                    else if (strcasecmp(tmp, "Ecirc") == 0) {
-                        *out++ = 0xca;
-                    }
-                    else if (strcasecmp(tmp, "Euml") == 0) {
-                        *out++ = 0xcb;
-                    }
-                    else if (strcasecmp(tmp, "Igrave") == 0) {
-                        *out++ = 0xcc;
-                    }
-                    else if (strcasecmp(tmp, "Iacute") == 0) {
-                        *out++ = 0xcd;
-                    }
-                    else if (strcasecmp(tmp, "Icirc") == 0) {
-                        *out++ = 0xce;
-                    }
-                    else if (strcasecmp(tmp, "Iuml") == 0) {
-                        *out++ = 0xcf;
-                    }
-                    else if (strcasecmp(tmp, "ETH") == 0) {
-                        *out++ = 0xd0;
-                    }
-                    else if (strcasecmp(tmp, "Ntilde") == 0) {
-                        *out++ = 0xd1;
-                    }
-                    else if (strcasecmp(tmp, "Ograve") == 0) {
-                        *out++ = 0xd2;
-                    }
-                    else if (strcasecmp(tmp, "Oacute") == 0) {
-                        *out++ = 0xd3;
-                    }
-                    else if (strcasecmp(tmp, "Ocirc") == 0) {
-                        *out++ = 0xd4;
-                    }
-                    else if (strcasecmp(tmp, "Otilde") == 0) {
-                        *out++ = 0xd5;
-                    }
-                    else if (strcasecmp(tmp, "Ouml") == 0) {
-                        *out++ = 0xd6;
-                    }
-                    else if (strcasecmp(tmp, "times") == 0) {
-                        *out++ = 0xd7;
-                    }
-                    else if (strcasecmp(tmp, "Oslash") == 0) {
-                        *out++ = 0xd8;
-                    }
-                    else if (strcasecmp(tmp, "Ugrave") == 0) {
-                        *out++ = 0xd9;
-                    }
-                    else if (strcasecmp(tmp, "Uacute") == 0) {
-                        *out++ = 0xda;
-                    }
-                    else if (strcasecmp(tmp, "Ucirc") == 0) {
-                        *out++ = 0xdb;
-                    }
-                    else if (strcasecmp(tmp, "Uuml") == 0) {
-                        *out++ = 0xdc;
-                    }
-                    else if (strcasecmp(tmp, "Yacute") == 0) {
-                        *out++ = 0xdd;
-                    }
-                    else if (strcasecmp(tmp, "THORN") == 0) {
-                        *out++ = 0xde;
-                    }
-                    else if (strcasecmp(tmp, "szlig") == 0) {
-                        *out++ = 0xdf;
-                    }
-                    else if (strcasecmp(tmp, "agrave") == 0) {
-                        *out++ = 0xe0;
-                    }
-                    else if (strcasecmp(tmp, "aacute") == 0) {
-                        *out++ = 0xe1;
-                    }
-                    else if (strcasecmp(tmp, "acirc") == 0) {
-                        *out++ = 0xe2;
-                    }
-                    else if (strcasecmp(tmp, "atilde") == 0) {
-                        *out++ = 0xe3;
-                    }
-                    else if (strcasecmp(tmp, "auml") == 0) {
-                        *out++ = 0xe4;
-                    }
-                    else if (strcasecmp(tmp, "aring") == 0) {
-                        *out++ = 0xe5;
-                    }
-                    else if (strcasecmp(tmp, "aelig") == 0) {
-                        *out++ = 0xe6;
-                    }
-                    else if (strcasecmp(tmp, "ccedil") == 0) {
-                        *out++ = 0xe7;
-                    }
-                    else if (strcasecmp(tmp, "egrave") == 0) {
-                        *out++ = 0xe8;
-                    }
-                    else if (strcasecmp(tmp, "eacute") == 0) {
-                        *out++ = 0xe9;
-                    }
-                    else if (strcasecmp(tmp, "ecirc") == 0) {
-                        *out++ = 0xea;
-                    }
-                    else if (strcasecmp(tmp, "euml") == 0) {
-                        *out++ = 0xeb;
-                    }
-                    else if (strcasecmp(tmp, "igrave") == 0) {
-                        *out++ = 0xec;
-                    }
-                    else if (strcasecmp(tmp, "iacute") == 0) {
-                        *out++ = 0xed;
-                    }
-                    else if (strcasecmp(tmp, "icirc") == 0) {
-                        *out++ = 0xee;
-                    }
-                    else if (strcasecmp(tmp, "iuml") == 0) {
-                        *out++ = 0xef;
-                    }
-                    else if (strcasecmp(tmp, "eth") == 0) {
-                        *out++ = 0xf0;
-                    }
-                    else if (strcasecmp(tmp, "ntilde") == 0) {
-                        *out++ = 0xf1;
-                    }
-                    else if (strcasecmp(tmp, "ograve") == 0) {
-                        *out++ = 0xf2;
-                    }
-                    else if (strcasecmp(tmp, "oacute") == 0) {
-                        *out++ = 0xf3;
-                    }
-                    else if (strcasecmp(tmp, "ocirc") == 0) {
-                        *out++ = 0xf4;
-                    }
-                    else if (strcasecmp(tmp, "otilde") == 0) {
-                        *out++ = 0xf5;
-                    }
-                    else if (strcasecmp(tmp, "ouml") == 0) {
-                        *out++ = 0xf6;
-                    }
-                    else if (strcasecmp(tmp, "divide") == 0) {
-                        *out++ = 0xf7;
-                    }
-                    else if (strcasecmp(tmp, "oslash") == 0) {
-                        *out++ = 0xf8;
-                    }
-                    else if (strcasecmp(tmp, "ugrave") == 0) {
-                        *out++ = 0xf9;
-                    }
-                    else if (strcasecmp(tmp, "uacute") == 0) {
-                        *out++ = 0xfa;
-                    }
-                    else if (strcasecmp(tmp, "ucirc") == 0) {
-                        *out++ = 0xfb;
-                    }
-                    else if (strcasecmp(tmp, "uuml") == 0) {
-                        *out++ = 0xfc;
-                    }
-                    else if (strcasecmp(tmp, "yacute") == 0) {
-                        *out++ = 0xfd;
-                    }
-                    else if (strcasecmp(tmp, "thorn") == 0) {
-                        *out++ = 0xfe;
-                    }
-                    else if (strcasecmp(tmp, "yuml") == 0) {
-                        *out++ = 0xff;
-                    }
-                    else {
-                        /* We do no want to convert this entity,
-                         * copy the raw data over. */
-                        copy = t1 - t2 + 1;
-                        free(tmp);
-                        goto HTML_ENT_OUT;
-                    }
-                    free(tmp);
+    return false;
+}
 
-                    /* Skip over the semicolon if it's there. */
-                    if ( (t1 < end) && (*t1 == ';') ) {
-                        in = t1 + 1;
-                    }
-                    else {
-                         in = t1;
-                    }
-                    continue;
-                }
-            }
+/**
+ * Value of a numeric entity, as strtol() would compute it, truncated to a
+ * byte.
+ *
+ * @param[in] digits Digits; all valid in @a base.
+ * @param[in] end End of @a digits.
+ * @param[in] base 10 or 16.
+ *
+ * @returns Decoded byte.
+ */
+static uint8_t html_entity_number(
+    const uint8_t *digits,
+    const uint8_t *end,
+    unsigned long  base
+)
+{
+    unsigned long v = 0;
+
+    for (const uint8_t *p = digits; p < end; ++p) {
+        unsigned long d = isdigit(*p) ? *p - '0' : (*p & 0xdf) - 'A' + 10;
+
+        /* strtol() saturates at LONG_MAX. */
+        if (v > (LONG_MAX - d) / base) {
+            return (uint8_t)LONG_MAX;
         }
+        v = v * base + d;
+    }
 
-  HTML_ENT_OUT:
-        {
-            size_t z;
-            for(z = 0; ( (z < copy) && (in < end) ); ++z) {
-                *out++ = *in++;
+    return (uint8_t)v;
+}
+
+/**
+ * Decode the entity at @a in.
+ *
+ * @param[in] in Input; starts with an &.
+ * @param[in] end End of input.
+ * @param[out] value Decoded byte.
+ * @param[out] used If decoded, the input length of the entity, else the
+ *             number of bytes to copy as is.
+ *
+ * @returns True if an entity was decoded.
+ */
+static bool html_entity(
+    const uint8_t  *in,
+    const uint8_t  *end,
+    uint8_t        *value,
+    size_t         *used
+)
+{
+    const uint8_t *t1 = in + 1;
+    const uint8_t *t2;
+
+    /* Require at least one character after the ampersand. */
+    *used = 1;
+    if (t1 >= end) {
+        return false;
+    }
+
+    if (*t1 == '#') {
+        /* Numerical entity. */
+        unsigned long base = 10;
+
+        ++*used;
+        ++t1;
+        if (t1 >= end) {
+            return false;
+        }
+
+        if (*t1 == 'x' || *t1 == 'X') {
+            /* Hexadecimal entity. */
+            base = 16;
+            ++*used;
+            ++t1;
+            if (t1 >= end) {
+                return false;
             }
         }
+
+        t2 = t1;
+        while (t1 < end && (base == 16 ? isxdigit(*t1) : isdigit(*t1))) {
+            ++t1;
+        }
+        if (t1 == t2) {
+            return false;
+        }
+        *value = html_entity_number(t2, t1, base);
+    }
+    else {
+        /* Text entity. */
+        t2 = t1;
+        while (t1 < end && isalnum(*t1)) {
+            ++t1;
+        }
+        if (t1 == t2) {
+            return false;
+        }
+        if (! html_entity_named(t2, t1 - t2, value)) {
+            /* We do not want to convert this entity, copy the raw data. */
+            *used = t1 - in;
+            return false;
+        }
     }
 
-    *dlen_out = (out - data_out);
+    /* Skip over the semicolon if it's there. */
+    if (t1 < end && *t1 == ';') {
+        ++t1;
+    }
+    *used = t1 - in;
+
+    return true;
+}
+
+/**
+ * Decode HTML entity data.
+ *
+ * @param[in] out Output. May be @a in.
+ * @param[in] in Input.
+ * @param[in] len Length of @a in.
+ * @param[in] amp First & in @a in.
+ *
+ * @returns Length of output.
+ */
+static size_t html_decode(
+    uint8_t       *out,
+    const uint8_t *in,
+    size_t         len,
+    const uint8_t *amp
+)
+{
+    const uint8_t *end = in + len;
+    const uint8_t *p   = in;
+    uint8_t       *o   = out;
+
+    while (amp != NULL) {
+        uint8_t value;
+        size_t  used;
+
+        /* Copy the run before the entity as a whole. */
+        o = copy_run(o, p, amp - p);
+        if (html_entity(amp, end, &value, &used)) {
+            *o++ = value;
+        }
+        else {
+            o = copy_run(o, amp, used);
+        }
+        p = amp + used;
+
+        amp = memchr(p, '&', end - p);
+    }
+
+    return copy_run(o, p, end - p) - out;
+}
+
+ib_status_t ib_util_decode_html_entity(
+    const uint8_t  *data_in,
+    size_t          dlen_in,
+    uint8_t        *data_out,
+    size_t         *dlen_out
+)
+{
+    assert(data_in != NULL);
+    assert(data_out != NULL);
+    assert(dlen_out != NULL);
+
+    *dlen_out = html_decode(
+        data_out, data_in, dlen_in, memchr(data_in, '&', dlen_in));
+
+    return IB_OK;
+}
+
+ib_status_t ib_util_decode_html_entity_const(
+    ib_mm_t          mm,
+    const uint8_t   *data_in,
+    size_t           dlen_in,
+    const uint8_t  **data_out,
+    size_t          *dlen_out
+)
+{
+    assert(data_in != NULL);
+    assert(data_out != NULL);
+    assert(dlen_out != NULL);
+
+    const uint8_t *amp = memchr(data_in, '&', dlen_in);
+    uint8_t       *buf;
+
+    if (amp == NULL) {
+        *data_out = data_in;
+        *dlen_out = dlen_in;
+        return IB_OK;
+    }
+
+    buf = ib_mm_alloc(mm, dlen_in);
+    if (buf == NULL) {
+        return IB_EALLOC;
+    }
+
+    *data_out = buf;
+    *dlen_out = html_decode(buf, data_in, dlen_in, amp);
 
     return IB_OK;
 }
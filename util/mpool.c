@@ -36,6 +36,7 @@
 #endif
 
 #include <assert.h>
+#include <pthread.h>
 #include <stdarg.h>
 #include <stdbool.h>
 #include <stdio.h>
@@ -103,6 +104,16 @@ static char s_zero_length_buffer[1];
 #define IB_MPOOL_POINTER_PAGE_SIZE \
      (IB_MPOOL_DEFAULT_PAGE_SIZE / sizeof(void *))
 
+/**
+ * Default per-thread page cache high-water mark in pages.
+ *
+ * One MiB per thread of the 128 KiB pages of pools with the default page
+ * size; see IB_MPOOL_CACHE_PAGESIZE.
+ *
+ * @sa ib_mpool_page_cache_set_limit()
+ **/
+#define IB_MPOOL_DEFAULT_PAGE_CACHE_LIMIT 8
+
 /**
  * The number of tracks.
  *
@@ -142,6 +153,46 @@ static char s_zero_length_buffer[1];
  **/
 #define IB_MPOOL_TRACK_ZERO_SIZE 8
 
+/**
+ * Granularity of fixed size object classes in bytes.
+ *
+ * Sizes passed to ib_mpool_alloc_fixed() are rounded up to a multiple of
+ * this and each multiple has its own free list.  Must be at least the size
+ * of a pointer.
+ *
+ * @sa IB_MPOOL_FIXED_MAX_SIZE
+ **/
+#define IB_MPOOL_FIXED_ALIGN 8
+
+/**
+ * Largest size in bytes served by fixed size object classes.
+ *
+ * Larger requests to ib_mpool_alloc_fixed() are ordinary allocations.  This
+ * covers a field with its value store.
+ *
+ * @sa IB_MPOOL_FIXED_ALIGN
+ **/
+#define IB_MPOOL_FIXED_MAX_SIZE 160
+
+/**
+ * Number of fixed size object classes.
+ **/
+#define IB_MPOOL_FIXED_CLASSES \
+    (IB_MPOOL_FIXED_MAX_SIZE / IB_MPOOL_FIXED_ALIGN)
+
+/**
+ * Objects in the first batch carved for a fixed size object class.
+ *
+ * Each further batch holds twice as many, up to
+ * @ref IB_MPOOL_FIXED_BATCH_SIZE bytes.
+ **/
+#define IB_MPOOL_FIXED_FIRST_BATCH 4
+
+/**
+ * Most bytes carved from the pool at once for a fixed size object class.
+ **/
+#define IB_MPOOL_FIXED_BATCH_SIZE 2048
+
 /**@}*/
 
 /* Basic Sanity Check -- Otherwise track number calculation fails. */
@@ -157,6 +208,8 @@ typedef struct ib_mpool_page_t ib_mpool_page_t;
 typedef struct ib_mpool_pointer_page_t ib_mpool_pointer_page_t;
 /** See struct ib_mpool_cleanup_t */
 typedef struct ib_mpool_cleanup_t ib_mpool_cleanup_t;
+/** See struct ib_mpool_fixed_t */
+typedef struct ib_mpool_fixed_t ib_mpool_fixed_t;
 
 /**
  * A page to hold small allocations.
@@ -177,6 +230,8 @@ struct ib_mpool_page_t
      *  If this address does not match the page address, then this is a
      *  sub-page and MUST NOT be freed. */
     void *slab;
+    /** Number of pages in slab; only meaningful if the page is the slab. */
+    size_t slab_pages;
     /**
      * First byte of page.
      *
@@ -222,6 +277,26 @@ struct ib_mpool_cleanup_t {
     void                  *function_data;
 };
 
+/**
+ * A fixed size object class.
+ *
+ * Objects are carved in batches from ordinary small allocations and handed
+ * out in order.  Released objects are kept on a free list, linked through
+ * their first bytes, and handed out before any new ones.
+ *
+ * @sa ib_mpool_alloc_fixed()
+ **/
+struct ib_mpool_fixed_t {
+    /** Released objects. */
+    void     *free;
+    /** Next object of current batch. */
+    char     *next;
+    /** Objects left in current batch. */
+    uint32_t  left;
+    /** Objects in current batch; 0 before the first. */
+    uint32_t  batch;
+};
+
 /**
  * A memory pool.
  *
@@ -443,6 +518,15 @@ struct ib_mpool_t
      * @sa ib_mpool_t
      **/
     ib_mpool_t              *free_children;
+    /**
+     * Fixed size object classes.
+     *
+     * Indexed by size, in units of IB_MPOOL_FIXED_ALIGN, less one.
+     * Allocated from the pool on first use; NULL before.
+     *
+     * @sa ib_mpool_alloc_fixed()
+     **/
+    ib_mpool_fixed_t        *fixed;
 };
 
 /**
@@ -461,6 +545,16 @@ struct ib_mpool_t
 #define IB_MPOOL_MINIMUM_PAGESIZE \
      (1 << (IB_MPOOL_TRACK_ZERO_SIZE + IB_MPOOL_NUM_TRACKS - 1))
 
+/**
+ * The page size of pools that may use the per-thread page cache.
+ *
+ * This is the page size ib_mpool_create() gives pools, i.e.,
+ * IB_MPOOL_DEFAULT_PAGE_SIZE raised to IB_MPOOL_MINIMUM_PAGESIZE.
+ **/
+#define IB_MPOOL_CACHE_PAGESIZE \
+     (IB_MPOOL_DEFAULT_PAGE_SIZE > IB_MPOOL_MINIMUM_PAGESIZE ? \
+      IB_MPOOL_DEFAULT_PAGE_SIZE : IB_MPOOL_MINIMUM_PAGESIZE)
+
 /**
  * Loop through a singly linked allowing for mutation.
  *
@@ -593,6 +687,142 @@ void ib_mpool_remove_child_from_parent(const ib_mpool_t *child)
 
 /**@}*/
 
+/**
+ * @name Per-thread page cache.
+ *
+ * Single page slabs and pointer pages of pools using the default page size,
+ * malloc() and free() are kept in a thread local cache on destruction and
+ * reused by later pools on that thread.  See ib_mpool_page_cache_set_limit().
+ */
+/**@{*/
+
+/** See struct ib_mpool_page_cache_t */
+typedef struct ib_mpool_page_cache_t ib_mpool_page_cache_t;
+
+/**
+ * A thread's page cache.
+ */
+struct ib_mpool_page_cache_t
+{
+    /** Singly linked list of cached pages. */
+    ib_mpool_page_t         *pages;
+    /** Number of entries in @c pages. */
+    size_t                   num_pages;
+    /** Singly linked list of cached pointer pages. */
+    ib_mpool_pointer_page_t *pointer_pages;
+    /** Number of entries in @c pointer_pages. */
+    size_t                   num_pointer_pages;
+};
+
+/** Key of the calling thread's ib_mpool_page_cache_t. */
+static pthread_key_t  s_page_cache_key;
+/** Initialization of @ref s_page_cache_key. */
+static pthread_once_t s_page_cache_once = PTHREAD_ONCE_INIT;
+/** True iff @ref s_page_cache_key was created. */
+static bool           s_page_cache_key_valid = false;
+/** Per-thread high-water mark. */
+static size_t         s_page_cache_limit = IB_MPOOL_DEFAULT_PAGE_CACHE_LIMIT;
+
+/**
+ * Free all pages of @a cache.
+ *
+ * @param[in] cache Cache to empty.
+ **/
+static
+void ib_mpool_page_cache_empty(ib_mpool_page_cache_t *cache)
+{
+    assert(cache != NULL);
+
+    IB_MPOOL_FOREACH(ib_mpool_page_t, mpage, cache->pages) {
+        free(mpage);
+    }
+    IB_MPOOL_FOREACH(ib_mpool_pointer_page_t, ppage, cache->pointer_pages) {
+        free(ppage);
+    }
+    cache->pages             = NULL;
+    cache->num_pages         = 0;
+    cache->pointer_pages     = NULL;
+    cache->num_pointer_pages = 0;
+
+    return;
+}
+
+/**
+ * Thread exit destructor of a page cache.
+ *
+ * @param[in] cache Cache to destroy.
+ **/
+static
+void ib_mpool_page_cache_destroy(void *cache)
+{
+    ib_mpool_page_cache_empty((ib_mpool_page_cache_t *)cache);
+    free(cache);
+
+    return;
+}
+
+/**
+ * Create @ref s_page_cache_key.
+ **/
+static
+void ib_mpool_page_cache_init(void)
+{
+    s_page_cache_key_valid =
+        pthread_key_create(&s_page_cache_key, &ib_mpool_page_cache_destroy)
+        == 0;
+
+    return;
+}
+
+/**
+ * Fetch the page cache of the calling thread if @a mp may use it.
+ *
+ * @param[in] mp     Memory pool.
+ * @param[in] create Create the cache if the thread has none.
+ * @return Page cache or NULL if @a mp may not use it, the cache is disabled,
+ *         or on allocation error.
+ **/
+static
+ib_mpool_page_cache_t *ib_mpool_page_cache(
+    const ib_mpool_t *mp,
+    bool              create
+)
+{
+    assert(mp != NULL);
+
+    ib_mpool_page_cache_t *cache;
+
+    if (
+        s_page_cache_limit == 0                  ||
+        mp->pagesize  != IB_MPOOL_CACHE_PAGESIZE ||
+        mp->malloc_fn != &malloc                 ||
+        mp->free_fn   != &free
+    ) {
+        return NULL;
+    }
+
+    pthread_once(&s_page_cache_once, &ib_mpool_page_cache_init);
+    if (! s_page_cache_key_valid) {
+        return NULL;
+    }
+
+    cache = (ib_mpool_page_cache_t *)pthread_getspecific(s_page_cache_key);
+    if (cache == NULL && create) {
+        cache = (ib_mpool_page_cache_t *)calloc(1, sizeof(*cache));
+        if (cache == NULL) {
+            return NULL;
+        }
+        if (pthread_setspecific(s_page_cache_key, cache) != 0) {
+            free(cache);
+            return NULL;
+        }
+    }
+
+    return cache;
+}
+
+/**@}*/
+
 /**
  * @name Helper functions for managing internal memory.
  */
@@ -614,6 +844,21 @@ ib_mpool_page_t *ib_mpool_alloc_pages(
     assert(mp != NULL);
     assert(pages > 0);
 
+    if (pages == 1) {
+        ib_mpool_page_cache_t *cache = ib_mpool_page_cache(mp, false);
+        if (cache != NULL && cache->pages != NULL) {
+            ib_mpool_page_t *mpage = cache->pages;
+            cache->pages = mpage->next;
+            --cache->num_pages;
+#ifdef IB_MPOOL_VALGRIND
+            int rc = VALGRIND_MAKE_MEM_NOACCESS(&(mpage->page), mp->pagesize);
+            assert(rc < 2);
+#endif
+            mpage->next = NULL;
+            return mpage;
+        }
+    }
+
     /* Allocate a slab of memory to hold all pages.
      *
      * NOTE: Since the ib_mpool_page_t structure size is not
@@ -638,8 +883,9 @@ ib_mpool_page_t *ib_mpool_alloc_pages(
         assert(rc < 2);
 #endif
 
-        mpage->slab = slab;
-        mpage->next = mpage_list;
+        mpage->slab       = slab;
+        mpage->slab_pages = pages;
+        mpage->next       = mpage_list;
         mpage_list = mpage;
     }
 
@@ -699,7 +945,15 @@ ib_mpool_pointer_page_t *ib_mpool_acquire_pointer_page(
         mp->free_pointer_pages = mp->free_pointer_pages->next;
     }
     else {
-        ppage = mp->malloc_fn(sizeof(*ppage));
+        ib_mpool_page_cache_t *cache = ib_mpool_page_cache(mp, false);
+        if (cache != NULL && cache->pointer_pages != NULL) {
+            ppage = cache->pointer_pages;
+            cache->pointer_pages = ppage->next;
+            --cache->num_pointer_pages;
+        }
+        else {
+            ppage = mp->malloc_fn(sizeof(*ppage));
+        }
     }
 
     return ppage;
@@ -765,6 +1019,35 @@ void ib_mpool_free_large_allocations(ib_mpool_t *mp)
     return;
 }
 
+/**
+ * Free a pointer page of @a mp or keep it in @a cache.
+ *
+ * @param[in] mp    Memory pool the pointer page belongs to.
+ * @param[in] cache Page cache of the calling thread or NULL.
+ * @param[in] ppage Pointer page to free.
+ **/
+static
+void ib_mpool_free_pointer_page(
+    ib_mpool_t              *mp,
+    ib_mpool_page_cache_t   *cache,
+    ib_mpool_pointer_page_t *ppage
+)
+{
+    assert(mp    != NULL);
+    assert(ppage != NULL);
+
+    if (cache != NULL && cache->num_pointer_pages < s_page_cache_limit) {
+        ppage->next = cache->pointer_pages;
+        cache->pointer_pages = ppage;
+        ++cache->num_pointer_pages;
+    }
+    else {
+        mp->free_fn(ppage);
+    }
+
+    return;
+}
+
 /**
  * Call every cleanup function for @a mp.
  *
@@ -1624,6 +1907,40 @@ size_t ib_mpool_inuse(
     return mp->inuse;
 }
 
+size_t ib_mpool_footprint(
+    const ib_mpool_t *mp
+)
+{
+    size_t pages = 0;
+    size_t footprint = 0;
+
+    if (mp == NULL) {
+        return 0;
+    }
+
+    for (size_t track_num = 0; track_num < IB_MPOOL_NUM_TRACKS; ++track_num) {
+        IB_MPOOL_FOREACH(
+            const ib_mpool_page_t, mpage,
+            mp->tracks[track_num]
+        ) {
+            ++pages;
+        }
+    }
+    IB_MPOOL_FOREACH(const ib_mpool_page_t, mpage, mp->free_pages) {
+        ++pages;
+    }
+    footprint = pages * mp->pagesize + mp->large_allocation_inuse;
+
+    IB_MPOOL_FOREACH(const ib_mpool_t, child, mp->children) {
+        footprint += ib_mpool_footprint(child);
+    }
+    IB_MPOOL_FOREACH(const ib_mpool_t, free_child, mp->free_children) {
+        footprint += ib_mpool_footprint(free_child);
+    }
+
+    return footprint;
+}
+
 ib_status_t ib_mpool_prealloc_pages(
     ib_mpool_t *mp,
     int pages
@@ -1664,6 +1981,51 @@ ib_status_t ib_mpool_prealloc_pages(
     return IB_OK;
 }
 
+void ib_mpool_page_cache_set_limit(
+    size_t limit
+)
+{
+    s_page_cache_limit = limit;
+
+    return;
+}
+
+size_t ib_mpool_page_cache_limit(void)
+{
+    return s_page_cache_limit;
+}
+
+size_t ib_mpool_page_cache_size(void)
+{
+    ib_mpool_page_cache_t *cache;
+
+    pthread_once(&s_page_cache_once, &ib_mpool_page_cache_init);
+    if (! s_page_cache_key_valid) {
+        return 0;
+    }
+
+    cache = (ib_mpool_page_cache_t *)pthread_getspecific(s_page_cache_key);
+
+    return (cache == NULL) ? 0 : cache->num_pages;
+}
+
+void ib_mpool_page_cache_flush(void)
+{
+    ib_mpool_page_cache_t *cache;
+
+    pthread_once(&s_page_cache_once, &ib_mpool_page_cache_init);
+    if (! s_page_cache_key_valid) {
+        return;
+    }
+
+    cache = (ib_mpool_page_cache_t *)pthread_getspecific(s_page_cache_key);
+    if (cache != NULL) {
+        ib_mpool_page_cache_empty(cache);
+    }
+
+    return;
+}
+
 void *ib_mpool_alloc(
     ib_mpool_t *mp,
     size_t      size
@@ -1758,6 +2120,94 @@ void *ib_mpool_alloc(
     return ptr;
 }
 
+void *ib_mpool_alloc_fixed(
+    ib_mpool_t *mp,
+    size_t      size
+)
+{
+    assert(mp != NULL);
+
+#ifdef IB_MPOOL_VALGRIND
+    /* Keep red zones around every object. */
+    return ib_mpool_alloc(mp, size);
+#else
+    if (size == 0 || size > IB_MPOOL_FIXED_MAX_SIZE) {
+        return ib_mpool_alloc(mp, size);
+    }
+
+    size_t            class_num = (size - 1) / IB_MPOOL_FIXED_ALIGN;
+    ib_mpool_fixed_t *fixed;
+    void             *ptr;
+
+    if (mp->fixed == NULL) {
+        mp->fixed = ib_mpool_alloc(
+            mp, IB_MPOOL_FIXED_CLASSES * sizeof(*mp->fixed)
+        );
+        if (mp->fixed == NULL) {
+            return NULL;
+        }
+        memset(mp->fixed, 0, IB_MPOOL_FIXED_CLASSES * sizeof(*mp->fixed));
+    }
+    fixed = &(mp->fixed[class_num]);
+
+    if (fixed->free != NULL) {
+        ptr = fixed->free;
+        fixed->free = *(void **)ptr;
+        return ptr;
+    }
+
+    size = (class_num + 1) * IB_MPOOL_FIXED_ALIGN;
+    if (fixed->left == 0) {
+        uint32_t  batch = IB_MPOOL_FIXED_FIRST_BATCH;
+        char     *objects;
+
+        /* Pools using a class a few times carve little of it. */
+        if (fixed->batch > 0) {
+            batch = fixed->batch * 2;
+            if (batch * size > IB_MPOOL_FIXED_BATCH_SIZE) {
+                batch = fixed->batch;
+            }
+        }
+        objects = ib_mpool_alloc(mp, batch * size);
+        if (objects == NULL) {
+            return NULL;
+        }
+        fixed->next  = objects;
+        fixed->left  = batch;
+        fixed->batch = batch;
+    }
+
+    ptr = fixed->next;
+    fixed->next += size;
+    --fixed->left;
+
+    return ptr;
+#endif
+}
+
+void ib_mpool_free_fixed(
+    ib_mpool_t *mp,
+    void       *ptr,
+    size_t      size
+)
+{
+    assert(mp != NULL);
+
+#ifndef IB_MPOOL_VALGRIND
+    if (ptr == NULL || size == 0 || size > IB_MPOOL_FIXED_MAX_SIZE) {
+        return;
+    }
+
+    assert(mp->fixed != NULL);
+
+    size_t            class_num = (size - 1) / IB_MPOOL_FIXED_ALIGN;
+    ib_mpool_fixed_t *fixed     = &(mp->fixed[class_num]);
+
+    *(void **)ptr = fixed->free;
+    fixed->free   = ptr;
+#endif
+}
+
 void ib_mpool_clear(
     ib_mpool_t *mp
 )
@@ -1809,6 +2259,8 @@ void ib_mpool_clear(
     mp->inuse                  = 0;
     mp->large_allocation_inuse = 0;
 
+    mp->fixed = NULL;
+
     IB_MPOOL_FOREACH(ib_mpool_t, child, mp->children) {
         ib_mpool_clear(child);
     }
@@ -1828,6 +2280,7 @@ void ib_mpool_destroy(
     ib_mpool_call_cleanups(mp);
     ib_mpool_free_large_allocations(mp);
     ib_mpool_page_t *freeable = NULL;
+    ib_mpool_page_cache_t *cache = ib_mpool_page_cache(mp, true);
 
     for (size_t track_num = 0; track_num < IB_MPOOL_NUM_TRACKS; ++track_num) {
         IB_MPOOL_FOREACH(ib_mpool_page_t, mpage, mp->tracks[track_num]) {
@@ -1839,7 +2292,7 @@ void ib_mpool_destroy(
     }
 
     IB_MPOOL_FOREACH(ib_mpool_pointer_page_t, ppage, mp->large_allocations) {
-        mp->free_fn(ppage);
+        ib_mpool_free_pointer_page(mp, cache, ppage);
     }
 
     IB_MPOOL_FOREACH(ib_mpool_cleanup_t, cleanup, mp->cleanups) {
@@ -1854,7 +2307,7 @@ void ib_mpool_destroy(
     }
 
     IB_MPOOL_FOREACH(ib_mpool_pointer_page_t, ppage, mp->free_pointer_pages) {
-        mp->free_fn(ppage);
+        ib_mpool_free_pointer_page(mp, cache, ppage);
     }
 
     IB_MPOOL_FOREACH(ib_mpool_cleanup_t, cleanup, mp->free_cleanups) {
@@ -1862,7 +2315,18 @@ void ib_mpool_destroy(
     }
 
     IB_MPOOL_FOREACH(ib_mpool_page_t, mpage, freeable) {
-        mp->free_fn(mpage);
+        if (
+            cache != NULL &&
+            mpage->slab_pages == 1 &&
+            cache->num_pages < s_page_cache_limit
+        ) {
+            mpage->next = cache->pages;
+            cache->pages = mpage;
+            ++cache->num_pages;
+        }
+        else {
+            mp->free_fn(mpage);
+        }
     }
 
    /* We remove the child's parent link so that the child does not
@@ -1944,6 +2408,23 @@ void ib_mpool_release(
     return;
 }
 
+void ib_mpool_reset(
+    ib_mpool_t *mp
+)
+{
+    if (mp == NULL) {
+        return;
+    }
+
+    ib_mpool_clear(mp);
+
+    IB_MPOOL_FOREACH(ib_mpool_t, child, mp->children) {
+        ib_mpool_release(child);
+    }
+
+    return;
+}
+
 ib_status_t ib_mpool_cleanup_register(
     ib_mpool_t            *mp,
     ib_mpool_cleanup_fn_t  cleanup_function,
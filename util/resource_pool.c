@@ -26,11 +26,22 @@
 #include "ironbee_config_auto.h"
 
 #include <ironbee/resource_pool.h>
+#include <ironbee/lock.h>
 #include <ironbee/util.h>
 
 #include <assert.h>
+#include <pthread.h>
+#include <stdint.h>
 #include <unistd.h>
 
+/**
+ * Number of per-thread cache slots of a threaded pool. A power of 2.
+ *
+ * Threads are assigned slots round robin. Threads beyond this number share
+ * slots, which stays correct but lets them take each other's resources.
+ */
+#define IB_RESOURCE_POOL_CACHE_SLOTS 64
+
 /**
  * This represents a resource to be managed by an ib_resource_pool_t.
  */
@@ -78,8 +89,118 @@ struct ib_resource_pool_t {
      * free queue.
      */
     size_t min_count;
+
+    /**
+     * Guard the pool if threaded, else NULL.
+     *
+     * @sa ib_resource_pool_set_threaded()
+     */
+    ib_lock_t *lock;
+
+    /**
+     * Per-thread cache slots if threaded, else NULL.
+     *
+     * Each is NULL or a free resource and is only accessed by atomic
+     * exchange. There are @ref IB_RESOURCE_POOL_CACHE_SLOTS.
+     */
+    ib_resource_t **cache;
 };
 
+/**
+ * Key of the cache slot index of the calling thread, plus one.
+ */
+static pthread_key_t  g_cache_slot_key;
+
+/**
+ * Ensure @ref g_cache_slot_key is created once.
+ */
+static pthread_once_t g_cache_slot_once = PTHREAD_ONCE_INIT;
+
+/**
+ * The slot index assigned to the next thread.
+ */
+static size_t         g_cache_slot_next = 0;
+
+/**
+ * Create @ref g_cache_slot_key.
+ */
+static void cache_slot_key_create(void)
+{
+    pthread_key_create(&g_cache_slot_key, NULL);
+}
+
+/**
+ * Return the cache slot of the calling thread in @a rp.
+ *
+ * @param[in] rp A threaded resource pool.
+ *
+ * @returns The slot.
+ */
+static ib_resource_t **cache_slot(ib_resource_pool_t *rp)
+{
+    assert(rp->cache != NULL);
+
+    uintptr_t idx = (uintptr_t)pthread_getspecific(g_cache_slot_key);
+
+    if (idx == 0) {
+        idx = __atomic_fetch_add(&g_cache_slot_next, 1, __ATOMIC_RELAXED) %
+                  IB_RESOURCE_POOL_CACHE_SLOTS + 1;
+        pthread_setspecific(g_cache_slot_key, (void *)idx);
+    }
+
+    return &(rp->cache[idx - 1]);
+}
+
+/**
+ * Take any resource out of the cache slots of @a rp.
+ *
+ * @param[in] rp A threaded resource pool.
+ *
+ * @returns A free resource or NULL if all slots are empty.
+ */
+static ib_resource_t *cache_steal(ib_resource_pool_t *rp)
+{
+    for (size_t i = 0; i < IB_RESOURCE_POOL_CACHE_SLOTS; ++i) {
+        ib_resource_t *r;
+
+        if (__atomic_load_n(&(rp->cache[i]), __ATOMIC_RELAXED) == NULL) {
+            continue;
+        }
+        r = __atomic_exchange_n(&(rp->cache[i]), NULL, __ATOMIC_ACQ_REL);
+        if (r != NULL) {
+            return r;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Lock @a rp if it is threaded.
+ *
+ * @param[in] rp The resource pool.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - Other on lock failure.
+ */
+static ib_status_t pool_lock(ib_resource_pool_t *rp)
+{
+    return (rp->lock == NULL) ? IB_OK : ib_lock_lock(rp->lock);
+}
+
+/**
+ * Unlock @a rp if it is threaded.
+ *
+ * @param[in] rp The resource pool.
+ */
+static void pool_unlock(ib_resource_pool_t *rp)
+{
+    if (rp->lock != NULL) {
+        ib_lock_unlock(rp->lock);
+    }
+}
+
 /**
  * This is registered with the memory pool passed to ib_resource_pool_create.
  *
@@ -91,6 +212,14 @@ static void ib_resource_pool_destroy(void *data) {
     ib_status_t rc;
     ib_resource_pool_t *rp = (ib_resource_pool_t *)data;
 
+    if (rp->cache != NULL) {
+        ib_resource_t *r;
+
+        while ((r = cache_steal(rp)) != NULL) {
+            (rp->destroy_fn)(r->resource, rp->destroy_data);
+        }
+    }
+
     while (ib_queue_size(rp->resources) > 0) {
         void *v;
         rc = ib_queue_pop_front(rp->resources, &v);
@@ -286,6 +415,23 @@ ib_status_t ib_resource_acquire(
     ib_resource_t *tmp_resource = NULL;
     ib_status_t rc;
 
+    /* Try the resource this thread last released, without locking. */
+    if (resource_pool->cache != NULL) {
+        tmp_resource = __atomic_exchange_n(
+            cache_slot(resource_pool),
+            NULL,
+            __ATOMIC_ACQ_REL);
+        if (tmp_resource != NULL) {
+            rc = IB_OK;
+            goto success;
+        }
+    }
+
+    rc = pool_lock(resource_pool);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
     /* If there is a free resource, acquire it. */
     if (ib_queue_size(resource_pool->resources) > 0) {
         rc = ib_queue_pop_front(
@@ -302,7 +448,7 @@ ib_status_t ib_resource_acquire(
             goto failure;
         }
 
-        goto success;
+        goto success_locked;
     }
     /* If we may create a new resource, do so. */
     else if (   (resource_pool->max_count == 0)
@@ -320,7 +466,16 @@ ib_status_t ib_resource_acquire(
             goto failure;
         }
 
-        goto success;
+        goto success_locked;
+    }
+    /* Before giving up, take a resource cached by another thread. */
+    else if (
+        resource_pool->cache != NULL &&
+        (tmp_resource = cache_steal(resource_pool)) != NULL
+    )
+    {
+        rc = IB_OK;
+        goto success_locked;
     }
     /* If we may not wait for the resource, fail w/ IB_DECLINED. */
     else {
@@ -328,6 +483,9 @@ ib_status_t ib_resource_acquire(
         goto failure;
     }
 
+success_locked:
+    pool_unlock(resource_pool);
+
 success:
 
     if (resource_pool->preuse_fn != NULL) {
@@ -342,6 +500,7 @@ success:
     return rc;
 
 failure:
+    pool_unlock(resource_pool);
     return rc;
 }
 
@@ -385,21 +544,44 @@ ib_status_t ib_resource_release(
     assert(resource != NULL);
     assert(resource->owner != NULL);
 
-    ib_status_t rc;
+    ib_resource_pool_t *rp = resource->owner;
+    ib_status_t         rc;
 
     /* If a postuse function is defined, handle it. */
-    if (resource->owner->postuse_fn != NULL) {
-        rc = (resource->owner->postuse_fn)(
-            resource->resource,
-            resource->owner->postuse_data);
+    if (rp->postuse_fn != NULL) {
+        rc = (rp->postuse_fn)(resource->resource, rp->postuse_data);
 
         /* If the user says that the resource is invalid, destroy it. */
         if (rc == IB_EINVAL) {
-            return destroy_resource(resource);
+            rc = pool_lock(rp);
+            if (rc != IB_OK) {
+                return rc;
+            }
+            rc = destroy_resource(resource);
+            pool_unlock(rp);
+            return rc;
         }
     }
 
-    rc = ib_queue_push_back(resource->owner->resources, resource);
+    /* Keep this resource for this thread; queue what it displaces. */
+    if (rp->cache != NULL) {
+        resource = __atomic_exchange_n(
+            cache_slot(rp),
+            resource,
+            __ATOMIC_ACQ_REL);
+        if (resource == NULL) {
+            return IB_OK;
+        }
+    }
+
+    rc = pool_lock(rp);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    rc = ib_queue_push_back(rp->resources, resource);
+
+    pool_unlock(rp);
 
     return rc;
 }
@@ -420,25 +602,76 @@ ib_status_t ib_resource_pool_set_min(ib_resource_pool_t *pool, size_t limit)
 {
     assert(pool != NULL);
 
+    ib_status_t rc;
+
+    rc = pool_lock(pool);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
     if (pool->max_count != 0 && pool->max_count < limit) {
-        return IB_EINVAL;
+        rc = IB_EINVAL;
+    }
+    else {
+        pool->min_count = limit;
     }
 
-    pool->min_count = limit;
+    pool_unlock(pool);
 
-    return IB_OK;
+    return rc;
 }
 
 ib_status_t ib_resource_pool_set_max(ib_resource_pool_t *pool, size_t limit)
 {
     assert(pool != NULL);
 
+    ib_status_t rc;
+
+    rc = pool_lock(pool);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
     /* MAX cannot be less than MIN. */
     if (limit != 0 && limit < pool->min_count) {
-        return IB_EINVAL;
+        rc = IB_EINVAL;
+    }
+    else {
+        pool->max_count = limit;
+    }
+
+    pool_unlock(pool);
+
+    return rc;
+}
+
+ib_status_t ib_resource_pool_set_threaded(ib_resource_pool_t *pool)
+{
+    assert(pool != NULL);
+
+    ib_status_t rc;
+
+    if (pool->cache != NULL) {
+        return IB_OK;
+    }
+
+    if (pthread_once(&g_cache_slot_once, cache_slot_key_create) != 0) {
+        return IB_EOTHER;
     }
 
-    pool->max_count = limit;
+    pool->cache = ib_mm_calloc(
+        pool->mm,
+        IB_RESOURCE_POOL_CACHE_SLOTS,
+        sizeof(*(pool->cache)));
+    if (pool->cache == NULL) {
+        return IB_EALLOC;
+    }
+
+    rc = ib_lock_create(&(pool->lock), pool->mm);
+    if (rc != IB_OK) {
+        pool->cache = NULL;
+        return rc;
+    }
 
     return IB_OK;
 }
@@ -451,13 +684,30 @@ ib_status_t ib_resource_pool_flush(
 
     ib_status_t rc;
 
+    rc = pool_lock(resource_pool);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    /* Return cached resources to the queue so they are destroyed too. */
+    if (resource_pool->cache != NULL) {
+        ib_resource_t *r;
+
+        while ((r = cache_steal(resource_pool)) != NULL) {
+            rc = ib_queue_push_back(resource_pool->resources, r);
+            if (rc != IB_OK) {
+                goto cleanup;
+            }
+        }
+    }
+
     /* Destroy all the resources. */
     while (resource_pool->count > 0) {
         ib_resource_t *r;
 
         rc = ib_queue_pop_front(resource_pool->resources, &r);
         if (rc != IB_OK) {
-            return rc;
+            goto cleanup;
         }
 
         destroy_resource(r);
@@ -465,11 +715,11 @@ ib_status_t ib_resource_pool_flush(
 
     /* Fill to the minimum. */
     rc = fill_to_min(resource_pool);
-    if (rc != IB_OK) {
-        return rc;
-    }
 
-    return IB_OK;
+cleanup:
+    pool_unlock(resource_pool);
+
+    return rc;
 }
 
 /** @} */
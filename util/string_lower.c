@@ -26,8 +26,10 @@
 
 #include <ironbee/string_lower.h>
 
+#include "string_scan_private.h"
+
 #include <assert.h>
-#include <ctype.h>
+#include <string.h>
 
 ib_status_t ib_strlower(
     ib_mm_t         mm,
@@ -39,14 +41,41 @@ ib_status_t ib_strlower(
     assert(in != NULL);
     assert(out != NULL);
 
-    *out = ib_mm_memdup(mm, in, in_len);
+    *out = ib_mm_alloc(mm, in_len);
     if (*out == NULL) {
         return IB_EALLOC;
     }
-    for (size_t i = 0; i < in_len; ++i) {
-        int c = *(in+i);
-        *(*out+i) = tolower(c);
+    ib_scan_lower(*out, in, in_len);
+
+    return IB_OK;
+}
+
+ib_status_t ib_strlower_const(
+    ib_mm_t          mm,
+    const uint8_t   *in,
+    size_t           in_len,
+    const uint8_t  **out
+)
+{
+    assert(in != NULL);
+    assert(out != NULL);
+
+    size_t   first = ib_scan_upper(in, in_len);
+    uint8_t *buf;
+
+    if (first == in_len) {
+        *out = in;
+        return IB_OK;
     }
 
+    buf = ib_mm_alloc(mm, in_len);
+    if (buf == NULL) {
+        return IB_EALLOC;
+    }
+    memcpy(buf, in, first);
+    ib_scan_lower(buf + first, in + first, in_len - first);
+
+    *out = buf;
+
     return IB_OK;
 }
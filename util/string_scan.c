@@ -0,0 +1,476 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- ASCII Scanning Kernels
+ *
+ * Each kernel has a scalar version, an SSE2 version used when the compiler
+ * targets SSE2 and an AVX2 version compiled for that target alone and
+ * selected at runtime. The vector versions finish the tail of the input
+ * with the next narrower version. The AVX2 versions clear the upper
+ * register halves first; SSE code run with them dirty is much slower.
+ */
+
+#include "ironbee_config_auto.h"
+
+#include "string_scan_private.h"
+
+#include <assert.h>
+#include <stdbool.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#if defined(__SSE2__) && defined(__GNUC__) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define IB_SCAN_AVX2 1
+#include <immintrin.h>
+#endif
+
+/**
+ * Byte classes.
+ */
+enum scan_class_t {
+    SCAN_UPPER, /**< A-Z. */
+    SCAN_SPACE, /**< isspace() in the C locale. */
+    SCAN_URL,   /**< % and +. */
+    SCAN_JSON   /**< Quote, backslash and control characters. */
+};
+typedef enum scan_class_t scan_class_t;
+
+/**
+ * True if @a c is in @a cls.
+ *
+ * @param[in] c Character.
+ * @param[in] cls Class.
+ *
+ * @returns True if @a c is in @a cls.
+ */
+static inline bool scan_in(uint8_t c, scan_class_t cls)
+{
+    if (cls == SCAN_UPPER) {
+        return (uint8_t)(c - 'A') < 26;
+    }
+    if (cls == SCAN_URL) {
+        return c == '%' || c == '+';
+    }
+    if (cls == SCAN_JSON) {
+        return c == '"' || c == '\\' || c < 0x20;
+    }
+    return c == ' ' || (uint8_t)(c - '\t') < 5;
+}
+
+/* Scalar kernels. */
+
+static size_t scalar_find(
+    const uint8_t *s,
+    size_t         len,
+    scan_class_t   cls,
+    bool           want
+)
+{
+    for (size_t i = 0; i < len; ++i) {
+        if (scan_in(s[i], cls) == want) {
+            return i;
+        }
+    }
+
+    return len;
+}
+
+static size_t scalar_rfind(
+    const uint8_t *s,
+    size_t         len,
+    scan_class_t   cls,
+    bool           want
+)
+{
+    for (size_t i = len; i > 0; --i) {
+        if (scan_in(s[i - 1], cls) == want) {
+            return i;
+        }
+    }
+
+    return 0;
+}
+
+static size_t scalar_space_pair(const uint8_t *s, size_t len)
+{
+    for (size_t i = 0; i + 1 < len; ++i) {
+        if (scan_in(s[i], SCAN_SPACE) && scan_in(s[i + 1], SCAN_SPACE)) {
+            return i;
+        }
+    }
+
+    return len;
+}
+
+static void scalar_lower(uint8_t *dst, const uint8_t *src, size_t len)
+{
+    for (size_t i = 0; i < len; ++i) {
+        uint8_t c = src[i];
+
+        dst[i] = scan_in(c, SCAN_UPPER) ? c + ('a' - 'A') : c;
+    }
+}
+
+#ifdef __SSE2__
+
+/**
+ * Vector of 0xff for the bytes of @a v in @a cls, else 0.
+ */
+static inline __m128i sse2_class(__m128i v, scan_class_t cls)
+{
+    /* Shift the range to the bottom of the signed range so a single
+     * signed compare checks both ends. */
+    if (cls == SCAN_UPPER) {
+        return _mm_cmplt_epi8(
+            _mm_add_epi8(v, _mm_set1_epi8((char)(0x80 - 'A'))),
+            _mm_set1_epi8((char)(0x80 + 26)));
+    }
+    if (cls == SCAN_URL) {
+        return _mm_or_si128(
+            _mm_cmpeq_epi8(v, _mm_set1_epi8('%')),
+            _mm_cmpeq_epi8(v, _mm_set1_epi8('+')));
+    }
+    if (cls == SCAN_JSON) {
+        return _mm_or_si128(
+            _mm_or_si128(
+                _mm_cmpeq_epi8(v, _mm_set1_epi8('"')),
+                _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))),
+            _mm_cmplt_epi8(
+                _mm_add_epi8(v, _mm_set1_epi8((char)0x80)),
+                _mm_set1_epi8((char)(0x80 + 0x20))));
+    }
+    return _mm_or_si128(
+        _mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+        _mm_cmplt_epi8(
+            _mm_add_epi8(v, _mm_set1_epi8((char)(0x80 - '\t'))),
+            _mm_set1_epi8((char)(0x80 + 5))));
+}
+
+/**
+ * Bit i set if byte i of the 16 at @a p is in @a cls.
+ */
+static inline unsigned int sse2_mask(const uint8_t *p, scan_class_t cls)
+{
+    return (unsigned int)_mm_movemask_epi8(
+        sse2_class(_mm_loadu_si128((const __m128i *)p), cls));
+}
+
+static size_t sse2_find(
+    const uint8_t *s,
+    size_t         len,
+    scan_class_t   cls,
+    bool           want
+)
+{
+    size_t i = 0;
+
+    for (; i + 16 <= len; i += 16) {
+        unsigned int m = sse2_mask(s + i, cls);
+
+        if (! want) {
+            m = ~m & 0xffff;
+        }
+        if (m != 0) {
+            return i + __builtin_ctz(m);
+        }
+    }
+
+    return i + scalar_find(s + i, len - i, cls, want);
+}
+
+static size_t sse2_rfind(
+    const uint8_t *s,
+    size_t         len,
+    scan_class_t   cls,
+    bool           want
+)
+{
+    size_t i = len;
+
+    for (; i >= 16; i -= 16) {
+        unsigned int m = sse2_mask(s + i - 16, cls);
+
+        if (! want) {
+            m = ~m & 0xffff;
+        }
+        if (m != 0) {
+            return i - 16 + (32 - __builtin_clz(m));
+        }
+    }
+
+    return scalar_rfind(s, i, cls, want);
+}
+
+static size_t sse2_space_pair(const uint8_t *s, size_t len)
+{
+    size_t i = 0;
+
+    for (; i + 16 <= len; i += 16) {
+        unsigned int m    = sse2_mask(s + i, SCAN_SPACE);
+        unsigned int pair = m & (m >> 1);
+
+        if (pair != 0) {
+            return i + __builtin_ctz(pair);
+        }
+        /* A pair may straddle this block and the next. */
+        if ((m & 0x8000) != 0 && i + 16 < len &&
+            scan_in(s[i + 16], SCAN_SPACE))
+        {
+            return i + 15;
+        }
+    }
+
+    return i + scalar_space_pair(s + i, len - i);
+}
+
+static void sse2_lower(uint8_t *dst, const uint8_t *src, size_t len)
+{
+    const __m128i delta = _mm_set1_epi8('a' - 'A');
+    size_t        i     = 0;
+
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+
+        v = _mm_add_epi8(
+            v,
+            _mm_and_si128(sse2_class(v, SCAN_UPPER), delta));
+        _mm_storeu_si128((__m128i *)(dst + i), v);
+    }
+
+    scalar_lower(dst + i, src + i, len - i);
+}
+
+#endif /* __SSE2__ */
+
+#ifdef IB_SCAN_AVX2
+
+#define IB_SCAN_AVX2_FN __attribute__((target("avx2")))
+
+IB_SCAN_AVX2_FN
+static inline __m256i avx2_class(__m256i v, scan_class_t cls)
+{
+    /* AVX2 has no signed less-than; swap the operands of greater-than. */
+    if (cls == SCAN_UPPER) {
+        return _mm256_cmpgt_epi8(
+            _mm256_set1_epi8((char)(0x80 + 26)),
+            _mm256_add_epi8(v, _mm256_set1_epi8((char)(0x80 - 'A'))));
+    }
+    if (cls == SCAN_URL) {
+        return _mm256_or_si256(
+            _mm256_cmpeq_epi8(v, _mm256_set1_epi8('%')),
+            _mm256_cmpeq_epi8(v, _mm256_set1_epi8('+')));
+    }
+    if (cls == SCAN_JSON) {
+        return _mm256_or_si256(
+            _mm256_or_si256(
+                _mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')),
+                _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))),
+            _mm256_cmpgt_epi8(
+                _mm256_set1_epi8((char)(0x80 + 0x20)),
+                _mm256_add_epi8(v, _mm256_set1_epi8((char)0x80))));
+    }
+    return _mm256_or_si256(
+        _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+        _mm256_cmpgt_epi8(
+            _mm256_set1_epi8((char)(0x80 + 5)),
+            _mm256_add_epi8(v, _mm256_set1_epi8((char)(0x80 - '\t')))));
+}
+
+IB_SCAN_AVX2_FN
+static inline uint32_t avx2_mask(const uint8_t *p, scan_class_t cls)
+{
+    return (uint32_t)_mm256_movemask_epi8(
+        avx2_class(_mm256_loadu_si256((const __m256i *)p), cls));
+}
+
+IB_SCAN_AVX2_FN
+static size_t avx2_find(
+    const uint8_t *s,
+    size_t         len,
+    scan_class_t   cls,
+    bool           want
+)
+{
+    size_t i = 0;
+
+    for (; i + 32 <= len; i += 32) {
+        uint32_t m = avx2_mask(s + i, cls);
+
+        if (! want) {
+            m = ~m;
+        }
+        if (m != 0) {
+            return i + __builtin_ctz(m);
+        }
+    }
+
+    _mm256_zeroupper();
+    return i + sse2_find(s + i, len - i, cls, want);
+}
+
+IB_SCAN_AVX2_FN
+static size_t avx2_rfind(
+    const uint8_t *s,
+    size_t         len,
+    scan_class_t   cls,
+    bool           want
+)
+{
+    size_t i = len;
+
+    for (; i >= 32; i -= 32) {
+        uint32_t m = avx2_mask(s + i - 32, cls);
+
+        if (! want) {
+            m = ~m;
+        }
+        if (m != 0) {
+            return i - 32 + (32 - __builtin_clz(m));
+        }
+    }
+
+    _mm256_zeroupper();
+    return sse2_rfind(s, i, cls, want);
+}
+
+IB_SCAN_AVX2_FN
+static size_t avx2_space_pair(const uint8_t *s, size_t len)
+{
+    size_t i = 0;
+
+    for (; i + 32 <= len; i += 32) {
+        uint32_t m    = avx2_mask(s + i, SCAN_SPACE);
+        uint32_t pair = m & (m >> 1);
+
+        if (pair != 0) {
+            return i + __builtin_ctz(pair);
+        }
+        if ((m & 0x80000000) != 0 && i + 32 < len &&
+            scan_in(s[i + 32], SCAN_SPACE))
+        {
+            return i + 31;
+        }
+    }
+
+    _mm256_zeroupper();
+    return i + sse2_space_pair(s + i, len - i);
+}
+
+IB_SCAN_AVX2_FN
+static void avx2_lower(uint8_t *dst, const uint8_t *src, size_t len)
+{
+    const __m256i delta = _mm256_set1_epi8('a' - 'A');
+    size_t        i     = 0;
+
+    for (; i + 32 <= len; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(src + i));
+
+        v = _mm256_add_epi8(
+            v,
+            _mm256_and_si256(avx2_class(v, SCAN_UPPER), delta));
+        _mm256_storeu_si256((__m256i *)(dst + i), v);
+    }
+
+    _mm256_zeroupper();
+    sse2_lower(dst + i, src + i, len - i);
+}
+
+/**
+ * True if the processor supports AVX2.
+ *
+ * This is a load and a bit test of data libgcc fills in at startup.
+ */
+static inline bool scan_have_avx2(void)
+{
+    return __builtin_cpu_supports("avx2");
+}
+
+#endif /* IB_SCAN_AVX2 */
+
+/**
+ * Dispatch to the best kernel @a name for this processor.
+ */
+#if defined(IB_SCAN_AVX2)
+#define SCAN_DISPATCH(name, ...) \
+    (scan_have_avx2() ? avx2_##name(__VA_ARGS__) : sse2_##name(__VA_ARGS__))
+#elif defined(__SSE2__)
+#define SCAN_DISPATCH(name, ...) sse2_##name(__VA_ARGS__)
+#else
+#define SCAN_DISPATCH(name, ...) scalar_##name(__VA_ARGS__)
+#endif
+
+size_t ib_scan_upper(const uint8_t *s, size_t len)
+{
+    assert(s != NULL || len == 0);
+
+    return SCAN_DISPATCH(find, s, len, SCAN_UPPER, true);
+}
+
+size_t ib_scan_space(const uint8_t *s, size_t len)
+{
+    assert(s != NULL || len == 0);
+
+    return SCAN_DISPATCH(find, s, len, SCAN_SPACE, true);
+}
+
+size_t ib_scan_nonspace(const uint8_t *s, size_t len)
+{
+    assert(s != NULL || len == 0);
+
+    return SCAN_DISPATCH(find, s, len, SCAN_SPACE, false);
+}
+
+size_t ib_scan_nonspace_reverse(const uint8_t *s, size_t len)
+{
+    assert(s != NULL || len == 0);
+
+    return SCAN_DISPATCH(rfind, s, len, SCAN_SPACE, false);
+}
+
+size_t ib_scan_url(const uint8_t *s, size_t len)
+{
+    assert(s != NULL || len == 0);
+
+    return SCAN_DISPATCH(find, s, len, SCAN_URL, true);
+}
+
+size_t ib_scan_json(const uint8_t *s, size_t len)
+{
+    assert(s != NULL || len == 0);
+
+    return SCAN_DISPATCH(find, s, len, SCAN_JSON, true);
+}
+
+size_t ib_scan_space_pair(const uint8_t *s, size_t len)
+{
+    assert(s != NULL || len == 0);
+
+    return SCAN_DISPATCH(space_pair, s, len);
+}
+
+void ib_scan_lower(uint8_t *dst, const uint8_t *src, size_t len)
+{
+    assert(dst != NULL || len == 0);
+    assert(src != NULL || len == 0);
+
+    SCAN_DISPATCH(lower, dst, src, len);
+}
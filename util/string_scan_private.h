@@ -0,0 +1,121 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+#ifndef __IB_STRING_SCAN_PRIVATE_H
+#define __IB_STRING_SCAN_PRIVATE_H
+
+/**
+ * @file
+ * @brief IronBee --- ASCII Scanning Kernels
+ *
+ * Byte class scans used by the string and decode utilities. Each is
+ * vectorized with SSE2, or AVX2 when the processor supports it, and falls
+ * back to a scalar loop elsewhere.
+ *
+ * Whitespace is what isspace() accepts in the C locale: space, tab,
+ * newline, vertical tab, form feed and carriage return. Upper case is
+ * ASCII A through Z. URL escapes are % and +. JSON escapes are the
+ * double quote, backslash and bytes below 0x20.
+ */
+
+#include <ironbee/types.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Offset of the first upper case character in @a s.
+ *
+ * @param[in] s String.
+ * @param[in] len Length of @a s.
+ *
+ * @returns Offset of the first upper case character or @a len if none.
+ */
+size_t ib_scan_upper(const uint8_t *s, size_t len);
+
+/**
+ * Offset of the first whitespace character in @a s.
+ *
+ * @param[in] s String.
+ * @param[in] len Length of @a s.
+ *
+ * @returns Offset of the first whitespace character or @a len if none.
+ */
+size_t ib_scan_space(const uint8_t *s, size_t len);
+
+/**
+ * Offset of the first non-whitespace character in @a s.
+ *
+ * @param[in] s String.
+ * @param[in] len Length of @a s.
+ *
+ * @returns Offset of the first non-whitespace character or @a len if none.
+ */
+size_t ib_scan_nonspace(const uint8_t *s, size_t len);
+
+/**
+ * Length of @a s without trailing whitespace.
+ *
+ * @param[in] s String.
+ * @param[in] len Length of @a s.
+ *
+ * @returns One past the offset of the last non-whitespace character or 0
+ *          if none.
+ */
+size_t ib_scan_nonspace_reverse(const uint8_t *s, size_t len);
+
+/**
+ * Offset of the first URL escape character in @a s.
+ *
+ * @param[in] s String.
+ * @param[in] len Length of @a s.
+ *
+ * @returns Offset of the first % or + or @a len if none.
+ */
+size_t ib_scan_url(const uint8_t *s, size_t len);
+
+/**
+ * Offset of the first byte of @a s that must be escaped in a JSON string.
+ *
+ * @param[in] s String.
+ * @param[in] len Length of @a s.
+ *
+ * @returns Offset of the first JSON escape character or @a len if none.
+ */
+size_t ib_scan_json(const uint8_t *s, size_t len);
+
+/**
+ * Offset of the first of two adjacent whitespace characters in @a s.
+ *
+ * @param[in] s String.
+ * @param[in] len Length of @a s.
+ *
+ * @returns Offset of the first whitespace character followed by another or
+ *          @a len if none.
+ */
+size_t ib_scan_space_pair(const uint8_t *s, size_t len);
+
+/**
+ * Copy @a len bytes from @a src to @a dst converting upper case to lower.
+ *
+ * @param[out] dst Destination. May be @a src.
+ * @param[in] src Source.
+ * @param[in] len Number of bytes.
+ */
+void ib_scan_lower(uint8_t *dst, const uint8_t *src, size_t len);
+
+#endif /* __IB_STRING_SCAN_PRIVATE_H */
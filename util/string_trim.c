@@ -27,62 +27,11 @@
 
 #include <ironbee/string_trim.h>
 
+#include "string_scan_private.h"
+
 #include <assert.h>
-#include <ctype.h>
 #include <stddef.h>
 
-/**
- * Search start from the left for the first non-whitespace.
- *
- * @param[in] str String to search
- * @param[in] len Length of @a str.
- *
- * @returns Offset of first non-whitespace, @a len if none found.
- */
-static
-int find_nonws_left(
-    const uint8_t *str,
-    size_t         len
-)
-{
-    assert (str != NULL);
-    int i;
-
-    for (i = 0; i < (int)len; ++i) {
-        if (isspace(str[i]) == 0) {
-            return i;
-        }
-    }
-
-    return len;
-}
-
-/**
- * Search start from the right for the first non-whitespace.
- *
- * @param[in] str String to search.
- * @param[in] len Length of @a str.
- *
- * @returns Offset of first non-whitespace, -1 if none found.
- */
-static
-int find_nonws_right(
-    const uint8_t *str,
-    size_t         len
-)
-{
-    assert (str != NULL);
-    int i;
-
-    for (i = len - 1; i >= 0; --i) {
-        if (isspace(str[i]) == 0) {
-            return i;
-        }
-    }
-
-    return i;
-}
-
 ib_status_t ib_strtrim_left(
     const uint8_t  *data_in,
     size_t          dlen_in,
@@ -94,10 +43,10 @@ ib_status_t ib_strtrim_left(
     assert(data_out != NULL);
     assert(dlen_out != NULL);
 
-    int offset;
+    size_t offset;
 
-    offset = find_nonws_left(data_in, dlen_in);
-    assert(offset <= (int)dlen_in);
+    offset = ib_scan_nonspace(data_in, dlen_in);
+    assert(offset <= dlen_in);
     *data_out = data_in + offset;
     *dlen_out = dlen_in - offset;
 
@@ -115,11 +64,8 @@ ib_status_t ib_strtrim_right(
     assert(data_out != NULL);
     assert(dlen_out != NULL);
 
-    int offset;
-
-    offset = find_nonws_right(data_in, dlen_in);
     *data_out = data_in;
-    *dlen_out = offset + 1;
+    *dlen_out = ib_scan_nonspace_reverse(data_in, dlen_in);
 
     return IB_OK;
 }
@@ -135,18 +81,20 @@ ib_status_t ib_strtrim_lr(
     assert(data_out != NULL);
     assert(dlen_out != NULL);
 
-    int left_offset;
-    int right_offset;
+    size_t left_offset;
+    size_t right_offset;
 
-    left_offset = find_nonws_left(data_in, dlen_in);
-    if (left_offset == (int)dlen_in) {
+    left_offset = ib_scan_nonspace(data_in, dlen_in);
+    if (left_offset == dlen_in) {
         *data_out = data_in;
         *dlen_out = 0;
         return IB_OK;
     }
-    right_offset = find_nonws_right(data_in, dlen_in);
+    right_offset = ib_scan_nonspace_reverse(
+        data_in + left_offset,
+        dlen_in - left_offset);
     *data_out = data_in + left_offset;
-    *dlen_out = right_offset - left_offset + 1;
+    *dlen_out = right_offset;
 
     return IB_OK;
 }
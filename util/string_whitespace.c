@@ -26,53 +26,86 @@
 
 #include <ironbee/string_whitespace.h>
 
+#include "string_scan_private.h"
+
 #include <assert.h>
-#include <ctype.h>
+#include <string.h>
 
 /**
- * Count the total whitespace and number of whitespace regions.
+ * Copy @a in to @a buf without whitespace.
+ *
+ * @param[out] buf Output buffer of at least @a len bytes.
+ * @param[in] in Input.
+ * @param[in] len Length of @a in.
+ * @param[in] first Offset of the first whitespace in @a in.
  *
- * @param[in] data String.
- * @param[in] dlen Length of @a s.
- * @param[out] spaces Number of whitespace characters.
- * @param[out] regions Number of whitespace regions.
- **/
-void count_ws(
-    const uint8_t *data,
-    size_t         dlen,
-    size_t        *spaces,
-    size_t        *regions
+ * @returns Length written to @a buf.
+ */
+static size_t ws_remove(
+    uint8_t       *buf,
+    const uint8_t *in,
+    size_t         len,
+    size_t         first
 )
 {
-    assert(data != NULL);
-
-    size_t local_spaces = 0;
-    size_t local_regions = 0;
-    local_spaces = 0;
-    local_regions = 0;
-    bool last_char_is_space = false;
-
-    for (size_t i = 0; i < dlen; ++i) {
-        uint8_t c = data[i];
-
-        if (isspace(c)) {
-            ++local_spaces;
-            if (! last_char_is_space) {
-                ++local_regions;
-            }
-            last_char_is_space = true;
-        }
-        else {
-            last_char_is_space = false;
-        }
-    }
+    size_t out = first;
+    size_t i   = first;
+
+    memcpy(buf, in, first);
+
+    /* Alternate between skipping whitespace and copying the run after. */
+    while (i < len) {
+        size_t run;
 
-    if (spaces != NULL) {
-        *spaces = local_spaces;
+        i += ib_scan_nonspace(in + i, len - i);
+        run = ib_scan_space(in + i, len - i);
+        memcpy(buf + out, in + i, run);
+        out += run;
+        i   += run;
     }
-    if (regions != NULL) {
-        *regions = local_regions;
+
+    return out;
+}
+
+/**
+ * Copy @a in to @a buf keeping only the first character of whitespace runs.
+ *
+ * @param[out] buf Output buffer of at least @a len bytes.
+ * @param[in] in Input.
+ * @param[in] len Length of @a in.
+ * @param[in] first Offset of the first of two adjacent whitespace
+ *            characters in @a in.
+ *
+ * @returns Length written to @a buf.
+ */
+static size_t ws_compress(
+    uint8_t       *buf,
+    const uint8_t *in,
+    size_t         len,
+    size_t         first
+)
+{
+    size_t out = first + 1;
+    size_t i   = first + 1;
+
+    memcpy(buf, in, first + 1);
+
+    /* Skip the rest of a whitespace run, then copy up to and including
+     * the first whitespace character of the next run. */
+    while (i < len) {
+        size_t run;
+
+        i += ib_scan_nonspace(in + i, len - i);
+        run = ib_scan_space(in + i, len - i);
+        if (i + run < len) {
+            ++run;
+        }
+        memcpy(buf + out, in + i, run);
+        out += run;
+        i   += run;
     }
+
+    return out;
 }
 
 ib_status_t ib_str_whitespace_remove(
@@ -87,27 +120,49 @@ ib_status_t ib_str_whitespace_remove(
     assert(data_out != NULL);
     assert(dlen_out != NULL);
 
-    size_t spaces = 0;
     uint8_t *buf;
-    uint8_t *cur;
 
-    count_ws(data_in, dlen_in, &spaces, NULL);
-    buf = ib_mm_alloc(mm, dlen_in - spaces);
+    buf = ib_mm_alloc(mm, dlen_in);
     if (buf == NULL) {
         return IB_EALLOC;
     }
 
-    cur = buf;
-    for (size_t i = 0; i < dlen_in; ++i) {
-        uint8_t c = data_in[i];
-        if (! isspace(c)) {
-            *cur = c;
-            ++cur;
-        }
+    *data_out = buf;
+    *dlen_out = ws_remove(
+        buf, data_in, dlen_in,
+        ib_scan_space(data_in, dlen_in));
+
+    return IB_OK;
+}
+
+ib_status_t ib_str_whitespace_remove_const(
+    ib_mm_t          mm,
+    const uint8_t   *data_in,
+    size_t           dlen_in,
+    const uint8_t  **data_out,
+    size_t          *dlen_out
+)
+{
+    assert(data_in != NULL);
+    assert(data_out != NULL);
+    assert(dlen_out != NULL);
+
+    size_t   first = ib_scan_space(data_in, dlen_in);
+    uint8_t *buf;
+
+    if (first == dlen_in) {
+        *data_out = data_in;
+        *dlen_out = dlen_in;
+        return IB_OK;
+    }
+
+    buf = ib_mm_alloc(mm, dlen_in);
+    if (buf == NULL) {
+        return IB_EALLOC;
     }
 
     *data_out = buf;
-    *dlen_out = dlen_in - spaces;
+    *dlen_out = ws_remove(buf, data_in, dlen_in, first);
 
     return IB_OK;
 }
@@ -124,31 +179,54 @@ ib_status_t ib_str_whitespace_compress(
     assert(data_out != NULL);
     assert(dlen_out != NULL);
 
-    size_t spaces = 0;
-    size_t regions = 0;
+    size_t   first = ib_scan_space_pair(data_in, dlen_in);
     uint8_t *buf;
-    uint8_t *cur;
-    bool last_char_is_space = false;
 
-    count_ws(data_in, dlen_in, &spaces, &regions);
-    buf = ib_mm_alloc(mm, dlen_in - spaces + regions);
+    buf = ib_mm_alloc(mm, dlen_in);
     if (buf == NULL) {
         return IB_EALLOC;
     }
 
-    cur = buf;
-    for (size_t i = 0; i < dlen_in; ++i) {
-        uint8_t c = data_in[i];
-        if (! isspace(c) || ! last_char_is_space) {
-            *cur = c;
-            ++cur;
-        }
+    *data_out = buf;
+    if (first == dlen_in) {
+        memcpy(buf, data_in, dlen_in);
+        *dlen_out = dlen_in;
+    }
+    else {
+        *dlen_out = ws_compress(buf, data_in, dlen_in, first);
+    }
 
-        last_char_is_space = isspace(c);
+    return IB_OK;
+}
+
+ib_status_t ib_str_whitespace_compress_const(
+    ib_mm_t          mm,
+    const uint8_t   *data_in,
+    size_t           dlen_in,
+    const uint8_t  **data_out,
+    size_t          *dlen_out
+)
+{
+    assert(data_in != NULL);
+    assert(data_out != NULL);
+    assert(dlen_out != NULL);
+
+    size_t   first = ib_scan_space_pair(data_in, dlen_in);
+    uint8_t *buf;
+
+    if (first == dlen_in) {
+        *data_out = data_in;
+        *dlen_out = dlen_in;
+        return IB_OK;
+    }
+
+    buf = ib_mm_alloc(mm, dlen_in);
+    if (buf == NULL) {
+        return IB_EALLOC;
     }
 
     *data_out = buf;
-    *dlen_out = dlen_in - spaces + regions;
+    *dlen_out = ws_compress(buf, data_in, dlen_in, first);
 
     return IB_OK;
 }
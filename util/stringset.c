@@ -21,6 +21,12 @@
  *
  * See @ref ib_stringset_t for details.
  *
+ * The compiled form built by ib_stringset_init_trie() is a double-array
+ * trie: node @c s has a child for byte @c c iff
+ * `cells[cells[s].base + c].check == s`.  The cells of a node are assigned
+ * at build time so that the children of every node fit in free cells,
+ * making each step of a query a single array access.
+ *
  * @author Christopher Alfeld <calfeld@qualys.com>
  * @nosubgrouping
  */
@@ -30,10 +36,80 @@
 #include <ironbee/stringset.h>
 #include <assert.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+/** Check value of a cell not used by any node. */
+#define TRIE_FREE -1
+
+/** Check value of the root cell. */
+#define TRIE_ROOT -2
+
+/** End of the free cell list. */
+#define TRIE_NONE -1
+
+/**
+ * Number of free cells tried as base for a node before giving up and placing
+ * its children past all used cells.  Bounds construction time at the cost of
+ * some sparsity.
+ **/
+#define TRIE_MAX_ATTEMPTS 64
+
+/** Cell of a double-array trie. */
+typedef struct trie_cell_t trie_cell_t;
+struct trie_cell_t
+{
+    /** Children of this node are at `base + byte`. */
+    int32_t base;
+    /** Node this is a child of, TRIE_FREE, or TRIE_ROOT. */
+    int32_t check;
+    /** Index + 1 of entry ending at this node or 0 if none. */
+    uint32_t entry;
+};
+
+/** See ib_stringset_trie_t. */
+struct ib_stringset_trie_t
+{
+    /** Cells; cell 0 is the root. */
+    const trie_cell_t *cells;
+    /** Number of cells. */
+    size_t num_cells;
+};
+
+/** Links of the doubly linked list of free cells, in index order. */
+typedef struct trie_link_t trie_link_t;
+struct trie_link_t
+{
+    /** Next free cell or TRIE_NONE. */
+    int32_t next;
+    /** Previous free cell or TRIE_NONE. */
+    int32_t prev;
+};
+
+/** State of trie construction.  Cells are malloced until final copy. */
+typedef struct trie_builder_t trie_builder_t;
+struct trie_builder_t
+{
+    /** Sorted entries. */
+    const ib_stringset_entry_t *entries;
+    /** Cells. */
+    trie_cell_t *cells;
+    /** Free list links, parallel to @c cells. */
+    trie_link_t *links;
+    /** Allocated cells. */
+    size_t capacity;
+    /** One more than the highest used cell. */
+    size_t used;
+    /** First free cell or TRIE_NONE. */
+    int32_t free_head;
+    /** Last free cell or TRIE_NONE. */
+    int32_t free_tail;
+    /** Scratch space for the child bytes of the node being placed. */
+    unsigned char labels[256];
+};
+
 /** Is `a` a prefix of a `b`. */
 static
 bool is_prefix(const ib_stringset_entry_t *a, const ib_stringset_entry_t *b)
@@ -81,6 +157,300 @@ bool less(const ib_stringset_entry_t *a, const ib_stringset_entry_t *b)
     return compare(a, b) < 0;
 }
 
+/** Length of longest common prefix of `a` and `b`. */
+static
+size_t common_prefix_length(
+    const ib_stringset_entry_t *a,
+    const ib_stringset_entry_t *b
+)
+{
+    size_t max = a->length < b->length ? a->length : b->length;
+    size_t i = 0;
+
+    while (i < max && a->string[i] == b->string[i]) {
+        ++i;
+    }
+
+    return i;
+}
+
+/** Index of first entry of `set` greater than `key`. */
+static
+size_t upper_bound(
+    const ib_stringset_t       *set,
+    const ib_stringset_entry_t *key
+)
+{
+    /* Based on C++ std::upper_bound() */
+    size_t len = set->num_entries;
+    size_t first = 0;
+
+    while (len > 0) {
+        size_t half = len >> 1;
+        size_t middle = first + half;
+
+        if (less(key, &set->entries[middle])) {
+            len = half;
+        }
+        else {
+            first = middle + 1;
+            len = len - half - 1;
+        }
+    }
+
+    return first;
+}
+
+/** Grow builder cells to at least `size`. */
+static
+ib_status_t trie_reserve(trie_builder_t *builder, size_t size)
+{
+    if (size <= builder->capacity) {
+        return IB_OK;
+    }
+
+    size_t new_capacity = builder->capacity == 0 ? 256 : builder->capacity;
+    while (new_capacity < size) {
+        new_capacity *= 2;
+    }
+    if (new_capacity > INT32_MAX) {
+        return IB_EINVAL;
+    }
+
+    trie_cell_t *cells =
+        realloc(builder->cells, new_capacity * sizeof(*cells));
+    if (cells == NULL) {
+        return IB_EALLOC;
+    }
+    builder->cells = cells;
+
+    trie_link_t *links =
+        realloc(builder->links, new_capacity * sizeof(*links));
+    if (links == NULL) {
+        return IB_EALLOC;
+    }
+    builder->links = links;
+
+    /* New cells are free and follow every existing cell. */
+    for (size_t i = builder->capacity; i < new_capacity; ++i) {
+        cells[i].base  = 0;
+        cells[i].check = TRIE_FREE;
+        cells[i].entry = 0;
+
+        links[i].next = TRIE_NONE;
+        links[i].prev = builder->free_tail;
+        if (builder->free_tail == TRIE_NONE) {
+            builder->free_head = (int32_t)i;
+        }
+        else {
+            links[builder->free_tail].next = (int32_t)i;
+        }
+        builder->free_tail = (int32_t)i;
+    }
+    builder->capacity = new_capacity;
+
+    return IB_OK;
+}
+
+/** Mark free cell `cell` as a child of `node`. */
+static
+void trie_use(trie_builder_t *builder, size_t cell, int32_t node)
+{
+    assert(cell < builder->capacity);
+    assert(builder->cells[cell].check == TRIE_FREE);
+
+    trie_link_t *link = &builder->links[cell];
+
+    if (link->prev == TRIE_NONE) {
+        builder->free_head = link->next;
+    }
+    else {
+        builder->links[link->prev].next = link->next;
+    }
+    if (link->next == TRIE_NONE) {
+        builder->free_tail = link->prev;
+    }
+    else {
+        builder->links[link->next].prev = link->prev;
+    }
+
+    builder->cells[cell].check = node;
+    if (cell + 1 > builder->used) {
+        builder->used = cell + 1;
+    }
+}
+
+/** Would every byte of `labels` land on a free cell with base `b`? */
+static
+bool trie_fits(
+    const trie_builder_t *builder,
+    size_t                b,
+    const unsigned char  *labels,
+    size_t                num_labels
+)
+{
+    for (size_t i = 0; i < num_labels; ++i) {
+        size_t cell = b + labels[i];
+        if (
+            cell < builder->capacity &&
+            builder->cells[cell].check != TRIE_FREE
+        ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Find a base at which every byte of `labels` lands on a free cell.
+ *
+ * Reserves the cells, marking them as children of `node`.
+ **/
+static
+ib_status_t trie_place(
+    trie_builder_t      *builder,
+    int32_t              node,
+    const unsigned char *labels,
+    size_t               num_labels,
+    int32_t             *base
+)
+{
+    assert(num_labels > 0);
+
+    ib_status_t rc;
+    size_t      b;
+    size_t      attempts = 0;
+    int32_t     cell;
+
+    /* Try aligning the smallest label with each free cell in turn. */
+    for (
+        cell = builder->free_head;
+        cell != TRIE_NONE;
+        cell = builder->links[cell].next
+    ) {
+        if ((size_t)cell < labels[0]) {
+            continue;
+        }
+        b = (size_t)cell - labels[0];
+        if (trie_fits(builder, b, labels, num_labels)) {
+            break;
+        }
+        if (++attempts == TRIE_MAX_ATTEMPTS) {
+            cell = TRIE_NONE;
+            break;
+        }
+    }
+    if (cell == TRIE_NONE) {
+        /* Every cell past the last used one is free. */
+        b = builder->used > labels[0] ? builder->used - labels[0] : 0;
+    }
+
+    rc = trie_reserve(builder, b + labels[num_labels - 1] + 1);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    for (size_t i = 0; i < num_labels; ++i) {
+        trie_use(builder, b + labels[i], node);
+    }
+
+    *base = (int32_t)b;
+
+    return IB_OK;
+}
+
+/**
+ * Build the subtrie at `node` for entries [`lo`, `hi`).
+ *
+ * All entries in the range have length at least `depth` and share the
+ * prefix of length `depth` spelled by the path to `node`.
+ **/
+static
+ib_status_t trie_build(
+    trie_builder_t *builder,
+    int32_t         node,
+    size_t          lo,
+    size_t          hi,
+    size_t          depth
+)
+{
+    const ib_stringset_entry_t *entries = builder->entries;
+    unsigned char *labels     = builder->labels;
+    size_t         num_labels = 0;
+    int32_t        base;
+    ib_status_t    rc;
+
+    /* Entries ending here sort first.  As with the binary search, the last
+     * of equal entries wins. */
+    while (lo < hi && entries[lo].length == depth) {
+        builder->cells[node].entry = (uint32_t)(lo + 1);
+        ++lo;
+    }
+    if (lo == hi) {
+        return IB_OK;
+    }
+
+    /* Remaining entries are grouped by their next byte. */
+    for (size_t i = lo; i < hi; ++i) {
+        unsigned char c = (unsigned char)entries[i].string[depth];
+        if (num_labels == 0 || labels[num_labels - 1] != c) {
+            labels[num_labels] = c;
+            ++num_labels;
+        }
+    }
+
+    /* All children are placed before any is built, so labels may be
+     * reused by the recursion. */
+    rc = trie_place(builder, node, labels, num_labels, &base);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    builder->cells[node].base = base;
+
+    while (lo < hi) {
+        unsigned char c = (unsigned char)entries[lo].string[depth];
+        size_t end = lo + 1;
+
+        while (end < hi && (unsigned char)entries[end].string[depth] == c) {
+            ++end;
+        }
+        rc = trie_build(builder, base + c, lo, end, depth + 1);
+        if (rc != IB_OK) {
+            return rc;
+        }
+        lo = end;
+    }
+
+    return IB_OK;
+}
+
+/** Query a set via its trie. */
+static
+const ib_stringset_entry_t *trie_query(
+    const ib_stringset_t *set,
+    const char           *string,
+    size_t                string_length
+)
+{
+    const trie_cell_t *cells     = set->trie->cells;
+    const size_t       num_cells = set->trie->num_cells;
+    uint32_t           best      = cells[0].entry;
+    int32_t            node      = 0;
+
+    for (size_t i = 0; i < string_length; ++i) {
+        size_t next = (size_t)cells[node].base + (unsigned char)string[i];
+
+        if (next >= num_cells || cells[next].check != node) {
+            break;
+        }
+        node = (int32_t)next;
+        if (cells[node].entry != 0) {
+            best = cells[node].entry;
+        }
+    }
+
+    return best == 0 ? NULL : &set->entries[best - 1];
+}
+
 ib_status_t ib_stringset_init(
     ib_stringset_t       *set,
     ib_stringset_entry_t *entries,
@@ -92,12 +462,72 @@ ib_status_t ib_stringset_init(
 
     set->entries = entries;
     set->num_entries = num_entries;
+    set->trie = NULL;
 
     qsort((void *)set->entries, num_entries, sizeof(*entries), compare);
 
     return IB_OK;
 }
 
+ib_status_t ib_stringset_init_trie(
+    ib_stringset_t       *set,
+    ib_stringset_entry_t *entries,
+    size_t                num_entries,
+    ib_mm_t               mm
+)
+{
+    assert(set != NULL);
+    assert(entries != NULL);
+
+    ib_status_t          rc;
+    trie_builder_t       builder;
+    ib_stringset_trie_t *trie;
+    trie_cell_t         *cells;
+
+    if (num_entries >= UINT32_MAX) {
+        return IB_EINVAL;
+    }
+
+    rc = ib_stringset_init(set, entries, num_entries);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    builder.entries   = entries;
+    builder.cells     = NULL;
+    builder.links     = NULL;
+    builder.capacity  = 0;
+    builder.used      = 0;
+    builder.free_head = TRIE_NONE;
+    builder.free_tail = TRIE_NONE;
+
+    rc = trie_reserve(&builder, 1);
+    if (rc != IB_OK) {
+        goto finish;
+    }
+    trie_use(&builder, 0, TRIE_ROOT);
+
+    rc = trie_build(&builder, 0, 0, num_entries, 0);
+    if (rc != IB_OK) {
+        goto finish;
+    }
+
+    trie = ib_mm_alloc(mm, sizeof(*trie));
+    cells = ib_mm_memdup(mm, builder.cells, builder.used * sizeof(*cells));
+    if (trie == NULL || cells == NULL) {
+        rc = IB_EALLOC;
+        goto finish;
+    }
+    trie->cells     = cells;
+    trie->num_cells = builder.used;
+    set->trie       = trie;
+
+finish:
+    free(builder.cells);
+    free(builder.links);
+    return rc;
+}
+
 ib_status_t ib_stringset_query(
     const ib_stringset_t        *set,
     const char                  *string,
@@ -108,33 +538,38 @@ ib_status_t ib_stringset_query(
     assert(set != NULL);
     assert(string != NULL);
 
-    ib_stringset_entry_t key = {string, string_length, NULL};
+    const ib_stringset_entry_t *result = NULL;
 
-    /* Based on C++ std::upper_bound() */
-    size_t len = set->num_entries;
-    size_t first = 0;
+    if (set->trie != NULL) {
+        result = trie_query(set, string, string_length);
+    }
+    else {
+        ib_stringset_entry_t key = {string, string_length, NULL};
 
-    while (len > 0) {
-        size_t half = len >> 1;
-        size_t middle = first + half;
+        /* The greatest entry not greater than key shares any prefix of key
+         * in the set.  If it is not itself a prefix, retry with key cut to
+         * their common prefix. */
+        for (;;) {
+            size_t first = upper_bound(set, &key);
+            const ib_stringset_entry_t *candidate;
 
-        if (less(&key, &set->entries[middle])) {
-            len = half;
-        }
-        else {
-            first = middle + 1;
-            len = len - half - 1;
+            if (first == 0) {
+                break;
+            }
+            candidate = &set->entries[first - 1];
+            if (is_prefix(candidate, &key)) {
+                result = candidate;
+                break;
+            }
+            key.length = common_prefix_length(candidate, &key);
         }
     }
 
-    /* At this point, first is the first element greater than key. */
-    if (first != 0 && is_prefix(&set->entries[first - 1], &key)) {
-        if (out_entry != NULL) {
-            *out_entry = &set->entries[first - 1];
-        }
-        return IB_OK;
-    }
-    else {
+    if (result == NULL) {
         return IB_ENOENT;
     }
+    if (out_entry != NULL) {
+        *out_entry = result;
+    }
+    return IB_OK;
 }
@@ -0,0 +1,111 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- Atom Tests
+ **/
+
+#include "ironbee_config_auto.h"
+#include "gtest/gtest.h"
+
+#include <ironbee/atom.h>
+#include <ironbee/string.h>
+
+#include <ironbeepp/memory_manager.hpp>
+#include <ironbeepp/memory_pool_lite.hpp>
+
+#include <string>
+
+using namespace std;
+using namespace IronBee;
+
+class TestAtom : public ::testing::Test
+{
+public:
+    TestAtom() : m_mm(MemoryManager(m_mpl).ib())
+    {
+        EXPECT_EQ(IB_OK, ib_atom_table_create(&m_table, m_mm));
+    }
+
+protected:
+    ScopedMemoryPoolLite m_mpl;
+    ib_mm_t m_mm;
+    ib_atom_table_t *m_table;
+};
+
+TEST_F(TestAtom, Intern)
+{
+    const ib_atom_t *a;
+    const ib_atom_t *b;
+    const ib_atom_t *c;
+    const char *name;
+    size_t name_length;
+
+    ASSERT_EQ(IB_OK, ib_atom_intern(m_table, IB_S2SL("Content-Type"), &a));
+    ASSERT_EQ(IB_OK, ib_atom_intern(m_table, IB_S2SL("content-TYPE"), &b));
+    ASSERT_EQ(IB_OK, ib_atom_intern(m_table, IB_S2SL("Host"), &c));
+
+    EXPECT_EQ(a, b);
+    EXPECT_NE(a, c);
+    EXPECT_EQ(0UL, ib_atom_id(a));
+    EXPECT_EQ(1UL, ib_atom_id(c));
+    EXPECT_EQ(2UL, ib_atom_table_size(m_table));
+
+    ib_atom_name(a, &name, &name_length);
+    EXPECT_EQ("Content-Type", string(name, name_length));
+    EXPECT_EQ('\0', name[name_length]);
+}
+
+TEST_F(TestAtom, Bounded)
+{
+    const ib_atom_t *a;
+    const ib_atom_t *b;
+
+    ASSERT_EQ(IB_OK, ib_atom_intern(m_table, "abcdef", 3, &a));
+    ASSERT_EQ(IB_OK, ib_atom_intern(m_table, IB_S2SL("ABC"), &b));
+    EXPECT_EQ(a, b);
+    ASSERT_EQ(IB_OK, ib_atom_intern(m_table, "", 0, &b));
+    EXPECT_NE(a, b);
+}
+
+TEST_F(TestAtom, Lookup)
+{
+    const ib_atom_t *a;
+    const ib_atom_t *b;
+
+    EXPECT_EQ(IB_ENOENT, ib_atom_lookup(m_table, IB_S2SL("ARGS"), &a));
+    EXPECT_EQ(0UL, ib_atom_table_size(m_table));
+
+    ASSERT_EQ(IB_OK, ib_atom_intern(m_table, IB_S2SL("ARGS"), &a));
+    ASSERT_EQ(IB_OK, ib_atom_lookup(m_table, IB_S2SL("args"), &b));
+    EXPECT_EQ(a, b);
+}
+
+TEST_F(TestAtom, Freeze)
+{
+    const ib_atom_t *a;
+    const ib_atom_t *b;
+
+    ASSERT_EQ(IB_OK, ib_atom_intern(m_table, IB_S2SL("foo"), &a));
+    ib_atom_table_freeze(m_table);
+
+    EXPECT_EQ(IB_OK, ib_atom_intern(m_table, IB_S2SL("FOO"), &b));
+    EXPECT_EQ(a, b);
+    EXPECT_EQ(IB_ENOENT, ib_atom_intern(m_table, IB_S2SL("bar"), &b));
+    EXPECT_EQ(1UL, ib_atom_table_size(m_table));
+}
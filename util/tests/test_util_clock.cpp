@@ -444,3 +444,83 @@ TEST(TestClock, test_timeval_add)
     ASSERT_EQ(0, ib_clock_timeval_cmp(&tv2, &exp));
 }
 
+
+TEST(TestClock, test_mode_coarse)
+{
+    ib_time_t    time1;
+    ib_time_t    time2;
+    ib_timeval_t itv;
+    struct timeval tv;
+
+    ib_clock_mode_set(IB_CLOCK_MODE_COARSE);
+    ASSERT_EQ(IB_CLOCK_MODE_COARSE, ib_clock_mode());
+
+    time1 = ib_clock_get_time();
+    usleep(50000);
+    time2 = ib_clock_get_time();
+    ASSERT_GT(time2, time1);
+    ASSERT_LT(time2 - time1, 200000U);
+    ASSERT_GE(time2 - time1, 40000U);
+
+    /* The precise clock is not subject to the mode. */
+    time1 = ib_clock_precise_get_time();
+    usleep(100);
+    time2 = ib_clock_precise_get_time();
+    ASSERT_GT(time2, time1);
+
+    gettimeofday(&tv, NULL);
+    ib_clock_gettimeofday(&itv);
+    ASSERT_TRUE(Compare(tv, itv, 0.05));
+
+    ib_clock_mode_set(IB_CLOCK_MODE_PRECISE);
+}
+
+TEST(TestClock, test_mode_cached)
+{
+    ib_time_t    time1;
+    ib_time_t    time2;
+    ib_timeval_t itv;
+    struct timeval tv;
+
+    ASSERT_EQ(IB_EINVAL, ib_clock_ticker_start(0));
+    ASSERT_EQ(IB_OK, ib_clock_ticker_start(1000));
+    ib_clock_mode_set(IB_CLOCK_MODE_CACHED);
+
+    time1 = ib_clock_get_time();
+    ASSERT_NE(0U, time1);
+    usleep(50000);
+    time2 = ib_clock_get_time();
+    ASSERT_GT(time2, time1);
+    ASSERT_LT(time2 - time1, 200000U);
+    ASSERT_GE(time2 - time1, 40000U);
+
+    gettimeofday(&tv, NULL);
+    ib_clock_gettimeofday(&itv);
+    ASSERT_TRUE(Compare(tv, itv, 0.05));
+
+    /* A second reference keeps the ticker running, at the smallest
+     * interval of the references. */
+    ASSERT_EQ(1000U, ib_clock_ticker_interval());
+    ASSERT_EQ(IB_OK, ib_clock_ticker_start(500));
+    ASSERT_EQ(500U, ib_clock_ticker_interval());
+    ib_clock_ticker_stop(500);
+    ASSERT_EQ(1000U, ib_clock_ticker_interval());
+    time1 = ib_clock_get_time();
+    usleep(20000);
+    ASSERT_GT(ib_clock_get_time(), time1);
+    ib_clock_ticker_stop(1000);
+    ASSERT_EQ(0U, ib_clock_ticker_interval());
+
+    /* Without a ticker the cached mode reads the clock. */
+    time1 = ib_clock_get_time();
+    ASSERT_NE(0U, time1);
+    usleep(20000);
+    ASSERT_GT(ib_clock_get_time(), time1);
+
+    /* Restarting works. */
+    ASSERT_EQ(IB_OK, ib_clock_ticker_start(1000));
+    ASSERT_NE(0U, ib_clock_get_time());
+    ib_clock_ticker_stop(1000);
+
+    ib_clock_mode_set(IB_CLOCK_MODE_PRECISE);
+}
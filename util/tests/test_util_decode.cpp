@@ -29,6 +29,8 @@
 
 #include <ironbeepp/all.hpp>
 
+#include <boost/function.hpp>
+
 #include "gtest/gtest.h"
 
 using namespace std;
@@ -36,6 +38,38 @@ using namespace IronBee;
 
 namespace {
 
+string decode_const(
+    boost::function<
+        ib_status_t(
+            ib_mm_t          mm,
+            const uint8_t   *data_in,
+            size_t           dlen_in,
+            const uint8_t  **data_out,
+            size_t          *dlen_out
+        )
+    > which,
+    const string& s,
+    bool *same = NULL
+)
+{
+    ScopedMemoryPoolLite mpl;
+
+    const uint8_t *out = NULL;
+    size_t out_len = 0;
+
+    throw_if_error(
+        which(
+            MemoryManager(mpl).ib(),
+            reinterpret_cast<const uint8_t*>(s.data()), s.length(),
+            &out, &out_len
+        )
+    );
+    if (same != NULL) {
+        *same = (out == reinterpret_cast<const uint8_t*>(s.data()));
+    }
+    return string(reinterpret_cast<const char*>(out), out_len);
+}
+
 string decode_url(const string& s)
 {
     vector<char> result(s.length() + 20);
@@ -89,6 +123,53 @@ TEST(TestUtilDecodeUrl, Invalid)
     EXPECT_EQ("%gg", "%gg");
 }
 
+TEST(TestUtilDecodeUrl, Const)
+{
+    bool same;
+
+    EXPECT_EQ("TestCase", decode_const(ib_util_decode_url_const, "TestCase", &same));
+    EXPECT_TRUE(same);
+    EXPECT_EQ("Test Case", decode_const(ib_util_decode_url_const, "Test+Case", &same));
+    EXPECT_FALSE(same);
+    EXPECT_EQ("Test Case", decode_const(ib_util_decode_url_const, "Test%20Case", &same));
+    EXPECT_FALSE(same);
+}
+
+TEST(TestUtilDecodeUrl, Long)
+{
+    /* Put an escape at every offset around the vector widths. */
+    for (size_t i = 0; i < 70; ++i) {
+        string s(70, 'a');
+        string expected(s);
+
+        s.replace(i, 1, "%41");
+        expected[i] = 'A';
+        EXPECT_EQ(expected, decode_url(s));
+        EXPECT_EQ(expected, decode_const(ib_util_decode_url_const, s));
+
+        s = string(70, 'a');
+        s[i] = '+';
+        expected = string(70, 'a');
+        expected[i] = ' ';
+        EXPECT_EQ(expected, decode_url(s));
+    }
+}
+
+TEST(TestUtilDecodeUrl, InPlace)
+{
+    string s("a%41b+c%4%zz%42");
+    size_t len;
+
+    throw_if_error(
+        ib_util_decode_url(
+            reinterpret_cast<const uint8_t*>(s.data()), s.length(),
+            reinterpret_cast<uint8_t *>(&s[0]),
+            &len
+        )
+    );
+    EXPECT_EQ("aAb c%4%zzB", s.substr(0, len));
+}
+
 namespace {
 
 string decode_html_entity(const string& s)
@@ -126,3 +207,41 @@ TEST(TestUtilHTMLEntity, Invalid)
     EXPECT_EQ("&#xg;&#Xg;&#xg0;\x02g;&#a;\0&#a2;\x03""a&#a00;\x01""a0;\x0a""a;&foo;", decode_html_entity("&#xg;&#Xg;&#xg0;&#X2g;&#a;\0&#a2;&#3" "a&#a00;&#1""a0;&#10a;&foo;"));
     EXPECT_EQ("&#xg&#Xg&#xg0\x02g&#a\0&#a2\x03""a&#a00\x01""a0\x0a""a&foo", decode_html_entity("&#xg&#Xg&#xg0&#X2g&#a\0&#a2&#3a" "&#a00&#1" "a0&#10a&foo"));
 }
+
+TEST(TestUtilHTMLEntity, Const)
+{
+    bool same;
+
+    EXPECT_EQ("TestCase", decode_const(ib_util_decode_html_entity_const, "TestCase", &same));
+    EXPECT_TRUE(same);
+    EXPECT_EQ("Test&Case", decode_const(ib_util_decode_html_entity_const, "Test&amp;Case", &same));
+    EXPECT_FALSE(same);
+    EXPECT_EQ("Test&foo;", decode_const(ib_util_decode_html_entity_const, "Test&foo;", &same));
+    EXPECT_FALSE(same);
+}
+
+TEST(TestUtilHTMLEntity, Long)
+{
+    for (size_t i = 0; i < 70; ++i) {
+        string s(70, 'a');
+        string expected(s);
+
+        s.replace(i, 1, "&lt;");
+        expected[i] = '<';
+        EXPECT_EQ(expected, decode_html_entity(s));
+        EXPECT_EQ(expected, decode_const(ib_util_decode_html_entity_const, s));
+    }
+}
+
+TEST(TestUtilHTMLEntity, Edge)
+{
+    /* Names are not case sensitive and too long names are not entities. */
+    EXPECT_EQ("<>\xc0", decode_html_entity("&LT;&Gt;&agrave;"));
+    EXPECT_EQ("&abcdefgh;", decode_html_entity("&abcdefgh;"));
+    /* Out of range numbers saturate as strtol() does. */
+    EXPECT_EQ("\xff", decode_html_entity("&#99999999999999999999999;"));
+    EXPECT_EQ("\xff", decode_html_entity("&#xffffffffffffffffffffff;"));
+    EXPECT_EQ("&", decode_html_entity("&"));
+    EXPECT_EQ("&#", decode_html_entity("&#"));
+    EXPECT_EQ("&#x", decode_html_entity("&#x"));
+}
@@ -31,8 +31,14 @@
 #include "simple_fixture.hpp"
 
 #include <ironbee/mm.h>
+#include <ironbee/mm_mpool.h>
+#include <ironbee/mpool.h>
+
+#include <boost/lexical_cast.hpp>
 
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 class TestIBUtilHash : public SimpleFixture
 {
@@ -114,6 +120,7 @@ TEST_F(TestIBUtilHash, test_hash_ex)
         &hash,
         MM(),
         32,
+        IB_HASH_LAYOUT_CHAINED,
         ib_hashfunc_djb2, NULL,
         ib_hashequal_default, NULL
     ));
@@ -361,6 +368,7 @@ TEST_F(TestIBUtilHash, test_hash_collision_delete)
         &hash,
         MM(),
         32,
+        IB_HASH_LAYOUT_CHAINED,
         test_hash_delete_hashfunc, NULL,
         ib_hashequal_default, NULL
     ));
@@ -432,6 +440,7 @@ TEST_F(TestIBUtilHash, bad_size) {
         &hash,
         MM(),
         3,
+        IB_HASH_LAYOUT_CHAINED,
         ib_hashfunc_djb2, NULL,
         ib_hashequal_default, NULL
     ));
@@ -515,3 +524,191 @@ TEST_F(TestIBUtilHash, non_printable_keys) {
     hash_data = NULL;
     ASSERT_EQ(IB_ENOENT, ib_hash_get(hash, &hash_data, key));
 }
+
+TEST_F(TestIBUtilHash, flat_set_get_remove)
+{
+    ib_hash_t  *hash  = NULL;
+    const char *value = NULL;
+
+    ASSERT_EQ(IB_OK, ib_hash_create_ex(
+        &hash,
+        MM(),
+        4,
+        IB_HASH_LAYOUT_FLAT,
+        ib_hashfunc_djb2_nocase, NULL,
+        ib_hashequal_nocase, NULL
+    ));
+
+    ASSERT_EQ(IB_OK, ib_hash_set(hash, "Key", (void *)"value"));
+    ASSERT_EQ(IB_OK, ib_hash_set(hash, "Key2", (void *)"value2"));
+    EXPECT_EQ(2UL, ib_hash_size(hash));
+
+    EXPECT_EQ(IB_OK, ib_hash_get(hash, &value, "kEY"));
+    EXPECT_STREQ("value", value);
+    EXPECT_EQ(IB_OK, ib_hash_get(hash, &value, "KEY2"));
+    EXPECT_STREQ("value2", value);
+    EXPECT_EQ(IB_ENOENT, ib_hash_get(hash, &value, "noKey"));
+    EXPECT_FALSE(value);
+
+    ASSERT_EQ(IB_OK, ib_hash_set(hash, "KEY", (void *)"other"));
+    EXPECT_EQ(2UL, ib_hash_size(hash));
+    EXPECT_EQ(IB_OK, ib_hash_get(hash, &value, "key"));
+    EXPECT_STREQ("other", value);
+
+    EXPECT_EQ(IB_OK, ib_hash_remove(hash, &value, "key"));
+    EXPECT_STREQ("other", value);
+    EXPECT_EQ(1UL, ib_hash_size(hash));
+    EXPECT_EQ(IB_ENOENT, ib_hash_get(hash, &value, "key"));
+    EXPECT_EQ(IB_ENOENT, ib_hash_remove(hash, NULL, "key"));
+
+    ib_hash_clear(hash);
+    EXPECT_EQ(0UL, ib_hash_size(hash));
+    EXPECT_EQ(IB_ENOENT, ib_hash_get(hash, &value, "key2"));
+}
+
+TEST_F(TestIBUtilHash, flat_collision_delete)
+{
+    ib_hash_t *hash = NULL;
+    static const char* keys[] = {
+        "a", "b", "c", "d", "e", "f", "g", "h", "i", "j",
+        "k", "l", "m", "n", "o", "p", "q", "r", "s", "t"
+    };
+    static const size_t num_keys = sizeof(keys) / sizeof(*keys);
+    const char* value = NULL;
+
+    // Every key has the same hash value and so the same tag.
+    ASSERT_EQ(IB_OK, ib_hash_create_ex(
+        &hash,
+        MM(),
+        16,
+        IB_HASH_LAYOUT_FLAT,
+        test_hash_delete_hashfunc, NULL,
+        ib_hashequal_default, NULL
+    ));
+
+    for (size_t i = 0; i < num_keys; ++i) {
+        ASSERT_EQ(IB_OK, ib_hash_set(hash, keys[i], (void *)keys[i]));
+    }
+    EXPECT_EQ(num_keys, ib_hash_size(hash));
+
+    for (size_t i = 0; i < num_keys; i += 2) {
+        ASSERT_EQ(IB_OK, ib_hash_set(hash, keys[i], NULL));
+    }
+    EXPECT_EQ(num_keys / 2, ib_hash_size(hash));
+
+    for (size_t i = 0; i < num_keys; ++i) {
+        if (i % 2 == 0) {
+            EXPECT_EQ(IB_ENOENT, ib_hash_get(hash, &value, keys[i]));
+        }
+        else {
+            EXPECT_EQ(IB_OK, ib_hash_get(hash, &value, keys[i]));
+            EXPECT_EQ(keys[i], value);
+        }
+    }
+}
+
+TEST_F(TestIBUtilHash, flat_grow_and_churn)
+{
+    ib_hash_t *hash = NULL;
+    std::vector<std::string> keys;
+
+    ASSERT_EQ(IB_OK, ib_hash_create_ex(
+        &hash,
+        MM(),
+        16,
+        IB_HASH_LAYOUT_FLAT,
+        ib_hashfunc_djb2, NULL,
+        ib_hashequal_default, NULL
+    ));
+
+    for (int i = 0; i < 1000; ++i) {
+        keys.push_back("key" + boost::lexical_cast<std::string>(i));
+    }
+
+    // Repeated insert and remove exercises tombstone reclamation.
+    for (int round = 0; round < 3; ++round) {
+        for (size_t i = 0; i < keys.size(); ++i) {
+            ASSERT_EQ(
+                IB_OK,
+                ib_hash_set(hash, keys[i].c_str(), (void *)&keys[i])
+            );
+        }
+        EXPECT_EQ(keys.size(), ib_hash_size(hash));
+        for (size_t i = 0; i < keys.size(); i += 3) {
+            ASSERT_EQ(IB_OK, ib_hash_remove(hash, NULL, keys[i].c_str()));
+        }
+    }
+
+    size_t expected = keys.size() - (keys.size() + 2) / 3;
+    EXPECT_EQ(expected, ib_hash_size(hash));
+
+    for (size_t i = 0; i < keys.size(); ++i) {
+        std::string *value = NULL;
+        if (i % 3 == 0) {
+            EXPECT_EQ(IB_ENOENT, ib_hash_get(hash, &value, keys[i].c_str()));
+        }
+        else {
+            ASSERT_EQ(IB_OK, ib_hash_get(hash, &value, keys[i].c_str()));
+            EXPECT_EQ(&keys[i], value);
+        }
+    }
+
+    size_t seen = 0;
+    ib_hash_iterator_t *i = ib_hash_iterator_create(MM());
+    for (
+        ib_hash_iterator_first(i, hash);
+        ! ib_hash_iterator_at_end(i);
+        ib_hash_iterator_next(i)
+    ) {
+        const char  *key;
+        size_t       key_length;
+        std::string *value;
+
+        ib_hash_iterator_fetch(&key, &key_length, &value, i);
+        EXPECT_EQ(*value, std::string(key, key_length));
+
+        // Removing the current entry does not invalidate the iterator.
+        ASSERT_EQ(IB_OK, ib_hash_remove_ex(hash, NULL, key, key_length));
+        ++seen;
+    }
+    EXPECT_EQ(expected, seen);
+    EXPECT_EQ(0UL, ib_hash_size(hash));
+}
+
+TEST_F(TestIBUtilHash, flat_churn_memory_bounded)
+{
+    ib_mpool_t *mp;
+    ib_hash_t  *hash = NULL;
+    size_t      inuse = 0;
+    std::vector<std::string> keys;
+
+    ASSERT_EQ(IB_OK, ib_mpool_create(&mp, "flat_churn", NULL));
+    ASSERT_EQ(IB_OK, ib_hash_create_ex(
+        &hash,
+        ib_mm_mpool(mp),
+        16,
+        IB_HASH_LAYOUT_FLAT,
+        ib_hashfunc_djb2, NULL,
+        ib_hashequal_default, NULL
+    ));
+
+    for (int i = 0; i < 200000; ++i) {
+        keys.push_back("key" + boost::lexical_cast<std::string>(i));
+    }
+
+    // Keep 100 keys while inserting distinct ones, rehashing many times.
+    for (size_t i = 0; i < keys.size(); ++i) {
+        ASSERT_EQ(IB_OK, ib_hash_set(hash, keys[i].c_str(), (void *)&keys[i]));
+        if (i >= 100) {
+            ASSERT_EQ(IB_OK, ib_hash_remove(hash, NULL, keys[i - 100].c_str()));
+        }
+        if (i == 1000) {
+            inuse = ib_mpool_inuse(mp);
+        }
+    }
+
+    EXPECT_EQ(100UL, ib_hash_size(hash));
+    EXPECT_EQ(inuse, ib_mpool_inuse(mp));
+
+    ib_mpool_destroy(mp);
+}
@@ -26,8 +26,11 @@
 
 #include "ironbee_config_auto.h"
 #include "gtest/gtest.h"
+#include "simple_fixture.hpp"
 
 #include <ironbee/ipset.h>
+#include <ironbee/mm_mpool.h>
+#include <ironbee/mpool.h>
 
 #include <stdexcept>
 #include <set>
@@ -43,7 +46,7 @@
 
 using namespace std;
 
-class TestIPSet : public ::testing::Test
+class TestIPSet : public SimpleFixture
 {
 protected:
     // Helper routines.
@@ -132,6 +135,68 @@ protected:
         set_bit(ip.ip[bit / 32], bit % 32, value);
     }
 
+    /** True iff @a net contains @a ip. */
+    bool contains(const ib_ip4_network_t& net, ib_ip4_t ip)
+    {
+        ib_ip4_t mask;
+        make_ones(mask, net.size);
+        return (ip & mask) == (net.ip & mask);
+    }
+
+    /** Overload of above for v6. */
+    bool contains(const ib_ip6_network_t& net, const ib_ip6_t& ip)
+    {
+        ib_ip6_t mask;
+        make_ones(mask, net.size);
+        for (size_t i = 0; i < 4; ++i) {
+            if ((ip.ip[i] & mask.ip[i]) != (net.ip.ip[i] & mask.ip[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Brute force query of @a negative and @a positive for @a ip.
+     *
+     * @a specific is the last of the longest containing positive entries
+     * and @a general the first of the shortest.
+     */
+    template <typename EntryType, typename IPType>
+    ib_status_t reference_query(
+        const vector<EntryType>& negative,
+        const vector<EntryType>& positive,
+        const IPType&            ip,
+        const EntryType*&        specific,
+        const EntryType*&        general
+    )
+    {
+        specific = general = NULL;
+        for (size_t i = 0; i < negative.size(); ++i) {
+            if (contains(negative[i].network, ip)) {
+                return IB_ENOENT;
+            }
+        }
+        for (size_t i = 0; i < positive.size(); ++i) {
+            if (! contains(positive[i].network, ip)) {
+                continue;
+            }
+            if (
+                specific == NULL ||
+                positive[i].network.size >= specific->network.size
+            ) {
+                specific = &positive[i];
+            }
+            if (
+                general == NULL ||
+                positive[i].network.size < general->network.size
+            ) {
+                general = &positive[i];
+            }
+        }
+        return specific == NULL ? IB_ENOENT : IB_OK;
+    }
+
     /** Set @a ip to be @a num_ones 1s followed by zeros. */
     void make_ones(ib_ip4_t& ip, size_t num_ones)
     {
@@ -620,3 +685,226 @@ TEST_F(TestIPSet, Inval)
         ib_ipset6_query(NULL, ib_ip6_t(), NULL, NULL, NULL)
     );
 }
+
+TEST_F(TestIPSet, Compiled4)
+{
+    ib_status_t rc;
+    ib_ipset4_t set;
+    vector<ib_ipset4_entry_t> positive;
+    vector<ib_ipset4_entry_t> negative;
+
+    static int marker_a = 1;
+    static int marker_b = 2;
+    static int marker_c = 3;
+
+    positive.push_back(entry4(2, 1, 0, 0, 16));
+    positive.push_back(entry4(2, 6, 1, 0, 24));
+    positive.push_back(entry4(1, 0, 0, 0, 8, &marker_a));
+    positive.push_back(entry4(2, 0, 0, 0, 8, &marker_b));
+    positive.push_back(entry4(2, 3, 0, 0, 16));
+    positive.push_back(entry4(2, 3, 1, 0, 24));
+    positive.push_back(entry4(2, 3, 1, 0, 30, &marker_c));
+
+    negative.push_back(entry4(2, 5, 128, 0, 17));
+    negative.push_back(entry4(2, 3, 1,   2, 31));
+    negative.push_back(entry4(3, 0, 0,   0, 8));
+
+    rc = ib_ipset4_init_compiled(
+        &set,
+        negative.data(), negative.size(),
+        positive.data(), positive.size(),
+        MM()
+    );
+    ASSERT_EQ(IB_OK, rc);
+
+    const ib_ipset4_entry_t* entry    = NULL;
+    const ib_ipset4_entry_t* specific = NULL;
+    const ib_ipset4_entry_t* general  = NULL;
+
+    rc = ib_ipset4_query(
+        &set, ip4(1, 2, 100, 20),
+        &entry, &specific, &general
+    );
+    EXPECT_EQ(IB_OK, rc);
+    EXPECT_EQ(entry, specific);
+    EXPECT_EQ(entry, general);
+    EXPECT_EQ(&marker_a, reinterpret_cast<const int*>(entry->data));
+    rc = ib_ipset4_query(
+        &set, ip4(2, 3, 1, 1),
+        &entry, &specific, &general
+    );
+    EXPECT_EQ(IB_OK, rc);
+    EXPECT_LT(general, specific);
+    EXPECT_EQ(&marker_b, reinterpret_cast<const int*>(general->data));
+    EXPECT_EQ(&marker_c, reinterpret_cast<const int*>(specific->data));
+    rc = ib_ipset4_query(
+        &set, ip4(2, 3, 1, 3),
+        &entry, &specific, &general
+    );
+    EXPECT_EQ(IB_ENOENT, rc);
+    EXPECT_FALSE(entry);
+    rc = ib_ipset4_query(
+        &set, ip4(2, 5, 130, 1),
+        &entry, &specific, &general
+    );
+    EXPECT_EQ(IB_ENOENT, rc);
+    EXPECT_FALSE(specific);
+    EXPECT_FALSE(general);
+    rc = ib_ipset4_query(
+        &set, ip4(4, 0, 0, 1),
+        &entry, &specific, &general
+    );
+    EXPECT_EQ(IB_ENOENT, rc);
+}
+
+TEST_F(TestIPSet, CompiledRandom4)
+{
+    static const size_t c_num_networks = 2000;
+    static const size_t c_num_tests = (size_t)1e5;
+
+    ib_status_t rc;
+    ib_ipset4_t set;
+    vector<ib_ipset4_entry_t> positive;
+    vector<ib_ipset4_entry_t> negative;
+
+    // Networks share a few prefixes so that they nest and overlap.
+    for (size_t i = 0; i < c_num_networks; ++i) {
+        ib_ipset4_entry_t entry;
+        entry.network.ip = (random(0, 3) << 28) | random(0, 0x00ffffff);
+        entry.network.size = random(0, 32);
+        entry.data = NULL;
+        entry.network.ip &= entry.network.size == 0 ?
+            0 : ~(0xffffffff >> entry.network.size);
+        (random(0, 3) == 0 ? negative : positive).push_back(entry);
+    }
+
+    rc = ib_ipset4_init_compiled(
+        &set,
+        negative.data(), negative.size(),
+        positive.data(), positive.size(),
+        MM()
+    );
+    ASSERT_EQ(IB_OK, rc);
+
+    for (size_t i = 0; i < c_num_tests; ++i) {
+        const ib_ipset4_entry_t* specific = NULL;
+        const ib_ipset4_entry_t* general  = NULL;
+        const ib_ipset4_entry_t* expected_specific;
+        const ib_ipset4_entry_t* expected_general;
+        ib_ip4_t ip = (random(0, 3) << 28) | random(0, 0x00ffffff);
+
+        ib_status_t expected = reference_query(
+            negative, positive, ip, expected_specific, expected_general
+        );
+        rc = ib_ipset4_query(&set, ip, NULL, &specific, &general);
+        ASSERT_EQ(expected, rc);
+        ASSERT_EQ(expected_specific, specific);
+        ASSERT_EQ(expected_general, general);
+    }
+}
+
+TEST_F(TestIPSet, CompiledSize4)
+{
+    static const size_t c_num_networks = 1024;
+
+    ib_mpool_t *mp;
+    ib_ipset4_t set;
+    vector<ib_ipset4_entry_t> positive;
+
+    // A /24 and a /32 in each of 1024 /16s: 2048 groups.
+    for (size_t i = 0; i < c_num_networks; ++i) {
+        ib_ipset4_entry_t entry;
+        entry.data = NULL;
+        entry.network.ip = (ib_ip4_t)((10 << 24) + (i << 16) + 0x0100);
+        entry.network.size = 24;
+        positive.push_back(entry);
+        entry.network.ip = (ib_ip4_t)((10 << 24) + (i << 16) + 0x0201);
+        entry.network.size = 32;
+        positive.push_back(entry);
+    }
+
+    ASSERT_EQ(IB_OK, ib_mpool_create(&mp, "CompiledSize4", NULL));
+    ASSERT_EQ(
+        IB_OK,
+        ib_ipset4_init_compiled(
+            &set,
+            NULL, 0,
+            positive.data(), positive.size(),
+            ib_mm_mpool(mp)
+        )
+    );
+
+    // 256 KiB first table and 1 KiB per group.
+    EXPECT_GT(
+        (256 + 2 * c_num_networks + 64) * 1024,
+        ib_mpool_inuse(mp)
+    );
+
+    EXPECT_EQ(
+        IB_OK,
+        ib_ipset4_query(&set, 0x0a0301c8, NULL, NULL, NULL)
+    );
+    EXPECT_EQ(
+        IB_OK,
+        ib_ipset4_query(&set, 0x0dff0201, NULL, NULL, NULL)
+    );
+    EXPECT_EQ(
+        IB_ENOENT,
+        ib_ipset4_query(&set, 0x0dff0202, NULL, NULL, NULL)
+    );
+
+    ib_mpool_destroy(mp);
+}
+
+TEST_F(TestIPSet, CompiledRandom6)
+{
+    static const size_t c_num_networks = 2000;
+    static const size_t c_num_tests = (size_t)1e5;
+
+    ib_status_t rc;
+    ib_ipset6_t set;
+    vector<ib_ipset6_entry_t> positive;
+    vector<ib_ipset6_entry_t> negative;
+
+    // Networks share a few prefixes so that they nest and overlap.
+    for (size_t i = 0; i < c_num_networks; ++i) {
+        ib_ipset6_entry_t entry;
+        ib_ip6_t mask;
+        entry.network.ip = ip6(
+            0x20010db8, random(0, 3) << 30, random(0, 3), random(0, 0xffff)
+        );
+        entry.network.size = random(0, 128);
+        entry.data = NULL;
+        make_ones(mask, entry.network.size);
+        for (size_t j = 0; j < 4; ++j) {
+            entry.network.ip.ip[j] &= mask.ip[j];
+        }
+        (random(0, 3) == 0 ? negative : positive).push_back(entry);
+    }
+
+    rc = ib_ipset6_init_compiled(
+        &set,
+        negative.data(), negative.size(),
+        positive.data(), positive.size(),
+        MM()
+    );
+    ASSERT_EQ(IB_OK, rc);
+
+    for (size_t i = 0; i < c_num_tests; ++i) {
+        const ib_ipset6_entry_t* specific = NULL;
+        const ib_ipset6_entry_t* general  = NULL;
+        const ib_ipset6_entry_t* expected_specific;
+        const ib_ipset6_entry_t* expected_general;
+        ib_ip6_t ip = ip6(
+            0x20010db8, random(0, 3) << 30, random(0, 3), random(0, 0xffff)
+        );
+
+        ib_status_t expected = reference_query(
+            negative, positive, ip, expected_specific, expected_general
+        );
+        rc = ib_ipset6_query(&set, ip, NULL, &specific, &general);
+        ASSERT_EQ(expected, rc);
+        ASSERT_EQ(expected_specific, specific);
+        ASSERT_EQ(expected_general, general);
+    }
+}
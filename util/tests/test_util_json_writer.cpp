@@ -0,0 +1,278 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- Streaming JSON Writer Tests
+ **/
+
+#include "ironbee_config_auto.h"
+#include "gtest/gtest.h"
+
+#include <ironbee/json_writer.h>
+#include <ironbee/list.h>
+#include <ironbee/string.h>
+
+#include <ironbeepp/memory_manager.hpp>
+#include <ironbeepp/memory_pool_lite.hpp>
+
+#include <string>
+
+using namespace std;
+using namespace IronBee;
+
+class TestJsonWriter : public ::testing::Test
+{
+public:
+    TestJsonWriter()
+    {
+        EXPECT_EQ(IB_OK, ib_json_writer_create(&m_writer, false));
+    }
+
+    ~TestJsonWriter()
+    {
+        ib_json_writer_destroy(m_writer);
+    }
+
+    string json()
+    {
+        const char *buf;
+        size_t      len;
+
+        EXPECT_EQ(IB_OK, ib_json_writer_buf(m_writer, &buf, &len));
+        EXPECT_EQ('\0', buf[len]);
+
+        return string(buf, len);
+    }
+
+protected:
+    ib_json_writer_t *m_writer;
+};
+
+TEST_F(TestJsonWriter, Compact)
+{
+    ASSERT_EQ(IB_OK, ib_json_writer_map_open(m_writer));
+    ASSERT_EQ(IB_OK, ib_json_writer_nulstr(m_writer, "a"));
+    ASSERT_EQ(IB_OK, ib_json_writer_num(m_writer, -12));
+    ASSERT_EQ(IB_OK, ib_json_writer_nulstr(m_writer, "b"));
+    ASSERT_EQ(IB_OK, ib_json_writer_array_open(m_writer));
+    ASSERT_EQ(IB_OK, ib_json_writer_bool(m_writer, true));
+    ASSERT_EQ(IB_OK, ib_json_writer_null(m_writer));
+    ASSERT_EQ(IB_OK, ib_json_writer_float(m_writer, 50));
+    ASSERT_EQ(IB_OK, ib_json_writer_float(m_writer, 0.5));
+    ASSERT_EQ(IB_OK, ib_json_writer_map_open(m_writer));
+    ASSERT_EQ(IB_OK, ib_json_writer_map_close(m_writer));
+    ASSERT_EQ(IB_OK, ib_json_writer_array_close(m_writer));
+    ASSERT_EQ(IB_OK, ib_json_writer_nulstr(m_writer, "c"));
+    ASSERT_EQ(IB_OK, ib_json_writer_nulstr(m_writer, "d"));
+    ASSERT_EQ(IB_OK, ib_json_writer_map_close(m_writer));
+
+    EXPECT_EQ(
+        "{\"a\":-12,\"b\":[true,null,50.0,0.5,{}],\"c\":\"d\"}",
+        json()
+    );
+}
+
+TEST_F(TestJsonWriter, Pretty)
+{
+    ib_json_writer_reset(m_writer, true);
+
+    ASSERT_EQ(IB_OK, ib_json_writer_map_open(m_writer));
+    ASSERT_EQ(IB_OK, ib_json_writer_nulstr(m_writer, "a"));
+    ASSERT_EQ(IB_OK, ib_json_writer_array_open(m_writer));
+    ASSERT_EQ(IB_OK, ib_json_writer_num(m_writer, 1));
+    ASSERT_EQ(IB_OK, ib_json_writer_num(m_writer, 2));
+    ASSERT_EQ(IB_OK, ib_json_writer_array_close(m_writer));
+    ASSERT_EQ(IB_OK, ib_json_writer_nulstr(m_writer, "b"));
+    ASSERT_EQ(IB_OK, ib_json_writer_array_open(m_writer));
+    ASSERT_EQ(IB_OK, ib_json_writer_array_close(m_writer));
+    ASSERT_EQ(IB_OK, ib_json_writer_map_close(m_writer));
+
+    EXPECT_EQ(
+        "{\n"
+        "    \"a\": [\n"
+        "        1,\n"
+        "        2\n"
+        "    ],\n"
+        "    \"b\": []\n"
+        "}\n",
+        json()
+    );
+}
+
+TEST_F(TestJsonWriter, Escape)
+{
+    const char in[] = "plain \"q\" \\ /\b\f\n\r\t\x01\x1f\x7f\xc3\xa9 end";
+
+    ASSERT_EQ(IB_OK, ib_json_writer_string(m_writer, in, sizeof(in) - 1));
+    EXPECT_EQ(
+        "\"plain \\\"q\\\" \\\\ /\\b\\f\\n\\r\\t\\u0001\\u001f\x7f\xc3\xa9 end\"",
+        json()
+    );
+
+    /* Long runs and escapes across vector blocks. */
+    string long_in(100, 'x');
+    string long_out("\"");
+    long_in[40] = '\0';
+    long_in[99] = '"';
+    long_out += string(40, 'x') + "\\u0000" + string(58, 'x') + "\\\"\"";
+
+    ib_json_writer_reset(m_writer, false);
+    ASSERT_EQ(
+        IB_OK,
+        ib_json_writer_string(m_writer, long_in.data(), long_in.length())
+    );
+    EXPECT_EQ(long_out, json());
+
+    ib_json_writer_reset(m_writer, false);
+    ASSERT_EQ(IB_OK, ib_json_writer_string(m_writer, NULL, 0));
+    EXPECT_EQ("\"\"", json());
+}
+
+TEST_F(TestJsonWriter, Grow)
+{
+    string big(5000, 'y');
+
+    ASSERT_EQ(IB_OK, ib_json_writer_array_open(m_writer));
+    for (int i = 0; i < 100; ++i) {
+        ASSERT_EQ(
+            IB_OK,
+            ib_json_writer_string(m_writer, big.data(), big.length())
+        );
+    }
+    ASSERT_EQ(IB_OK, ib_json_writer_array_close(m_writer));
+
+    EXPECT_EQ(2 + 100 * 5002 + 99UL, json().length());
+}
+
+TEST_F(TestJsonWriter, Errors)
+{
+    const char *buf;
+
+    /* Incomplete. */
+    EXPECT_EQ(IB_EINVAL, ib_json_writer_buf(m_writer, &buf, NULL));
+    ASSERT_EQ(IB_OK, ib_json_writer_map_open(m_writer));
+    EXPECT_EQ(IB_EINVAL, ib_json_writer_buf(m_writer, &buf, NULL));
+
+    /* Keys must be strings. */
+    EXPECT_EQ(IB_EINVAL, ib_json_writer_num(m_writer, 1));
+
+    /* Sticky. */
+    EXPECT_EQ(IB_EINVAL, ib_json_writer_nulstr(m_writer, "a"));
+    EXPECT_EQ(IB_EINVAL, ib_json_writer_buf(m_writer, &buf, NULL));
+
+    /* Mismatched close. */
+    ib_json_writer_reset(m_writer, false);
+    ASSERT_EQ(IB_OK, ib_json_writer_map_open(m_writer));
+    EXPECT_EQ(IB_EINVAL, ib_json_writer_array_close(m_writer));
+
+    /* Key without value. */
+    ib_json_writer_reset(m_writer, false);
+    ASSERT_EQ(IB_OK, ib_json_writer_map_open(m_writer));
+    ASSERT_EQ(IB_OK, ib_json_writer_nulstr(m_writer, "a"));
+    EXPECT_EQ(IB_EINVAL, ib_json_writer_map_close(m_writer));
+
+    /* One value only. */
+    ib_json_writer_reset(m_writer, false);
+    ASSERT_EQ(IB_OK, ib_json_writer_num(m_writer, 1));
+    EXPECT_EQ(IB_EINVAL, ib_json_writer_num(m_writer, 2));
+
+    /* Not a number. */
+    ib_json_writer_reset(m_writer, false);
+    EXPECT_EQ(IB_EINVAL, ib_json_writer_float(m_writer, 1.0 / 0.0));
+
+    /* Too deep. */
+    ib_json_writer_reset(m_writer, false);
+    ib_status_t rc = IB_OK;
+    for (int i = 0; i < 100 && rc == IB_OK; ++i) {
+        rc = ib_json_writer_array_open(m_writer);
+    }
+    EXPECT_EQ(IB_EINVAL, rc);
+}
+
+TEST_F(TestJsonWriter, Field)
+{
+    ScopedMemoryPoolLite mpl;
+    ib_mm_t              mm = MemoryManager(mpl).ib();
+    ib_field_t          *f;
+    ib_field_t          *list_f;
+    ib_num_t             num = 7;
+
+    ASSERT_EQ(IB_OK, ib_json_writer_map_open(m_writer));
+
+    ASSERT_EQ(IB_OK, ib_field_create(&f, mm, IB_S2SL("num"),
+                                     IB_FTYPE_NUM, ib_ftype_num_in(&num)));
+    ASSERT_EQ(IB_OK, ib_json_writer_field(m_writer, f));
+
+    ASSERT_EQ(IB_OK, ib_field_create_bytestr_alias(&f, mm, IB_S2SL("bs"),
+                                                   (uint8_t *)"a\"b", 3));
+    ASSERT_EQ(IB_OK, ib_json_writer_field(m_writer, f));
+
+    ASSERT_EQ(IB_OK, ib_field_create(&f, mm, IB_S2SL("null"),
+                                     IB_FTYPE_NULSTR, NULL));
+    ASSERT_EQ(IB_OK, ib_json_writer_field(m_writer, f));
+
+    ASSERT_EQ(IB_OK, ib_field_create(&list_f, mm, IB_S2SL("list"),
+                                     IB_FTYPE_LIST, NULL));
+    ASSERT_EQ(IB_OK, ib_field_create(&f, mm, IB_S2SL("tag"),
+                                     IB_FTYPE_NULSTR,
+                                     ib_ftype_nulstr_in("x")));
+    ASSERT_EQ(IB_OK, ib_field_list_add(list_f, f));
+    ASSERT_EQ(IB_OK, ib_json_writer_field(m_writer, list_f));
+
+    /* As a value, the name is not written. */
+    ASSERT_EQ(IB_OK, ib_json_writer_nulstr(m_writer, "value"));
+    ASSERT_EQ(IB_OK, ib_json_writer_field(m_writer, f));
+
+    ASSERT_EQ(IB_OK, ib_json_writer_map_close(m_writer));
+
+    EXPECT_EQ(
+        "{\"num\":7,\"bs\":\"a\\\"b\",\"null\":null,"
+        "\"list\":{\"tag\":\"x\"},\"value\":\"x\"}",
+        json()
+    );
+}
+
+TEST(TestJsonWriterThread, Acquire)
+{
+    ib_json_writer_t *a;
+    ib_json_writer_t *b;
+    ib_json_writer_t *c;
+    const char       *buf;
+    size_t            len;
+
+    ASSERT_EQ(IB_OK, ib_json_writer_acquire(&a, false));
+    ASSERT_EQ(IB_OK, ib_json_writer_acquire(&b, false));
+    EXPECT_NE(a, b);
+
+    ASSERT_EQ(IB_OK, ib_json_writer_num(a, 1));
+    ASSERT_EQ(IB_OK, ib_json_writer_num(b, 2));
+    ASSERT_EQ(IB_OK, ib_json_writer_buf(a, &buf, &len));
+    EXPECT_EQ("1", string(buf, len));
+
+    ib_json_writer_release(b);
+    ib_json_writer_release(a);
+
+    /* The thread's writer is reused and empty. */
+    ASSERT_EQ(IB_OK, ib_json_writer_acquire(&c, true));
+    EXPECT_EQ(a, c);
+    EXPECT_EQ(IB_EINVAL, ib_json_writer_buf(c, &buf, &len));
+    ASSERT_EQ(IB_OK, ib_json_writer_null(c));
+    ASSERT_EQ(IB_OK, ib_json_writer_buf(c, &buf, &len));
+    EXPECT_EQ("null\n", string(buf, len));
+    ib_json_writer_release(c);
+}
@@ -0,0 +1,417 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- Log Structured Key-Value Store Tests
+ **/
+
+extern "C" {
+#include "ironbee_config_auto.h"
+
+#include <ironbee/kvstore_log.h>
+#include <ironbee/mm_mpool.h>
+#include <ironbee/mpool.h>
+}
+
+#include "gtest/gtest.h"
+
+#include <string>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+const char *c_dir = "TestKVStoreLog.d";
+
+}
+
+class TestKVStoreLog : public ::testing::Test
+{
+public:
+    virtual void SetUp()
+    {
+        DIR           *dir = opendir(c_dir);
+        struct dirent *de;
+
+        if (dir != NULL) {
+            while ((de = readdir(dir)) != NULL) {
+                if (de->d_name[0] != '.') {
+                    unlink((string(c_dir) + "/" + de->d_name).c_str());
+                }
+            }
+            closedir(dir);
+        }
+
+        ASSERT_EQ(IB_OK, ib_mpool_create(&m_mp, "TestKVStoreLog", NULL));
+        m_mm = ib_mm_mpool(m_mp);
+        m_kvstore = static_cast<ib_kvstore_t *>(
+            ib_mm_alloc(m_mm, ib_kvstore_size())
+        );
+        init(m_kvstore);
+        ASSERT_EQ(IB_OK, ib_kvstore_connect(m_kvstore));
+    }
+
+    virtual void TearDown()
+    {
+        ib_kvstore_destroy(m_kvstore);
+        ib_mpool_destroy(m_mp);
+    }
+
+    void init(ib_kvstore_t *kvstore)
+    {
+        ASSERT_EQ(IB_OK, ib_kvstore_log_init(kvstore, c_dir));
+        ib_kvstore_log_set_segment_size(kvstore, 4096);
+        ib_kvstore_log_set_compact_interval(kvstore, 0);
+    }
+
+    void reconnect()
+    {
+        ASSERT_EQ(IB_OK, ib_kvstore_disconnect(m_kvstore));
+        ASSERT_EQ(IB_OK, ib_kvstore_connect(m_kvstore));
+    }
+
+    ib_kvstore_key_t *key(const char *s)
+    {
+        ib_kvstore_key_t *k;
+
+        EXPECT_EQ(
+            IB_OK,
+            ib_kvstore_key_create(
+                &k, m_mm, reinterpret_cast<const uint8_t *>(s), strlen(s)
+            )
+        );
+
+        return k;
+    }
+
+    ib_kvstore_value_t *value(
+        const string &v,
+        ib_time_t expiration = 100 * 1000000LU
+    )
+    {
+        ib_kvstore_value_t *val;
+
+        EXPECT_EQ(IB_OK, ib_kvstore_value_create(&val, m_mm));
+        ib_kvstore_value_value_set(
+            val, reinterpret_cast<const uint8_t *>(v.data()), v.length()
+        );
+        ib_kvstore_value_type_set(val, "txt", 3);
+        ib_kvstore_value_expiration_set(val, expiration);
+
+        return val;
+    }
+
+    ib_status_t set(
+        const char *k,
+        const string &v,
+        ib_time_t expiration = 100 * 1000000LU
+    )
+    {
+        return ib_kvstore_set(m_kvstore, NULL, key(k), value(v, expiration));
+    }
+
+    //! Value of @a k or "ENOENT".
+    string get(const char *k)
+    {
+        ib_kvstore_value_t *val;
+        const uint8_t      *data;
+        size_t              data_length;
+        const char         *type;
+        size_t              type_length;
+        ib_status_t         rc;
+
+        rc = ib_kvstore_get(m_kvstore, NULL, m_mm, key(k), &val);
+        if (rc == IB_ENOENT) {
+            return "ENOENT";
+        }
+        EXPECT_EQ(IB_OK, rc);
+        if (rc != IB_OK) {
+            return "";
+        }
+
+        ib_kvstore_value_type_get(val, &type, &type_length);
+        EXPECT_EQ("txt", string(type, type_length));
+        ib_kvstore_value_value_get(val, &data, &data_length);
+
+        return string(reinterpret_cast<const char *>(data), data_length);
+    }
+
+protected:
+    ib_mpool_t   *m_mp;
+    ib_mm_t       m_mm;
+    ib_kvstore_t *m_kvstore;
+};
+
+TEST_F(TestKVStoreLog, SetGetRemove)
+{
+    EXPECT_EQ("ENOENT", get("a"));
+    ASSERT_EQ(IB_OK, set("a", "1"));
+    ASSERT_EQ(IB_OK, set("b", ""));
+    EXPECT_EQ("1", get("a"));
+    EXPECT_EQ("", get("b"));
+
+    ASSERT_EQ(IB_OK, set("a", "22"));
+    EXPECT_EQ("22", get("a"));
+
+    ASSERT_EQ(IB_OK, ib_kvstore_remove(m_kvstore, key("a")));
+    EXPECT_EQ("ENOENT", get("a"));
+    ASSERT_EQ(IB_OK, ib_kvstore_remove(m_kvstore, key("a")));
+    EXPECT_EQ("", get("b"));
+
+    /* Too large for a segment. */
+    EXPECT_EQ(IB_EINVAL, set("c", string(5000, 'c')));
+}
+
+TEST_F(TestKVStoreLog, Expiration)
+{
+    ASSERT_EQ(IB_OK, set("a", "1", 0));
+    EXPECT_EQ("ENOENT", get("a"));
+
+    ASSERT_EQ(IB_OK, set("b", "2"));
+    EXPECT_EQ("2", get("b"));
+}
+
+TEST_F(TestKVStoreLog, Persist)
+{
+    ASSERT_EQ(IB_OK, set("a", "1"));
+    ASSERT_EQ(IB_OK, set("b", "2"));
+    ASSERT_EQ(IB_OK, set("a", "3"));
+    ASSERT_EQ(IB_OK, ib_kvstore_remove(m_kvstore, key("b")));
+
+    reconnect();
+    EXPECT_EQ("3", get("a"));
+    EXPECT_EQ("ENOENT", get("b"));
+
+    ASSERT_EQ(IB_OK, set("b", "4"));
+    reconnect();
+    EXPECT_EQ("3", get("a"));
+    EXPECT_EQ("4", get("b"));
+}
+
+TEST_F(TestKVStoreLog, Compact)
+{
+    string v(1000, 'v');
+
+    /* Rewrite two keys until there are several segments. */
+    for (int i = 0; i < 20; ++i) {
+        v[0] = 'a' + i;
+        ASSERT_EQ(IB_OK, set("a", v));
+        ASSERT_EQ(IB_OK, set("b", v));
+    }
+    ASSERT_EQ(IB_OK, set("c", "gone"));
+    ASSERT_EQ(IB_OK, ib_kvstore_remove(m_kvstore, key("c")));
+    ASSERT_EQ(IB_OK, set("d", "expired", 0));
+
+    size_t before = ib_kvstore_log_segments(m_kvstore);
+    EXPECT_LT(5UL, before);
+
+    ASSERT_EQ(IB_OK, ib_kvstore_log_compact(m_kvstore));
+    EXPECT_GT(3UL, ib_kvstore_log_segments(m_kvstore));
+
+    EXPECT_EQ(v, get("a"));
+    EXPECT_EQ(v, get("b"));
+    EXPECT_EQ("ENOENT", get("c"));
+    EXPECT_EQ("ENOENT", get("d"));
+
+    reconnect();
+    EXPECT_EQ(v, get("a"));
+    EXPECT_EQ(v, get("b"));
+    EXPECT_EQ("ENOENT", get("c"));
+    EXPECT_EQ("ENOENT", get("d"));
+}
+
+namespace {
+
+void *compact_loop(void *arg)
+{
+    ib_kvstore_t *kvstore = static_cast<ib_kvstore_t *>(arg);
+
+    for (int i = 0; i < 50; ++i) {
+        if (ib_kvstore_log_compact(kvstore) != IB_OK) {
+            return arg;
+        }
+    }
+
+    return NULL;
+}
+
+}
+
+TEST_F(TestKVStoreLog, CompactConcurrent)
+{
+    /* Segments of several chunks, compacted while keys are rewritten. */
+    const int  n = 200;
+    string     v(8000, 'v');
+    pthread_t  thread;
+    void      *result;
+    char       k[16];
+
+    ib_kvstore_destroy(m_kvstore);
+    ASSERT_EQ(IB_OK, ib_kvstore_log_init(m_kvstore, c_dir));
+    ib_kvstore_log_set_segment_size(m_kvstore, 1024 * 1024);
+    ib_kvstore_log_set_compact_interval(m_kvstore, 0);
+    ASSERT_EQ(IB_OK, ib_kvstore_connect(m_kvstore));
+
+    for (int i = 0; i < n; ++i) {
+        snprintf(k, sizeof(k), "k%d", i);
+        ASSERT_EQ(IB_OK, set(k, v));
+    }
+
+    ASSERT_EQ(0, pthread_create(&thread, NULL, compact_loop, m_kvstore));
+    for (int round = 0; round < 5; ++round) {
+        for (int i = 0; i < n; ++i) {
+            snprintf(k, sizeof(k), "k%d", i);
+            v[0] = 'a' + round;
+            v[1] = 'a' + i % 26;
+            ASSERT_EQ(IB_OK, set(k, v));
+            EXPECT_EQ(v, get(k));
+        }
+    }
+    ASSERT_EQ(0, pthread_join(thread, &result));
+    EXPECT_TRUE(result == NULL);
+
+    ASSERT_EQ(IB_OK, ib_kvstore_log_compact(m_kvstore));
+    EXPECT_GE(3UL, ib_kvstore_log_segments(m_kvstore));
+    reconnect();
+    for (int i = 0; i < n; ++i) {
+        snprintf(k, sizeof(k), "k%d", i);
+        v[0] = 'a' + 4;
+        v[1] = 'a' + i % 26;
+        EXPECT_EQ(v, get(k));
+    }
+}
+
+TEST_F(TestKVStoreLog, Background)
+{
+    string v(1000, 'v');
+
+    ib_kvstore_destroy(m_kvstore);
+    ASSERT_EQ(IB_OK, ib_kvstore_log_init(m_kvstore, c_dir));
+    ib_kvstore_log_set_segment_size(m_kvstore, 4096);
+    ib_kvstore_log_set_compact_interval(m_kvstore, 10000);
+    ASSERT_EQ(IB_OK, ib_kvstore_connect(m_kvstore));
+
+    for (int i = 0; i < 20; ++i) {
+        ASSERT_EQ(IB_OK, set("a", v));
+    }
+    for (int i = 0; i < 100 && ib_kvstore_log_segments(m_kvstore) > 2; ++i) {
+        usleep(10000);
+    }
+    EXPECT_GE(2UL, ib_kvstore_log_segments(m_kvstore));
+    EXPECT_EQ(v, get("a"));
+}
+
+TEST_F(TestKVStoreLog, TornTail)
+{
+    string path;
+    int    fd;
+
+    ASSERT_EQ(IB_OK, set("a", "1"));
+    ASSERT_EQ(IB_OK, set("b", "2"));
+    ASSERT_EQ(IB_OK, ib_kvstore_disconnect(m_kvstore));
+
+    /* Cut the last record short. */
+    path = string(c_dir) + "/0000000000000000.log";
+    fd = open(path.c_str(), O_RDWR);
+    ASSERT_LE(0, fd);
+    struct stat sb;
+    ASSERT_EQ(0, fstat(fd, &sb));
+    ASSERT_EQ(0, ftruncate(fd, sb.st_size - 12));
+    close(fd);
+
+    ASSERT_EQ(IB_OK, ib_kvstore_connect(m_kvstore));
+    EXPECT_EQ("1", get("a"));
+    EXPECT_EQ("ENOENT", get("b"));
+
+    ASSERT_EQ(IB_OK, set("b", "3"));
+    reconnect();
+    EXPECT_EQ("3", get("b"));
+}
+
+TEST_F(TestKVStoreLog, Exclusive)
+{
+    ib_kvstore_t *kvstore = static_cast<ib_kvstore_t *>(
+        ib_mm_alloc(m_mm, ib_kvstore_size())
+    );
+
+    init(kvstore);
+    EXPECT_EQ(IB_EOTHER, ib_kvstore_connect(kvstore));
+
+    ASSERT_EQ(IB_OK, ib_kvstore_disconnect(m_kvstore));
+    EXPECT_EQ(IB_OK, ib_kvstore_connect(kvstore));
+    ib_kvstore_destroy(kvstore);
+
+    ASSERT_EQ(IB_OK, ib_kvstore_connect(m_kvstore));
+}
+
+TEST_F(TestKVStoreLog, Fork)
+{
+    pid_t pid;
+    int   status;
+
+    ASSERT_EQ(IB_OK, set("a", "1"));
+
+    /* The child may not use the parent's connection nor take the
+     * directory from it. */
+    pid = fork();
+    ASSERT_LE(0, pid);
+    if (pid == 0) {
+        _exit(
+            set("b", "2") == IB_EOTHER &&
+            ib_kvstore_connect(m_kvstore) == IB_EOTHER &&
+            set("b", "2") == IB_EINVAL ? 0 : 1
+        );
+    }
+    ASSERT_EQ(pid, waitpid(pid, &status, 0));
+    ASSERT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(0, WEXITSTATUS(status));
+    EXPECT_EQ("ENOENT", get("b"));
+
+    /* Once the parent has disconnected the child can connect. */
+    ASSERT_EQ(IB_OK, set("b", "2"));
+    ASSERT_EQ(IB_OK, ib_kvstore_disconnect(m_kvstore));
+    pid = fork();
+    ASSERT_LE(0, pid);
+    if (pid == 0) {
+        ib_kvstore_t *kvstore = static_cast<ib_kvstore_t *>(
+            ib_mm_alloc(m_mm, ib_kvstore_size())
+        );
+
+        init(kvstore);
+        _exit(
+            ib_kvstore_connect(kvstore) == IB_OK &&
+            ib_kvstore_set(kvstore, NULL, key("c"), value("3")) == IB_OK
+            ? 0 : 1
+        );
+    }
+    ASSERT_EQ(pid, waitpid(pid, &status, 0));
+    ASSERT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(0, WEXITSTATUS(status));
+
+    ASSERT_EQ(IB_OK, ib_kvstore_connect(m_kvstore));
+    EXPECT_EQ("1", get("a"));
+    EXPECT_EQ("2", get("b"));
+    EXPECT_EQ("3", get("c"));
+}
@@ -0,0 +1,275 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- In-Memory Key-Value Store Tests
+ **/
+
+extern "C" {
+#include "ironbee_config_auto.h"
+
+#include <ironbee/kvstore_memory.h>
+#include <ironbee/mm_mpool.h>
+#include <ironbee/mpool.h>
+}
+
+#include "gtest/gtest.h"
+
+#include <boost/lexical_cast.hpp>
+
+#include <string>
+
+using namespace std;
+
+class TestKVStoreMemory : public ::testing::Test
+{
+public:
+    virtual void SetUp()
+    {
+        ASSERT_EQ(IB_OK, ib_mpool_create(&m_mp, "TestKVStoreMemory", NULL));
+        m_mm = ib_mm_mpool(m_mp);
+        m_kvstore = static_cast<ib_kvstore_t *>(
+            ib_mm_alloc(m_mm, ib_kvstore_size())
+        );
+        ASSERT_EQ(IB_OK, ib_kvstore_memory_init(m_kvstore, 0));
+        ASSERT_EQ(IB_OK, ib_kvstore_connect(m_kvstore));
+    }
+
+    virtual void TearDown()
+    {
+        ib_kvstore_disconnect(m_kvstore);
+        ib_kvstore_destroy(m_kvstore);
+        ib_mpool_destroy(m_mp);
+    }
+
+    ib_kvstore_key_t *key(const string &s)
+    {
+        ib_kvstore_key_t *k;
+        uint8_t          *data = static_cast<uint8_t *>(
+            ib_mm_memdup(m_mm, s.data(), s.length())
+        );
+
+        EXPECT_EQ(IB_OK, ib_kvstore_key_create(&k, m_mm, data, s.length()));
+
+        return k;
+    }
+
+    ib_status_t set(
+        const string                 &k,
+        const string                 &v,
+        ib_time_t                     expiration = 100 * 1000000LU,
+        ib_kvstore_merge_policy_fn_t  merge_policy = NULL
+    )
+    {
+        ib_kvstore_value_t *val;
+
+        EXPECT_EQ(IB_OK, ib_kvstore_value_create(&val, m_mm));
+        ib_kvstore_value_value_set(
+            val, reinterpret_cast<const uint8_t *>(v.data()), v.length()
+        );
+        ib_kvstore_value_type_set(val, "txt", 3);
+        ib_kvstore_value_expiration_set(val, expiration);
+
+        return ib_kvstore_set(m_kvstore, merge_policy, key(k), val);
+    }
+
+    //! Value of @a k or "ENOENT".
+    string get(const string &k)
+    {
+        ib_kvstore_value_t *val;
+        const uint8_t      *data;
+        size_t              data_length;
+        const char         *type;
+        size_t              type_length;
+        ib_status_t         rc;
+
+        rc = ib_kvstore_get(m_kvstore, NULL, m_mm, key(k), &val);
+        if (rc == IB_ENOENT) {
+            return "ENOENT";
+        }
+        EXPECT_EQ(IB_OK, rc);
+        if (rc != IB_OK) {
+            return "";
+        }
+
+        ib_kvstore_value_type_get(val, &type, &type_length);
+        EXPECT_EQ("txt", string(type, type_length));
+        ib_kvstore_value_value_get(val, &data, &data_length);
+
+        return string(reinterpret_cast<const char *>(data), data_length);
+    }
+
+protected:
+    ib_mpool_t   *m_mp;
+    ib_mm_t       m_mm;
+    ib_kvstore_t *m_kvstore;
+};
+
+TEST_F(TestKVStoreMemory, SetGetRemove)
+{
+    EXPECT_EQ("ENOENT", get("a"));
+    ASSERT_EQ(IB_OK, set("a", "1"));
+    ASSERT_EQ(IB_OK, set("b", ""));
+    EXPECT_EQ("1", get("a"));
+    EXPECT_EQ("", get("b"));
+    EXPECT_EQ(2UL, ib_kvstore_memory_entries(m_kvstore));
+
+    ASSERT_EQ(IB_OK, set("a", "22"));
+    EXPECT_EQ("22", get("a"));
+    EXPECT_EQ(2UL, ib_kvstore_memory_entries(m_kvstore));
+
+    ASSERT_EQ(IB_OK, ib_kvstore_remove(m_kvstore, key("a")));
+    EXPECT_EQ("ENOENT", get("a"));
+    ASSERT_EQ(IB_OK, ib_kvstore_remove(m_kvstore, key("a")));
+    EXPECT_EQ("", get("b"));
+    EXPECT_EQ(1UL, ib_kvstore_memory_entries(m_kvstore));
+}
+
+TEST_F(TestKVStoreMemory, Expiration)
+{
+    ib_kvstore_value_t *val;
+    ib_timeval_t        tv;
+
+    ASSERT_EQ(IB_OK, set("a", "1", 0));
+    EXPECT_EQ("ENOENT", get("a"));
+    EXPECT_EQ(0UL, ib_kvstore_memory_entries(m_kvstore));
+
+    /* Relative on set, absolute on get. */
+    ib_clock_gettimeofday(&tv);
+    ASSERT_EQ(IB_OK, set("b", "2", 1000000));
+    ASSERT_EQ(IB_OK, ib_kvstore_get(m_kvstore, NULL, m_mm, key("b"), &val));
+    EXPECT_LE(
+        IB_CLOCK_TIMEVAL_TIME(tv) + 1000000,
+        ib_kvstore_value_expiration_get(val)
+    );
+    EXPECT_LE(
+        IB_CLOCK_TIMEVAL_TIME(tv),
+        ib_kvstore_value_creation_get(val)
+    );
+}
+
+TEST_F(TestKVStoreMemory, Evict)
+{
+    ib_kvstore_destroy(m_kvstore);
+    ASSERT_EQ(IB_OK, ib_kvstore_memory_init(m_kvstore, 32));
+
+    /* Keep one key in use. */
+    ASSERT_EQ(IB_OK, set("keep", "k"));
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_EQ(IB_OK, set("key" + to_string(i), to_string(i)));
+        EXPECT_EQ("k", get("keep"));
+    }
+
+    EXPECT_GE(32UL, ib_kvstore_memory_entries(m_kvstore));
+    EXPECT_EQ("999", get("key999"));
+    EXPECT_EQ("ENOENT", get("key0"));
+}
+
+namespace {
+
+//! Add the numbers of the values into the stored value.
+ib_status_t sum_merge_policy(
+    ib_kvstore_t            *kvstore,
+    const ib_kvstore_key_t  *key,
+    ib_kvstore_value_t     **values,
+    size_t                   value_size,
+    ib_kvstore_value_t     **resultant_value,
+    ib_kvstore_cbdata_t     *cbdata
+)
+{
+    static string s_result;
+    int           sum = 0;
+    const uint8_t *data;
+    size_t         data_length;
+
+    for (size_t i = 0; i < value_size; ++i) {
+        ib_kvstore_value_value_get(values[i], &data, &data_length);
+        sum += stoi(string(reinterpret_cast<const char *>(data), data_length));
+    }
+    s_result = to_string(sum);
+
+    /* Keep the type and expiration of the stored value. */
+    *resultant_value = values[value_size - 1];
+    ib_kvstore_value_value_set(
+        *resultant_value,
+        reinterpret_cast<const uint8_t *>(s_result.data()),
+        s_result.length()
+    );
+
+    return IB_OK;
+}
+
+}
+
+TEST_F(TestKVStoreMemory, Merge)
+{
+    ASSERT_EQ(IB_OK, set("n", "1", 1000000, sum_merge_policy));
+    EXPECT_EQ("1", get("n"));
+    ASSERT_EQ(IB_OK, set("n", "2", 1000000, sum_merge_policy));
+    ASSERT_EQ(IB_OK, set("n", "3", 1000000, sum_merge_policy));
+    EXPECT_EQ("6", get("n"));
+
+    /* Default merge policy replaces. */
+    ASSERT_EQ(IB_OK, set("n", "4"));
+    EXPECT_EQ("4", get("n"));
+}
+
+TEST_F(TestKVStoreMemory, ChurnMemoryBounded)
+{
+    ib_mpool_t *mp;
+    ib_mm_t     mm;
+    size_t      footprint = 0;
+
+    ib_kvstore_destroy(m_kvstore);
+    ASSERT_EQ(IB_OK, ib_kvstore_memory_init(m_kvstore, 1600));
+    ASSERT_EQ(IB_OK, ib_mpool_create(&mp, "ChurnMemoryBounded", NULL));
+    mm = ib_mm_mpool(mp);
+
+    /* Distinct keys of one length keep evicting and rehashing the shard
+     * tables; the footprint must not grow once the store is full. */
+    for (int i = 0; i < 20000; ++i) {
+        string              k = "key" + boost::lexical_cast<string>(100000 + i);
+        ib_kvstore_key_t   *kv_key;
+        ib_kvstore_value_t *val;
+
+        ASSERT_EQ(IB_OK, ib_kvstore_key_create(
+            &kv_key, mm,
+            static_cast<uint8_t *>(ib_mm_memdup(mm, k.data(), k.length())),
+            k.length()
+        ));
+        ASSERT_EQ(IB_OK, ib_kvstore_value_create(&val, mm));
+        ib_kvstore_value_value_set(
+            val, reinterpret_cast<const uint8_t *>(k.data()), k.length()
+        );
+        ib_kvstore_value_type_set(val, "txt", 3);
+        ib_kvstore_value_expiration_set(val, 100 * 1000000LU);
+        ASSERT_EQ(IB_OK, ib_kvstore_set(m_kvstore, NULL, kv_key, val));
+
+        if (i % 1000 == 999) {
+            ib_mpool_clear(mp);
+        }
+        if (i == 5000) {
+            footprint = ib_kvstore_memory_footprint(m_kvstore);
+        }
+    }
+
+    EXPECT_GE(1600UL, ib_kvstore_memory_entries(m_kvstore));
+    EXPECT_GE(footprint, ib_kvstore_memory_footprint(m_kvstore));
+
+    ib_mpool_destroy(mp);
+}
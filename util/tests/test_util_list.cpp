@@ -571,4 +571,119 @@ TEST_F(TestIBUtilList, test_insert) {
     ASSERT_EQ(IB_OK, ib_list_shift(list, &p));
     ASSERT_EQ(&k, p) << "k expected";
 
-}
\ No newline at end of file
+}
+/// @test Appended nodes are allocated in contiguous chunks.
+TEST_F(TestIBUtilList, test_list_chunked)
+{
+    ib_list_t            *list;
+    ib_list_t            *copy;
+    const ib_list_node_t *node;
+    int                   ints[500];
+    size_t                adjacent = 0;
+
+    for (int i = 0; i < 500; ++i) {
+        ints[i] = i;
+    }
+
+    ASSERT_EQ(IB_OK, ib_list_create(&list, MM()));
+    populate_list(list, ints, 500);
+    check_list(list, ints, 500);
+
+    IB_LIST_LOOP_CONST(list, node) {
+        if (ib_list_node_next_const(node) == node + 1) {
+            ++adjacent;
+        }
+    }
+    /* Only chunk boundaries break adjacency. */
+    ASSERT_LE(500UL - 500UL / 16 - 8, adjacent);
+
+    /* A copy is a single chunk. */
+    ASSERT_EQ(IB_OK, ib_list_copy(list, MM(), &copy));
+    check_list(copy, ints, 500);
+    adjacent = 0;
+    IB_LIST_LOOP_CONST(copy, node) {
+        if (ib_list_node_next_const(node) == node + 1) {
+            ++adjacent;
+        }
+    }
+    ASSERT_EQ(499UL, adjacent);
+}
+
+/// @test Removed nodes of pool backed lists are reused.
+TEST_F(TestIBUtilList, test_list_node_reuse)
+{
+    ib_mpool_t     *mp;
+    ib_list_t      *a;
+    ib_list_t      *b;
+    ib_list_node_t *node;
+    int             i = 1;
+    int             j = 2;
+    void           *p;
+
+    ASSERT_EQ(IB_OK, ib_mpool_create(&mp, "list", NULL));
+    ASSERT_EQ(IB_OK, ib_list_create(&a, ib_mm_mpool(mp)));
+    ASSERT_EQ(IB_OK, ib_list_create(&b, ib_mm_mpool(mp)));
+
+    ASSERT_EQ(IB_OK, ib_list_push(a, &i));
+    node = ib_list_first(a);
+    ASSERT_EQ(IB_OK, ib_list_pop(a, &p));
+    ASSERT_EQ(&i, p);
+
+    ASSERT_EQ(IB_OK, ib_list_push(b, &j));
+    ASSERT_EQ(node, ib_list_first(b));
+    ASSERT_EQ(&j, ib_list_node_data(ib_list_first(b)));
+    ASSERT_EQ(NULL, ib_list_node_next(ib_list_first(b)));
+    ASSERT_EQ(1UL, ib_list_elements(b));
+
+    ib_mpool_destroy(mp);
+}
+
+/// @test Every insertion, removal and replacement changes the generation.
+TEST_F(TestIBUtilList, test_list_generation)
+{
+    ib_list_t *list;
+    int        i = 1;
+    size_t     generation;
+    void      *p;
+
+    ASSERT_EQ(IB_OK, ib_list_create(&list, MM()));
+
+    generation = ib_list_generation(list);
+    ASSERT_EQ(IB_OK, ib_list_push(list, &i));
+    ASSERT_NE(generation, ib_list_generation(list));
+
+    generation = ib_list_generation(list);
+    ASSERT_EQ(IB_OK, ib_list_unshift(list, &i));
+    ASSERT_NE(generation, ib_list_generation(list));
+
+    generation = ib_list_generation(list);
+    ASSERT_EQ(IB_OK, ib_list_insert(list, &i, 1));
+    ASSERT_NE(generation, ib_list_generation(list));
+
+    generation = ib_list_generation(list);
+    ib_list_node_data_set(list, ib_list_first(list), &i);
+    ASSERT_NE(generation, ib_list_generation(list));
+
+    /* Pop and push back leaves the same length and may reuse the node. */
+    generation = ib_list_generation(list);
+    ASSERT_EQ(IB_OK, ib_list_pop(list, &p));
+    ASSERT_EQ(IB_OK, ib_list_push(list, &i));
+    ASSERT_NE(generation, ib_list_generation(list));
+
+    generation = ib_list_generation(list);
+    ib_list_node_remove(list, ib_list_first(list));
+    ASSERT_NE(generation, ib_list_generation(list));
+
+    generation = ib_list_generation(list);
+    ASSERT_EQ(IB_OK, ib_list_shift(list, &p));
+    ASSERT_NE(generation, ib_list_generation(list));
+
+    generation = ib_list_generation(list);
+    ib_list_clear(list);
+    ASSERT_NE(generation, ib_list_generation(list));
+
+    /* Reading does not change it. */
+    generation = ib_list_generation(list);
+    ASSERT_EQ(0UL, ib_list_elements(list));
+    ASSERT_EQ(generation, ib_list_generation(list));
+}
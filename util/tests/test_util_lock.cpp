@@ -35,6 +35,7 @@
 #include <stdexcept>
 #include <math.h>
 #include <pthread.h>
+#include <sched.h>
 
 using namespace std;
 
@@ -424,3 +425,192 @@ TEST_F(TestIBUtilLock, test_long)
     ASSERT_EQ(IB_OK, rc);
 #endif
 }
+
+namespace {
+
+const size_t c_contend_threads = 8;
+const size_t c_contend_loops   = 10000;
+
+struct RWLockData
+{
+    ib_rwlock_t *lock;
+    size_t       shared;
+    size_t       errors;
+};
+
+void *rwlock_thread(void *data)
+{
+    RWLockData *d = static_cast<RWLockData *>(data);
+
+    for (size_t n = 0; n < c_contend_loops; ++n) {
+        if (ib_rwlock_wrlock(d->lock) != IB_OK) {
+            __atomic_add_fetch(&d->errors, 1, __ATOMIC_RELAXED);
+            break;
+        }
+        ++d->shared;
+        ib_rwlock_unlock(d->lock);
+
+        if (ib_rwlock_rdlock(d->lock) != IB_OK) {
+            __atomic_add_fetch(&d->errors, 1, __ATOMIC_RELAXED);
+            break;
+        }
+        size_t before = d->shared;
+        sched_yield();
+        if (d->shared != before) {
+            __atomic_add_fetch(&d->errors, 1, __ATOMIC_RELAXED);
+        }
+        ib_rwlock_unlock(d->lock);
+    }
+
+    return NULL;
+}
+
+struct SpinLockData
+{
+    ib_spinlock_t *lock;
+    size_t         shared;
+};
+
+void *spinlock_thread(void *data)
+{
+    SpinLockData *d = static_cast<SpinLockData *>(data);
+
+    for (size_t n = 0; n < c_contend_loops; ++n) {
+        ib_spinlock_lock(d->lock);
+        ++d->shared;
+        ib_spinlock_unlock(d->lock);
+    }
+
+    return NULL;
+}
+
+}
+
+TEST_F(TestIBUtilLock, test_rwlock)
+{
+    RWLockData      data;
+    pthread_t       threads[c_contend_threads];
+    ib_lock_stats_t read;
+    ib_lock_stats_t write;
+
+    ASSERT_EQ(IB_OK, ib_rwlock_create(&data.lock, MM()));
+    data.shared = 0;
+    data.errors = 0;
+    ib_rwlock_stats_enable(data.lock, true);
+
+    for (size_t i = 0; i < c_contend_threads; ++i) {
+        ASSERT_EQ(0, pthread_create(&threads[i], NULL, rwlock_thread, &data));
+    }
+    for (size_t i = 0; i < c_contend_threads; ++i) {
+        ASSERT_EQ(0, pthread_join(threads[i], NULL));
+    }
+
+    EXPECT_EQ(0UL, data.errors);
+    EXPECT_EQ(c_contend_threads * c_contend_loops, data.shared);
+
+    ib_rwlock_stats(data.lock, &read, &write);
+    EXPECT_EQ(c_contend_threads * c_contend_loops, read.acquisitions);
+    EXPECT_EQ(c_contend_threads * c_contend_loops, write.acquisitions);
+    EXPECT_GE(read.acquisitions, read.contended);
+    EXPECT_GE(write.acquisitions, write.contended);
+    if (write.contended == 0) {
+        EXPECT_EQ(0UL, write.wait_ns);
+    }
+
+    /* Disabled locks do not count. */
+    ib_rwlock_stats_enable(data.lock, false);
+    ASSERT_EQ(IB_OK, ib_rwlock_rdlock(data.lock));
+    ASSERT_EQ(IB_OK, ib_rwlock_unlock(data.lock));
+    ib_rwlock_stats(data.lock, &read, NULL);
+    EXPECT_EQ(c_contend_threads * c_contend_loops, read.acquisitions);
+}
+
+TEST_F(TestIBUtilLock, test_spinlock)
+{
+    SpinLockData    data;
+    pthread_t       threads[c_contend_threads];
+    ib_lock_stats_t stats;
+
+    ASSERT_EQ(IB_OK, ib_spinlock_create_malloc(&data.lock));
+    data.shared = 0;
+
+    ASSERT_EQ(IB_OK, ib_spinlock_trylock(data.lock));
+    ASSERT_EQ(IB_DECLINED, ib_spinlock_trylock(data.lock));
+    ib_spinlock_unlock(data.lock);
+
+    ib_spinlock_stats_enable(data.lock, true);
+    for (size_t i = 0; i < c_contend_threads; ++i) {
+        ASSERT_EQ(
+            0,
+            pthread_create(&threads[i], NULL, spinlock_thread, &data));
+    }
+    for (size_t i = 0; i < c_contend_threads; ++i) {
+        ASSERT_EQ(0, pthread_join(threads[i], NULL));
+    }
+
+    EXPECT_EQ(c_contend_threads * c_contend_loops, data.shared);
+
+    ib_spinlock_stats(data.lock, &stats);
+    EXPECT_EQ(c_contend_threads * c_contend_loops, stats.acquisitions);
+    EXPECT_GE(stats.acquisitions, stats.contended);
+
+    ib_spinlock_destroy_malloc(data.lock);
+}
+
+struct CondData
+{
+    ib_lock_t *lock;
+    ib_cond_t *cond;
+    bool       ready;
+    bool       woken;
+};
+
+static void *trylock_thread(void *data)
+{
+    CondData *d = static_cast<CondData *>(data);
+
+    return reinterpret_cast<void *>(
+        ib_lock_trylock(d->lock) == IB_DECLINED ? 0 : 1
+    );
+}
+
+static void *cond_thread(void *data)
+{
+    CondData *d = static_cast<CondData *>(data);
+
+    ib_lock_lock(d->lock);
+    while (! d->ready) {
+        ib_cond_wait(d->cond, d->lock);
+    }
+    d->woken = true;
+    ib_lock_unlock(d->lock);
+
+    return NULL;
+}
+
+TEST_F(TestIBUtilLock, test_trylock_cond)
+{
+    CondData   data;
+    pthread_t  thread;
+    void      *result;
+
+    ASSERT_EQ(IB_OK, ib_lock_create(&data.lock, MM()));
+    ASSERT_EQ(IB_OK, ib_cond_create(&data.cond, MM()));
+    data.ready = false;
+    data.woken = false;
+
+    /* Held by this thread: another is declined. */
+    ASSERT_EQ(IB_OK, ib_lock_trylock(data.lock));
+    ASSERT_EQ(0, pthread_create(&thread, NULL, trylock_thread, &data));
+    ASSERT_EQ(0, pthread_join(thread, &result));
+    EXPECT_TRUE(result == NULL);
+    ASSERT_EQ(IB_OK, ib_lock_unlock(data.lock));
+
+    ASSERT_EQ(0, pthread_create(&thread, NULL, cond_thread, &data));
+    ASSERT_EQ(IB_OK, ib_lock_lock(data.lock));
+    data.ready = true;
+    ASSERT_EQ(IB_OK, ib_cond_broadcast(data.cond));
+    ASSERT_EQ(IB_OK, ib_lock_unlock(data.lock));
+    ASSERT_EQ(0, pthread_join(thread, NULL));
+    EXPECT_TRUE(data.woken);
+}
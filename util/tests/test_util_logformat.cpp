@@ -103,6 +103,19 @@ ib_status_t format_field(
     return IB_OK;
 }
 
+ib_status_t format_field_len(
+    const ib_logformat_t        *lf,
+    const ib_logformat_field_t  *field,
+    const void                  *cbdata,
+    const char                 **str,
+    size_t                      *len)
+{
+    ib_status_t rc = format_field(lf, field, cbdata, str);
+
+    *len = strlen(*str);
+    return rc;
+}
+
 static const size_t buflen = 8192;
 static const size_t trunclen = 64;
 TEST_F(TestIBUtilLogformat, test_parse_default)
@@ -282,3 +295,40 @@ TEST_F(TestIBUtilLogformat, test_parse_custom3)
     ASSERT_EQ(IB_OK, rc);
     ASSERT_STREQ(formatted, linebuf);
 }
+
+TEST_F(TestIBUtilLogformat, test_write)
+{
+    ib_status_t rc;
+    ib_logformat_t *lf = NULL;
+    size_t len;
+    static char linebuf[buflen + 1];
+    static const char *formatted = \
+        "MyFormat " SITE_ID " " SENSOR_ID " " HOST_NAME " " LOG_FILE " END";
+
+    rc = ib_logformat_create(MM(), &lf);
+    ASSERT_EQ(IB_OK, rc);
+
+    rc = ib_logformat_parse(lf, "MyFormat %s %S %h %f END");
+    ASSERT_EQ(IB_OK, rc);
+    ASSERT_EQ(ib_list_elements(lf->items), lf->num_ops);
+    ASSERT_TRUE(lf->ops[0].field == NULL);
+    ASSERT_EQ(9U, lf->ops[0].len);
+    ASSERT_EQ('s', lf->ops[1].field->fchar);
+
+    rc = ib_logformat_write(lf, linebuf, buflen, &len, format_field_len, NULL);
+    ASSERT_EQ(IB_OK, rc);
+    ASSERT_STREQ(formatted, linebuf);
+    ASSERT_EQ(strlen(formatted), len);
+
+    /* Truncate in the middle of a field. */
+    rc = ib_logformat_write(lf, linebuf, 20, &len, format_field_len, NULL);
+    ASSERT_EQ(IB_ETRUNC, rc);
+    ASSERT_EQ(19U, len);
+    ASSERT_EQ(std::string(formatted, 19), linebuf);
+
+    /* Exactly fitting is not truncation. */
+    rc = ib_logformat_write(
+        lf, linebuf, strlen(formatted) + 1, &len, format_field_len, NULL);
+    ASSERT_EQ(IB_OK, rc);
+    ASSERT_STREQ(formatted, linebuf);
+}
@@ -852,3 +852,192 @@ TEST(TestMpool, ReleaseComplex)
     ASSERT_EQ(g_malloc_calls, g_free_calls);
     ASSERT_EQ(g_malloc_bytes, g_free_bytes);
 }
+
+TEST(TestMpool, PageCache)
+{
+    ib_mpool_t* mp = NULL;
+    size_t saved_limit = ib_mpool_page_cache_limit();
+
+    ib_mpool_page_cache_flush();
+    ib_mpool_page_cache_set_limit(16);
+    EXPECT_EQ(16U, ib_mpool_page_cache_limit());
+    EXPECT_EQ(0U, ib_mpool_page_cache_size());
+
+    // Two tracks, two pages.
+    ASSERT_EQ(IB_OK, ib_mpool_create(&mp, "page_cache", NULL));
+    ASSERT_TRUE(ib_mpool_alloc(mp, 100));
+    ASSERT_TRUE(ib_mpool_alloc(mp, 10000));
+    ib_mpool_destroy(mp);
+    EXPECT_EQ(2U, ib_mpool_page_cache_size());
+
+    // The pages of the destroyed pool are reused.
+    ASSERT_EQ(IB_OK, ib_mpool_create(&mp, "page_cache", NULL));
+    EXPECT_TRUE(ib_mpool_alloc(mp, 100));
+    EXPECT_EQ(1U, ib_mpool_page_cache_size());
+    EXPECT_TRUE(ib_mpool_alloc(mp, 10000));
+    EXPECT_EQ(0U, ib_mpool_page_cache_size());
+    EXPECT_VALID(mp);
+    ib_mpool_destroy(mp);
+    EXPECT_EQ(2U, ib_mpool_page_cache_size());
+
+    // Pages beyond the limit are freed.
+    ib_mpool_page_cache_flush();
+    EXPECT_EQ(0U, ib_mpool_page_cache_size());
+    ib_mpool_page_cache_set_limit(1);
+    ASSERT_EQ(IB_OK, ib_mpool_create(&mp, "page_cache", NULL));
+    ASSERT_TRUE(ib_mpool_alloc(mp, 100));
+    ASSERT_TRUE(ib_mpool_alloc(mp, 10000));
+    ib_mpool_destroy(mp);
+    EXPECT_EQ(1U, ib_mpool_page_cache_size());
+
+    // Pools with their own malloc do not use the cache.
+    reset_test();
+    ASSERT_EQ(IB_OK,
+        ib_mpool_create_ex(&mp, "page_cache", NULL, 0,
+            &test_malloc, &test_free));
+    EXPECT_TRUE(ib_mpool_alloc(mp, 100));
+    EXPECT_EQ(1U, ib_mpool_page_cache_size());
+    ib_mpool_destroy(mp);
+    EXPECT_EQ(1U, ib_mpool_page_cache_size());
+    ASSERT_EQ(g_malloc_calls, g_free_calls);
+    ASSERT_EQ(g_malloc_bytes, g_free_bytes);
+
+    ib_mpool_page_cache_flush();
+    EXPECT_EQ(0U, ib_mpool_page_cache_size());
+    ib_mpool_page_cache_set_limit(saved_limit);
+}
+
+TEST(TestMpool, PageCacheDisabled)
+{
+    ib_mpool_t* mp = NULL;
+    size_t saved_limit = ib_mpool_page_cache_limit();
+
+    ib_mpool_page_cache_set_limit(0);
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_EQ(IB_OK, ib_mpool_create(&mp, "page_cache_disabled", NULL));
+        EXPECT_TRUE(ib_mpool_alloc(mp, 100));
+        EXPECT_VALID(mp);
+        ib_mpool_destroy(mp);
+    }
+
+    ib_mpool_page_cache_set_limit(saved_limit);
+}
+
+TEST(TestMpool, Reset)
+{
+    reset_test();
+
+    ib_mpool_t* mp = NULL;
+    ib_mpool_t* child = NULL;
+    ib_status_t rc =
+        ib_mpool_create_ex(&mp, "reset", NULL, 0,
+            &test_malloc, &test_free);
+    ASSERT_EQ(IB_OK, rc);
+    rc = ib_mpool_create(&child, "reset_child", mp);
+    ASSERT_EQ(IB_OK, rc);
+    EXPECT_TRUE(ib_mpool_alloc(mp, 100));
+    EXPECT_TRUE(ib_mpool_alloc(child, 100));
+
+    ib_mpool_reset(mp);
+    EXPECT_VALID(mp);
+    EXPECT_EQ(0U, ib_mpool_inuse(mp));
+
+    size_t saved_malloc_calls = g_malloc_calls;
+
+    // Pages of the pool and the released child are reused.
+    EXPECT_TRUE(ib_mpool_alloc(mp, 100));
+    rc = ib_mpool_create(&child, NULL, mp);
+    ASSERT_EQ(IB_OK, rc);
+    EXPECT_TRUE(ib_mpool_alloc(child, 100));
+    EXPECT_VALID(mp);
+    EXPECT_EQ(saved_malloc_calls, g_malloc_calls);
+
+    ib_mpool_destroy(mp);
+
+    ASSERT_EQ(g_malloc_calls, g_free_calls);
+    ASSERT_EQ(g_malloc_bytes, g_free_bytes);
+}
+
+TEST(TestMpool, Fixed)
+{
+    reset_test();
+
+    ib_mpool_t* mp = NULL;
+    ib_status_t rc =
+        ib_mpool_create_ex(&mp, "fixed", NULL, 0,
+            &test_malloc, &test_free);
+    ASSERT_EQ(IB_OK, rc);
+
+    // A first object carves little.
+    EXPECT_EQ(0U, ib_mpool_inuse(mp));
+    EXPECT_TRUE(ib_mpool_alloc_fixed(mp, 24));
+    EXPECT_GT(1024U, ib_mpool_inuse(mp));
+
+    // Objects of one size are distinct and do not overlap.
+    char* a = reinterpret_cast<char*>(ib_mpool_alloc_fixed(mp, 20));
+    char* b = reinterpret_cast<char*>(ib_mpool_alloc_fixed(mp, 24));
+    char* c = reinterpret_cast<char*>(ib_mpool_alloc_fixed(mp, 40));
+    ASSERT_TRUE(a);
+    ASSERT_TRUE(b);
+    ASSERT_TRUE(c);
+    EXPECT_NE(a, b);
+    EXPECT_TRUE(a + 24 <= b || b + 24 <= a);
+    memset(a, 'a', 20);
+    memset(b, 'b', 24);
+    memset(c, 'c', 40);
+    EXPECT_VALID(mp);
+
+    // Released objects are reused by the same size class only.
+    ib_mpool_free_fixed(mp, b, 24);
+    EXPECT_NE(b, ib_mpool_alloc_fixed(mp, 40));
+    EXPECT_EQ(b, ib_mpool_alloc_fixed(mp, 17));
+
+    // Many objects share few allocations.
+    size_t saved_malloc_calls = g_malloc_calls;
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_TRUE(ib_mpool_alloc_fixed(mp, 32));
+    }
+    EXPECT_GT(saved_malloc_calls + 10, g_malloc_calls);
+
+    // Large sizes are ordinary allocations.
+    EXPECT_TRUE(ib_mpool_alloc_fixed(mp, 1000));
+    ib_mpool_free_fixed(mp, NULL, 24);
+    EXPECT_VALID(mp);
+
+    // Clear forgets released objects.
+    a = reinterpret_cast<char*>(ib_mpool_alloc_fixed(mp, 64));
+    ib_mpool_free_fixed(mp, a, 64);
+    ib_mpool_clear(mp);
+    EXPECT_EQ(0U, ib_mpool_inuse(mp));
+    EXPECT_TRUE(ib_mpool_alloc_fixed(mp, 64));
+    EXPECT_VALID(mp);
+
+    ib_mpool_destroy(mp);
+
+    ASSERT_EQ(g_malloc_calls, g_free_calls);
+    ASSERT_EQ(g_malloc_bytes, g_free_bytes);
+}
+
+TEST(TestMpool, Footprint)
+{
+    ib_mpool_t* mp = NULL;
+    ib_mpool_t* child = NULL;
+    ib_status_t rc = ib_mpool_create(&mp, "footprint", NULL);
+    ASSERT_EQ(IB_OK, rc);
+    rc = ib_mpool_create(&child, "footprint_child", mp);
+    ASSERT_EQ(IB_OK, rc);
+    EXPECT_EQ(0U, ib_mpool_footprint(mp));
+
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_TRUE(ib_mpool_alloc(child, 1000));
+    }
+    size_t footprint = ib_mpool_footprint(mp);
+    EXPECT_LE(100000U, footprint);
+    EXPECT_EQ(footprint, ib_mpool_footprint(child));
+
+    // Reset keeps the pages of the released child.
+    ib_mpool_reset(mp);
+    EXPECT_EQ(footprint, ib_mpool_footprint(mp));
+
+    ib_mpool_destroy(mp);
+}
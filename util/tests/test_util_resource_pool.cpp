@@ -30,6 +30,8 @@
 
 #include "gtest/gtest.h"
 
+#include <pthread.h>
+
 namespace {
 extern "C" {
     //! The resource we are going to build and test the resource pool with.
@@ -38,6 +40,7 @@ extern "C" {
         int postuse;
         int use;
         int destroy;
+        int held;
     };
     typedef struct resource_t resource_t;
 
@@ -234,3 +237,103 @@ TEST_F(ResourcePoolTest, create_destroy) {
         }
     }
 }
+
+TEST_F(ResourcePoolTest, threaded_cache) {
+    ib_resource_t *ib_r;
+    ib_resource_t *ib_r2;
+
+    ASSERT_EQ(IB_OK, ib_resource_pool_set_threaded(m_rp));
+
+    /* A released resource is handed back to the same thread. */
+    ASSERT_EQ(IB_OK, ib_resource_acquire(m_rp, &ib_r));
+    ASSERT_EQ(IB_OK, ib_resource_acquire(m_rp, &ib_r2));
+    ASSERT_EQ(IB_OK, ib_resource_release(ib_r2));
+    ASSERT_EQ(IB_OK, ib_resource_acquire(m_rp, &ib_r2));
+    ASSERT_EQ(2U, ib_resource_use_get(ib_r2));
+
+    resource_t *r = reinterpret_cast<resource_t *>(ib_resource_get(ib_r2));
+    ASSERT_EQ(2, r->preuse);
+    ASSERT_EQ(1, r->postuse);
+
+    ASSERT_EQ(IB_OK, ib_resource_release(ib_r2));
+    ASSERT_EQ(IB_OK, ib_resource_release(ib_r));
+}
+
+TEST_F(ResourcePoolTest, threaded_limit_reached) {
+    ib_resource_t *ib_r[11];
+
+    ASSERT_EQ(IB_OK, ib_resource_pool_set_threaded(m_rp));
+
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_EQ(IB_OK, ib_resource_acquire(m_rp, &ib_r[i]));
+    }
+    ASSERT_EQ(IB_DECLINED, ib_resource_acquire(m_rp, &ib_r[10]));
+
+    /* Cached resources still count against the limit and are found. */
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_EQ(IB_OK, ib_resource_release(ib_r[i]));
+    }
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_EQ(IB_OK, ib_resource_acquire(m_rp, &ib_r[i]));
+    }
+    ASSERT_EQ(IB_DECLINED, ib_resource_acquire(m_rp, &ib_r[10]));
+
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_EQ(IB_OK, ib_resource_release(ib_r[i]));
+    }
+
+    ASSERT_EQ(IB_OK, ib_resource_pool_flush(m_rp));
+}
+
+namespace {
+
+struct threaded_data_t {
+    ib_resource_pool_t *rp;
+    int                 errors;
+};
+
+extern "C" void *threaded_fn(void *data) {
+    threaded_data_t *d = reinterpret_cast<threaded_data_t *>(data);
+
+    for (int i = 0; i < 10000; ++i) {
+        ib_resource_t *ib_r;
+
+        if (ib_resource_acquire(d->rp, &ib_r) != IB_OK) {
+            /* The pool is at its limit; try again. */
+            continue;
+        }
+
+        resource_t *r = reinterpret_cast<resource_t *>(ib_resource_get(ib_r));
+        if (__atomic_exchange_n(&(r->held), 1, __ATOMIC_ACQ_REL) != 0) {
+            __atomic_add_fetch(&(d->errors), 1, __ATOMIC_RELAXED);
+        }
+        __atomic_store_n(&(r->held), 0, __ATOMIC_RELEASE);
+
+        if (ib_resource_release(ib_r) != IB_OK) {
+            __atomic_add_fetch(&(d->errors), 1, __ATOMIC_RELAXED);
+        }
+    }
+
+    return NULL;
+}
+
+} /* Close anonymous namespace. */
+
+TEST_F(ResourcePoolTest, threaded_concurrent) {
+    threaded_data_t data;
+    pthread_t       threads[8];
+
+    ASSERT_EQ(IB_OK, ib_resource_pool_set_threaded(m_rp));
+    data.rp     = m_rp;
+    data.errors = 0;
+
+    for (int i = 0; i < 8; ++i) {
+        ASSERT_EQ(0, pthread_create(&threads[i], NULL, threaded_fn, &data));
+    }
+    for (int i = 0; i < 8; ++i) {
+        ASSERT_EQ(0, pthread_join(threads[i], NULL));
+    }
+
+    ASSERT_EQ(0, data.errors);
+    ASSERT_EQ(IB_OK, ib_resource_pool_flush(m_rp));
+}
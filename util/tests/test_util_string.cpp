@@ -32,6 +32,8 @@
 
 #include "gtest/gtest.h"
 
+#include <cmath>
+
 using namespace std;
 using namespace IronBee;
 
@@ -60,6 +62,36 @@ TEST(TestString, string_to_num)
     EXPECT_EQ(0x1234L, n);
 }
 
+TEST(TestString, string_to_num_bounded)
+{
+    ib_num_t n;
+
+    /* Only slen bytes are parsed. */
+    EXPECT_EQ(IB_OK, ib_type_atoi_ex("12345", 3, 10, &n));
+    EXPECT_EQ(123L, n);
+    EXPECT_EQ(IB_OK, ib_type_atoi_ex(IB_S2SL("  +42"), 10, &n));
+    EXPECT_EQ(42L, n);
+    EXPECT_EQ(IB_OK, ib_type_atoi_ex(IB_S2SL("010"), 0, &n));
+    EXPECT_EQ(8L, n);
+    EXPECT_EQ(IB_OK, ib_type_atoi_ex(IB_S2SL("0xff"), 16, &n));
+    EXPECT_EQ(255L, n);
+    EXPECT_EQ(IB_OK, ib_type_atoi_ex(IB_S2SL("zz"), 36, &n));
+    EXPECT_EQ(1295L, n);
+    EXPECT_EQ(IB_OK, ib_type_atoi_ex(IB_S2SL("9223372036854775807"), 10, &n));
+    EXPECT_EQ(INT64_MAX, n);
+    EXPECT_EQ(IB_OK, ib_type_atoi_ex(IB_S2SL("-9223372036854775808"), 10, &n));
+    EXPECT_EQ(INT64_MIN, n);
+
+    EXPECT_EQ(IB_EINVAL, ib_type_atoi_ex(IB_S2SL("9223372036854775808"), 10, &n));
+    EXPECT_EQ(IB_EINVAL, ib_type_atoi_ex(IB_S2SL("-9223372036854775809"), 10, &n));
+    EXPECT_EQ(IB_EINVAL, ib_type_atoi_ex(IB_S2SL("12 "), 10, &n));
+    EXPECT_EQ(IB_EINVAL, ib_type_atoi_ex(IB_S2SL("-"), 10, &n));
+    EXPECT_EQ(IB_EINVAL, ib_type_atoi_ex(IB_S2SL("0x"), 0, &n));
+    EXPECT_EQ(IB_EINVAL, ib_type_atoi_ex(IB_S2SL("08"), 0, &n));
+    EXPECT_EQ(IB_EINVAL, ib_type_atoi_ex(IB_S2SL("12"), 1, &n));
+    EXPECT_EQ(IB_EINVAL, ib_type_atoi_ex("1\0", 2, 10, &n));
+}
+
 TEST(TestString, string_to_time)
 {
     ib_time_t t;
@@ -90,6 +122,43 @@ TEST(TestString, string_to_float)
     EXPECT_EQ(IB_EINVAL, ib_type_atof("", &f));
 }
 
+TEST(TestString, string_to_float_bounded)
+{
+    static const char *inputs[] = {
+        "0", "-0", "1.5", "  -12.25", "+.5", "5.", "1e10", "1E-5",
+        "123456789012345678", "0.1", "0.000001", "3.14159265358979",
+        "1234567890123456789012345", "1e300", "1e-300", "0x1p4", "inf",
+        "-nan", "1e", "1.2.3", ".", "e5", "1e5x"
+    };
+
+    for (size_t i = 0; i < sizeof(inputs) / sizeof(*inputs); ++i) {
+        const char *s = inputs[i];
+        char *end;
+        ib_float_t expected = strtold(s, &end);
+        ib_float_t f;
+        ib_status_t rc = ib_type_atof_ex(s, strlen(s), &f);
+
+        if (*end != '\0') {
+            EXPECT_EQ(IB_EINVAL, rc) << s;
+        }
+        else {
+            ASSERT_EQ(IB_OK, rc) << s;
+            if (isnan(expected)) {
+                EXPECT_TRUE(isnan(f)) << s;
+            }
+            else {
+                EXPECT_EQ(expected, f) << s;
+                EXPECT_EQ(signbit(expected), signbit(f)) << s;
+            }
+        }
+    }
+
+    /* Only slen bytes are parsed. */
+    ib_float_t f;
+    EXPECT_EQ(IB_OK, ib_type_atof_ex("2.5e3", 3, &f));
+    EXPECT_EQ(2.5L, f);
+}
+
 TEST(TestString, strstr)
 {
     const char *haystack;
@@ -117,6 +186,15 @@ TEST(TestString, num_to_string)
 
     EXPECT_EQ(string("1234"), ib_type_itoa(mm, 1234));
     EXPECT_EQ(string("-1234"), ib_type_itoa(mm, -1234));
+    EXPECT_EQ(string("0"), ib_type_itoa(mm, 0));
+    EXPECT_EQ(string("9223372036854775807"), ib_type_itoa(mm, INT64_MAX));
+    EXPECT_EQ(string("-9223372036854775808"), ib_type_itoa(mm, INT64_MIN));
+
+    char buf[IB_TYPE_NUM_BUF_SIZE];
+    EXPECT_EQ(2UL, ib_type_itoa_buf(-7, buf));
+    EXPECT_EQ(string("-7"), buf);
+    EXPECT_EQ(20UL, ib_type_ttoa_buf(UINT64_MAX, buf));
+    EXPECT_EQ(string("18446744073709551615"), buf);
 }
 
 TEST(TestString, time_to_string)
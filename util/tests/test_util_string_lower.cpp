@@ -63,3 +63,45 @@ TEST(TestStringLower, strlower)
     EXPECT_EQ("abc", strlower("ABC"));
     EXPECT_EQ("", strlower(""));
 }
+
+TEST(TestStringLower, strlower_const)
+{
+    ScopedMemoryPoolLite mpl;
+    const uint8_t *out;
+
+    const string unchanged = "already lower case, long enough for vectors.";
+    ASSERT_EQ(IB_OK, ib_strlower_const(
+        MemoryManager(mpl).ib(),
+        reinterpret_cast<const uint8_t*>(unchanged.data()), unchanged.length(),
+        &out
+    ));
+    EXPECT_EQ(reinterpret_cast<const uint8_t*>(unchanged.data()), out);
+
+    /* Every length and position around the vector widths. */
+    for (size_t len = 1; len < 100; ++len) {
+        for (size_t pos = 0; pos < len; ++pos) {
+            string s(len, 'x');
+            s[pos] = 'Q';
+            string expected(len, 'x');
+            expected[pos] = 'q';
+
+            ASSERT_EQ(IB_OK, ib_strlower_const(
+                MemoryManager(mpl).ib(),
+                reinterpret_cast<const uint8_t*>(s.data()), s.length(),
+                &out
+            ));
+            EXPECT_EQ(expected, string(reinterpret_cast<const char*>(out), len));
+            EXPECT_EQ(expected, strlower(s));
+        }
+    }
+
+    /* All byte values. */
+    string all;
+    string all_lower;
+    for (int c = 0; c < 256; ++c) {
+        all.push_back(static_cast<char>(c));
+        all_lower.push_back(
+            static_cast<char>((c >= 'A' && c <= 'Z') ? c + 32 : c));
+    }
+    EXPECT_EQ(all_lower, strlower(all));
+}
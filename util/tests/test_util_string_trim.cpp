@@ -92,3 +92,24 @@ TEST(TestStringTrim, strtrim_lr)
     EXPECT_EQ("", strtrim(ib_strtrim_lr, "  "));
     EXPECT_EQ("", strtrim(ib_strtrim_lr, ""));
 }
+
+TEST(TestStringTrim, strtrim_long)
+{
+    /* Padding and text lengths around the vector widths. */
+    for (size_t pad = 0; pad < 70; ++pad) {
+        EXPECT_EQ("", strtrim(ib_strtrim_left, string(pad, ' ')));
+        EXPECT_EQ("", strtrim(ib_strtrim_right, string(pad, ' ')));
+        EXPECT_EQ("", strtrim(ib_strtrim_lr, string(pad, ' ')));
+
+        for (size_t text = 1; text < 70; text += 7) {
+            string core = "x" + string(text - 1, ' ') + "y";
+            string lpad(pad, ' ');
+            string rpad(pad, '\t');
+            string s = lpad + core + rpad;
+
+            EXPECT_EQ(core + rpad, strtrim(ib_strtrim_left, s));
+            EXPECT_EQ(lpad + core, strtrim(ib_strtrim_right, s));
+            EXPECT_EQ(core, strtrim(ib_strtrim_lr, s));
+        }
+    }
+}
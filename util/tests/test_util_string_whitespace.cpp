@@ -83,3 +83,110 @@ TEST(TestStringWhitespace, str_whitespace_compress)
     EXPECT_EQ("a b c", strws(ib_str_whitespace_compress, "a b c"));
     EXPECT_EQ("", strws(ib_str_whitespace_compress, ""));
 }
+
+namespace {
+
+string strws_const(
+    boost::function<
+        ib_status_t(
+            ib_mm_t          mm,
+            const uint8_t   *data_in,
+            size_t           dlen_in,
+            const uint8_t  **data_out,
+            size_t          *dlen_out
+        )
+    > which,
+    const string& s,
+    bool *same = NULL
+)
+{
+    ScopedMemoryPoolLite mpl;
+
+    const uint8_t *out = NULL;
+    size_t out_len = 0;
+    ib_status_t rc;
+
+    rc = which(
+        MemoryManager(mpl).ib(),
+        reinterpret_cast<const uint8_t*>(s.data()), s.length(),
+        &out, &out_len
+    );
+    if (rc != IB_OK) {
+        throw runtime_error("Did not return IB_OK");
+    }
+    if (same != NULL) {
+        *same = (out == reinterpret_cast<const uint8_t*>(s.data()));
+    }
+
+    return string(reinterpret_cast<const char*>(out), out_len);
+}
+
+bool is_ws(char c)
+{
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+string reference_remove(const string& s)
+{
+    string r;
+    for (size_t i = 0; i < s.length(); ++i) {
+        if (! is_ws(s[i])) {
+            r.push_back(s[i]);
+        }
+    }
+    return r;
+}
+
+string reference_compress(const string& s)
+{
+    string r;
+    for (size_t i = 0; i < s.length(); ++i) {
+        if (! is_ws(s[i]) || i == 0 || ! is_ws(s[i - 1])) {
+            r.push_back(s[i]);
+        }
+    }
+    return r;
+}
+
+}
+
+TEST(TestStringWhitespace, str_whitespace_const)
+{
+    bool same;
+
+    EXPECT_EQ("abc", strws_const(ib_str_whitespace_remove_const, "abc", &same));
+    EXPECT_TRUE(same);
+    EXPECT_EQ("abc", strws_const(ib_str_whitespace_remove_const, "a b\tc", &same));
+    EXPECT_FALSE(same);
+
+    EXPECT_EQ("a b c", strws_const(ib_str_whitespace_compress_const, "a b c", &same));
+    EXPECT_TRUE(same);
+    EXPECT_EQ(" a\tb c ", strws_const(ib_str_whitespace_compress_const, "  a\t\tb \n c \r", &same));
+    EXPECT_FALSE(same);
+}
+
+TEST(TestStringWhitespace, str_whitespace_random)
+{
+    const char alphabet[] = "ab \t\n\v\f\rZ";
+
+    srandom(42);
+    for (int n = 0; n < 2000; ++n) {
+        string s;
+        size_t len = random() % 130;
+
+        for (size_t i = 0; i < len; ++i) {
+            /* Mostly text so long runs without whitespace happen. */
+            s.push_back(
+                random() % 4 == 0 ?
+                    alphabet[random() % (sizeof(alphabet) - 1)] :
+                    'x');
+        }
+
+        EXPECT_EQ(reference_remove(s), strws(ib_str_whitespace_remove, s));
+        EXPECT_EQ(reference_remove(s),
+                  strws_const(ib_str_whitespace_remove_const, s));
+        EXPECT_EQ(reference_compress(s), strws(ib_str_whitespace_compress, s));
+        EXPECT_EQ(reference_compress(s),
+                  strws_const(ib_str_whitespace_compress_const, s));
+    }
+}
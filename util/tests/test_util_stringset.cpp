@@ -24,12 +24,21 @@
 
 #include "ironbee_config_auto.h"
 #include "gtest/gtest.h"
+#include "simple_fixture.hpp"
 
 #include <ironbee/stringset.h>
 #include <ironbee/string.h>
 
+#include <cstdlib>
+#include <string>
+#include <vector>
+
 using namespace std;
 
+class TestStringSetTrie : public SimpleFixture
+{
+};
+
 TEST(TestStringSet, Empty)
 {
     ib_stringset_t set;
@@ -109,3 +118,121 @@ TEST(TestStringSet, AfterEnd)
 
     EXPECT_EQ(IB_ENOENT, ib_stringset_query(&set, IB_S2SL("g"), NULL));
 }
+
+TEST(TestStringSet, ShorterPrefixBehindSibling)
+{
+    ib_stringset_t set;
+    ib_stringset_entry_t entries[2] = {
+        {"a", 1, NULL},
+        {"ab", 2, NULL}
+    };
+
+    ASSERT_EQ(IB_OK, ib_stringset_init(&set, entries, 2));
+
+    const ib_stringset_entry_t* result;
+
+    ASSERT_EQ(IB_OK, ib_stringset_query(&set, IB_S2SL("ac"), &result));
+    EXPECT_EQ("a", string(result->string, result->length));
+}
+
+TEST_F(TestStringSetTrie, Empty)
+{
+    ib_stringset_t set;
+    ib_stringset_entry_t entries;
+
+    ASSERT_EQ(IB_OK, ib_stringset_init_trie(&set, &entries, 0, MM()));
+
+    EXPECT_EQ(IB_ENOENT, ib_stringset_query(&set, IB_S2SL("foo"), NULL));
+    EXPECT_EQ(IB_ENOENT, ib_stringset_query(&set, IB_S2SL(""), NULL));
+}
+
+TEST_F(TestStringSetTrie, Prefixed)
+{
+    int a = 1;
+    ib_stringset_t set;
+    ib_stringset_entry_t entries[5] = {
+        {"bar", 3, NULL},
+        {"a", 1, NULL},
+        {"aaa", 3, &a},
+        {"aa", 2, NULL},
+        {"ab", 2, NULL}
+    };
+
+    ASSERT_EQ(IB_OK, ib_stringset_init_trie(&set, entries, 5, MM()));
+
+    const ib_stringset_entry_t* result;
+
+    EXPECT_EQ(IB_ENOENT, ib_stringset_query(&set, IB_S2SL("hello"), NULL));
+    EXPECT_EQ(IB_ENOENT, ib_stringset_query(&set, IB_S2SL("ba"), NULL));
+
+    ASSERT_EQ(IB_OK, ib_stringset_query(&set, IB_S2SL("aaaaaa"), &result));
+    EXPECT_EQ("aaa", string(result->string, result->length));
+    EXPECT_EQ(&a, result->data);
+
+    ASSERT_EQ(IB_OK, ib_stringset_query(&set, IB_S2SL("ac"), &result));
+    EXPECT_EQ("a", string(result->string, result->length));
+
+    ASSERT_EQ(IB_OK, ib_stringset_query(&set, IB_S2SL("bar"), &result));
+    EXPECT_EQ("bar", string(result->string, result->length));
+}
+
+TEST_F(TestStringSetTrie, MatchesBinarySearch)
+{
+    static const size_t c_num_entries = 2000;
+    // Entries use the first four; queries also use the last.
+    static const char c_alphabet[] = {'/', 'a', 'b', '\xff', 'c'};
+    vector<string> strings;
+    vector<ib_stringset_entry_t> trie_entries;
+    vector<ib_stringset_entry_t> search_entries;
+    ib_stringset_t trie_set;
+    ib_stringset_t search_set;
+
+    srand(1234);
+    for (size_t i = 0; i < c_num_entries; ++i) {
+        string s;
+        size_t length = rand() % 12;
+        for (size_t j = 0; j < length; ++j) {
+            s += c_alphabet[rand() % 4];
+        }
+        strings.push_back(s);
+    }
+    for (size_t i = 0; i < c_num_entries; ++i) {
+        ib_stringset_entry_t entry = {
+            strings[i].data(), strings[i].length(), NULL
+        };
+        trie_entries.push_back(entry);
+        search_entries.push_back(entry);
+    }
+
+    ASSERT_EQ(IB_OK, ib_stringset_init_trie(
+        &trie_set, &trie_entries[0], c_num_entries, MM()
+    ));
+    ASSERT_EQ(IB_OK, ib_stringset_init(
+        &search_set, &search_entries[0], c_num_entries
+    ));
+
+    for (size_t i = 0; i < 5000; ++i) {
+        string query;
+        size_t length = rand() % 16;
+        for (size_t j = 0; j < length; ++j) {
+            query += c_alphabet[rand() % 5];
+        }
+
+        const ib_stringset_entry_t* trie_result = NULL;
+        const ib_stringset_entry_t* search_result = NULL;
+        ib_status_t trie_rc = ib_stringset_query(
+            &trie_set, query.data(), query.length(), &trie_result
+        );
+        ib_status_t search_rc = ib_stringset_query(
+            &search_set, query.data(), query.length(), &search_result
+        );
+
+        ASSERT_EQ(search_rc, trie_rc) << query;
+        if (trie_rc == IB_OK) {
+            EXPECT_EQ(
+                string(search_result->string, search_result->length),
+                string(trie_result->string, trie_result->length)
+            ) << query;
+        }
+    }
+}
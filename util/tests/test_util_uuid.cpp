@@ -28,7 +28,13 @@
 
 #include "gtest/gtest.h"
 
+#include <set>
+#include <string>
+
+#include <pthread.h>
 #include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 TEST(TestIBUtilUUID, random)
 {
@@ -49,3 +55,91 @@ TEST(TestIBUtilUUID, random)
 
     ib_uuid_shutdown();
 }
+
+TEST(TestIBUtilUUID, format)
+{
+    char uuid[IB_UUID_LENGTH];
+
+    for (int i = 0; i < 100; ++i) {
+        ASSERT_EQ(IB_OK, ib_uuid_create_v4(uuid));
+        ASSERT_EQ(size_t(IB_UUID_LENGTH - 1), strlen(uuid));
+        for (int j = 0; j < IB_UUID_LENGTH - 1; ++j) {
+            if (j == 8 || j == 13 || j == 18 || j == 23) {
+                EXPECT_EQ('-', uuid[j]);
+            }
+            else {
+                EXPECT_TRUE(strchr("0123456789abcdef", uuid[j]) != NULL);
+            }
+        }
+        EXPECT_EQ('4', uuid[14]);
+        EXPECT_TRUE(strchr("89ab", uuid[19]) != NULL);
+    }
+    ib_uuid_shutdown();
+}
+
+namespace {
+
+const int c_uuids_per_thread = 2000;
+
+extern "C"
+void *create_uuids(void *arg)
+{
+    std::set<std::string> *uuids = static_cast<std::set<std::string> *>(arg);
+    char uuid[IB_UUID_LENGTH];
+
+    for (int i = 0; i < c_uuids_per_thread; ++i) {
+        if (ib_uuid_create_v4(uuid) != IB_OK) {
+            break;
+        }
+        uuids->insert(uuid);
+    }
+
+    return NULL;
+}
+
+}
+
+TEST(TestIBUtilUUID, threads)
+{
+    const int num_threads = 8;
+    pthread_t threads[num_threads];
+    std::set<std::string> uuids[num_threads];
+    std::set<std::string> all;
+
+    for (int i = 0; i < num_threads; ++i) {
+        ASSERT_EQ(0, pthread_create(&threads[i], NULL, create_uuids, &uuids[i]));
+    }
+    for (int i = 0; i < num_threads; ++i) {
+        pthread_join(threads[i], NULL);
+        all.insert(uuids[i].begin(), uuids[i].end());
+    }
+
+    EXPECT_EQ(size_t(num_threads * c_uuids_per_thread), all.size());
+}
+
+TEST(TestIBUtilUUID, fork)
+{
+    char uuid[IB_UUID_LENGTH];
+    char child_uuid[IB_UUID_LENGTH];
+    int  fds[2];
+    pid_t pid;
+
+    /* Seed this thread before forking. */
+    ASSERT_EQ(IB_OK, ib_uuid_create_v4(uuid));
+    ASSERT_EQ(0, pipe(fds));
+
+    pid = fork();
+    ASSERT_NE(-1, pid);
+    if (pid == 0) {
+        ib_uuid_create_v4(child_uuid);
+        _exit(write(fds[1], child_uuid, IB_UUID_LENGTH) == IB_UUID_LENGTH ? 0 : 1);
+    }
+
+    ASSERT_EQ(IB_OK, ib_uuid_create_v4(uuid));
+    ASSERT_EQ(ssize_t(IB_UUID_LENGTH), read(fds[0], child_uuid, IB_UUID_LENGTH));
+    waitpid(pid, NULL, 0);
+    close(fds[0]);
+    close(fds[1]);
+
+    EXPECT_STRNE(uuid, child_uuid);
+}
@@ -27,61 +27,405 @@
 
 #include <assert.h>
 #include <errno.h>
+#include <float.h>
 #include <inttypes.h>
 #include <math.h>
 #include <limits.h>
+#include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 
 /* Helper Functions. */
 
 /**
- * Get the number of digits in a number
+ * Size of the stack buffer used to hand a float to strtold().
  *
- * @param[in] num The number to operate on
+ * Longer strings are copied to the heap.
+ */
+#define FLOAT_COPY_SIZE 64
+
+/**
+ * Largest power of ten that is exact in an @ref ib_float_t.
  *
- * @returns Number of digits (including '-')
+ * A decimal with a mantissa below @ref FLOAT_EXACT_MANTISSA and an exponent
+ * no larger than this in magnitude converts with a single rounding, giving
+ * the same result as strtold().
  */
-static size_t ib_num_digits(int64_t num);
+#if LDBL_MANT_DIG >= 64
+#define FLOAT_EXACT_POW10 27
+#define FLOAT_EXACT_MANTISSA UINT64_MAX
+#else
+#define FLOAT_EXACT_POW10 22
+#define FLOAT_EXACT_MANTISSA (UINT64_C(1) << DBL_MANT_DIG)
+#endif
 
 /**
- * Get the size of a string buffer required to store a number
+ * Powers of ten up to @ref FLOAT_EXACT_POW10.
+ */
+static const ib_float_t c_pow10[] = {
+    1e0L,  1e1L,  1e2L,  1e3L,  1e4L,  1e5L,  1e6L,  1e7L,  1e8L,  1e9L,
+    1e10L, 1e11L, 1e12L, 1e13L, 1e14L, 1e15L, 1e16L, 1e17L, 1e18L, 1e19L,
+    1e20L, 1e21L, 1e22L, 1e23L, 1e24L, 1e25L, 1e26L, 1e27L
+};
+
+/**
+ * Digit pairs 00 through 99 for formatting.
+ */
+static const char c_digit_pairs[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233"
+    "34353637383940414243444546474849505152535455565758596061626364656667"
+    "6869707172737475767778798081828384858687888990919293949596979899";
+
+/**
+ * Is @a c whitespace in the C locale?
  *
- * @param[in] num The number to operate on
+ * @param[in] c Character.
  *
- * @returns Required string length
+ * @returns True if @a c is space, tab, newline, vertical tab, form feed or
+ *          carriage return.
  */
-static size_t ib_num_buf_size(int64_t num);
+static inline bool is_space(char c)
+{
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
 
-static const int64_t  P10_INT64_LIMIT  = (INT64_MAX  / 10);
+/**
+ * Value of @a c as a digit in bases up to 36.
+ *
+ * @param[in] c Character.
+ *
+ * @returns The digit value or 36 if @a c is not a digit in any base.
+ */
+static inline unsigned int digit_value(char c)
+{
+    unsigned int d;
+
+    d = (unsigned int)(unsigned char)c - '0';
+    if (d < 10) {
+        return d;
+    }
+    d = ((unsigned int)(unsigned char)c | 0x20) - 'a';
+    if (d < 26) {
+        return d + 10;
+    }
+    return 36;
+}
 
-static size_t ib_num_digits(int64_t num)
+/**
+ * Parse an integer the way strtol() does in the C locale.
+ *
+ * Leading whitespace, a sign and, for base 0 or 16, a 0x prefix are
+ * accepted. Base 0 selects octal for a leading 0. Unlike strtol(), all of
+ * @a s must be consumed.
+ *
+ * @param[in] s String.
+ * @param[in] slen Length of @a s.
+ * @param[in] base Base: 0 or 2 through 36.
+ * @param[in] pos_limit Largest magnitude accepted for a positive value.
+ * @param[in] neg_limit Largest magnitude accepted for a negative value.
+ * @param[out] negative Set to true if a minus sign was seen.
+ * @param[out] result The magnitude.
+ *
+ * @returns
+ *   - IB_OK On success.
+ *   - IB_EINVAL If @a s is not entirely an integer or is out of range.
+ */
+static ib_status_t parse_integer(
+    const char *s,
+    size_t      slen,
+    int         base,
+    uint64_t    pos_limit,
+    uint64_t    neg_limit,
+    bool       *negative,
+    uint64_t   *result
+)
 {
-    size_t n = 1;
-    int64_t po10;
+    assert(s != NULL);
+    assert(negative != NULL);
+    assert(result != NULL);
+
+    const char *end = s + slen;
+    uint64_t value = 0;
+    uint64_t limit;
+    uint64_t cutoff;
+    unsigned int cutlim;
 
-    if (num < 0) {
-        num = -num;
-        ++n;
+    while (s < end && is_space(*s)) {
+        ++s;
     }
 
-    po10 = 10;
-    while (num >= po10) {
-        ++n;
-        if (po10 > P10_INT64_LIMIT)
-            break;
-        po10 *= 10;
+    *negative = false;
+    if (s < end && (*s == '+' || *s == '-')) {
+        *negative = (*s == '-');
+        ++s;
     }
-    return n;
+
+    if ( (base == 0 || base == 16) &&
+         (end - s > 2) &&
+         (s[0] == '0') &&
+         ((s[1] | 0x20) == 'x') &&
+         (digit_value(s[2]) < 16) )
+    {
+        s += 2;
+        base = 16;
+    }
+    else if (base == 0) {
+        base = (s < end && *s == '0') ? 8 : 10;
+    }
+    else if (base < 2 || base > 36) {
+        return IB_EINVAL;
+    }
+
+    if (s == end) {
+        return IB_EINVAL;
+    }
+
+    limit = *negative ? neg_limit : pos_limit;
+    cutoff = limit / (unsigned int)base;
+    cutlim = (unsigned int)(limit % (unsigned int)base);
+
+    for (; s < end; ++s) {
+        unsigned int d = digit_value(*s);
+
+        if (d >= (unsigned int)base) {
+            return IB_EINVAL;
+        }
+        if (value > cutoff || (value == cutoff && d > cutlim)) {
+            return IB_EINVAL;
+        }
+        value = value * (unsigned int)base + d;
+    }
+
+    *result = value;
+    return IB_OK;
 }
 
-static size_t ib_num_buf_size(int64_t num)
+/**
+ * Convert a plain decimal float without libc.
+ *
+ * Handles an optional sign, digits with an optional fraction and an
+ * optional exponent when the value can be computed with a single rounding.
+ * Everything else, including hexadecimal floats, infinities and long
+ * mantissas, is declined so the caller can fall back to strtold().
+ *
+ * @param[in] s String.
+ * @param[in] slen Length of @a s.
+ * @param[out] result The result.
+ *
+ * @returns
+ *   - IB_OK On success.
+ *   - IB_DECLINED If @a s needs strtold().
+ */
+static ib_status_t parse_decimal(
+    const char *s,
+    size_t      slen,
+    ib_float_t *result
+)
 {
-    size_t digits = ib_num_digits(num);
-    return digits + 1;
+    assert(s != NULL);
+    assert(result != NULL);
+
+    const char *end = s + slen;
+    bool negative = false;
+    bool any = false;
+    uint64_t mantissa = 0;
+    int ndigits = 0;
+    int exp10 = 0;
+    ib_float_t value;
+
+    while (s < end && is_space(*s)) {
+        ++s;
+    }
+    if (s < end && (*s == '+' || *s == '-')) {
+        negative = (*s == '-');
+        ++s;
+    }
+
+    /* Integer part. Leading zeros are not significant. */
+    for (; s < end && (unsigned int)(*s - '0') < 10; ++s) {
+        any = true;
+        if (mantissa == 0 && *s == '0') {
+            continue;
+        }
+        if (ndigits == 19) {
+            return IB_DECLINED;
+        }
+        mantissa = mantissa * 10 + (unsigned int)(*s - '0');
+        ++ndigits;
+    }
+
+    /* Fraction. */
+    if (s < end && *s == '.') {
+        for (++s; s < end && (unsigned int)(*s - '0') < 10; ++s) {
+            any = true;
+            --exp10;
+            if (mantissa == 0 && *s == '0') {
+                continue;
+            }
+            if (ndigits == 19) {
+                return IB_DECLINED;
+            }
+            mantissa = mantissa * 10 + (unsigned int)(*s - '0');
+            ++ndigits;
+        }
+    }
+    if (! any) {
+        return IB_DECLINED;
+    }
+
+    /* Exponent. */
+    if (s < end && (*s | 0x20) == 'e') {
+        bool exp_negative = false;
+        int exp = 0;
+
+        ++s;
+        if (s < end && (*s == '+' || *s == '-')) {
+            exp_negative = (*s == '-');
+            ++s;
+        }
+        if (s == end) {
+            return IB_DECLINED;
+        }
+        for (; s < end && (unsigned int)(*s - '0') < 10; ++s) {
+            if (exp > 10000) {
+                return IB_DECLINED;
+            }
+            exp = exp * 10 + (*s - '0');
+        }
+        exp10 += exp_negative ? -exp : exp;
+    }
+    if (s != end) {
+        return IB_DECLINED;
+    }
+
+    if (mantissa == 0) {
+        *result = negative ? -0.0L : 0.0L;
+        return IB_OK;
+    }
+    if ( (mantissa > FLOAT_EXACT_MANTISSA) ||
+         (exp10 > FLOAT_EXACT_POW10) ||
+         (exp10 < -FLOAT_EXACT_POW10) )
+    {
+        return IB_DECLINED;
+    }
+
+    value = (ib_float_t)mantissa;
+    if (exp10 < 0) {
+        value /= c_pow10[-exp10];
+    }
+    else {
+        value *= c_pow10[exp10];
+    }
+
+    *result = negative ? -value : value;
+    return IB_OK;
+}
+
+/**
+ * Convert a float with strtold() from a NUL-terminated copy of @a s.
+ *
+ * @param[in] s String.
+ * @param[in] slen Length of @a s.
+ * @param[out] result The result.
+ *
+ * @returns
+ *   - IB_OK On success.
+ *   - IB_EALLOC If a long string could not be copied.
+ *   - IB_EINVAL If @a s is not a float or is out of range.
+ */
+static ib_status_t parse_float_libc(
+    const char *s,
+    size_t      slen,
+    ib_float_t *result
+)
+{
+    assert(s != NULL);
+    assert(result != NULL);
+
+    char local[FLOAT_COPY_SIZE];
+    char *buf = local;
+    char *endptr;
+    ib_float_t val;
+    ib_status_t rc = IB_OK;
+
+    if (slen >= sizeof(local)) {
+        buf = malloc(slen + 1);
+        if (buf == NULL) {
+            return IB_EALLOC;
+        }
+    }
+    memcpy(buf, s, slen);
+    buf[slen] = '\0';
+
+    errno = 0;
+    val = strtold(buf, &endptr);
+
+    /* Conversion failed */
+    if (endptr != buf + slen) {
+        rc = IB_EINVAL;
+    }
+    /* Check for Underflow would occur. */
+    else if ( (val == 0.0) && (errno == ERANGE) ) {
+        rc = IB_EINVAL;
+    }
+    /* Overflow would occur. */
+    else if ( ((val == HUGE_VALL) || (val == -HUGE_VALL)) &&
+              (errno == ERANGE) )
+    {
+        rc = IB_EINVAL;
+    }
+    else {
+        *result = val;
+    }
+
+    if (buf != local) {
+        free(buf);
+    }
+    return rc;
 }
 
+/**
+ * Write @a value in decimal to @a buf.
+ *
+ * @param[in] value Magnitude.
+ * @param[in] negative Prefix a minus sign.
+ * @param[out] buf Buffer of at least @ref IB_TYPE_NUM_BUF_SIZE bytes.
+ *
+ * @returns Length written, not including the NUL.
+ */
+static size_t format_decimal(uint64_t value, bool negative, char *buf)
+{
+    assert(buf != NULL);
+
+    char tmp[IB_TYPE_NUM_BUF_SIZE];
+    char *p = tmp + sizeof(tmp);
+    size_t len;
+
+    while (value >= 100) {
+        unsigned int pair = (unsigned int)(value % 100) * 2;
+        value /= 100;
+        *--p = c_digit_pairs[pair + 1];
+        *--p = c_digit_pairs[pair];
+    }
+    if (value >= 10) {
+        unsigned int pair = (unsigned int)value * 2;
+        *--p = c_digit_pairs[pair + 1];
+        *--p = c_digit_pairs[pair];
+    }
+    else {
+        *--p = (char)('0' + value);
+    }
+    if (negative) {
+        *--p = '-';
+    }
+
+    len = tmp + sizeof(tmp) - p;
+    memcpy(buf, p, len);
+    buf[len] = '\0';
+    return len;
+}
 
 ib_status_t ib_type_atoi_ex(
     const char *s,
@@ -92,23 +436,31 @@ ib_status_t ib_type_atoi_ex(
 {
     assert(result != NULL);
 
-    char *buf;
     ib_status_t rc;
+    bool negative;
+    uint64_t value;
 
     /* Check for zero length string */
     if ( (s == NULL) || (slen == 0) ) {
         return IB_EINVAL;
     }
 
-    buf = malloc(slen+1);
-    if (buf == NULL) {
-        return IB_EALLOC;
+    rc = parse_integer(
+        s, slen, base,
+        INT64_MAX, (uint64_t)INT64_MAX + 1,
+        &negative, &value
+    );
+    if (rc != IB_OK) {
+        return rc;
     }
-    memcpy(buf, s, slen);
-    buf[slen] = '\0';
-    rc = ib_type_atoi(buf, base, result);
-    free(buf);
-    return rc;
+
+    if (negative && value != 0) {
+        *result = -(ib_num_t)(value - 1) - 1;
+    }
+    else {
+        *result = (ib_num_t)value;
+    }
+    return IB_OK;
 }
 
 ib_status_t ib_type_atoi(
@@ -119,33 +471,12 @@ ib_status_t ib_type_atoi(
 {
     assert(result != NULL);
 
-    size_t slen;
-    char *end;
-    long int value;
-    size_t vlen;
-
     /* Check for zero length string */
     if ( (s == NULL) || (*s == '\0') ) {
         return IB_EINVAL;
     }
 
-    slen = strlen(s);
-
-    /* Do the conversion, check for errors */
-    value = strtol(s, &end, base);
-    vlen = (end - s);
-    if (vlen != slen) {
-        return IB_EINVAL;
-    }
-    else if ( ((value == LONG_MIN) || (value == LONG_MAX)) &&
-              (errno == ERANGE) )
-    {
-        return IB_EINVAL;
-    }
-    else {
-        *result = value;
-        return IB_OK;
-    }
+    return ib_type_atoi_ex(s, strlen(s), base, result);
 }
 
 ib_status_t ib_type_atot_ex(
@@ -157,24 +488,21 @@ ib_status_t ib_type_atot_ex(
     assert(result != NULL);
 
     ib_status_t rc;
-    char *buf;
+    bool negative;
+    uint64_t value;
 
     /* Check for zero length string */
     if ( (s == NULL) || (slen == 0) ) {
         return IB_EINVAL;
     }
 
-    buf = malloc(slen+1);
-    if (buf == NULL) {
-        return IB_EALLOC;
+    rc = parse_integer(s, slen, 0, UINT64_MAX, 0, &negative, &value);
+    if (rc != IB_OK) {
+        return rc;
     }
 
-    memcpy(buf, s, slen);
-    buf[slen] = '\0';
-    rc = ib_type_atot(buf, result);
-
-    free(buf);
-    return rc;
+    *result = value;
+    return IB_OK;
 }
 
 ib_status_t ib_type_atot(
@@ -184,32 +512,12 @@ ib_status_t ib_type_atot(
 {
     assert(result != NULL);
 
-    size_t slen;
-    char *end;
-    unsigned long int value;
-    size_t vlen;
-
     /* Check for zero length string */
     if ( (s == NULL) || (*s == '\0') ) {
         return IB_EINVAL;
     }
 
-    slen = strlen(s);
-
-    /* Do the conversion, check for errors */
-    value = strtoul(s, &end, 0);
-    vlen = (end - s);
-    if (vlen != slen) {
-        return IB_EINVAL;
-    }
-    else if ( (value == ULONG_MAX) && (errno == ERANGE) )
-    {
-        return IB_EINVAL;
-    }
-    else {
-        *result = value;
-        return IB_OK;
-    }
+    return ib_type_atot_ex(s, strlen(s), result);
 }
 
 ib_status_t ib_type_atof_ex(
@@ -222,22 +530,17 @@ ib_status_t ib_type_atof_ex(
 
     ib_status_t rc;
 
+    *result = 0.0;
+
     /* Check for zero length string */
-    if ( (s == NULL) || (*s == '\0') ) {
+    if ( (s == NULL) || (slen == 0) ) {
         return IB_EINVAL;
     }
 
-    char *sdup = strndup(s, slen);
-
-    if ( ! sdup ) {
-        return IB_EALLOC;
+    rc = parse_decimal(s, slen, result);
+    if (rc == IB_DECLINED) {
+        rc = parse_float_libc(s, slen, result);
     }
-
-    /* In this case the _ex function calls out to the no-length function. */
-    rc = ib_type_atof(sdup, result);
-
-    free(sdup);
-
     return rc;
 }
 
@@ -245,11 +548,6 @@ ib_status_t ib_type_atof(const char *s, ib_float_t *result)
 {
     assert(result != NULL);
 
-    char *endptr;
-    const char *send;
-    ib_float_t val;
-    size_t len;
-
     *result = 0.0;
 
     /* Check for zero length string */
@@ -257,52 +555,42 @@ ib_status_t ib_type_atof(const char *s, ib_float_t *result)
         return IB_EINVAL;
     }
 
-    /* Get the length */
-    len = strlen(s);
-    send = s + len;
-
-    errno = 0;
-    val = strtold(s, &endptr);
+    return ib_type_atof_ex(s, strlen(s), result);
+}
 
-    /* Conversion failed */
-    if (endptr != send) {
-        return IB_EINVAL;
-    }
+size_t ib_type_itoa_buf(int64_t value, char *buf)
+{
+    assert(buf != NULL);
 
-    /* Check for Underflow would occur. */
-    if ( (val == 0.0) && (errno == ERANGE) ) {
-        return IB_EINVAL;
+    if (value < 0) {
+        return format_decimal((uint64_t)-(value + 1) + 1, true, buf);
     }
+    return format_decimal((uint64_t)value, false, buf);
+}
 
-    /* Overflow would occur. */
-    if ( ((val == HUGE_VALL) || (val == -HUGE_VALL)) && (errno == ERANGE)) {
-        return IB_EINVAL;
-    }
+size_t ib_type_ttoa_buf(ib_time_t value, char *buf)
+{
+    assert(buf != NULL);
 
-    *result = val;
-    return IB_OK;
+    return format_decimal(value, false, buf);
 }
 
 const char *ib_type_itoa(
     ib_mm_t mm,
     int64_t value
 ) {
-    size_t size = ib_num_buf_size(value);
-    char *buf = ib_mm_alloc(mm, size);
-    if (buf != NULL) {
-        snprintf(buf, size, "%"PRId64, value);
-    }
-    return buf;
+    char buf[IB_TYPE_NUM_BUF_SIZE];
+    size_t len = ib_type_itoa_buf(value, buf);
+
+    return ib_mm_memdup(mm, buf, len + 1);
 }
 
 const char *ib_type_ttoa(ib_mm_t mm, ib_time_t value)
 {
-    size_t size = ib_num_buf_size(value);
-    char *buf = ib_mm_alloc(mm, size);
-    if (buf != NULL) {
-        snprintf(buf, size, "%"PRIu64, value);
-    }
-    return buf;
+    char buf[IB_TYPE_NUM_BUF_SIZE];
+    size_t len = ib_type_ttoa_buf(value, buf);
+
+    return ib_mm_memdup(mm, buf, len + 1);
 }
 
 const char *ib_type_ftoa(
@@ -14,54 +14,215 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  ****************************************************************************/
-
 /**
  * @file
  * @brief UUID helper functions
+ *
+ * Version 4 UUIDs come from a per thread xoshiro256** generator. Each
+ * thread seeds its generator from the operating system the first time it
+ * creates a UUID, so creating one takes no lock and makes no library call.
+ * A forked child reseeds so that it does not repeat its parent's UUIDs.
+ *
  * @author Christopher Alfeld <calfeld@qualys.com>
  * @todo Add bin to ascii
  */
 
 #include "ironbee_config_auto.h"
 
-#include <uuid.h>
-
 #include <ironbee/uuid.h>
 
-#include <ironbee/lock.h>
-
 #include <assert.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
 
-/*
- * These are initialized by ib_uuid_init();
- * OSSP UUID is ... generous .. in what it creates for a UUID.  E.g., it will
- * do multiple allocations, check its MAC (it may have changed?), etc. for
- * every creation.  So we only keep one at reuse it.
+/**
+ * Per thread generator state.
  */
-static ib_lock_t *g_uuid_lock;
-static uuid_t    *g_ossp_uuid;
+typedef struct uuid_state_t uuid_state_t;
+struct uuid_state_t {
+    uint64_t s[4];       /**< xoshiro256** state. */
+    unsigned generation; /**< Value of @ref g_uuid_generation when seeded. */
+};
 
-ib_status_t ib_uuid_initialize(void)
+/**
+ * Key of the @ref uuid_state_t of the calling thread.
+ */
+static pthread_key_t  g_uuid_key;
+
+/**
+ * Ensure @ref g_uuid_key is created once.
+ */
+static pthread_once_t g_uuid_once = PTHREAD_ONCE_INIT;
+
+/**
+ * Incremented in each forked child, forcing every state to reseed.
+ */
+static unsigned       g_uuid_generation = 0;
+
+/**
+ * Incremented for each seeding, so no two seeds are equal even if the
+ * operating system provides no randomness.
+ */
+static uint64_t       g_uuid_seeds = 0;
+
+/**
+ * Force reseeding in a forked child.
+ */
+static void uuid_atfork_child(void)
+{
+    __atomic_add_fetch(&g_uuid_generation, 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * Create @ref g_uuid_key and register @ref uuid_atfork_child().
+ */
+static void uuid_once(void)
 {
-    ib_status_t rc;
+    pthread_key_create(&g_uuid_key, free);
+    pthread_atfork(NULL, NULL, uuid_atfork_child);
+}
 
-    if (uuid_create(&g_ossp_uuid) != UUID_RC_OK) {
-        return IB_EOTHER;
+/**
+ * The splitmix64 generator; used to expand seeds.
+ *
+ * @param[in,out] x Generator state.
+ *
+ * @returns Next value.
+ */
+static uint64_t splitmix64(uint64_t *x)
+{
+    uint64_t z = (*x += UINT64_C(0x9e3779b97f4a7c15));
+
+    z = (z ^ (z >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+    z = (z ^ (z >> 27)) * UINT64_C(0x94d049bb133111eb);
+    return z ^ (z >> 31);
+}
+
+/**
+ * Seed @a state.
+ *
+ * Reads the seed from /dev/urandom and mixes in the time, process id and
+ * a global seed count in case that is not available.
+ *
+ * @param[out] state State to seed.
+ */
+static void uuid_seed(uuid_state_t *state)
+{
+    struct timespec ts;
+    uint64_t        x;
+    int             fd;
+
+    memset(state->s, 0, sizeof(state->s));
+    fd = open("/dev/urandom", O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        /* A short read leaves zeros, which the mixing below covers. */
+        if (read(fd, state->s, sizeof(state->s)) < 0) {
+            memset(state->s, 0, sizeof(state->s));
+        }
+        close(fd);
     }
 
-    rc = ib_lock_create_malloc(&g_uuid_lock);
-    if ( rc != IB_OK ) {
-        return rc;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    x = __atomic_fetch_add(&g_uuid_seeds, 1, __ATOMIC_RELAXED) ^
+        ((uint64_t)getpid() << 32) ^
+        (uint64_t)ts.tv_sec ^ ((uint64_t)ts.tv_nsec << 20);
+    for (size_t i = 0; i < 4; ++i) {
+        state->s[i] ^= splitmix64(&x);
     }
 
-    return rc;
+    state->generation =
+        __atomic_load_n(&g_uuid_generation, __ATOMIC_RELAXED);
+}
+
+/**
+ * Rotate left.
+ */
+static inline uint64_t rotl(uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+/**
+ * The xoshiro256** generator.
+ *
+ * @param[in,out] state Generator state.
+ *
+ * @returns Next value.
+ */
+static inline uint64_t xoshiro256ss(uuid_state_t *state)
+{
+    uint64_t *s      = state->s;
+    uint64_t  result = rotl(s[1] * 5, 7) * 9;
+    uint64_t  t      = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+
+    return result;
+}
+
+/**
+ * Generator state of the calling thread, seeded.
+ *
+ * @returns State or NULL on allocation failure.
+ */
+static uuid_state_t *uuid_state(void)
+{
+    uuid_state_t *state = pthread_getspecific(g_uuid_key);
+
+    if (state == NULL) {
+        state = malloc(sizeof(*state));
+        if (state == NULL) {
+            return NULL;
+        }
+        if (pthread_setspecific(g_uuid_key, state) != 0) {
+            free(state);
+            return NULL;
+        }
+        uuid_seed(state);
+    }
+    else if (
+        state->generation !=
+        __atomic_load_n(&g_uuid_generation, __ATOMIC_RELAXED)
+    )
+    {
+        uuid_seed(state);
+    }
+
+    return state;
+}
+
+ib_status_t ib_uuid_initialize(void)
+{
+    if (pthread_once(&g_uuid_once, uuid_once) != 0) {
+        return IB_EOTHER;
+    }
+
+    return IB_OK;
 }
 
 ib_status_t ib_uuid_shutdown(void)
 {
-    ib_lock_destroy_malloc(g_uuid_lock);
-    uuid_destroy(g_ossp_uuid);
+    uuid_state_t *state;
+
+    if (pthread_once(&g_uuid_once, uuid_once) != 0) {
+        return IB_EOTHER;
+    }
+
+    /* Other threads free their state when they exit. */
+    state = pthread_getspecific(g_uuid_key);
+    if (state != NULL) {
+        pthread_setspecific(g_uuid_key, NULL);
+        free(state);
+    }
 
     return IB_OK;
 }
@@ -70,42 +231,37 @@ ib_status_t ib_uuid_create_v4(char *uuid)
 {
     assert(uuid != NULL);
 
-    ib_status_t rc;
-    uuid_rc_t uuid_rc;
-    size_t uuid_len = UUID_LEN_STR+1;
+    static const char hex[] = "0123456789abcdef";
+    uuid_state_t *state;
+    uint8_t       bytes[16];
+    char         *out = uuid;
 
-    rc = ib_lock_lock(g_uuid_lock);
-    if (rc != IB_OK) {
-        return rc;
-    }
-
-    uuid_rc = uuid_make(g_ossp_uuid, UUID_MAKE_V4);
-    if (uuid_rc == UUID_RC_MEM) {
-        rc = IB_EALLOC;
-        goto finish;
+    if (pthread_once(&g_uuid_once, uuid_once) != 0) {
+        return IB_EOTHER;
     }
-    else if (uuid_rc != UUID_RC_OK) {
-        rc = IB_EOTHER;
-        goto finish;
+    state = uuid_state();
+    if (state == NULL) {
+        return IB_EALLOC;
     }
 
-    uuid_rc = uuid_export(
-        g_ossp_uuid, UUID_FMT_STR,
-        (void *)&uuid, &uuid_len
-    );
-    if (uuid_rc == UUID_RC_MEM) {
-        rc = IB_EALLOC;
-        goto finish;
-    }
-    else if (uuid_rc != UUID_RC_OK || uuid_len != UUID_LEN_STR+1) {
-        rc = IB_EOTHER;
-        goto finish;
+    for (size_t i = 0; i < sizeof(bytes); i += 8) {
+        uint64_t r = xoshiro256ss(state);
+
+        memcpy(bytes + i, &r, 8);
     }
 
-finish:
-    if (ib_lock_unlock(g_uuid_lock) != IB_OK) {
-        return IB_EOTHER;
+    /* RFC 4122 version 4 and variant bits. */
+    bytes[6] = (bytes[6] & 0x0f) | 0x40;
+    bytes[8] = (bytes[8] & 0x3f) | 0x80;
+
+    for (size_t i = 0; i < sizeof(bytes); ++i) {
+        if (i == 4 || i == 6 || i == 8 || i == 10) {
+            *out++ = '-';
+        }
+        *out++ = hex[bytes[i] >> 4];
+        *out++ = hex[bytes[i] & 0x0f];
     }
+    *out = '\0';
 
-    return rc;
+    return IB_OK;
 }